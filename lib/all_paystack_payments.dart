@@ -3,6 +3,8 @@ export 'enums.dart';
 export 'paystack_error.dart';
 export 'payment_request.dart';
 export 'payment_response.dart';
+export 'payment_status_update.dart';
+export 'verification_result.dart';
 export 'card_payment_request.dart';
 export 'bank_transfer_request.dart';
 export 'mobile_money_request.dart';
@@ -14,6 +16,8 @@ import 'bank_transfer_request.dart';
 import 'mobile_money_request.dart';
 import 'payment_request.dart';
 import 'payment_response.dart';
+import 'payment_status_update.dart';
+import 'verification_result.dart';
 import 'enums.dart';
 import 'webview_payment_handler.dart';
 
@@ -57,6 +61,24 @@ class AllPaystackPayments {
   ///
   /// ## Parameters
   /// - [publicKey]: Your Paystack public key (starts with 'pk_test_' for test mode or 'pk_live_' for live mode)
+  /// - [baseUrl]: Optional API base URL used instead of `https://api.paystack.co`,
+  ///   such as a local `paystack_mock_server` for load testing. Honoured on
+  ///   Linux, Windows and web.
+  /// - [hedgeVerifyPercentile]: Optional percentile, from 50 to 99, of recent
+  ///   verification latencies. A verification still unanswered after it is
+  ///   sent again over a new connection, the first response wins and the
+  ///   other request is cancelled. Hedges are capped at a small share of
+  ///   verifications. Honoured on Linux.
+  /// - [rateLimitPerSecond]: Optional number of requests per second, from 1
+  ///   to 1000, sent to each Paystack endpoint. Calls beyond it wait their
+  ///   turn instead of being refused by Paystack. Whether or not it is set,
+  ///   calls answered with HTTP 429 wait as long as Paystack asks and are
+  ///   sent again. Honoured on Linux and Windows.
+  /// - [embeddedCheckout]: Whether to show checkouts in a window of the app
+  ///   instead of the browser. The window is prepared in the background
+  ///   now, so that checkouts come up at once, and it closes as soon as the
+  ///   payment completes. Honoured on Linux when the plugin is built with
+  ///   WebKitGTK; checkouts open in the browser otherwise.
   ///
   /// ## Example
   /// ```dart
@@ -64,9 +86,23 @@ class AllPaystackPayments {
   /// ```
   ///
   /// ## Throws
-  /// - [PaystackError] if initialization fails
-  static Future<void> initialize(String publicKey) {
-    return AllPaystackPaymentsPlatform.instance.initialize(publicKey);
+  /// - [PaystackError] if initialization fails, if [baseUrl] is not an
+  ///   http or https URL, or if [hedgeVerifyPercentile] or
+  ///   [rateLimitPerSecond] is out of range
+  static Future<void> initialize(
+    String publicKey, {
+    String? baseUrl,
+    int? hedgeVerifyPercentile,
+    int? rateLimitPerSecond,
+    bool? embeddedCheckout,
+  }) {
+    return AllPaystackPaymentsPlatform.instance.initialize(
+      publicKey,
+      baseUrl: baseUrl,
+      hedgeVerifyPercentile: hedgeVerifyPercentile,
+      rateLimitPerSecond: rateLimitPerSecond,
+      embeddedCheckout: embeddedCheckout,
+    );
   }
 
   /// Initialize a card payment with secure tokenization.
@@ -146,7 +182,7 @@ class AllPaystackPayments {
 
     // Get checkout URL from platform
     final checkoutUrl = await AllPaystackPaymentsPlatform.instance
-        .getCheckoutUrl(request);
+        .getCheckoutUrl(request, returnToApp: true);
 
     // Process payment through webview
     final handler = WebViewPaymentHandlerFactory.create();
@@ -209,7 +245,7 @@ class AllPaystackPayments {
 
     // Get checkout URL from platform
     final checkoutUrl = await AllPaystackPaymentsPlatform.instance
-        .getCheckoutUrl(request);
+        .getCheckoutUrl(request, returnToApp: true);
 
     // Process payment through webview
     final handler = WebViewPaymentHandlerFactory.create();
@@ -282,7 +318,7 @@ class AllPaystackPayments {
 
     // Get checkout URL from platform
     final checkoutUrl = await AllPaystackPaymentsPlatform.instance
-        .getCheckoutUrl(request);
+        .getCheckoutUrl(request, returnToApp: true);
 
     // Process payment through webview
     final handler = WebViewPaymentHandlerFactory.create();
@@ -320,7 +356,7 @@ class AllPaystackPayments {
   ) async {
     // Get checkout URL from platform
     final checkoutUrl = await AllPaystackPaymentsPlatform.instance
-        .getCheckoutUrl(request);
+        .getCheckoutUrl(request, returnToApp: true);
 
     // Process payment through webview
     final handler = WebViewPaymentHandlerFactory.create();
@@ -334,6 +370,9 @@ class AllPaystackPayments {
   ///
   /// ## Parameters
   /// - [reference]: The transaction reference to verify
+  /// - [fields]: Optional members of the transaction to return in
+  ///   [PaymentResponse.rawResponse], for example `['customer', 'authorization']`.
+  ///   By default every member is returned.
   ///
   /// ## Returns
   /// A [PaymentResponse] with the verified payment status and details.
@@ -356,9 +395,55 @@ class AllPaystackPayments {
   /// ```
   ///
   /// ## Throws
-  /// - [PaystackError] if verification fails
-  static Future<PaymentResponse> verifyPayment(String reference) {
-    return AllPaystackPaymentsPlatform.instance.verifyPayment(reference);
+  /// - [PaystackError] if verification fails; with code `CIRCUIT_OPEN` on
+  ///   Linux and Windows if Paystack has been failing and the request was not
+  ///   sent, `RATE_LIMITED` if it waited too long for the rate limit, and
+  ///   `CANCELLED` on Linux if [cancelPayment] aborted it
+  static Future<PaymentResponse> verifyPayment(
+    String reference, {
+    List<String>? fields,
+  }) {
+    return AllPaystackPaymentsPlatform.instance.verifyPayment(
+      reference,
+      fields: fields,
+    );
+  }
+
+  /// Verify many payment transactions in one call.
+  ///
+  /// Useful for end-of-day reconciliation. References are verified
+  /// concurrently, natively where the platform supports it, instead of one
+  /// platform channel round trip per reference.
+  ///
+  /// ## Parameters
+  /// - [references]: The transaction references to verify
+  /// - [maxConcurrency]: How many verifications may run at the same time
+  ///
+  /// ## Returns
+  /// One [VerificationResult] per reference, in the same order as
+  /// [references]. A reference that cannot be verified yields a failed result
+  /// instead of failing the whole batch.
+  ///
+  /// ## Example
+  /// ```dart
+  /// final results = await AllPaystackPayments.verifyPayments(
+  ///   ['txn_ref_1', 'txn_ref_2', 'txn_ref_3'],
+  /// );
+  ///
+  /// final failed = results.where((result) => !result.isSuccessful);
+  /// print('${failed.length} references need attention');
+  /// ```
+  ///
+  /// ## Throws
+  /// - [PaystackError] if the batch itself cannot be run
+  static Future<List<VerificationResult>> verifyPayments(
+    List<String> references, {
+    int maxConcurrency = 16,
+  }) {
+    return AllPaystackPaymentsPlatform.instance.verifyPayments(
+      references,
+      maxConcurrency: maxConcurrency,
+    );
   }
 
   /// Get the current status of a payment transaction.
@@ -389,16 +474,149 @@ class AllPaystackPayments {
     return AllPaystackPaymentsPlatform.instance.getPaymentStatus(reference);
   }
 
+  /// Drop cached payment verification results.
+  ///
+  /// On platforms that cache verification results (currently Linux),
+  /// [getPaymentStatus] answers from the cache when it can. Results for
+  /// completed transactions are kept until evicted, while pending ones expire
+  /// after a few seconds. Use this to force the next status check for a
+  /// reference to go back to Paystack.
+  ///
+  /// ## Parameters
+  /// - [reference]: The transaction reference to drop, or `null` to drop all
+  ///
+  /// ## Example
+  /// ```dart
+  /// await AllPaystackPayments.invalidateVerificationCache(
+  ///   reference: 'txn_ref_123',
+  /// );
+  /// ```
+  static Future<void> invalidateVerificationCache({String? reference}) {
+    return AllPaystackPaymentsPlatform.instance.invalidateVerificationCache(
+      reference: reference,
+    );
+  }
+
+  /// Get the counters of the payment verification result cache.
+  ///
+  /// ## Returns
+  /// A map with `hits` and `misses` (status checks answered with and without
+  /// the cache) and `size` (results currently cached). Platforms that do not
+  /// cache verification results report zeros.
+  ///
+  /// ## Example
+  /// ```dart
+  /// final stats = await AllPaystackPayments.getVerificationCacheStats();
+  /// print('Cache hits: ${stats['hits']}, misses: ${stats['misses']}');
+  /// ```
+  static Future<Map<String, int>> getVerificationCacheStats() {
+    return AllPaystackPaymentsPlatform.instance.getVerificationCacheStats();
+  }
+
+  /// Get latency and error metrics of the native Paystack requests.
+  ///
+  /// ## Returns
+  /// A map with an entry per endpoint (`initialize` and `verify`), each
+  /// holding `requests`, `errors` counted by code (`HTTP_ERROR`,
+  /// `API_ERROR`, `PARSE_ERROR`), `retries` of transient failures,
+  /// `throttledRetries` the retry budget refused, `hedges` sent for slow
+  /// verifications and the `hedgesWon` that answered first, `rateLimited`
+  /// responses (HTTP 429) after which the call waited, and `phases`.
+  /// Each phase (`dns`, `connect`,
+  /// `tls`, `firstByte`, `total`, `parse` and `build`) reports `count`,
+  /// `p50`, `p90`, `p99`, `p999` and `max` in microseconds. A `methods`
+  /// entry counts the `calls` and `invalidArguments` of each method. Only
+  /// the Linux and Windows plugins record metrics; other platforms return an
+  /// empty map.
+  ///
+  /// ## Example
+  /// ```dart
+  /// final metrics = await AllPaystackPayments.getMetrics();
+  /// final total = metrics['verify']['phases']['total'];
+  /// print('verifyPayment p99: ${total['p99'] / 1000} ms');
+  /// ```
+  static Future<Map<String, dynamic>> getMetrics() {
+    return AllPaystackPaymentsPlatform.instance.getMetrics();
+  }
+
+  /// Get the state of the native load control in front of Paystack.
+  ///
+  /// Each endpoint has a circuit breaker: after repeated connection failures
+  /// or server errors it opens, and calls fail at once with a [PaystackError]
+  /// of code `CIRCUIT_OPEN` until a probe request succeeds. Requests beyond
+  /// an adaptive concurrency limit wait in a queue, and so do requests
+  /// beyond the rate limit, failing with `RATE_LIMITED` if they wait too
+  /// long.
+  ///
+  /// ## Returns
+  /// A map with `circuits`, holding per endpoint (`initialize` and `verify`)
+  /// its `state` (`closed`, `open` or `halfOpen`), `consecutiveFailures` and
+  /// the calls it `rejected`, and `limiter`, holding the current `limit`,
+  /// the requests `inFlight` and those `queued`, and `rateLimits`, holding
+  /// per endpoint the calls `waiting` for the rate limit and those that
+  /// `expired` waiting. Only the Linux and Windows
+  /// plugins have load control; other platforms return an empty map.
+  ///
+  /// ## Example
+  /// ```dart
+  /// final stats = await AllPaystackPayments.getTransportStats();
+  /// if (stats['circuits']?['verify']['state'] == 'open') {
+  ///   showPaystackOutageBanner();
+  /// }
+  /// ```
+  static Future<Map<String, dynamic>> getTransportStats() {
+    return AllPaystackPaymentsPlatform.instance.getTransportStats();
+  }
+
+  /// Start writing a trace of the native payment calls to a file.
+  ///
+  /// Every method call is traced as spans for its dispatch, the wait for the
+  /// I/O thread, DNS, connect, TLS, request, response, parsing and the
+  /// response back to Dart, each carrying the payment reference where it is
+  /// known. The file is in the Chrome trace event format and opens in
+  /// `ui.perfetto.dev` or `chrome://tracing`. Starting again replaces the
+  /// trace in progress.
+  ///
+  /// ## Parameters
+  /// - [path]: Where the trace is written, replacing any existing file
+  ///
+  /// ## Returns
+  /// `true` if tracing started, `false` on platforms without native tracing
+  /// (only Linux and Windows trace).
+  ///
+  /// ## Throws
+  /// - [PaystackError] with code `TRACE_ERROR` if the file cannot be created
+  ///
+  /// ## Example
+  /// ```dart
+  /// await AllPaystackPayments.startTracing('/tmp/checkout_trace.json');
+  /// await AllPaystackPayments.verifyPayment(reference);
+  /// await AllPaystackPayments.stopTracing();
+  /// ```
+  static Future<bool> startTracing(String path) {
+    return AllPaystackPaymentsPlatform.instance.startTracing(path);
+  }
+
+  /// Stop tracing and finish the file [startTracing] writes.
+  static Future<void> stopTracing() {
+    return AllPaystackPaymentsPlatform.instance.stopTracing();
+  }
+
   /// Cancel a pending payment transaction.
   ///
   /// This method attempts to cancel a payment that is still in pending status.
   /// Note that only pending payments can be cancelled; completed payments cannot be cancelled.
   ///
+  /// On Linux, every call about [reference] still in flight, queued or
+  /// waiting to be retried is aborted at once, and fails with a
+  /// [PaystackError] of code `CANCELLED`.
+  ///
   /// ## Parameters
   /// - [reference]: The transaction reference to cancel
   ///
   /// ## Returns
-  /// `true` if the payment was successfully cancelled, `false` otherwise.
+  /// `true` if the payment was successfully cancelled, `false` otherwise,
+  /// such as when no call about [reference] was outstanding.
   ///
   /// ## Example
   /// ```dart
@@ -417,6 +635,61 @@ class AllPaystackPayments {
     return AllPaystackPaymentsPlatform.instance.cancelPayment(reference);
   }
 
+  /// Watch a payment in the background until it completes.
+  ///
+  /// The transaction is verified at once, then again at intervals that
+  /// grow from a second to half a minute, so that a payment completed soon
+  /// after checkout opens is noticed quickly. Each change of its status is
+  /// emitted on [paymentStatusUpdates], the last one with
+  /// [PaymentStatusUpdate.isFinal] set once the payment succeeds, fails or
+  /// is reversed, or [timeout] (15 minutes by default) passes. Watching a
+  /// reference again restarts its watch.
+  ///
+  /// Honoured on Linux, where one native timer serves every watched
+  /// reference. Elsewhere this returns `false` and callers should poll with
+  /// [verifyPayment] instead.
+  ///
+  /// ## Parameters
+  /// - [reference]: The transaction reference to watch
+  /// - [timeout]: How long to watch it, up to a day
+  ///
+  /// ## Returns
+  /// `true` if the reference is watched.
+  ///
+  /// ## Example
+  /// ```dart
+  /// final subscription = AllPaystackPayments.paymentStatusUpdates
+  ///     .where((update) => update.reference == reference && update.isFinal)
+  ///     .listen((update) => print('Payment ended as ${update.status}'));
+  /// await AllPaystackPayments.watchPayment(reference);
+  /// ```
+  ///
+  /// ## Throws
+  /// - [PaystackError] with code `INVALID_ARGUMENTS` if [timeout] is not
+  ///   between a millisecond and a day
+  static Future<bool> watchPayment(String reference, {Duration? timeout}) {
+    return AllPaystackPaymentsPlatform.instance.watchPayment(
+      reference,
+      timeout: timeout,
+    );
+  }
+
+  /// Stop watching a payment passed to [watchPayment], without a final
+  /// update.
+  ///
+  /// Returns `false` if [reference] was not watched.
+  static Future<bool> unwatchPayment(String reference) {
+    return AllPaystackPaymentsPlatform.instance.unwatchPayment(reference);
+  }
+
+  /// Status changes of the payments passed to [watchPayment].
+  ///
+  /// A broadcast stream shared by every watched reference; filter it by
+  /// [PaymentStatusUpdate.reference]. Listen before calling [watchPayment]
+  /// so that no update is missed.
+  static Stream<PaymentStatusUpdate> get paymentStatusUpdates =>
+      AllPaystackPaymentsPlatform.instance.paymentStatusUpdates;
+
   /// For backward compatibility.
   static Future<String?> getPlatformVersion() async {
     return AllPaystackPaymentsPlatform.instance.getPlatformVersion();
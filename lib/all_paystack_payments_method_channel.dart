@@ -4,7 +4,9 @@ import 'package:flutter/services.dart';
 import 'all_paystack_payments_platform_interface.dart';
 import 'payment_request.dart';
 import 'payment_response.dart';
+import 'payment_status_update.dart';
 import 'paystack_error.dart';
+import 'verification_result.dart';
 
 /// An implementation of [AllPaystackPaymentsPlatform] that uses method channels.
 class MethodChannelAllPaystackPayments extends AllPaystackPaymentsPlatform {
@@ -12,10 +14,30 @@ class MethodChannelAllPaystackPayments extends AllPaystackPaymentsPlatform {
   @visibleForTesting
   final methodChannel = const MethodChannel('all_paystack_payments');
 
+  /// The event channel the native poller sends payment status updates on.
+  @visibleForTesting
+  final eventChannel = const EventChannel('all_paystack_payments/events');
+
+  Stream<PaymentStatusUpdate>? _paymentStatusUpdates;
+
   @override
-  Future<void> initialize(String publicKey) async {
+  Future<void> initialize(
+    String publicKey, {
+    String? baseUrl,
+    int? hedgeVerifyPercentile,
+    int? rateLimitPerSecond,
+    bool? embeddedCheckout,
+  }) async {
     try {
-      await methodChannel.invokeMethod('initialize', {'publicKey': publicKey});
+      await methodChannel.invokeMethod('initialize', {
+        'publicKey': publicKey,
+        if (baseUrl != null) 'baseUrl': baseUrl,
+        if (hedgeVerifyPercentile != null)
+          'hedgeVerifyPercentile': hedgeVerifyPercentile,
+        if (rateLimitPerSecond != null)
+          'rateLimitPerSecond': rateLimitPerSecond,
+        if (embeddedCheckout != null) 'embeddedCheckout': embeddedCheckout,
+      });
     } on PlatformException catch (e) {
       throw PaystackError(
         message: e.message ?? 'Failed to initialize Paystack',
@@ -49,11 +71,14 @@ class MethodChannelAllPaystackPayments extends AllPaystackPaymentsPlatform {
   }
 
   @override
-  Future<PaymentResponse> verifyPayment(String reference) async {
+  Future<PaymentResponse> verifyPayment(
+    String reference, {
+    List<String>? fields,
+  }) async {
     try {
       final result = await methodChannel.invokeMethod<Map<dynamic, dynamic>>(
         'verifyPayment',
-        {'reference': reference},
+        {'reference': reference, if (fields != null) 'fields': fields},
       );
       if (result == null) {
         throw PaystackError(message: 'No response from payment verification');
@@ -71,6 +96,63 @@ class MethodChannelAllPaystackPayments extends AllPaystackPaymentsPlatform {
     }
   }
 
+  @override
+  Future<List<VerificationResult>> verifyPayments(
+    List<String> references, {
+    int maxConcurrency = 16,
+  }) async {
+    final List<dynamic>? result;
+    try {
+      result = await methodChannel.invokeMethod<List<dynamic>>(
+        'verifyPayments',
+        {'references': references, 'maxConcurrency': maxConcurrency},
+      );
+    } on MissingPluginException {
+      // Platforms without a native batch verify one reference at a time.
+      return super.verifyPayments(references, maxConcurrency: maxConcurrency);
+    } on PlatformException catch (e) {
+      throw PaystackError(
+        message: e.message ?? 'Failed to verify payments',
+        code: e.code,
+      );
+    }
+    if (result == null) {
+      throw PaystackError(message: 'No response from batch verification');
+    }
+    return result
+        .map(
+          (entry) => _verificationResultFromEntry(
+            (entry as Map<dynamic, dynamic>).cast<String, dynamic>(),
+          ),
+        )
+        .toList();
+  }
+
+  VerificationResult _verificationResultFromEntry(Map<String, dynamic> entry) {
+    final reference = entry['reference'] as String;
+    if (entry['success'] != true) {
+      return VerificationResult.failure(
+        reference,
+        PaystackError(
+          message: entry['message'] as String? ?? 'Failed to verify payment',
+          code: entry['code'] as String?,
+        ),
+      );
+    }
+    final data = (entry['data'] as Map<dynamic, dynamic>)
+        .cast<String, dynamic>();
+    if (data['status'] != 'success') {
+      return VerificationResult.failure(
+        reference,
+        PaystackError.fromApiResponse(data),
+      );
+    }
+    return VerificationResult.success(
+      reference,
+      PaymentResponse.fromApiResponse(data),
+    );
+  }
+
   @override
   Future<PaymentResponse> getPaymentStatus(String reference) async {
     try {
@@ -94,6 +176,111 @@ class MethodChannelAllPaystackPayments extends AllPaystackPaymentsPlatform {
     }
   }
 
+  @override
+  Future<void> invalidateVerificationCache({String? reference}) async {
+    try {
+      await methodChannel.invokeMethod<void>('invalidateVerificationCache', {
+        'reference': reference,
+      });
+    } on MissingPluginException {
+      return super.invalidateVerificationCache(reference: reference);
+    } on PlatformException catch (e) {
+      throw PaystackError(
+        message: e.message ?? 'Failed to invalidate verification cache',
+        code: e.code,
+      );
+    }
+  }
+
+  @override
+  Future<Map<String, int>> getVerificationCacheStats() async {
+    try {
+      final result = await methodChannel.invokeMethod<Map<dynamic, dynamic>>(
+        'getVerificationCacheStats',
+      );
+      if (result == null) {
+        throw PaystackError(message: 'No response from verification cache');
+      }
+      return result.cast<String, int>();
+    } on MissingPluginException {
+      return super.getVerificationCacheStats();
+    } on PlatformException catch (e) {
+      throw PaystackError(
+        message: e.message ?? 'Failed to get verification cache stats',
+        code: e.code,
+      );
+    }
+  }
+
+  @override
+  Future<Map<String, dynamic>> getMetrics() async {
+    try {
+      final result = await methodChannel.invokeMethod<Map<dynamic, dynamic>>(
+        'getMetrics',
+      );
+      if (result == null) {
+        throw PaystackError(message: 'No response from metrics');
+      }
+      return result.cast<String, dynamic>();
+    } on MissingPluginException {
+      return super.getMetrics();
+    } on PlatformException catch (e) {
+      throw PaystackError(
+        message: e.message ?? 'Failed to get metrics',
+        code: e.code,
+      );
+    }
+  }
+
+  @override
+  Future<Map<String, dynamic>> getTransportStats() async {
+    try {
+      final result = await methodChannel.invokeMethod<Map<dynamic, dynamic>>(
+        'getTransportStats',
+      );
+      if (result == null) {
+        throw PaystackError(message: 'No response from transport stats');
+      }
+      return result.cast<String, dynamic>();
+    } on MissingPluginException {
+      return super.getTransportStats();
+    } on PlatformException catch (e) {
+      throw PaystackError(
+        message: e.message ?? 'Failed to get transport stats',
+        code: e.code,
+      );
+    }
+  }
+
+  @override
+  Future<bool> startTracing(String path) async {
+    try {
+      await methodChannel.invokeMethod<void>('startTracing', {'path': path});
+      return true;
+    } on MissingPluginException {
+      return super.startTracing(path);
+    } on PlatformException catch (e) {
+      throw PaystackError(
+        message: e.message ?? 'Failed to start tracing',
+        code: e.code,
+      );
+    }
+  }
+
+  @override
+  Future<void> stopTracing() async {
+    try {
+      await methodChannel.invokeMethod<void>('stopTracing');
+    } on MissingPluginException {
+      return super.stopTracing();
+    } on PlatformException catch (e) {
+      throw PaystackError(
+        message: e.message ?? 'Failed to stop tracing',
+        code: e.code,
+      );
+    }
+  }
+
   @override
   Future<bool> cancelPayment(String reference) async {
     try {
@@ -110,12 +297,62 @@ class MethodChannelAllPaystackPayments extends AllPaystackPaymentsPlatform {
   }
 
   @override
-  Future<String> getCheckoutUrl(PaymentRequest request) async {
+  Future<bool> watchPayment(String reference, {Duration? timeout}) async {
+    try {
+      final result = await methodChannel.invokeMethod<bool>('watchPayment', {
+        'reference': reference,
+        if (timeout != null) 'timeoutMs': timeout.inMilliseconds,
+      });
+      return result ?? false;
+    } on MissingPluginException {
+      return super.watchPayment(reference, timeout: timeout);
+    } on PlatformException catch (e) {
+      throw PaystackError(
+        message: e.message ?? 'Failed to watch payment',
+        code: e.code,
+      );
+    }
+  }
+
+  @override
+  Future<bool> unwatchPayment(String reference) async {
+    try {
+      final result = await methodChannel.invokeMethod<bool>(
+        'unwatchPayment',
+        {'reference': reference},
+      );
+      return result ?? false;
+    } on MissingPluginException {
+      return super.unwatchPayment(reference);
+    } on PlatformException catch (e) {
+      throw PaystackError(
+        message: e.message ?? 'Failed to unwatch payment',
+        code: e.code,
+      );
+    }
+  }
+
+  @override
+  Stream<PaymentStatusUpdate> get paymentStatusUpdates {
+    // One native subscription, shared by every listener.
+    return _paymentStatusUpdates ??= eventChannel
+        .receiveBroadcastStream()
+        .map(
+          (event) =>
+              PaymentStatusUpdate.fromMap(event as Map<dynamic, dynamic>),
+        );
+  }
+
+  @override
+  Future<String> getCheckoutUrl(
+    PaymentRequest request, {
+    bool returnToApp = false,
+  }) async {
     try {
       request.validate();
       final result = await methodChannel.invokeMethod<Map<dynamic, dynamic>>(
         'getCheckoutUrl',
-        request.toJson(),
+        {...request.toJson(), if (returnToApp) 'returnToApp': true},
       );
       if (result == null) {
         throw PaystackError(message: 'No response from checkout URL request');
@@ -124,7 +361,7 @@ class MethodChannelAllPaystackPayments extends AllPaystackPaymentsPlatform {
       if (castedResult['status'] != 'success') {
         throw PaystackError.fromApiResponse(castedResult);
       }
-      final data = castedResult['data'] as Map<String, dynamic>;
+      final data = (castedResult['data'] as Map).cast<String, dynamic>();
       final checkoutUrl = data['authorization_url'] as String?;
       if (checkoutUrl == null) {
         throw PaystackError(message: 'No checkout URL in response');
@@ -3,6 +3,9 @@ import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 import 'all_paystack_payments_method_channel.dart';
 import 'payment_request.dart';
 import 'payment_response.dart';
+import 'payment_status_update.dart';
+import 'paystack_error.dart';
+import 'verification_result.dart';
 
 abstract class AllPaystackPaymentsPlatform extends PlatformInterface {
   /// Constructs a AllPaystackPaymentsPlatform.
@@ -27,7 +30,20 @@ abstract class AllPaystackPaymentsPlatform extends PlatformInterface {
   }
 
   /// Initialize the Paystack SDK with public key
-  Future<void> initialize(String publicKey) {
+  ///
+  /// Implementations that support it send requests to [baseUrl] instead of
+  /// the production API, hedge verifications still unanswered after
+  /// [hedgeVerifyPercentile] of recent ones, send at most
+  /// [rateLimitPerSecond] requests per second to each endpoint, and show
+  /// checkouts in a prewarmed window of the app if [embeddedCheckout] is
+  /// set.
+  Future<void> initialize(
+    String publicKey, {
+    String? baseUrl,
+    int? hedgeVerifyPercentile,
+    int? rateLimitPerSecond,
+    bool? embeddedCheckout,
+  }) {
     throw UnimplementedError('initialize() has not been implemented.');
   }
 
@@ -40,25 +56,142 @@ abstract class AllPaystackPaymentsPlatform extends PlatformInterface {
   ///
   /// This method initializes a transaction with Paystack and returns the checkout URL
   /// that can be opened in a webview for payment processing.
-  Future<String> getCheckoutUrl(PaymentRequest request) {
+  ///
+  /// Set [returnToApp] when the checkout will be opened in this app through
+  /// the webview handler. Implementations that can learn when it completes
+  /// then send the customer back to the app instead of to the integration's
+  /// callback URL, unless the request has a callback URL of its own.
+  Future<String> getCheckoutUrl(
+    PaymentRequest request, {
+    bool returnToApp = false,
+  }) {
     throw UnimplementedError('getCheckoutUrl() has not been implemented.');
   }
 
   /// Verify a payment transaction
-  Future<PaymentResponse> verifyPayment(String reference) {
+  ///
+  /// If [fields] is given, [PaymentResponse.rawResponse] only holds those
+  /// members of the transaction, plus the ones [PaymentResponse] reads.
+  /// Implementations that cannot project the response return every member.
+  Future<PaymentResponse> verifyPayment(
+    String reference, {
+    List<String>? fields,
+  }) {
     throw UnimplementedError('verifyPayment() has not been implemented.');
   }
 
+  /// Verify several payment transactions at once
+  ///
+  /// Returns one [VerificationResult] per reference, in the order given, so a
+  /// failed reference does not fail the whole batch. At most [maxConcurrency]
+  /// verifications run at the same time.
+  ///
+  /// The default implementation calls [verifyPayment] for each reference.
+  /// Platforms with a native batch call override it.
+  Future<List<VerificationResult>> verifyPayments(
+    List<String> references, {
+    int maxConcurrency = 16,
+  }) async {
+    if (references.isEmpty) {
+      return [];
+    }
+    final results = List<VerificationResult?>.filled(references.length, null);
+    var next = 0;
+
+    Future<void> worker() async {
+      while (next < references.length) {
+        final index = next++;
+        final reference = references[index];
+        try {
+          results[index] = VerificationResult.success(
+            reference,
+            await verifyPayment(reference),
+          );
+        } on PaystackError catch (e) {
+          results[index] = VerificationResult.failure(reference, e);
+        } on Exception catch (e) {
+          results[index] = VerificationResult.failure(
+            reference,
+            PaystackError(message: e.toString()),
+          );
+        }
+      }
+    }
+
+    final workers = maxConcurrency.clamp(1, references.length);
+    await Future.wait(List.generate(workers, (_) => worker()));
+    return results.cast<VerificationResult>();
+  }
+
   /// Get payment status
   Future<PaymentResponse> getPaymentStatus(String reference) {
     throw UnimplementedError('getPaymentStatus() has not been implemented.');
   }
 
+  /// Drop cached verification results
+  ///
+  /// Drops the result for [reference], or every result when it is `null`.
+  /// Platforms that do not cache verification results have nothing to drop.
+  Future<void> invalidateVerificationCache({String? reference}) async {}
+
+  /// Get the hit and miss counters of the verification result cache
+  ///
+  /// Returns a map with `hits`, `misses` and `size`. Platforms that do not
+  /// cache verification results report zeros.
+  Future<Map<String, int>> getVerificationCacheStats() async {
+    return {'hits': 0, 'misses': 0, 'size': 0};
+  }
+
+  /// Get latency histograms and error counts of the native requests
+  ///
+  /// Platforms that do not record metrics return an empty map.
+  Future<Map<String, dynamic>> getMetrics() async {
+    return {};
+  }
+
+  /// Get the state of the native circuit breakers and concurrency limiter
+  ///
+  /// Platforms without load control return an empty map.
+  Future<Map<String, dynamic>> getTransportStats() async {
+    return {};
+  }
+
+  /// Start writing a Chrome trace of the native calls to [path]
+  ///
+  /// Returns false on platforms that do not trace.
+  Future<bool> startTracing(String path) async {
+    return false;
+  }
+
+  /// Stop tracing and close the trace file
+  Future<void> stopTracing() async {}
+
   /// Cancel a payment transaction
   Future<bool> cancelPayment(String reference) {
     throw UnimplementedError('cancelPayment() has not been implemented.');
   }
 
+  /// Watch [reference] in the background until its payment completes or
+  /// [timeout] passes, reporting its changes on [paymentStatusUpdates]
+  ///
+  /// Returns false on platforms without a native poller.
+  Future<bool> watchPayment(String reference, {Duration? timeout}) async {
+    return false;
+  }
+
+  /// Stop watching [reference]
+  ///
+  /// Returns false if it was not watched.
+  Future<bool> unwatchPayment(String reference) async {
+    return false;
+  }
+
+  /// Status changes of the payments passed to [watchPayment]
+  ///
+  /// Empty on platforms without a native poller.
+  Stream<PaymentStatusUpdate> get paymentStatusUpdates =>
+      const Stream.empty();
+
   /// Get platform version (legacy method for backward compatibility)
   Future<String?> getPlatformVersion() {
     throw UnimplementedError('platformVersion() has not been implemented.');
@@ -29,7 +29,10 @@ class AllPaystackPaymentsWeb extends AllPaystackPaymentsPlatform {
     AllPaystackPaymentsPlatform.instance = AllPaystackPaymentsWeb();
   }
 
+  static const String _defaultBaseUrl = 'https://api.paystack.co';
+
   String? _publicKey;
+  String _baseUrl = _defaultBaseUrl;
   bool _scriptLoaded = false;
   final Map<String, Completer<PaymentResponse>> _paymentCompleters = {};
 
@@ -98,9 +101,29 @@ class AllPaystackPaymentsWeb extends AllPaystackPaymentsPlatform {
   }
 
   @override
-  Future<void> initialize(String publicKey) async {
+  Future<void> initialize(
+    String publicKey, {
+    String? baseUrl,
+    int? hedgeVerifyPercentile,
+    int? rateLimitPerSecond,
+    bool? embeddedCheckout,
+  }) async {
+    // The browser owns the connections, so verifications are not hedged,
+    // requests are not rate limited, and checkouts load in it anyway.
+    if (baseUrl != null) {
+      final uri = Uri.tryParse(baseUrl);
+      if (uri == null ||
+          (uri.scheme != 'http' && uri.scheme != 'https') ||
+          uri.host.isEmpty) {
+        throw PaystackError(
+          message: 'baseUrl must be an http or https URL',
+          code: 'INVALID_ARGUMENTS',
+        );
+      }
+    }
     await _ensureScriptLoaded();
     _publicKey = publicKey;
+    _baseUrl = (baseUrl ?? _defaultBaseUrl).replaceFirst(RegExp(r'/+$'), '');
   }
 
   @override
@@ -123,7 +146,10 @@ class AllPaystackPaymentsWeb extends AllPaystackPaymentsPlatform {
   }
 
   @override
-  Future<String> getCheckoutUrl(PaymentRequest request) async {
+  Future<String> getCheckoutUrl(
+    PaymentRequest request, {
+    bool returnToApp = false,
+  }) async {
     if (_publicKey == null) {
       throw PaystackError(
         message: 'Paystack not initialized. Call initialize() first.',
@@ -134,7 +160,7 @@ class AllPaystackPaymentsWeb extends AllPaystackPaymentsPlatform {
 
     try {
       // Initialize transaction with Paystack API to get checkout URL
-      final url = Uri.parse('https://api.paystack.co/transaction/initialize');
+      final url = Uri.parse('$_baseUrl/transaction/initialize');
       final response = await http.post(
         url,
         headers: {
@@ -174,7 +200,10 @@ class AllPaystackPaymentsWeb extends AllPaystackPaymentsPlatform {
   }
 
   @override
-  Future<PaymentResponse> verifyPayment(String reference) async {
+  Future<PaymentResponse> verifyPayment(
+    String reference, {
+    List<String>? fields,
+  }) async {
     return _verifyTransaction(reference);
   }
 
@@ -192,7 +221,7 @@ class AllPaystackPaymentsWeb extends AllPaystackPaymentsPlatform {
 
     try {
       final url = Uri.parse(
-        'https://api.paystack.co/transaction/verify/$reference',
+        '$_baseUrl/transaction/verify/$reference',
       );
       final response = await http.get(
         url,
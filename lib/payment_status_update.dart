@@ -0,0 +1,57 @@
+/// A change in the status of a payment being watched.
+///
+/// Emitted by [AllPaystackPayments.paymentStatusUpdates] for the references
+/// passed to [AllPaystackPayments.watchPayment]. Each reference yields an
+/// update whenever its status changes, and a last one with [isFinal] set.
+///
+/// ## Example
+/// ```dart
+/// AllPaystackPayments.paymentStatusUpdates.listen((update) {
+///   if (update.isFinal) {
+///     print('${update.reference} ended as ${update.status}');
+///   }
+/// });
+/// await AllPaystackPayments.watchPayment(reference);
+/// ```
+class PaymentStatusUpdate {
+  /// The reference being watched
+  final String reference;
+
+  /// Paystack's status of the transaction, such as `abandoned`, `ongoing`,
+  /// `success` or `failed`. Empty if the watch timed out before the
+  /// transaction could be verified.
+  final String status;
+
+  /// Whether this is the last update for [reference]: its status can no
+  /// longer change, or the watch timed out
+  final bool isFinal;
+
+  /// Whether the watch gave up before the payment completed
+  final bool timedOut;
+
+  const PaymentStatusUpdate({
+    required this.reference,
+    required this.status,
+    this.isFinal = false,
+    this.timedOut = false,
+  });
+
+  /// Creates an update from an event of the native poller.
+  factory PaymentStatusUpdate.fromMap(Map<dynamic, dynamic> map) {
+    return PaymentStatusUpdate(
+      reference: map['reference'] as String? ?? '',
+      status: map['status'] as String? ?? '',
+      isFinal: map['final'] as bool? ?? false,
+      timedOut: map['timedOut'] as bool? ?? false,
+    );
+  }
+
+  /// Whether the payment succeeded
+  bool get isSuccessful => status == 'success';
+
+  @override
+  String toString() {
+    return 'PaymentStatusUpdate($reference: $status'
+        '${isFinal ? ', final' : ''}${timedOut ? ', timed out' : ''})';
+  }
+}
@@ -0,0 +1,45 @@
+import 'payment_response.dart';
+import 'paystack_error.dart';
+
+/// Outcome of verifying one reference in a batch.
+///
+/// Returned by [AllPaystackPayments.verifyPayments], which yields one result
+/// per reference so that a single bad reference does not fail the batch.
+///
+/// ## Example
+/// ```dart
+/// final results = await AllPaystackPayments.verifyPayments(references);
+/// for (final result in results) {
+///   if (result.isSuccessful) {
+///     print('${result.reference}: ${result.response!.status}');
+///   } else {
+///     print('${result.reference} failed: ${result.error!.message}');
+///   }
+/// }
+/// ```
+class VerificationResult {
+  /// The reference that was verified
+  final String reference;
+
+  /// The verified payment, or `null` if verification failed
+  final PaymentResponse? response;
+
+  /// Why verification failed, or `null` if it succeeded
+  final PaystackError? error;
+
+  VerificationResult.success(this.reference, PaymentResponse this.response)
+    : error = null;
+
+  VerificationResult.failure(this.reference, PaystackError this.error)
+    : response = null;
+
+  /// Whether the reference was verified successfully
+  bool get isSuccessful => error == null;
+
+  @override
+  String toString() {
+    return isSuccessful
+        ? 'VerificationResult($reference: ${response!.status})'
+        : 'VerificationResult($reference: $error)';
+  }
+}
@@ -19,7 +19,8 @@ class LinuxWebViewPaymentHandler implements WebViewPaymentHandler {
         'linux_webview_${DateTime.now().millisecondsSinceEpoch}';
 
     try {
-      // Call platform method to show webview (opens in browser) with timeout
+      // Call platform method to show webview (opens in browser) with timeout;
+      // it answers once the checkout completes, when the plugin can tell.
       final result = await _channel
           .invokeMethod<Map<dynamic, dynamic>>('showWebView', {
             'checkoutUrl': checkoutUrl,
@@ -45,7 +46,13 @@ class LinuxWebViewPaymentHandler implements WebViewPaymentHandler {
       }
 
       // Parse the payment result
-      final data = castedResult['data'] as Map<String, dynamic>;
+      final data = (castedResult['data'] as Map).cast<String, dynamic>();
+      if (data.containsKey('amount')) {
+        // The checkout redirected back to the plugin, which verified it.
+        return PaymentResponse.fromApiResponse(data);
+      }
+
+      // Opened in the browser without a way back: the outcome is unknown.
       final paymentReference = data['reference'] as String? ?? reference;
       final status = data['status'] as String? ?? 'success';
 
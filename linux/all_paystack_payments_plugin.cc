@@ -4,20 +4,188 @@
 #include <gtk/gtk.h>
 #include <sys/utsname.h>
 
+#include <algorithm>
 #include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "all_paystack_payments_plugin_private.h"
-
-#include <curl/curl.h>
-#include <nlohmann/json.hpp>
+#include "paystack_call_engine.h"
+#include "paystack_callback_listener.h"
+#include "paystack_checkout_window.h"
+#include "paystack_client.h"
+#include "paystack_fl_value_builder.h"
+#include "paystack_fl_value_writer.h"
+#include "paystack_http_client.h"
+#include "paystack_metrics.h"
+#include "paystack_payment_poller.h"
+#include "paystack_request_body.h"
+#include "paystack_response_parser.h"
+#include "paystack_trace.h"
+#include "paystack_verify_cache.h"
 
 #define ALL_PAYSTACK_PAYMENTS_PLUGIN(obj) \
   (G_TYPE_CHECK_INSTANCE_CAST((obj), all_paystack_payments_plugin_get_type(), \
                                AllPaystackPaymentsPlugin))
 
+// Default and upper bound for the number of references verifyPayments
+// verifies at the same time.
+static constexpr int64_t kDefaultBatchConcurrency = 16;
+static constexpr int64_t kMaxBatchConcurrency = 64;
+
+// Bounds of the verification latency percentile after which initialize's
+// hedgeVerifyPercentile hedges verifications.
+static constexpr int64_t kMinHedgePercentile = 50;
+static constexpr int64_t kMaxHedgePercentile = 99;
+
+// Upper bound of initialize's rateLimitPerSecond.
+static constexpr int64_t kMaxRateLimitPerSecond = 1000;
+
+// Upper bound of watchPayment's timeoutMs: a day.
+static constexpr int64_t kMaxWatchTimeoutMs = 24 * 60 * 60 * 1000;
+
+// How long showWebView waits for the browser to come back from checkout; as
+// long as the Dart side waits for it.
+static constexpr int64_t kCheckoutWaitMs = 10 * 60 * 1000;
+
+// Checkouts getCheckoutUrl remembers for showWebView. Beyond it the oldest
+// ones are forgotten, and showWebView cannot tell when they complete.
+static constexpr size_t kMaxTrackedCheckouts = 256;
+
+// How long dispose lets calls in flight finish before aborting them.
+static constexpr int64_t kDisposeDrainMs = 2000;
+
+// Members of a verified transaction that PaymentResponse reads, returned
+// whatever field projection the caller asked for.
+static const char* const kVerifyCoreFields[] = {
+    "reference", "status", "amount", "currency", "gateway_response", "created_at",
+};
+
+using all_paystack_payments::ArgSpec;
+using all_paystack_payments::ArgType;
+using all_paystack_payments::arg_list;
+using all_paystack_payments::kNoArgs;
+
+constexpr ArgSpec kInitializeArgs[] = {
+    {"publicKey", ArgType::kString, true},
+    {"baseUrl", ArgType::kString, false},
+    {"hedgeVerifyPercentile", ArgType::kInt, false},
+    {"rateLimitPerSecond", ArgType::kInt, false},
+    {"embeddedCheckout", ArgType::kBool, false},
+};
+constexpr ArgSpec kCheckoutArgs[] = {
+    {"amount", ArgType::kInt, true},
+    {"email", ArgType::kString, true},
+    {"currency", ArgType::kString, false},
+    {"reference", ArgType::kString, false},
+    {"callbackUrl", ArgType::kString, false},
+    // How PaymentRequest.toJson names it.
+    {"callback_url", ArgType::kString, false},
+    {"metadata", ArgType::kMap, false},
+    {"returnToApp", ArgType::kBool, false},
+};
+constexpr ArgSpec kVerifyArgs[] = {
+    {"reference", ArgType::kString, true},
+    {"fields", ArgType::kStringList, false},
+};
+constexpr ArgSpec kVerifyBatchArgs[] = {
+    {"references", ArgType::kStringList, true},
+    {"fields", ArgType::kStringList, false},
+    {"maxConcurrency", ArgType::kInt, false},
+};
+constexpr ArgSpec kInvalidateArgs[] = {
+    {"reference", ArgType::kString, false},
+};
+constexpr ArgSpec kCancelArgs[] = {
+    {"reference", ArgType::kString, true},
+};
+constexpr ArgSpec kWatchArgs[] = {
+    {"reference", ArgType::kString, true},
+    {"timeoutMs", ArgType::kInt, false},
+};
+constexpr ArgSpec kUnwatchArgs[] = {
+    {"reference", ArgType::kString, true},
+};
+constexpr ArgSpec kShowWebViewArgs[] = {
+    {"checkoutUrl", ArgType::kString, true},
+};
+constexpr ArgSpec kStartTracingArgs[] = {
+    {"path", ArgType::kString, true},
+};
+
+// Every method call the plugin handles. A new method only needs an entry
+// here and its handler.
+constexpr PluginMethod kPluginMethods[] = {
+    {"initialize", arg_list(kInitializeArgs), false, handle_initialize},
+    {"initializePayment", arg_list(kCheckoutArgs), true, handle_initialize_payment},
+    {"getCheckoutUrl", arg_list(kCheckoutArgs), true, handle_get_checkout_url},
+    {"verifyPayment", arg_list(kVerifyArgs), true, handle_verify_payment},
+    {"verifyPayments", arg_list(kVerifyBatchArgs), true, handle_verify_payments},
+    {"getPaymentStatus", arg_list(kVerifyArgs), true, handle_get_payment_status},
+    {"invalidateVerificationCache", arg_list(kInvalidateArgs), false, handle_invalidate_verification_cache},
+    {"getVerificationCacheStats", kNoArgs, false, handle_get_verification_cache_stats},
+    {"getMetrics", kNoArgs, false, handle_get_metrics},
+    {"getTransportStats", kNoArgs, true, handle_get_transport_stats},
+    {"startTracing", arg_list(kStartTracingArgs), false, handle_start_tracing},
+    {"stopTracing", kNoArgs, false, handle_stop_tracing},
+    {"cancelPayment", arg_list(kCancelArgs), true, handle_cancel_payment},
+    {"watchPayment", arg_list(kWatchArgs), true, handle_watch_payment},
+    {"unwatchPayment", arg_list(kUnwatchArgs), true, handle_unwatch_payment},
+    {"showWebView", arg_list(kShowWebViewArgs), true, handle_show_webview},
+    {"getPlatformVersion", kNoArgs, false, handle_get_platform_version},
+};
+constexpr size_t kPluginMethodCount = sizeof(kPluginMethods) / sizeof(kPluginMethods[0]);
+
+constexpr all_paystack_payments::MethodTable<kPluginMethodCount> kPluginMethodTable(kPluginMethods);
+static_assert(kPluginMethodTable.ok(), "No perfect hash for the method names; raise MethodTable's seed limit");
+
+// A showWebView call waiting for the browser to come back from checkout.
+struct CheckoutWait {
+  uint64_t id;
+  std::string checkout_url;
+  std::string reference;
+  all_paystack_payments::ApiConfig api;
+  all_paystack_payments::CallEngine::Respond respond;
+};
+
 struct _AllPaystackPaymentsPluginPrivate {
-  std::string public_key;
+  all_paystack_payments::ApiConfig api;
+  // Traces the dispatcher, the engine and the client. Declared first so that
+  // it outlives them.
+  all_paystack_payments::Tracer tracer;
+  // Indexed like kPluginMethods. Only updated on the platform thread.
+  all_paystack_payments::MethodStats method_stats[kPluginMethodCount];
+  std::unique_ptr<all_paystack_payments::CallEngine> engine;
+  // Only used on the engine's I/O thread.
+  std::unique_ptr<all_paystack_payments::HttpClient> http_client;
+  // Sends its requests through |http_client|. Only used on the engine's I/O
+  // thread, except for its verification cache, which getPaymentStatus reads
+  // on the platform thread.
+  std::unique_ptr<all_paystack_payments::PaystackClient> client;
+  // Watches references through |client|, on the I/O thread, and sends their
+  // updates on |events|.
+  std::unique_ptr<all_paystack_payments::PaymentPoller> poller;
+  // The all_paystack_payments/events channel; nullptr until registered.
+  FlEventChannel* events = nullptr;
+  // Serves the callback URL of the checkouts getCheckoutUrl starts without
+  // one. Like the members after it, only used on the engine's I/O thread.
+  std::unique_ptr<all_paystack_payments::CallbackListener> callback_listener;
+  // References of those checkouts by authorization URL, oldest first, until
+  // showWebView opens them.
+  std::vector<std::pair<std::string, std::string>> tracked_checkouts;
+  std::vector<CheckoutWait> checkout_waits;
+  uint64_t last_checkout_wait = 0;
+  // Shows checkouts in process instead of the browser once initialize has
+  // asked for it. Only used on the platform thread.
+  std::unique_ptr<all_paystack_payments::CheckoutWindow> checkout_window;
+  // The view of the app, which the checkout window is transient for;
+  // nullptr when running headless.
+  FlView* view = nullptr;
 };
 
 struct _AllPaystackPaymentsPlugin {
@@ -27,36 +195,115 @@ struct _AllPaystackPaymentsPlugin {
 
 G_DEFINE_TYPE_WITH_PRIVATE(AllPaystackPaymentsPlugin, all_paystack_payments_plugin, g_object_get_type())
 
+// Bookkeeping of showWebView's checkouts, on the I/O thread.
+static void track_checkout(AllPaystackPaymentsPluginPrivate* priv, const all_paystack_payments::CheckoutResult& result);
+static std::vector<CheckoutWait> take_checkout_waits(AllPaystackPaymentsPluginPrivate* priv, const std::function<bool(const CheckoutWait&)>& match);
+static void wait_for_checkout(AllPaystackPaymentsPluginPrivate* priv, const std::string& checkout_url, const all_paystack_payments::ApiConfig& api, all_paystack_payments::CallEngine::Respond respond);
+static void complete_checkout(AllPaystackPaymentsPluginPrivate* priv, const std::function<bool(const CheckoutWait&)>& match);
+
+const PluginMethod* plugin_method_from_name(const gchar* name) {
+  size_t index = kPluginMethodTable.Find(name);
+  return index == kPluginMethodTable.kNotFound ? nullptr : &kPluginMethods[index];
+}
+
+static bool fl_value_has_type(FlValue* value, ArgType type) {
+  switch (type) {
+    case ArgType::kString:
+      return fl_value_get_type(value) == FL_VALUE_TYPE_STRING;
+    case ArgType::kInt:
+      return fl_value_get_type(value) == FL_VALUE_TYPE_INT;
+    case ArgType::kBool:
+      return fl_value_get_type(value) == FL_VALUE_TYPE_BOOL;
+    case ArgType::kMap:
+      return fl_value_get_type(value) == FL_VALUE_TYPE_MAP;
+    case ArgType::kStringList:
+      if (fl_value_get_type(value) != FL_VALUE_TYPE_LIST) {
+        return false;
+      }
+      for (size_t i = 0; i < fl_value_get_length(value); i++) {
+        if (fl_value_get_type(fl_value_get_list_value(value, i)) != FL_VALUE_TYPE_STRING) {
+          return false;
+        }
+      }
+      return true;
+  }
+  return false;
+}
+
+FlMethodResponse* check_method_args(const PluginMethod& method, FlValue* args) {
+  const all_paystack_payments::ArgList& specs = method.args;
+  if (specs.size == 0) {
+    return nullptr;
+  }
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    bool has_required = std::any_of(specs.data, specs.data + specs.size, [](const ArgSpec& spec) { return spec.required; });
+    if (!has_required && (args == nullptr || fl_value_get_type(args) == FL_VALUE_TYPE_NULL)) {
+      return nullptr;
+    }
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "Arguments must be a map", nullptr));
+  }
+  for (size_t i = 0; i < specs.size; i++) {
+    const ArgSpec& spec = specs.data[i];
+    FlValue* value = fl_value_lookup_string(args, spec.name);
+    if (value == nullptr || fl_value_get_type(value) == FL_VALUE_TYPE_NULL) {
+      if (!spec.required) {
+        continue;
+      }
+    } else if (fl_value_has_type(value, spec.type)) {
+      continue;
+    }
+    g_autofree gchar* message = g_strdup_printf("%s must be %s", spec.name, all_paystack_payments::arg_type_description(spec.type));
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", message, nullptr));
+  }
+  return nullptr;
+}
+
+// What the spans of |method_call| are traced with: its method and the
+// reference it is about, if any. Empty unless tracing.
+static all_paystack_payments::TraceArgs trace_args(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  all_paystack_payments::TraceArgs args;
+  if (!self->priv->tracer.enabled()) {
+    return args;
+  }
+  args.method = fl_method_call_get_name(method_call);
+  FlValue* call_args = fl_method_call_get_args(method_call);
+  if (call_args != nullptr && fl_value_get_type(call_args) == FL_VALUE_TYPE_MAP) {
+    FlValue* reference = fl_value_lookup_string(call_args, "reference");
+    if (reference != nullptr && fl_value_get_type(reference) == FL_VALUE_TYPE_STRING) {
+      args.reference = fl_value_get_string(reference);
+    }
+  }
+  return args;
+}
+
 // Called when a method call is received from Flutter.
 static void all_paystack_payments_plugin_handle_method_call(
     AllPaystackPaymentsPlugin* self,
     FlMethodCall* method_call) {
+  int64_t start = all_paystack_payments::Tracer::Now();
   g_autoptr(FlMethodResponse) response = nullptr;
 
-  const gchar* method = fl_method_call_get_name(method_call);
-  FlValue* args = fl_method_call_get_args(method_call);
-
-  if (strcmp(method, "initialize") == 0) {
-    response = handle_initialize(self, args);
-  } else if (strcmp(method, "initializePayment") == 0) {
-    response = handle_initialize_payment(self, args);
-  } else if (strcmp(method, "getCheckoutUrl") == 0) {
-    response = handle_get_checkout_url(self, args);
-  } else if (strcmp(method, "verifyPayment") == 0) {
-    response = handle_verify_payment(self, args);
-  } else if (strcmp(method, "getPaymentStatus") == 0) {
-    response = handle_get_payment_status(self, args);
-  } else if (strcmp(method, "cancelPayment") == 0) {
-    response = handle_cancel_payment(self, args);
-  } else if (strcmp(method, "showWebView") == 0) {
-    response = handle_show_webview(self, args);
-  } else if (strcmp(method, "getPlatformVersion") == 0) {
-    response = get_platform_version();
-  } else {
+  const PluginMethod* method = plugin_method_from_name(fl_method_call_get_name(method_call));
+  if (method == nullptr) {
     response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  } else {
+    all_paystack_payments::MethodStats& stats = self->priv->method_stats[method - kPluginMethods];
+    stats.calls.fetch_add(1, std::memory_order_relaxed);
+    response = check_method_args(*method, fl_method_call_get_args(method_call));
+    if (response != nullptr) {
+      stats.invalid_arguments.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      response = method->handler(self, method_call);
+      g_warn_if_fail(response != nullptr || method->async);
+    }
   }
 
-  fl_method_call_respond(method_call, response, nullptr);
+  // Handlers that hand their work to the engine return nullptr and respond
+  // once the worker has finished.
+  if (response != nullptr) {
+    fl_method_call_respond(method_call, response, nullptr);
+  }
+  self->priv->tracer.Span("dispatch", start, all_paystack_payments::Tracer::Now() - start, trace_args(self, method_call));
 }
 
 FlMethodResponse* get_platform_version() {
@@ -67,29 +314,92 @@ FlMethodResponse* get_platform_version() {
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* handle_initialize(AllPaystackPaymentsPlugin* self, FlValue* args) {
-  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "Arguments must be a map", nullptr));
+FlMethodResponse* handle_get_platform_version(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  return get_platform_version();
+}
+
+FlMethodResponse* handle_initialize(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  all_paystack_payments::ApiConfig api;
+  api.public_key = fl_value_get_string(fl_value_lookup_string(args, "publicKey"));
+  FlValue* base_url_value = fl_value_lookup_string(args, "baseUrl");
+  if (base_url_value && fl_value_get_type(base_url_value) == FL_VALUE_TYPE_STRING) {
+    api.base_url = fl_value_get_string(base_url_value);
+    if (!all_paystack_payments::normalize_base_url(&api.base_url)) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "baseUrl must be an http or https URL", nullptr));
+    }
+  }
+  all_paystack_payments::HedgePolicy hedge_policy;
+  FlValue* hedge_value = fl_value_lookup_string(args, "hedgeVerifyPercentile");
+  if (hedge_value && fl_value_get_type(hedge_value) == FL_VALUE_TYPE_INT) {
+    int64_t percentile = fl_value_get_int(hedge_value);
+    if (percentile < kMinHedgePercentile || percentile > kMaxHedgePercentile) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "hedgeVerifyPercentile must be between 50 and 99", nullptr));
+    }
+    hedge_policy.percentile = static_cast<double>(percentile);
   }
-  FlValue* public_key_value = fl_value_lookup_string(args, "publicKey");
-  if (!public_key_value || fl_value_get_type(public_key_value) != FL_VALUE_TYPE_STRING) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "publicKey must be a string", nullptr));
+  // Each endpoint gets a bucket of its own, a second's worth deep.
+  all_paystack_payments::RateLimitPolicy rate_limit_policy;
+  FlValue* rate_value = fl_value_lookup_string(args, "rateLimitPerSecond");
+  if (rate_value && fl_value_get_type(rate_value) == FL_VALUE_TYPE_INT) {
+    int64_t rate = fl_value_get_int(rate_value);
+    if (rate < 1 || rate > kMaxRateLimitPerSecond) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "rateLimitPerSecond must be between 1 and 1000", nullptr));
+    }
+    rate_limit_policy.requests_per_second = static_cast<double>(rate);
+    rate_limit_policy.burst = static_cast<double>(rate);
   }
-  const gchar* public_key = fl_value_get_string(public_key_value);
-  self->priv->public_key = public_key;
+  // Built hidden now, so that the first checkout is shown warm.
+  // A missing or null embeddedCheckout leaves the window as it is.
+  FlValue* embedded_value = fl_value_lookup_string(args, "embeddedCheckout");
+  bool has_embedded = embedded_value && fl_value_get_type(embedded_value) == FL_VALUE_TYPE_BOOL;
+  if (has_embedded && fl_value_get_bool(embedded_value)) {
+    if (!all_paystack_payments::CheckoutWindow::Available()) {
+      g_warning("embeddedCheckout needs the plugin to be built with WebKitGTK; checkouts open in the browser");
+    } else if (!self->priv->checkout_window) {
+      AllPaystackPaymentsPluginPrivate* priv = self->priv;
+      priv->checkout_window = std::make_unique<all_paystack_payments::CheckoutWindow>([priv](const std::string& checkout_url, const std::string& reference) {
+        priv->engine->Post([priv, checkout_url, reference]() {
+          // Closed windows are verified too, to answer with what became of
+          // the payment.
+          if (reference.empty()) {
+            complete_checkout(priv, [&checkout_url](const CheckoutWait& wait) { return wait.checkout_url == checkout_url; });
+          } else {
+            complete_checkout(priv, [&reference](const CheckoutWait& wait) { return wait.reference == reference; });
+          }
+        });
+      });
+      priv->checkout_window->Prewarm();
+    }
+  } else if (has_embedded && self->priv->checkout_window) {
+    // As if the customer closed it, so the call waiting for the checkout
+    // being shown is answered.
+    self->priv->checkout_window->Close();
+    self->priv->checkout_window.reset();
+  }
+  // Cached results belong to the integration the previous key and API
+  // identified.
+  if (self->priv->api.public_key != api.public_key || self->priv->api.base_url != api.base_url) {
+    self->priv->client->verify_cache().Clear();
+  }
+  self->priv->api = std::move(api);
+  // The client is only used on the I/O thread.
+  all_paystack_payments::PaystackClient* client = self->priv->client.get();
+  self->priv->engine->Post([client, hedge_policy, rate_limit_policy]() {
+    client->set_hedge_policy(hedge_policy);
+    client->set_rate_limit_policy(rate_limit_policy);
+  });
   return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
-FlMethodResponse* handle_initialize_payment(AllPaystackPaymentsPlugin* self, FlValue* args) {
+FlMethodResponse* handle_initialize_payment(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
   // For unified webview approach, initializePayment now gets checkout URL and returns it
   // The actual payment processing happens in the webview
-  return handle_get_checkout_url(self, args);
+  return handle_get_checkout_url(self, method_call);
 }
 
-FlMethodResponse* handle_get_checkout_url(AllPaystackPaymentsPlugin* self, FlValue* args) {
-  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "Arguments must be a map", nullptr));
-  }
+FlMethodResponse* handle_get_checkout_url(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
 
   // Extract common fields
   FlValue* amount_value = fl_value_lookup_string(args, "amount");
@@ -97,200 +407,587 @@ FlMethodResponse* handle_get_checkout_url(AllPaystackPaymentsPlugin* self, FlVal
   FlValue* currency_value = fl_value_lookup_string(args, "currency");
   FlValue* reference_value = fl_value_lookup_string(args, "reference");
   FlValue* callback_url_value = fl_value_lookup_string(args, "callbackUrl");
+  if (callback_url_value == nullptr || fl_value_get_type(callback_url_value) != FL_VALUE_TYPE_STRING) {
+    callback_url_value = fl_value_lookup_string(args, "callback_url");
+  }
+  FlValue* return_to_app_value = fl_value_lookup_string(args, "returnToApp");
+  bool return_to_app = return_to_app_value && fl_value_get_type(return_to_app_value) == FL_VALUE_TYPE_BOOL && fl_value_get_bool(return_to_app_value);
   FlValue* metadata_value = fl_value_lookup_string(args, "metadata");
 
-  if (!amount_value || fl_value_get_type(amount_value) != FL_VALUE_TYPE_INT ||
-      !email_value || fl_value_get_type(email_value) != FL_VALUE_TYPE_STRING) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "Missing required arguments: amount, email", nullptr));
+  // Copy everything the request needs out of the FlValue arguments, which
+  // belong to the platform thread.
+  all_paystack_payments::CheckoutRequest request;
+  request.amount = fl_value_get_int(amount_value);
+  request.email = fl_value_get_string(email_value);
+  request.currency = currency_value && fl_value_get_type(currency_value) == FL_VALUE_TYPE_STRING ? fl_value_get_string(currency_value) : "NGN";
+  if (reference_value && fl_value_get_type(reference_value) == FL_VALUE_TYPE_STRING) {
+    request.has_reference = true;
+    request.reference = fl_value_get_string(reference_value);
+  }
+  if (callback_url_value && fl_value_get_type(callback_url_value) == FL_VALUE_TYPE_STRING) {
+    request.has_callback_url = true;
+    request.callback_url = fl_value_get_string(callback_url_value);
   }
 
-  int64_t amount = fl_value_get_int(amount_value);
-  const gchar* email = fl_value_get_string(email_value);
-  const gchar* currency = currency_value && fl_value_get_type(currency_value) == FL_VALUE_TYPE_STRING ? fl_value_get_string(currency_value) : "NGN";
-  const gchar* reference = reference_value && fl_value_get_type(reference_value) == FL_VALUE_TYPE_STRING ? fl_value_get_string(reference_value) : nullptr;
-  const gchar* callback_url = callback_url_value && fl_value_get_type(callback_url_value) == FL_VALUE_TYPE_STRING ? fl_value_get_string(callback_url_value) : nullptr;
+  if (metadata_value && fl_value_get_type(metadata_value) != FL_VALUE_TYPE_NULL) {
+    // Serialized here, on the thread that owns the arguments. The scratch
+    // buffer keeps its capacity between calls, so even large carts only
+    // allocate the copy the request keeps.
+    static thread_local std::string metadata_scratch;
+    metadata_scratch.clear();
+    if (!all_paystack_payments::fl_value_to_json(metadata_value, &metadata_scratch)) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "metadata must be a map of JSON values", nullptr));
+    }
+    request.has_metadata = true;
+    request.metadata_json = metadata_scratch;
+  }
 
-  // Build JSON body
-  nlohmann::json json_body;
-  json_body["amount"] = amount;
-  json_body["email"] = email;
-  if (currency) json_body["currency"] = currency;
-  if (reference) json_body["reference"] = reference;
-  if (callback_url) json_body["callback_url"] = callback_url;
+  all_paystack_payments::ApiConfig api = self->priv->api;
+  AllPaystackPaymentsPluginPrivate* priv = self->priv;
+  self->priv->engine->Submit(method_call, [priv, request = std::move(request), api, return_to_app](all_paystack_payments::CallEngine::Respond respond) mutable {
+    // A checkout the caller will open with showWebView, and that has no
+    // callback URL of its own, comes back to the loopback listener, so that
+    // showWebView learns when the payment ends. Any other checkout keeps
+    // the integration's callback URL: it may be finished on another device.
+    std::string error;
+    if (!return_to_app || request.has_callback_url) {
+      start_get_checkout_url(priv->client.get(), request, api, std::move(respond));
+    } else if (!priv->callback_listener->Start(&error)) {
+      g_warning("Cannot listen for checkout callbacks: %s", error.c_str());
+      start_get_checkout_url(priv->client.get(), request, api, std::move(respond));
+    } else {
+      request.has_callback_url = true;
+      request.callback_url = priv->callback_listener->url();
+      start_get_checkout_url(priv->client.get(), request, api, std::move(respond), [priv](const all_paystack_payments::CheckoutResult& result) {
+        if (result.ok()) {
+          track_checkout(priv, result);
+        }
+      });
+    }
+  }, trace_args(self, method_call));
+  return nullptr;
+}
 
-  // Add metadata if present (simplified)
-  if (metadata_value && fl_value_get_type(metadata_value) == FL_VALUE_TYPE_MAP) {
-    // For simplicity, we'll skip complex metadata parsing for now
-  }
+void start_get_checkout_url(all_paystack_payments::PaystackClient* client, const all_paystack_payments::CheckoutRequest& request, const all_paystack_payments::ApiConfig& api, all_paystack_payments::CallEngine::Respond respond, std::function<void(const all_paystack_payments::CheckoutResult&)> on_result) {
+  client->InitializeTransaction(request, api, [client, respond, on_result](const all_paystack_payments::CheckoutResult& result) {
+    if (on_result) {
+      on_result(result);
+    }
+    gint64 start = g_get_monotonic_time();
+    FlMethodResponse* response = make_checkout_response(result);
+    client->metrics().Record(all_paystack_payments::Endpoint::kInitialize, all_paystack_payments::Phase::kBuild, g_get_monotonic_time() - start);
+    respond(response);
+  });
+}
 
-  std::string json_str = json_body.dump();
-  std::string response = make_http_post_request("https://api.paystack.co/transaction/initialize", json_str, self->priv->public_key);
+FlMethodResponse* parse_checkout_response(const all_paystack_payments::HttpResponse& http_response) {
+  all_paystack_payments::CheckoutResponseParser parser;
+  parser.Feed(http_response.body.data(), http_response.body.size());
+  return make_checkout_response(parser.Finish(http_response));
+}
 
-  if (response.empty()) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("HTTP_ERROR", "Failed to make HTTP request", nullptr));
+FlMethodResponse* make_checkout_response(const all_paystack_payments::CheckoutResult& checkout_result) {
+  if (!checkout_result.ok()) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(checkout_result.error_code.c_str(), checkout_result.error_message.c_str(), nullptr));
   }
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "status", fl_value_new_string("success"));
 
-  try {
-    nlohmann::json json_response = nlohmann::json::parse(response);
-    if (json_response["status"].get<bool>()) {
-      nlohmann::json data = json_response["data"];
-      std::string checkout_url = data["authorization_url"].get<std::string>();
-      std::string ref = data["reference"].get<std::string>();
+  FlValue* data_map = fl_value_new_map();
+  fl_value_set_string_take(data_map, "authorization_url", fl_value_new_string(checkout_result.authorization_url.c_str()));
+  fl_value_set_string_take(data_map, "reference", fl_value_new_string(checkout_result.reference.c_str()));
+  fl_value_set_string_take(result, "data", data_map);
 
-      g_autoptr(FlValue) result = fl_value_new_map();
-      fl_value_set(result, fl_value_new_string("status"), fl_value_new_string("success"));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
 
-      g_autoptr(FlValue) data_map = fl_value_new_map();
-      fl_value_set(data_map, fl_value_new_string("authorization_url"), fl_value_new_string(checkout_url.c_str()));
-      fl_value_set(data_map, fl_value_new_string("reference"), fl_value_new_string(ref.c_str()));
-      fl_value_set(result, fl_value_new_string("data"), data_map);
+FlMethodResponse* handle_verify_payment(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  std::string reference = fl_value_get_string(fl_value_lookup_string(args, "reference"));
+  std::vector<std::string> fields;
+  read_verify_fields(args, &fields);
+  all_paystack_payments::ApiConfig api = self->priv->api;
+  all_paystack_payments::PaystackClient* client = self->priv->client.get();
+  self->priv->engine->Submit(method_call, [client, reference, fields, api](all_paystack_payments::CallEngine::Respond respond) {
+    start_verify_payment(client, reference, fields, api, std::move(respond));
+  }, trace_args(self, method_call));
+  return nullptr;
+}
 
-      return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
-    } else {
-      return FL_METHOD_RESPONSE(fl_method_error_response_new("API_ERROR", json_response["message"].get<std::string>().c_str(), nullptr));
+bool read_verify_fields(FlValue* args, std::vector<std::string>* fields) {
+  FlValue* fields_value = fl_value_lookup_string(args, "fields");
+  if (fields_value == nullptr || fl_value_get_type(fields_value) == FL_VALUE_TYPE_NULL) {
+    return true;
+  }
+  if (fl_value_get_type(fields_value) != FL_VALUE_TYPE_LIST) {
+    return false;
+  }
+  for (size_t i = 0; i < fl_value_get_length(fields_value); i++) {
+    FlValue* field_value = fl_value_get_list_value(fields_value, i);
+    if (fl_value_get_type(field_value) != FL_VALUE_TYPE_STRING) {
+      return false;
     }
-  } catch (const std::exception& e) {
+    fields->push_back(fl_value_get_string(field_value));
+  }
+  return true;
+}
+
+void start_verify_payment(all_paystack_payments::PaystackClient* client, const std::string& reference, const std::vector<std::string>& fields, const all_paystack_payments::ApiConfig& api, all_paystack_payments::CallEngine::Respond respond) {
+  client->VerifyTransaction(reference, api, [client, fields, respond](const all_paystack_payments::VerifyResult& result) {
+    gint64 start = g_get_monotonic_time();
+    FlMethodResponse* response = make_verify_response(result, fields);
+    client->metrics().Record(all_paystack_payments::Endpoint::kVerify, all_paystack_payments::Phase::kBuild, g_get_monotonic_time() - start);
+    respond(response);
+  });
+}
+
+FlMethodResponse* parse_verify_response(const all_paystack_payments::HttpResponse& http_response) {
+  return make_verify_response(parse_verify_result(http_response));
+}
+
+all_paystack_payments::VerifyResult parse_verify_result(const all_paystack_payments::HttpResponse& http_response) {
+  all_paystack_payments::VerifyResponseParser parser;
+  parser.Feed(http_response.body.data(), http_response.body.size());
+  return parser.Finish(http_response);
+}
+
+FlMethodResponse* make_verify_response(const all_paystack_payments::VerifyResult& verify_result, const std::vector<std::string>& fields) {
+  if (!verify_result.ok()) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(verify_result.error_code.c_str(), verify_result.error_message.c_str(), nullptr));
+  }
+  // Pass the whole data object through, or the projected part of it.
+  std::vector<std::string> projection;
+  if (!fields.empty()) {
+    projection = fields;
+    projection.insert(projection.end(), std::begin(kVerifyCoreFields), std::end(kVerifyCoreFields));
+  }
+  g_autoptr(FlValue) result = all_paystack_payments::json_to_fl_value(verify_result.data_json.data(), verify_result.data_json.size(), projection);
+  if (result == nullptr || fl_value_get_type(result) != FL_VALUE_TYPE_MAP) {
     return FL_METHOD_RESPONSE(fl_method_error_response_new("PARSE_ERROR", "Failed to parse API response", nullptr));
   }
+  // Paystack's channel names match the payment methods the Dart side knows.
+  const char* payment_method = verify_result.channel.empty() ? "card" : verify_result.channel.c_str();
+  fl_value_set_string_take(result, "payment_method", fl_value_new_string(payment_method));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* handle_verify_payment(AllPaystackPaymentsPlugin* self, FlValue* args) {
-  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "Arguments must be a map", nullptr));
+FlMethodResponse* handle_verify_payments(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  FlValue* references_value = fl_value_lookup_string(args, "references");
+  std::vector<std::string> references;
+  references.reserve(fl_value_get_length(references_value));
+  for (size_t i = 0; i < fl_value_get_length(references_value); i++) {
+    references.push_back(fl_value_get_string(fl_value_get_list_value(references_value, i)));
   }
-  FlValue* reference_value = fl_value_lookup_string(args, "reference");
-  if (!reference_value || fl_value_get_type(reference_value) != FL_VALUE_TYPE_STRING) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "reference must be a string", nullptr));
-  }
-  const gchar* reference = fl_value_get_string(reference_value);
-  std::string url = "https://api.paystack.co/transaction/verify/" + std::string(reference);
-  std::string response = make_http_request(url, self->priv->public_key);
-  if (response.empty()) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("HTTP_ERROR", "Failed to make HTTP request", nullptr));
-  }
-  try {
-    nlohmann::json json_response = nlohmann::json::parse(response);
-    if (json_response["status"].get<bool>()) {
-      nlohmann::json data = json_response["data"];
-      g_autoptr(FlValue) result = fl_value_new_map();
-      fl_value_set(result, fl_value_new_string("reference"), fl_value_new_string(data["reference"].get<std::string>().c_str()));
-      fl_value_set(result, fl_value_new_string("status"), fl_value_new_string(data["status"].get<std::string>().c_str()));
-      fl_value_set(result, fl_value_new_string("amount"), fl_value_new_int(data["amount"].get<int>()));
-      fl_value_set(result, fl_value_new_string("currency"), fl_value_new_string(data["currency"].get<std::string>().c_str()));
-      fl_value_set(result, fl_value_new_string("payment_method"), fl_value_new_string("card")); // default
-      if (data.contains("gateway_response")) {
-        fl_value_set(result, fl_value_new_string("gateway_response"), fl_value_new_string(data["gateway_response"].get<std::string>().c_str()));
-      }
-      return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
-    } else {
-      return FL_METHOD_RESPONSE(fl_method_error_response_new("API_ERROR", json_response["message"].get<std::string>().c_str(), nullptr));
+  std::vector<std::string> fields;
+  read_verify_fields(args, &fields);
+  int64_t max_concurrency = kDefaultBatchConcurrency;
+  FlValue* max_concurrency_value = fl_value_lookup_string(args, "maxConcurrency");
+  if (max_concurrency_value && fl_value_get_type(max_concurrency_value) == FL_VALUE_TYPE_INT) {
+    max_concurrency = std::max<int64_t>(1, std::min(fl_value_get_int(max_concurrency_value), kMaxBatchConcurrency));
+  }
+
+  all_paystack_payments::ApiConfig api = self->priv->api;
+  all_paystack_payments::PaystackClient* client = self->priv->client.get();
+  self->priv->engine->Submit(method_call, [client, references, fields, max_concurrency, api](all_paystack_payments::CallEngine::Respond respond) {
+    start_verify_payments(client, references, fields, static_cast<size_t>(max_concurrency), api, std::move(respond));
+  }, trace_args(self, method_call));
+  return nullptr;
+}
+
+FlValue* make_batch_entry(const std::string& reference, FlMethodResponse* response) {
+  FlValue* entry = fl_value_new_map();
+  fl_value_set_string_take(entry, "reference", fl_value_new_string(reference.c_str()));
+  if (FL_IS_METHOD_SUCCESS_RESPONSE(response)) {
+    FlValue* result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response));
+    fl_value_set_string_take(entry, "success", fl_value_new_bool(true));
+    fl_value_set_string(entry, "data", result);
+  } else {
+    FlMethodErrorResponse* error = FL_METHOD_ERROR_RESPONSE(response);
+    const gchar* message = fl_method_error_response_get_message(error);
+    fl_value_set_string_take(entry, "success", fl_value_new_bool(false));
+    fl_value_set_string_take(entry, "code", fl_value_new_string(fl_method_error_response_get_code(error)));
+    fl_value_set_string_take(entry, "message", fl_value_new_string(message != nullptr ? message : ""));
+  }
+  return entry;
+}
+
+void start_verify_payments(all_paystack_payments::PaystackClient* client, const std::vector<std::string>& references, const std::vector<std::string>& fields, size_t max_concurrency, const all_paystack_payments::ApiConfig& api, all_paystack_payments::CallEngine::Respond respond) {
+  client->VerifyTransactions(references, max_concurrency, api, [client, references, fields, respond](const std::vector<all_paystack_payments::VerifyResult>& results) {
+    g_autoptr(FlValue) result = fl_value_new_list();
+    for (size_t i = 0; i < results.size(); i++) {
+      gint64 start = g_get_monotonic_time();
+      g_autoptr(FlMethodResponse) response = make_verify_response(results[i], fields);
+      fl_value_append_take(result, make_batch_entry(references[i], response));
+      client->metrics().Record(all_paystack_payments::Endpoint::kVerify, all_paystack_payments::Phase::kBuild, g_get_monotonic_time() - start);
     }
-  } catch (const std::exception& e) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("PARSE_ERROR", "Failed to parse API response", nullptr));
+    respond(FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+  });
+}
+
+FlMethodResponse* handle_get_payment_status(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  // Answer from the cache when possible; otherwise this is a verify, which
+  // refreshes the cache.
+  FlValue* args = fl_method_call_get_args(method_call);
+  all_paystack_payments::VerifyResult cached;
+  if (self->priv->client->verify_cache().Get(fl_value_get_string(fl_value_lookup_string(args, "reference")), &cached)) {
+    std::vector<std::string> fields;
+    read_verify_fields(args, &fields);
+    return make_verify_response(cached, fields);
   }
+  return handle_verify_payment(self, method_call);
 }
 
-FlMethodResponse* handle_get_payment_status(AllPaystackPaymentsPlugin* self, FlValue* args) {
-  // Same as verify for now
-  return handle_verify_payment(self, args);
+FlMethodResponse* handle_invalidate_verification_cache(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  FlValue* reference_value = nullptr;
+  if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP) {
+    reference_value = fl_value_lookup_string(args, "reference");
+  }
+  if (reference_value == nullptr || fl_value_get_type(reference_value) == FL_VALUE_TYPE_NULL) {
+    self->priv->client->verify_cache().Clear();
+  } else {
+    self->priv->client->verify_cache().Invalidate(fl_value_get_string(reference_value));
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
 }
 
-FlMethodResponse* handle_cancel_payment(AllPaystackPaymentsPlugin* self, FlValue* args) {
-  g_autoptr(FlValue) result = fl_value_new_bool(false);
+FlMethodResponse* handle_get_verification_cache_stats(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  all_paystack_payments::VerifyCache::Stats stats = self->priv->client->verify_cache().stats();
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "hits", fl_value_new_int(static_cast<int64_t>(stats.hits)));
+  fl_value_set_string_take(result, "misses", fl_value_new_int(static_cast<int64_t>(stats.misses)));
+  fl_value_set_string_take(result, "size", fl_value_new_int(static_cast<int64_t>(stats.size)));
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-FlMethodResponse* handle_show_webview(AllPaystackPaymentsPlugin* self, FlValue* args) {
-  if (fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "Arguments must be a map", nullptr));
+FlValue* metrics_to_fl_value(all_paystack_payments::ClientMetrics& metrics) {
+  FlValue* result = fl_value_new_map();
+  for (size_t i = 0; i < all_paystack_payments::kEndpointCount; i++) {
+    auto endpoint = static_cast<all_paystack_payments::Endpoint>(i);
+    all_paystack_payments::EndpointMetrics& endpoint_metrics = metrics.endpoint(endpoint);
+    FlValue* endpoint_value = fl_value_new_map();
+    fl_value_set_string_take(endpoint_value, "requests", fl_value_new_int(static_cast<int64_t>(endpoint_metrics.requests.load(std::memory_order_relaxed))));
+    FlValue* errors = fl_value_new_map();
+    for (size_t code = 0; code < all_paystack_payments::kMetricErrorCodeCount; code++) {
+      fl_value_set_string_take(errors, all_paystack_payments::kMetricErrorCodes[code], fl_value_new_int(static_cast<int64_t>(endpoint_metrics.errors[code].load(std::memory_order_relaxed))));
+    }
+    fl_value_set_string_take(endpoint_value, "errors", errors);
+    fl_value_set_string_take(endpoint_value, "retries", fl_value_new_int(static_cast<int64_t>(endpoint_metrics.retries.load(std::memory_order_relaxed))));
+    fl_value_set_string_take(endpoint_value, "throttledRetries", fl_value_new_int(static_cast<int64_t>(endpoint_metrics.throttled_retries.load(std::memory_order_relaxed))));
+    fl_value_set_string_take(endpoint_value, "hedges", fl_value_new_int(static_cast<int64_t>(endpoint_metrics.hedges.load(std::memory_order_relaxed))));
+    fl_value_set_string_take(endpoint_value, "hedgesWon", fl_value_new_int(static_cast<int64_t>(endpoint_metrics.hedges_won.load(std::memory_order_relaxed))));
+    fl_value_set_string_take(endpoint_value, "rateLimited", fl_value_new_int(static_cast<int64_t>(endpoint_metrics.rate_limited.load(std::memory_order_relaxed))));
+    FlValue* phases = fl_value_new_map();
+    for (size_t phase = 0; phase < all_paystack_payments::kPhaseCount; phase++) {
+      all_paystack_payments::LatencySummary summary = endpoint_metrics.phases[phase].Summarize();
+      FlValue* summary_value = fl_value_new_map();
+      fl_value_set_string_take(summary_value, "count", fl_value_new_int(static_cast<int64_t>(summary.count)));
+      fl_value_set_string_take(summary_value, "p50", fl_value_new_int(summary.p50));
+      fl_value_set_string_take(summary_value, "p90", fl_value_new_int(summary.p90));
+      fl_value_set_string_take(summary_value, "p99", fl_value_new_int(summary.p99));
+      fl_value_set_string_take(summary_value, "p999", fl_value_new_int(summary.p999));
+      fl_value_set_string_take(summary_value, "max", fl_value_new_int(summary.max));
+      fl_value_set_string_take(phases, all_paystack_payments::phase_name(static_cast<all_paystack_payments::Phase>(phase)), summary_value);
+    }
+    fl_value_set_string_take(endpoint_value, "phases", phases);
+    fl_value_set_string_take(result, all_paystack_payments::endpoint_name(endpoint), endpoint_value);
   }
+  return result;
+}
 
-  FlValue* checkout_url_value = fl_value_lookup_string(args, "checkoutUrl");
-  if (!checkout_url_value || fl_value_get_type(checkout_url_value) != FL_VALUE_TYPE_STRING) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "checkoutUrl must be a string", nullptr));
+FlMethodResponse* handle_get_metrics(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  g_autoptr(FlValue) result = metrics_to_fl_value(self->priv->client->metrics());
+  FlValue* methods = fl_value_new_map();
+  for (size_t i = 0; i < kPluginMethodCount; i++) {
+    const all_paystack_payments::MethodStats& stats = self->priv->method_stats[i];
+    FlValue* method = fl_value_new_map();
+    fl_value_set_string_take(method, "calls", fl_value_new_int(static_cast<int64_t>(stats.calls.load(std::memory_order_relaxed))));
+    fl_value_set_string_take(method, "invalidArguments", fl_value_new_int(static_cast<int64_t>(stats.invalid_arguments.load(std::memory_order_relaxed))));
+    fl_value_set_string_take(methods, kPluginMethods[i].name, method);
   }
+  fl_value_set_string_take(result, "methods", methods);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
 
-  const gchar* checkout_url = fl_value_get_string(checkout_url_value);
+FlValue* transport_stats_to_fl_value(const all_paystack_payments::PaystackClient& client) {
+  FlValue* result = fl_value_new_map();
+  FlValue* circuits = fl_value_new_map();
+  FlValue* rate_limits = fl_value_new_map();
+  for (size_t i = 0; i < all_paystack_payments::kEndpointCount; i++) {
+    auto endpoint = static_cast<all_paystack_payments::Endpoint>(i);
+    const all_paystack_payments::CircuitBreaker& breaker = client.circuit_breaker(endpoint);
+    FlValue* circuit = fl_value_new_map();
+    fl_value_set_string_take(circuit, "state", fl_value_new_string(all_paystack_payments::circuit_state_name(breaker.state())));
+    fl_value_set_string_take(circuit, "consecutiveFailures", fl_value_new_int(breaker.consecutive_failures()));
+    fl_value_set_string_take(circuit, "rejected", fl_value_new_int(static_cast<int64_t>(breaker.rejected())));
+    fl_value_set_string_take(circuits, all_paystack_payments::endpoint_name(endpoint), circuit);
+    FlValue* rate_limit = fl_value_new_map();
+    fl_value_set_string_take(rate_limit, "waiting", fl_value_new_int(static_cast<int64_t>(client.rate_limited(endpoint))));
+    fl_value_set_string_take(rate_limit, "expired", fl_value_new_int(static_cast<int64_t>(client.rate_limit_expired(endpoint))));
+    fl_value_set_string_take(rate_limits, all_paystack_payments::endpoint_name(endpoint), rate_limit);
+  }
+  fl_value_set_string_take(result, "circuits", circuits);
+  const all_paystack_payments::ConcurrencyLimiter& limiter = client.concurrency_limiter();
+  FlValue* limiter_value = fl_value_new_map();
+  fl_value_set_string_take(limiter_value, "limit", fl_value_new_int(limiter.limit()));
+  fl_value_set_string_take(limiter_value, "inFlight", fl_value_new_int(limiter.in_flight()));
+  fl_value_set_string_take(limiter_value, "queued", fl_value_new_int(static_cast<int64_t>(client.queued())));
+  fl_value_set_string_take(result, "limiter", limiter_value);
+  fl_value_set_string_take(result, "rateLimits", rate_limits);
+  return result;
+}
 
-  // For Linux, try to open the URL in the default browser
-  // Using xdg-open or similar
-  std::string command = "xdg-open '" + std::string(checkout_url) + "' 2>/dev/null &";
-  int result_code = system(command.c_str());
+FlMethodResponse* handle_get_transport_stats(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  // The circuits and the limiters are only used on the I/O thread, so they
+  // are read there.
+  all_paystack_payments::PaystackClient* client = self->priv->client.get();
+  self->priv->engine->Submit(method_call, [client](all_paystack_payments::CallEngine::Respond respond) {
+    g_autoptr(FlValue) result = transport_stats_to_fl_value(*client);
+    respond(FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+  }, trace_args(self, method_call));
+  return nullptr;
+}
 
-  if (result_code != 0) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("BROWSER_ERROR", "Failed to open browser", nullptr));
+FlMethodResponse* handle_start_tracing(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  const gchar* path = fl_value_get_string(fl_value_lookup_string(fl_method_call_get_args(method_call), "path"));
+  std::string error;
+  if (!self->priv->tracer.Start(path, &error)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("TRACE_ERROR", error.c_str(), nullptr));
   }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
 
-  // Return a simulated response
-  g_autoptr(FlValue) result = fl_value_new_map();
-  fl_value_set(result, fl_value_new_string("status"), fl_value_new_string("success"));
-  fl_value_set(result, fl_value_new_string("message"), fl_value_new_string("Payment completed"));
+FlMethodResponse* handle_stop_tracing(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  self->priv->tracer.Stop();
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+FlMethodResponse* handle_cancel_payment(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  std::string reference = fl_value_get_string(fl_value_lookup_string(fl_method_call_get_args(method_call), "reference"));
+  // Aborts the calls about the reference on the I/O thread, which answers
+  // them with CANCELLED before this call is answered.
+  // A showWebView call waiting for the checkout is answered with CANCELLED
+  // too.
+  AllPaystackPaymentsPluginPrivate* priv = self->priv;
+  self->priv->engine->Submit(method_call, [priv, reference](all_paystack_payments::CallEngine::Respond respond) {
+    bool cancelled = priv->client->Cancel(reference);
+    for (CheckoutWait& wait : take_checkout_waits(priv, [&reference](const CheckoutWait& wait) { return wait.reference == reference; })) {
+      wait.respond(FL_METHOD_RESPONSE(fl_method_error_response_new(all_paystack_payments::kCancelledError, "Payment was cancelled", nullptr)));
+      cancelled = true;
+    }
+    g_autoptr(FlValue) result = fl_value_new_bool(cancelled);
+    respond(FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+  }, trace_args(self, method_call));
+  return nullptr;
+}
+
+FlMethodResponse* handle_watch_payment(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  std::string reference = fl_value_get_string(fl_value_lookup_string(args, "reference"));
+  all_paystack_payments::PollPolicy policy;
+  FlValue* timeout_value = fl_value_lookup_string(args, "timeoutMs");
+  if (timeout_value && fl_value_get_type(timeout_value) == FL_VALUE_TYPE_INT) {
+    policy.timeout_ms = fl_value_get_int(timeout_value);
+    if (policy.timeout_ms < 1 || policy.timeout_ms > kMaxWatchTimeoutMs) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID_ARGUMENTS", "timeoutMs must be between 1 and 86400000", nullptr));
+    }
+  }
+  all_paystack_payments::ApiConfig api = self->priv->api;
+  all_paystack_payments::PaymentPoller* poller = self->priv->poller.get();
+  self->priv->engine->Submit(method_call, [poller, reference, api, policy](all_paystack_payments::CallEngine::Respond respond) {
+    poller->Watch(reference, api, policy);
+    g_autoptr(FlValue) result = fl_value_new_bool(true);
+    respond(FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+  }, trace_args(self, method_call));
+  return nullptr;
+}
+
+FlMethodResponse* handle_unwatch_payment(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  std::string reference = fl_value_get_string(fl_value_lookup_string(fl_method_call_get_args(method_call), "reference"));
+  all_paystack_payments::PaymentPoller* poller = self->priv->poller.get();
+  self->priv->engine->Submit(method_call, [poller, reference](all_paystack_payments::CallEngine::Respond respond) {
+    g_autoptr(FlValue) result = fl_value_new_bool(poller->Unwatch(reference));
+    respond(FL_METHOD_RESPONSE(fl_method_success_response_new(result)));
+  }, trace_args(self, method_call));
+  return nullptr;
+}
+
+FlValue* payment_status_update_to_fl_value(const all_paystack_payments::PaymentStatusUpdate& update) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "reference", fl_value_new_string(update.reference.c_str()));
+  fl_value_set_string_take(value, "status", fl_value_new_string(update.status.c_str()));
+  fl_value_set_string_take(value, "final", fl_value_new_bool(update.final));
+  fl_value_set_string_take(value, "timedOut", fl_value_new_bool(update.timed_out));
+  return value;
+}
+
+FlMethodResponse* handle_show_webview(AllPaystackPaymentsPlugin* self, FlMethodCall* method_call) {
+  FlValue* args = fl_method_call_get_args(method_call);
+  std::string checkout_url = fl_value_get_string(fl_value_lookup_string(args, "checkoutUrl"));
+  AllPaystackPaymentsPluginPrivate* priv = self->priv;
+
+  bool shown = false;
+  if (priv->checkout_window) {
+    GtkWindow* parent = nullptr;
+    if (priv->view != nullptr) {
+      GtkWidget* toplevel = gtk_widget_get_toplevel(GTK_WIDGET(priv->view));
+      parent = GTK_IS_WINDOW(toplevel) ? GTK_WINDOW(toplevel) : nullptr;
+    }
+    shown = priv->checkout_window->Show(checkout_url, parent);
+  }
+  if (!shown) {
+    // Open the default browser, without a shell in between.
+    gchar* argv[] = {const_cast<gchar*>("xdg-open"), const_cast<gchar*>(checkout_url.c_str()), nullptr};
+    if (!g_spawn_async(nullptr, argv, nullptr, G_SPAWN_SEARCH_PATH, nullptr, nullptr, nullptr, nullptr)) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("BROWSER_ERROR", "Failed to open browser", nullptr));
+    }
+  }
+
+  // The checkout window reports back through the I/O thread after this
+  // wait, and the browser takes far longer to load checkout than the wait
+  // takes to start, so neither can come back before it does.
+  all_paystack_payments::ApiConfig api = priv->api;
+  self->priv->engine->Submit(method_call, [priv, checkout_url, api](all_paystack_payments::CallEngine::Respond respond) {
+    wait_for_checkout(priv, checkout_url, api, std::move(respond));
+  }, trace_args(self, method_call));
+  return nullptr;
+}
+
+static void track_checkout(AllPaystackPaymentsPluginPrivate* priv, const all_paystack_payments::CheckoutResult& result) {
+  if (priv->tracked_checkouts.size() >= kMaxTrackedCheckouts) {
+    priv->tracked_checkouts.erase(priv->tracked_checkouts.begin());
+  }
+  priv->tracked_checkouts.emplace_back(result.authorization_url, result.reference);
+}
+
+static std::vector<CheckoutWait> take_checkout_waits(AllPaystackPaymentsPluginPrivate* priv, const std::function<bool(const CheckoutWait&)>& match) {
+  std::vector<CheckoutWait> taken;
+  auto kept = std::stable_partition(priv->checkout_waits.begin(), priv->checkout_waits.end(), [&match](const CheckoutWait& wait) { return !match(wait); });
+  std::move(kept, priv->checkout_waits.end(), std::back_inserter(taken));
+  priv->checkout_waits.erase(kept, priv->checkout_waits.end());
+  return taken;
+}
 
-  g_autoptr(FlValue) data_map = fl_value_new_map();
-  std::string ref = "linux_browser_ref_" + std::to_string(std::time(nullptr));
-  fl_value_set(data_map, fl_value_new_string("reference"), fl_value_new_string(ref.c_str()));
-  fl_value_set(data_map, fl_value_new_string("status"), fl_value_new_string("success"));
-  fl_value_set(result, fl_value_new_string("data"), data_map);
+static void wait_for_checkout(AllPaystackPaymentsPluginPrivate* priv, const std::string& checkout_url, const all_paystack_payments::ApiConfig& api, all_paystack_payments::CallEngine::Respond respond) {
+  auto tracked = std::find_if(priv->tracked_checkouts.begin(), priv->tracked_checkouts.end(), [&checkout_url](const std::pair<std::string, std::string>& checkout) { return checkout.first == checkout_url; });
+  if (tracked == priv->tracked_checkouts.end()) {
+    // Its callback URL is not the listener's, so nothing tells when it ends.
+    respond(make_checkout_opened_response());
+    return;
+  }
+  uint64_t id = ++priv->last_checkout_wait;
+  priv->checkout_waits.push_back({id, checkout_url, tracked->second, api, std::move(respond)});
+  priv->tracked_checkouts.erase(tracked);
+  priv->http_client->RunAfter(kCheckoutWaitMs, [priv, id](bool cancelled) {
+    if (cancelled) {
+      return;
+    }
+    for (CheckoutWait& wait : take_checkout_waits(priv, [id](const CheckoutWait& wait) { return wait.id == id; })) {
+      wait.respond(FL_METHOD_RESPONSE(fl_method_error_response_new("PAYMENT_TIMEOUT", "Payment timeout - user took too long to complete payment", nullptr)));
+    }
+  });
+}
+
+static void complete_checkout(AllPaystackPaymentsPluginPrivate* priv, const std::function<bool(const CheckoutWait&)>& match) {
+  auto waits = std::make_shared<std::vector<CheckoutWait>>(take_checkout_waits(priv, match));
+  if (waits->empty()) {
+    // Reloaded, or not opened through showWebView.
+    return;
+  }
+  // One verification answers every call waiting for the checkout.
+  priv->client->VerifyTransaction(waits->front().reference, waits->front().api, [waits](const all_paystack_payments::VerifyResult& result) {
+    for (CheckoutWait& wait : *waits) {
+      wait.respond(make_checkout_completed_response(result));
+    }
+  });
+}
 
+FlMethodResponse* make_checkout_completed_response(const all_paystack_payments::VerifyResult& verify_result) {
+  g_autoptr(FlMethodResponse) verified = make_verify_response(verify_result);
+  if (!verify_result.ok() || !FL_IS_METHOD_SUCCESS_RESPONSE(verified)) {
+    return FL_METHOD_RESPONSE(g_steal_pointer(&verified));
+  }
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "status", fl_value_new_string("success"));
+  fl_value_set_string(result, "data", fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(verified)));
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-std::string make_http_post_request(const std::string& url, const std::string& json_body, const std::string& public_key) {
-  CURL* curl = curl_easy_init();
-  if (!curl) return "";
-  std::string response;
-  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(curl, CURLOPT_POST, 1L);
-  curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_body.c_str());
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-  struct curl_slist* headers = nullptr;
-  std::string auth_header = "Authorization: Bearer " + public_key;
-  headers = curl_slist_append(headers, "Content-Type: application/json");
-  headers = curl_slist_append(headers, auth_header.c_str());
-  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-  CURLcode res = curl_easy_perform(curl);
-  curl_slist_free_all(headers);
-  curl_easy_cleanup(curl);
-  if (res != CURLE_OK) return "";
-  return response;
-}
-
-std::string make_http_request(const std::string& url, const std::string& public_key) {
-  CURL* curl = curl_easy_init();
-  if (!curl) return "";
-  std::string response;
-  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-  struct curl_slist* headers = nullptr;
-  std::string auth_header = "Authorization: Bearer " + public_key;
-  headers = curl_slist_append(headers, auth_header.c_str());
-  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-  CURLcode res = curl_easy_perform(curl);
-  curl_slist_free_all(headers);
-  curl_easy_cleanup(curl);
-  if (res != CURLE_OK) return "";
-  return response;
-}
-
-size_t write_callback(void* contents, size_t size, size_t nmemb, std::string* response) {
-  size_t total_size = size * nmemb;
-  response->append((char*)contents, total_size);
-  return total_size;
+FlMethodResponse* make_checkout_opened_response() {
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "status", fl_value_new_string("success"));
+  FlValue* data_map = fl_value_new_map();
+  fl_value_set_string_take(data_map, "status", fl_value_new_string("pending"));
+  fl_value_set_string_take(data_map, "message", fl_value_new_string("Checkout opened in the browser; verify the payment to learn its outcome"));
+  fl_value_set_string_take(result, "data", data_map);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
 static void all_paystack_payments_plugin_dispose(GObject* object) {
+  AllPaystackPaymentsPlugin* self = ALL_PAYSTACK_PAYMENTS_PLUGIN(object);
+  // Destroying the checkout window does not report the checkout it shows;
+  // the call waiting for it is answered with the others below.
+  self->priv->checkout_window.reset();
+  // Give the calls in flight a bounded time to finish, then stop the I/O
+  // thread so the client can be torn down here. Aborted and never-started
+  // requests are still answered with an error.
+  if (self->priv->engine) {
+    all_paystack_payments::PaystackClient* client = self->priv->client.get();
+    if (!self->priv->engine->Drain(kDisposeDrainMs, [client]() { return client->pending_calls() == 0; })) {
+      g_debug("Aborting Paystack calls still in flight after %" G_GINT64_FORMAT " ms", kDisposeDrainMs);
+    }
+    self->priv->engine->Shutdown();
+  }
+  // Dropping the waiting showWebView calls answers them with an error.
+  self->priv->checkout_waits.clear();
+  // Frees the browser connections it was serving on the stopped I/O thread.
+  self->priv->callback_listener.reset();
+  // Aborting the remaining transfers completes them through the client and
+  // the poller.
+  self->priv->http_client.reset();
+  self->priv->poller.reset();
+  self->priv->client.reset();
+  self->priv->engine.reset();
+  g_clear_object(&self->priv->events);
   G_OBJECT_CLASS(all_paystack_payments_plugin_parent_class)->dispose(object);
 }
 
+static void all_paystack_payments_plugin_finalize(GObject* object) {
+  AllPaystackPaymentsPlugin* self = ALL_PAYSTACK_PAYMENTS_PLUGIN(object);
+  self->priv->~AllPaystackPaymentsPluginPrivate();
+  G_OBJECT_CLASS(all_paystack_payments_plugin_parent_class)->finalize(object);
+}
+
 static void all_paystack_payments_plugin_class_init(AllPaystackPaymentsPluginClass* klass) {
   G_OBJECT_CLASS(klass)->dispose = all_paystack_payments_plugin_dispose;
+  G_OBJECT_CLASS(klass)->finalize = all_paystack_payments_plugin_finalize;
 }
 
 static void all_paystack_payments_plugin_init(AllPaystackPaymentsPlugin* self) {
   self->priv = static_cast<AllPaystackPaymentsPluginPrivate*>(
       all_paystack_payments_plugin_get_instance_private(self));
+  // GObject only zero-fills the private struct, so construct its C++ members.
+  new (self->priv) AllPaystackPaymentsPluginPrivate();
+  self->priv->engine = std::make_unique<all_paystack_payments::CallEngine>();
+  self->priv->engine->set_tracer(&self->priv->tracer);
+  self->priv->http_client = std::make_unique<all_paystack_payments::HttpClient>(
+      self->priv->engine->io_context());
+  self->priv->client = std::make_unique<all_paystack_payments::PaystackClient>(
+      self->priv->http_client.get());
+  self->priv->client->set_tracer(&self->priv->tracer);
+  AllPaystackPaymentsPluginPrivate* priv = self->priv;
+  priv->callback_listener = std::make_unique<all_paystack_payments::CallbackListener>(
+      [priv](const std::string& reference) {
+        complete_checkout(priv, [&reference](const CheckoutWait& wait) { return wait.reference == reference; });
+      });
+  priv->poller = std::make_unique<all_paystack_payments::PaymentPoller>(
+      priv->client.get(), priv->http_client.get(),
+      [priv](const all_paystack_payments::PaymentStatusUpdate& update) {
+        if (priv->events != nullptr) {
+          priv->engine->SendEvent(priv->events, payment_status_update_to_fl_value(update));
+        }
+      });
 }
 
 static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
@@ -312,5 +1009,14 @@ void all_paystack_payments_plugin_register_with_registrar(FlPluginRegistrar* reg
                                             g_object_ref(plugin),
                                             g_object_unref);
 
+  plugin->priv->view = fl_plugin_registrar_get_view(registrar);
+
+  // Carries the poller's payment status updates. Set before any method call
+  // can start a watch.
+  plugin->priv->events =
+      fl_event_channel_new(fl_plugin_registrar_get_messenger(registrar),
+                           "all_paystack_payments/events",
+                           FL_METHOD_CODEC(codec));
+
   g_object_unref(plugin);
 }
@@ -1,10 +1,114 @@
 #include <flutter_linux/flutter_linux.h>
 
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
 #include "include/all_paystack_payments/all_paystack_payments_plugin.h"
+#include "paystack_call_engine.h"
+#include "paystack_client.h"
+#include "paystack_method_registry.h"
+#include "paystack_payment_poller.h"
+#include "paystack_request_body.h"
+#include "paystack_response_parser.h"
+#include "paystack_transport.h"
 
 // This file exposes some plugin internals for unit testing. See
 // https://github.com/flutter/flutter/issues/88724 for current limitations
 // in the unit-testable API.
 
+// Answers a method call. Handlers of async methods may instead start the
+// work on the plugin's call engine and return nullptr; the engine responds to
+// |method_call| when it completes.
+using PluginMethodHandler = FlMethodResponse *(*)(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+
+// A method call the plugin handles, as registered in kPluginMethods.
+using PluginMethod = all_paystack_payments::MethodSpec<PluginMethodHandler>;
+
+// Finds the registered method |name| invokes, or returns nullptr.
+const PluginMethod *plugin_method_from_name(const gchar *name);
+
+// Returns an INVALID_ARGUMENTS response if |args| do not match the schema
+// |method| declares, or nullptr if they do.
+FlMethodResponse *check_method_args(const PluginMethod &method, FlValue *args);
+
 // Handles the getPlatformVersion method call.
 FlMethodResponse *get_platform_version();
+
+// Method call handlers. The dispatcher has checked their arguments against
+// the method's schema; anything it cannot express, they check themselves on
+// the platform thread.
+FlMethodResponse *handle_initialize(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_initialize_payment(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_get_checkout_url(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_verify_payment(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_verify_payments(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_get_payment_status(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_invalidate_verification_cache(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_get_verification_cache_stats(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_get_metrics(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_get_transport_stats(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+// Start and stop writing a Chrome trace of the plugin's calls; see Tracer.
+FlMethodResponse *handle_start_tracing(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_stop_tracing(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_cancel_payment(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_watch_payment(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_unwatch_payment(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_show_webview(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+FlMethodResponse *handle_get_platform_version(AllPaystackPaymentsPlugin *self, FlMethodCall *method_call);
+
+// Reads the optional "fields" projection of a verify call from |args|.
+// Returns false if it is not a list of strings.
+bool read_verify_fields(FlValue *args, std::vector<std::string> *fields);
+
+// Start Paystack requests through |client| on the call engine's I/O thread.
+// |respond| is invoked there once the request completes.
+// |on_result|, if set, sees the result before it is answered.
+void start_get_checkout_url(all_paystack_payments::PaystackClient *client, const all_paystack_payments::CheckoutRequest &request, const all_paystack_payments::ApiConfig &api, all_paystack_payments::CallEngine::Respond respond, std::function<void(const all_paystack_payments::CheckoutResult &)> on_result = nullptr);
+// |fields| projects the members of the transaction returned; empty returns
+// all of them.
+void start_verify_payment(all_paystack_payments::PaystackClient *client, const std::string &reference, const std::vector<std::string> &fields, const all_paystack_payments::ApiConfig &api, all_paystack_payments::CallEngine::Respond respond);
+// Verifies |references| with at most |max_concurrency| requests in flight and
+// responds with one entry per reference, in input order.
+void start_verify_payments(all_paystack_payments::PaystackClient *client, const std::vector<std::string> &references, const std::vector<std::string> &fields, size_t max_concurrency, const all_paystack_payments::ApiConfig &api, all_paystack_payments::CallEngine::Respond respond);
+
+// Turn the outcome of a transfer into the method call response. Requests
+// stream their body through a response parser instead; these parse a body
+// that was collected in |http_response|.
+FlMethodResponse *parse_checkout_response(const all_paystack_payments::HttpResponse &http_response);
+FlMethodResponse *parse_verify_response(const all_paystack_payments::HttpResponse &http_response);
+
+// Split halves of parse_verify_response, so that verification results can be
+// cached without holding on to FlValues.
+all_paystack_payments::VerifyResult parse_verify_result(const all_paystack_payments::HttpResponse &http_response);
+// Returns the transaction's whole data object, or only |fields| of it (plus
+// the members PaymentResponse needs) if the list is not empty.
+FlMethodResponse *make_verify_response(const all_paystack_payments::VerifyResult &result, const std::vector<std::string> &fields = std::vector<std::string>());
+FlMethodResponse *make_checkout_response(const all_paystack_payments::CheckoutResult &result);
+
+// Answer showWebView: once the browser came back from checkout, with
+// {status: success, data} holding the verified transaction as verifyPayment
+// returns it, or verification's error; or at once, when nothing will tell
+// when the checkout ends, with a pending status.
+FlMethodResponse *make_checkout_completed_response(const all_paystack_payments::VerifyResult &verify_result);
+FlMethodResponse *make_checkout_opened_response();
+
+// Summarizes |metrics| for getMetrics: for each endpoint, the number of
+// requests, errors by code, retries and the percentiles of each phase in
+// microseconds.
+FlValue *metrics_to_fl_value(all_paystack_payments::ClientMetrics &metrics);
+
+// Summarizes the state of |client|'s load control for getTransportStats: the
+// circuit of each endpoint, and the concurrency limit with the requests in
+// flight and queued. Must be called on the client's thread.
+FlValue *transport_stats_to_fl_value(const all_paystack_payments::PaystackClient &client);
+
+// Turns a poller update into the event sent on all_paystack_payments/events:
+// {reference, status, final, timedOut}.
+FlValue *payment_status_update_to_fl_value(const all_paystack_payments::PaymentStatusUpdate &update);
+
+// Turns the response to one verification of a verifyPayments call into its
+// result entry: {reference, success: true, data} or
+// {reference, success: false, code, message}.
+FlValue *make_batch_entry(const std::string &reference, FlMethodResponse *response);
@@ -0,0 +1,108 @@
+// Measures how many requests per second HttpClient completes over HTTP/1.1
+// and over HTTP/2 when many calls are in flight at once, the way a POS app
+// verifies a whole shift of payments.
+//
+// Run it against a local server that speaks both protocols. nghttpx's
+// cleartext frontend accepts HTTP/1.1 as well as HTTP/2 with prior knowledge
+// and can sit in front of any static file server:
+//
+// $ python3 -m http.server 8000 &
+// $ nghttpx -f'127.0.0.1,3000;no-tls' -b'127.0.0.1,8000' &
+// $ cd build/linux/x64/release/plugins/all_paystack_payments
+// $ ./all_paystack_payments_http2_benchmark http://127.0.0.1:3000/ 2000 64
+
+#include <glib.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "paystack_http_client.h"
+
+using all_paystack_payments::HttpClient;
+using all_paystack_payments::HttpClientOptions;
+using all_paystack_payments::HttpResponse;
+using all_paystack_payments::HttpVersion;
+
+namespace {
+
+struct Run {
+  HttpClient* client;
+  std::string url;
+  GMainLoop* loop;
+  int total;
+  int started = 0;
+  int completed = 0;
+  int failed = 0;
+  int multiplexed = 0;
+  long connections = 0;
+};
+
+void StartNext(Run* run) {
+  if (run->started == run->total) return;
+  run->started++;
+  run->client->Get(run->url, "benchmark", [run](HttpResponse& response) {
+    run->completed++;
+    if (!response.ok() || response.status_code >= 400) run->failed++;
+    if (response.http_version == 2) run->multiplexed++;
+    run->connections += response.connections_opened;
+    if (run->completed == run->total) {
+      g_main_loop_quit(run->loop);
+    } else {
+      StartNext(run);
+    }
+  });
+}
+
+void Measure(const char* label, HttpVersion version, const std::string& url,
+             int requests, int concurrency, long max_streams) {
+  HttpClientOptions options;
+  options.http_version = version;
+  options.max_concurrent_streams = max_streams;
+  HttpClient client(g_main_context_default(), options);
+  GMainLoop* loop = g_main_loop_new(nullptr, FALSE);
+
+  Run run{&client, url, loop, requests};
+  gint64 start = g_get_monotonic_time();
+  for (int i = 0; i < concurrency; i++) {
+    StartNext(&run);
+  }
+  g_main_loop_run(loop);
+  double seconds = (g_get_monotonic_time() - start) / 1e6;
+
+  printf("%-9s %6d requests  %8.1f ms  %9.1f req/s  %4ld connections  "
+         "%6d over h2  %d failed\n",
+         label, requests, seconds * 1000, requests / seconds, run.connections,
+         run.multiplexed, run.failed);
+  g_main_loop_unref(loop);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <url> [requests] [concurrency] [max-streams]\n",
+            argv[0]);
+    return 1;
+  }
+  std::string url = argv[1];
+  int requests = argc > 2 ? atoi(argv[2]) : 1000;
+  int concurrency = argc > 3 ? atoi(argv[3]) : 50;
+  long max_streams = argc > 4 ? atol(argv[4]) : 100;
+  if (requests <= 0 || concurrency <= 0 || max_streams <= 0) {
+    fprintf(stderr, "requests, concurrency and max-streams must be positive\n");
+    return 1;
+  }
+
+  // Cleartext servers cannot negotiate HTTP/2 through ALPN.
+  HttpVersion http2 = url.rfind("https://", 0) == 0
+                          ? HttpVersion::kHttp2
+                          : HttpVersion::kHttp2PriorKnowledge;
+
+  printf("%d requests, %d in flight, up to %ld streams per connection\n",
+         requests, concurrency, max_streams);
+  Measure("HTTP/1.1", HttpVersion::kHttp1, url, requests, concurrency,
+          max_streams);
+  Measure("HTTP/2", http2, url, requests, concurrency, max_streams);
+  return 0;
+}
@@ -0,0 +1,508 @@
+// Google Benchmark suite for the plugin's hot paths, each measured on its
+// own: method dispatch, request body building, response parsing, FlValue
+// result construction and whole handler round trips over an in-process
+// transport. Besides time per operation, every benchmark reports the
+// allocations and bytes allocated per operation, counted by interposing
+// malloc, so GLib and FlValue allocations are included.
+//
+// $ cd build/linux/x64/release/plugins/all_paystack_payments
+// $ ./all_paystack_payments_benchmark --benchmark_counters_tabular=true
+//
+// Compare two builds with tools/compare.py from Google Benchmark, using the
+// JSON written by --benchmark_out=<file> --benchmark_out_format=json.
+
+#include <benchmark/benchmark.h>
+#include <flutter_linux/flutter_linux.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "all_paystack_payments_plugin_private.h"
+#include "paystack_client.h"
+#include "paystack_fl_value_writer.h"
+#include "paystack_metrics.h"
+#include "paystack_request_body.h"
+#include "paystack_response_parser.h"
+#include "paystack_trace.h"
+#include "paystack_transport.h"
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* pointer);
+}
+
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+std::atomic<size_t> g_allocated_bytes{0};
+
+void CountAllocation(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+// Every allocation in the process, operator new and g_malloc included, ends
+// up here.
+extern "C" {
+
+void* malloc(size_t size) {
+  CountAllocation(size);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  CountAllocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+  CountAllocation(size);
+  return __libc_realloc(pointer, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+  CountAllocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  return memalign(alignment, size);
+}
+
+int posix_memalign(void** pointer, size_t alignment, size_t size) {
+  *pointer = memalign(alignment, size);
+  return *pointer != nullptr ? 0 : ENOMEM;
+}
+
+void free(void* pointer) { __libc_free(pointer); }
+
+}  // extern "C"
+
+namespace all_paystack_payments {
+namespace {
+
+// A /transaction/verify response as Paystack returns it for a card payment.
+const char kVerifyBody[] = R"({
+  "status": true,
+  "message": "Verification successful",
+  "data": {
+    "id": 4099260516,
+    "domain": "test",
+    "status": "success",
+    "reference": "re4lyvq3s3",
+    "receipt_number": null,
+    "amount": 40333,
+    "message": null,
+    "gateway_response": "Successful",
+    "paid_at": "2024-08-22T09:15:02.000Z",
+    "created_at": "2024-08-22T09:14:24.000Z",
+    "channel": "card",
+    "currency": "NGN",
+    "ip_address": "197.210.54.33",
+    "metadata": {
+      "cart_id": 398,
+      "custom_fields": [
+        {"display_name": "Invoice ID", "variable_name": "Invoice ID", "value": 209},
+        {"display_name": "Cart Items", "variable_name": "cart_items", "value": "3 bananas, 12 mangoes"}
+      ]
+    },
+    "log": {
+      "start_time": 1724318098,
+      "time_spent": 4,
+      "attempts": 1,
+      "errors": 0,
+      "success": true,
+      "mobile": false,
+      "input": [],
+      "history": [
+        {"type": "action", "message": "Attempted to pay with card", "time": 3},
+        {"type": "success", "message": "Successfully paid with card", "time": 4}
+      ]
+    },
+    "fees": 10283,
+    "fees_split": null,
+    "authorization": {
+      "authorization_code": "AUTH_uh8bcl3zbn",
+      "bin": "408408",
+      "last4": "4081",
+      "exp_month": "12",
+      "exp_year": "2030",
+      "channel": "card",
+      "card_type": "visa ",
+      "bank": "TEST BANK",
+      "country_code": "NG",
+      "brand": "visa",
+      "reusable": true,
+      "signature": "SIG_yEXu7dLBeqG0kU7g95Ke",
+      "account_name": null
+    },
+    "customer": {
+      "id": 181873746,
+      "first_name": null,
+      "last_name": null,
+      "email": "demo@test.com",
+      "customer_code": "CUS_1rkzaqsv4rrhqo6",
+      "phone": null,
+      "metadata": null,
+      "risk_action": "default",
+      "international_format_phone": null
+    },
+    "plan": null,
+    "split": {},
+    "order_id": null,
+    "paidAt": "2024-08-22T09:15:02.000Z",
+    "createdAt": "2024-08-22T09:14:24.000Z",
+    "requested_amount": 30050,
+    "pos_transaction_data": null,
+    "source": null,
+    "fees_breakdown": null,
+    "connect": null,
+    "transaction_date": "2024-08-22T09:14:24.000Z",
+    "plan_object": {},
+    "subaccount": {}
+  }
+})";
+
+// A /transaction/initialize response.
+const char kInitializeBody[] = R"({
+  "status": true,
+  "message": "Authorization URL created",
+  "data": {
+    "authorization_url": "https://checkout.paystack.com/3ni8kdavz62431k",
+    "access_code": "3ni8kdavz62431k",
+    "reference": "re4lyvq3s3"
+  }
+})";
+
+// Answers every request before Send returns, streaming the canned body for
+// its endpoint to the sink in one piece, as curl does for bodies this size.
+class FakeTransport : public Transport {
+ public:
+  RequestId Send(HttpRequest request, HttpCallback callback,
+                 BodySink sink) override {
+    const char* body = request.method == HttpMethod::kPost ? kInitializeBody
+                                                           : kVerifyBody;
+    HttpResponse response;
+    response.status_code = 200;
+    if (sink) {
+      sink(body, strlen(body));
+    } else {
+      response.body = body;
+    }
+    callback(response);
+    return 0;
+  }
+
+  void Cancel(RequestId id) override {}
+
+  // Every request succeeds, so nothing is retried.
+  void RunAfter(int64_t delay_ms, DelayedTask task) override { task(false); }
+};
+
+// Reports the allocations made since it was created, per iteration of
+// |state|. Create it after any setup the benchmark does outside its loop.
+class AllocationCounter {
+ public:
+  explicit AllocationCounter(benchmark::State& state)
+      : state_(state),
+        allocations_(g_allocations.load(std::memory_order_relaxed)),
+        bytes_(g_allocated_bytes.load(std::memory_order_relaxed)) {}
+
+  ~AllocationCounter() {
+    state_.counters["allocs/op"] = benchmark::Counter(
+        static_cast<double>(g_allocations.load(std::memory_order_relaxed) -
+                            allocations_),
+        benchmark::Counter::kAvgIterations);
+    state_.counters["bytes/op"] = benchmark::Counter(
+        static_cast<double>(g_allocated_bytes.load(std::memory_order_relaxed) -
+                            bytes_),
+        benchmark::Counter::kAvgIterations);
+  }
+
+ private:
+  benchmark::State& state_;
+  size_t allocations_;
+  size_t bytes_;
+};
+
+ApiConfig MakeApiConfig() {
+  ApiConfig api;
+  api.public_key = "pk_test";
+  return api;
+}
+
+CheckoutRequest MakeCheckoutRequest() {
+  CheckoutRequest request;
+  request.amount = 250000;
+  request.email = "customer@example.com";
+  request.currency = "NGN";
+  request.has_reference = true;
+  request.reference = "order_1724318064_398";
+  request.has_callback_url = true;
+  request.callback_url = "https://shop.example.com/paystack/callback";
+  request.has_metadata = true;
+  request.metadata_json =
+      R"({"cart_id":398,"custom_fields":[{"display_name":"Invoice ID",)"
+      R"("value":209,"variable_name":"Invoice ID"}]})";
+  return request;
+}
+
+VerifyResult ParseVerify(const char* body, size_t chunk_size) {
+  VerifyResponseParser parser;
+  size_t length = strlen(body);
+  for (size_t offset = 0; offset < length; offset += chunk_size) {
+    size_t size = length - offset < chunk_size ? length - offset : chunk_size;
+    parser.Feed(body + offset, size);
+  }
+  HttpResponse response;
+  response.status_code = 200;
+  return parser.Finish(response);
+}
+
+// A cart of |items| products, as apps pass it in initializePayment metadata.
+FlValue* MakeMetadata(int items) {
+  FlValue* metadata = fl_value_new_map();
+  fl_value_set_string_take(metadata, "cart_id", fl_value_new_int(398));
+  FlValue* cart = fl_value_new_list();
+  for (int i = 0; i < items; i++) {
+    FlValue* item = fl_value_new_map();
+    fl_value_set_string_take(item, "sku", fl_value_new_string("SKU-00042"));
+    fl_value_set_string_take(item, "name", fl_value_new_string("Mango \"Ataulfo\""));
+    fl_value_set_string_take(item, "quantity", fl_value_new_int(12));
+    fl_value_set_string_take(item, "price", fl_value_new_float(1.25));
+    fl_value_append_take(cart, item);
+  }
+  fl_value_set_string_take(metadata, "cart", cart);
+  return metadata;
+}
+
+// Every method the plugin handles, and one it does not.
+const char* const kMethodNames[] = {
+    "initialize",
+    "initializePayment",
+    "getCheckoutUrl",
+    "verifyPayment",
+    "verifyPayments",
+    "getPaymentStatus",
+    "invalidateVerificationCache",
+    "getVerificationCacheStats",
+    "getMetrics",
+    "getTransportStats",
+    "startTracing",
+    "stopTracing",
+    "cancelPayment",
+    "watchPayment",
+    "unwatchPayment",
+    "showWebView",
+    "getPlatformVersion",
+    "notAMethod",
+};
+
+void BM_MethodDispatch(benchmark::State& state) {
+  const char* name = kMethodNames[state.range(0)];
+  state.SetLabel(name);
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(name);
+    benchmark::DoNotOptimize(plugin_method_from_name(name));
+  }
+}
+BENCHMARK(BM_MethodDispatch)
+    ->DenseRange(0, sizeof(kMethodNames) / sizeof(kMethodNames[0]) - 1);
+
+void BM_InitializeBody(benchmark::State& state) {
+  CheckoutRequest request = MakeCheckoutRequest();
+  // Grows the reused buffer.
+  build_initialize_body(request);
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(build_initialize_body(request).data());
+  }
+}
+BENCHMARK(BM_InitializeBody);
+
+void BM_MetadataToJson(benchmark::State& state) {
+  g_autoptr(FlValue) metadata = MakeMetadata(static_cast<int>(state.range(0)));
+  std::string json;
+  fl_value_to_json(metadata, &json);
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    json.clear();
+    benchmark::DoNotOptimize(fl_value_to_json(metadata, &json));
+  }
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_MetadataToJson)->Arg(1)->Arg(50);
+
+// Argument: bytes per chunk fed to the parser.
+void BM_ParseVerifyResponse(benchmark::State& state) {
+  size_t chunk_size = static_cast<size_t>(state.range(0));
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    VerifyResult result = ParseVerify(kVerifyBody, chunk_size);
+    benchmark::DoNotOptimize(result.amount);
+  }
+  state.SetBytesProcessed(state.iterations() * strlen(kVerifyBody));
+}
+BENCHMARK(BM_ParseVerifyResponse)->Arg(16384)->Arg(512);
+
+void BM_ParseCheckoutResponse(benchmark::State& state) {
+  size_t length = strlen(kInitializeBody);
+  HttpResponse response;
+  response.status_code = 200;
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    CheckoutResponseParser parser;
+    parser.Feed(kInitializeBody, length);
+    CheckoutResult result = parser.Finish(response);
+    benchmark::DoNotOptimize(result.authorization_url.data());
+  }
+  state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_ParseCheckoutResponse);
+
+// Argument: 0 converts the whole transaction, 1 projects two fields.
+void BM_MakeVerifyResponse(benchmark::State& state) {
+  VerifyResult result = ParseVerify(kVerifyBody, sizeof(kVerifyBody));
+  std::vector<std::string> fields;
+  if (state.range(0) == 1) {
+    fields = {"customer", "paid_at"};
+  }
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    FlMethodResponse* response = make_verify_response(result, fields);
+    g_object_unref(response);
+  }
+}
+BENCHMARK(BM_MakeVerifyResponse)->Arg(0)->Arg(1);
+
+void BM_MakeCheckoutResponse(benchmark::State& state) {
+  CheckoutResult result;
+  result.authorization_url = "https://checkout.paystack.com/3ni8kdavz62431k";
+  result.reference = "re4lyvq3s3";
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    FlMethodResponse* response = make_checkout_response(result);
+    g_object_unref(response);
+  }
+}
+BENCHMARK(BM_MakeCheckoutResponse);
+
+// getCheckoutUrl from the I/O thread's side: body, transport, parse and
+// response.
+void BM_CheckoutRoundTrip(benchmark::State& state) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  CheckoutRequest request = MakeCheckoutRequest();
+  ApiConfig api = MakeApiConfig();
+  CallEngine::Respond respond = [](FlMethodResponse* response) {
+    g_object_unref(response);
+  };
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    start_get_checkout_url(&client, request, api, respond);
+  }
+}
+BENCHMARK(BM_CheckoutRoundTrip);
+
+// verifyPayment from the I/O thread's side: transport, streamed parse, cache
+// fill and response.
+void BM_VerifyRoundTrip(benchmark::State& state) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  std::vector<std::string> fields;
+  ApiConfig api = MakeApiConfig();
+  CallEngine::Respond respond = [](FlMethodResponse* response) {
+    g_object_unref(response);
+  };
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    start_verify_payment(&client, "re4lyvq3s3", fields, api, respond);
+  }
+}
+BENCHMARK(BM_VerifyRoundTrip);
+
+// verifyPayments of |range(0)| references, up to 16 at a time.
+void BM_VerifyBatchRoundTrip(benchmark::State& state) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  std::vector<std::string> references;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    references.push_back("ref_" + std::to_string(i));
+  }
+  std::vector<std::string> fields;
+  ApiConfig api = MakeApiConfig();
+  CallEngine::Respond respond = [](FlMethodResponse* response) {
+    g_object_unref(response);
+  };
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    start_verify_payments(&client, references, fields, 16, api, respond);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_VerifyBatchRoundTrip)->Arg(50);
+
+// One phase of one transfer recorded into the shared metrics, from
+// |threads| threads at once as the I/O thread and the platform thread do.
+void BM_RecordLatency(benchmark::State& state) {
+  static ClientMetrics metrics;
+  int64_t micros = 1000 + state.thread_index() * 7919;
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    metrics.Record(Endpoint::kVerify, Phase::kTotal, micros);
+    micros = micros * 31 % 2000003;
+  }
+}
+BENCHMARK(BM_RecordLatency)->Threads(1)->Threads(4);
+
+// getMetrics' summary of every endpoint and phase.
+void BM_MetricsToFlValue(benchmark::State& state) {
+  ClientMetrics metrics;
+  for (int64_t micros = 1; micros < 100000; micros += 37) {
+    metrics.Record(Endpoint::kVerify, Phase::kTotal, micros);
+  }
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    FlValue* value = metrics_to_fl_value(metrics);
+    fl_value_unref(value);
+  }
+}
+BENCHMARK(BM_MetricsToFlValue);
+
+// One span recorded while tracing to /dev/null, from |threads| threads at
+// once. Formatting is on the caller; the background writer takes the rest.
+void BM_TraceSpan(benchmark::State& state) {
+  static Tracer tracer;
+  if (state.thread_index() == 0) {
+    std::string error;
+    if (!tracer.Start("/dev/null", &error)) {
+      state.SkipWithError(error.c_str());
+    }
+  }
+  TraceArgs args;
+  args.reference = "ref_2f8d1c6a9b";
+  args.method = "verifyPayment";
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    tracer.Span("parse", Tracer::Now(), 42, args);
+  }
+  if (state.thread_index() == 0) {
+    tracer.Stop();
+  }
+}
+BENCHMARK(BM_TraceSpan)->Threads(1)->Threads(4);
+
+}  // namespace
+}  // namespace all_paystack_payments
+
+BENCHMARK_MAIN();
@@ -0,0 +1,225 @@
+#include "paystack_call_engine.h"
+
+#include <future>
+#include <memory>
+#include <utility>
+
+namespace all_paystack_payments {
+
+// How often Drain checks whether the I/O thread is idle.
+static constexpr gulong kDrainPollMicros = 10000;
+
+// A call waiting for its response. Holds the only engine reference to the
+// method call, which is handed to the delivery on the main context so the
+// call is always released on the platform thread.
+struct CallEngine::Job {
+  Job(FlMethodCall* method_call, GMainContext* main_context, Work work,
+      Tracer* tracer, const TraceArgs& trace_args)
+      : method_call(FL_METHOD_CALL(g_object_ref(method_call))),
+        main_context(g_main_context_ref(main_context)),
+        work(std::move(work)),
+        tracer(tracer),
+        trace_args(trace_args),
+        submitted(Tracer::Now()) {}
+
+  ~Job() {
+    if (method_call != nullptr) {
+      Deliver(this, method_call,
+              FL_METHOD_RESPONSE(fl_method_error_response_new(
+                  "ENGINE_ERROR", "Payment request was dropped", nullptr)));
+    }
+    g_main_context_unref(main_context);
+  }
+
+  FlMethodCall* method_call;
+  GMainContext* main_context;
+  Work work;
+  Tracer* tracer;
+  TraceArgs trace_args;
+  int64_t submitted;
+};
+
+// A response on its way to the main context.
+struct Delivery {
+  FlMethodCall* method_call;
+  FlMethodResponse* response;
+  Tracer* tracer;
+  TraceArgs trace_args;
+  // When the response was handed over, in Tracer::Now microseconds.
+  int64_t delivered;
+};
+
+// An event on its way to the main context.
+struct EventDelivery {
+  FlEventChannel* channel;
+  FlValue* event;
+};
+
+CallEngine::CallEngine()
+    : main_context_(g_main_context_ref_thread_default()),
+      io_context_(g_main_context_new()),
+      io_loop_(g_main_loop_new(io_context_, FALSE)),
+      io_thread_(g_thread_new("paystack-io", RunIoThread, this)) {}
+
+CallEngine::~CallEngine() {
+  Shutdown();
+  g_main_loop_unref(io_loop_);
+  // Destroys the sources of jobs that never started, which answers them.
+  g_main_context_unref(io_context_);
+  g_main_context_unref(main_context_);
+}
+
+void CallEngine::Submit(FlMethodCall* method_call, Work work,
+                        const TraceArgs& trace_args) {
+  if (io_thread_ == nullptr) {
+    g_autoptr(FlMethodResponse) response = FL_METHOD_RESPONSE(
+        fl_method_error_response_new("ENGINE_ERROR",
+                                     "Payment engine is not running", nullptr));
+    fl_method_call_respond(method_call, response, nullptr);
+    return;
+  }
+
+  auto* job = new std::shared_ptr<Job>(
+      std::make_shared<Job>(method_call, main_context_, std::move(work),
+                            tracer_, trace_args));
+  g_main_context_invoke_full(
+      io_context_, G_PRIORITY_DEFAULT, StartJob, job, [](gpointer data) {
+        delete static_cast<std::shared_ptr<Job>*>(data);
+      });
+}
+
+void CallEngine::Post(std::function<void()> task) {
+  if (io_thread_ == nullptr) {
+    return;
+  }
+  g_main_context_invoke_full(
+      io_context_, G_PRIORITY_DEFAULT, RunTask,
+      new std::function<void()>(std::move(task)), [](gpointer data) {
+        delete static_cast<std::function<void()>*>(data);
+      });
+}
+
+void CallEngine::SendEvent(FlEventChannel* channel, FlValue* event) {
+  if (io_thread_ == nullptr) {
+    fl_value_unref(event);
+    return;
+  }
+  EventDelivery* delivery = new EventDelivery{
+      FL_EVENT_CHANNEL(g_object_ref(channel)), event};
+  g_main_context_invoke_full(main_context_, G_PRIORITY_DEFAULT,
+                             SendEventOnMainContext, delivery,
+                             DestroyEventDelivery);
+}
+
+bool CallEngine::Drain(int64_t timeout_ms, std::function<bool()> idle) {
+  gint64 deadline = g_get_monotonic_time() + timeout_ms * 1000;
+  while (io_thread_ != nullptr) {
+    auto checked = std::make_shared<std::promise<bool>>();
+    std::future<bool> is_idle = checked->get_future();
+    Post([checked, idle]() { checked->set_value(idle()); });
+    if (is_idle.get()) {
+      return true;
+    }
+    if (g_get_monotonic_time() >= deadline) {
+      return false;
+    }
+    g_usleep(kDrainPollMicros);
+  }
+  return false;
+}
+
+void CallEngine::Shutdown() {
+  if (io_thread_ == nullptr) {
+    return;
+  }
+  g_main_context_invoke(io_context_, QuitIoThread, io_loop_);
+  g_thread_join(io_thread_);
+  io_thread_ = nullptr;
+}
+
+gpointer CallEngine::RunIoThread(gpointer data) {
+  CallEngine* self = static_cast<CallEngine*>(data);
+  g_main_context_push_thread_default(self->io_context_);
+  g_main_loop_run(self->io_loop_);
+  g_main_context_pop_thread_default(self->io_context_);
+  return nullptr;
+}
+
+gboolean CallEngine::StartJob(gpointer data) {
+  std::shared_ptr<Job> job = *static_cast<std::shared_ptr<Job>*>(data);
+  if (job->tracer != nullptr) {
+    job->tracer->Span("queue wait", job->submitted,
+                      Tracer::Now() - job->submitted, job->trace_args);
+  }
+  Work work = std::move(job->work);
+  work([job](FlMethodResponse* response) {
+    if (job->method_call == nullptr) {
+      g_warning("Ignoring second response to a Paystack method call");
+      g_object_unref(response);
+      return;
+    }
+    FlMethodCall* method_call = job->method_call;
+    job->method_call = nullptr;
+    Deliver(job.get(), method_call, response);
+  });
+  return G_SOURCE_REMOVE;
+}
+
+gboolean CallEngine::RunTask(gpointer data) {
+  (*static_cast<std::function<void()>*>(data))();
+  return G_SOURCE_REMOVE;
+}
+
+gboolean CallEngine::QuitIoThread(gpointer data) {
+  g_main_loop_quit(static_cast<GMainLoop*>(data));
+  return G_SOURCE_REMOVE;
+}
+
+void CallEngine::Deliver(Job* job, FlMethodCall* method_call,
+                         FlMethodResponse* response) {
+  Delivery* delivery = new Delivery{method_call, response, job->tracer,
+                                    job->trace_args, Tracer::Now()};
+  g_main_context_invoke_full(job->main_context, G_PRIORITY_DEFAULT,
+                             RespondOnMainContext, delivery, DestroyDelivery);
+}
+
+gboolean CallEngine::RespondOnMainContext(gpointer data) {
+  Delivery* delivery = static_cast<Delivery*>(data);
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(delivery->method_call, delivery->response,
+                              &error)) {
+    g_warning("Failed to send method response: %s", error->message);
+  }
+  if (delivery->tracer != nullptr) {
+    delivery->tracer->Span("respond", delivery->delivered,
+                           Tracer::Now() - delivery->delivered,
+                           delivery->trace_args);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+void CallEngine::DestroyDelivery(gpointer data) {
+  Delivery* delivery = static_cast<Delivery*>(data);
+  g_object_unref(delivery->response);
+  g_object_unref(delivery->method_call);
+  delete delivery;
+}
+
+gboolean CallEngine::SendEventOnMainContext(gpointer data) {
+  EventDelivery* delivery = static_cast<EventDelivery*>(data);
+  g_autoptr(GError) error = nullptr;
+  if (!fl_event_channel_send(delivery->channel, delivery->event, nullptr,
+                             &error)) {
+    g_warning("Failed to send event: %s", error->message);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+void CallEngine::DestroyEventDelivery(gpointer data) {
+  EventDelivery* delivery = static_cast<EventDelivery*>(data);
+  fl_value_unref(delivery->event);
+  g_object_unref(delivery->channel);
+  delete delivery;
+}
+
+}  // namespace all_paystack_payments
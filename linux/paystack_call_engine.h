@@ -0,0 +1,93 @@
+#ifndef FLUTTER_PLUGIN_PAYSTACK_CALL_ENGINE_H_
+#define FLUTTER_PLUGIN_PAYSTACK_CALL_ENGINE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstdint>
+#include <functional>
+
+#include "paystack_trace.h"
+
+namespace all_paystack_payments {
+
+// Runs method calls that talk to Paystack on a dedicated I/O thread and
+// answers them back on the main context the engine was created on, so the
+// platform thread never waits for a Paystack round trip.
+//
+// The I/O thread iterates its own GMainContext. Work started there is
+// expected to be non-blocking (see HttpClient), so a single thread
+// multiplexes every in-flight call.
+//
+// With a tracer set, each call is traced as a "queue wait" span, from Submit
+// until its work starts, and a "respond" span, from its response until it
+// has been sent on the main context.
+class CallEngine {
+ public:
+  // Completes a call with a new response, which the engine takes ownership
+  // of. Must be invoked exactly once, on the I/O thread.
+  using Respond = std::function<void(FlMethodResponse* response)>;
+
+  // Work started on the I/O thread.
+  using Work = std::function<void(Respond respond)>;
+
+  CallEngine();
+  ~CallEngine();
+
+  // Disallow copy and assign.
+  CallEngine(const CallEngine&) = delete;
+  CallEngine& operator=(const CallEngine&) = delete;
+
+  // Starts |work| on the I/O thread. |method_call| is kept alive until the
+  // response passed to |respond| has been sent. The spans of the call are
+  // traced with |trace_args|.
+  void Submit(FlMethodCall* method_call, Work work,
+              const TraceArgs& trace_args = TraceArgs());
+
+  // Runs |task| on the I/O thread, before work submitted after it. Dropped
+  // once the engine has shut down.
+  void Post(std::function<void()> task);
+
+  // Sends |event|, which the engine takes ownership of, on |channel| from
+  // the main context. For the I/O thread; dropped once the engine has shut
+  // down.
+  void SendEvent(FlEventChannel* channel, FlValue* event);
+
+  // Blocks until |idle|, polled on the I/O thread, returns true, or for at
+  // most |timeout_ms| milliseconds. Returns whether it did.
+  bool Drain(int64_t timeout_ms, std::function<bool()> idle);
+
+  // Stops the I/O thread. Work that has not started yet never runs; its calls
+  // are answered with an error when the engine is destroyed. Idempotent.
+  void Shutdown();
+
+  // The context iterated by the I/O thread.
+  GMainContext* io_context() const { return io_context_; }
+
+  // Must be called before the first Submit. |tracer| must outlive the
+  // engine.
+  void set_tracer(Tracer* tracer) { tracer_ = tracer; }
+
+ private:
+  struct Job;
+
+  static gpointer RunIoThread(gpointer data);
+  static gboolean StartJob(gpointer data);
+  static gboolean RunTask(gpointer data);
+  static gboolean QuitIoThread(gpointer data);
+  static void Deliver(Job* job, FlMethodCall* method_call,
+                      FlMethodResponse* response);
+  static gboolean RespondOnMainContext(gpointer data);
+  static void DestroyDelivery(gpointer data);
+  static gboolean SendEventOnMainContext(gpointer data);
+  static void DestroyEventDelivery(gpointer data);
+
+  GMainContext* main_context_;
+  GMainContext* io_context_;
+  GMainLoop* io_loop_;
+  GThread* io_thread_;
+  Tracer* tracer_ = nullptr;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // FLUTTER_PLUGIN_PAYSTACK_CALL_ENGINE_H_
@@ -0,0 +1,163 @@
+#include "paystack_callback_listener.h"
+
+#include <cstring>
+#include <utility>
+
+#include "paystack_callback_request.h"
+
+namespace all_paystack_payments {
+
+const char CallbackListener::kPath[] = "/paystack/callback";
+
+// Longest request head read. Browsers send a few hundred bytes to a
+// loopback host; the head is read whole so that closing the connection
+// does not reset it before the page arrives.
+static constexpr size_t kMaxRequestSize = 8192;
+
+static constexpr char kCompletedPage[] =
+    "<!DOCTYPE html><html><head><meta charset=\"utf-8\">"
+    "<title>Payment complete</title></head><body>"
+    "<p>Payment complete. You can close this window and return to the app."
+    "</p></body></html>";
+
+// A browser connection being served.
+struct CallbackListener::Connection {
+  CallbackListener* listener;
+  GSocketConnection* connection;
+  GCancellable* cancellable;
+  char request[kMaxRequestSize];
+  size_t size = 0;
+  std::string response;
+
+  ~Connection() {
+    listener->connections_.erase(this);
+    g_object_unref(connection);
+    g_object_unref(cancellable);
+  }
+};
+
+CallbackListener::CallbackListener(Callback callback)
+    : callback_(std::move(callback)), cancellable_(g_cancellable_new()) {}
+
+CallbackListener::~CallbackListener() {
+  g_cancellable_cancel(cancellable_);
+  // Their callbacks will not run on the stopped context to free them.
+  std::unordered_set<Connection*> connections = std::move(connections_);
+  connections_.clear();
+  for (Connection* connection : connections) {
+    delete connection;
+  }
+  if (service_ != nullptr) {
+    g_socket_service_stop(service_);
+    g_socket_listener_close(G_SOCKET_LISTENER(service_));
+    g_object_unref(service_);
+  }
+  g_object_unref(cancellable_);
+}
+
+bool CallbackListener::Start(std::string* error) {
+  if (service_ != nullptr) {
+    return true;
+  }
+  GSocketService* service = g_socket_service_new();
+  g_autoptr(GInetAddress) loopback =
+      g_inet_address_new_loopback(G_SOCKET_FAMILY_IPV4);
+  g_autoptr(GSocketAddress) address = g_inet_socket_address_new(loopback, 0);
+  g_autoptr(GSocketAddress) bound = nullptr;
+  g_autoptr(GError) bind_error = nullptr;
+  if (!g_socket_listener_add_address(
+          G_SOCKET_LISTENER(service), address, G_SOCKET_TYPE_STREAM,
+          G_SOCKET_PROTOCOL_TCP, nullptr, &bound, &bind_error)) {
+    *error = bind_error->message;
+    g_object_unref(service);
+    return false;
+  }
+  g_signal_connect(service, "incoming", G_CALLBACK(OnIncoming), this);
+  g_socket_service_start(service);
+  service_ = service;
+  url_ = "http://127.0.0.1:" +
+         std::to_string(g_inet_socket_address_get_port(
+             G_INET_SOCKET_ADDRESS(bound))) +
+         kPath;
+  return true;
+}
+
+gboolean CallbackListener::OnIncoming(GSocketService* service,
+                                      GSocketConnection* connection,
+                                      GObject* source_object,
+                                      gpointer user_data) {
+  CallbackListener* self = static_cast<CallbackListener*>(user_data);
+  Connection* served = new Connection{
+      self, G_SOCKET_CONNECTION(g_object_ref(connection)),
+      G_CANCELLABLE(g_object_ref(self->cancellable_))};
+  self->connections_.insert(served);
+  Read(served);
+  return TRUE;
+}
+
+void CallbackListener::Read(Connection* connection) {
+  GInputStream* input =
+      g_io_stream_get_input_stream(G_IO_STREAM(connection->connection));
+  g_input_stream_read_async(input, connection->request + connection->size,
+                            kMaxRequestSize - connection->size,
+                            G_PRIORITY_DEFAULT, connection->cancellable,
+                            OnRead, connection);
+}
+
+void CallbackListener::OnRead(GObject* source, GAsyncResult* result,
+                              gpointer user_data) {
+  Connection* connection = static_cast<Connection*>(user_data);
+  g_autoptr(GError) error = nullptr;
+  gssize read =
+      g_input_stream_read_finish(G_INPUT_STREAM(source), result, &error);
+  if (read <= 0) {
+    // Closed, failed or cancelled before a whole request head arrived.
+    delete connection;
+    return;
+  }
+  connection->size += static_cast<size_t>(read);
+  bool complete = g_strstr_len(connection->request, connection->size,
+                               "\r\n\r\n") != nullptr;
+  if (!complete && connection->size < kMaxRequestSize) {
+    Read(connection);
+    return;
+  }
+  Respond(connection);
+}
+
+void CallbackListener::Respond(Connection* connection) {
+  std::string reference;
+  if (read_callback_reference(connection->request, connection->size,
+                              kPath, &reference)) {
+    connection->response =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/html; charset=utf-8\r\n"
+        "Cache-Control: no-store\r\n"
+        "Connection: close\r\n"
+        "Content-Length: " +
+        std::to_string(sizeof(kCompletedPage) - 1) + "\r\n\r\n" +
+        kCompletedPage;
+    connection->listener->callback_(reference);
+  } else {
+    connection->response =
+        "HTTP/1.1 404 Not Found\r\n"
+        "Connection: close\r\n"
+        "Content-Length: 0\r\n\r\n";
+  }
+  GOutputStream* output =
+      g_io_stream_get_output_stream(G_IO_STREAM(connection->connection));
+  g_output_stream_write_all_async(
+      output, connection->response.data(), connection->response.size(),
+      G_PRIORITY_DEFAULT, connection->cancellable, OnWritten, connection);
+}
+
+void CallbackListener::OnWritten(GObject* source, GAsyncResult* result,
+                                 gpointer user_data) {
+  Connection* connection = static_cast<Connection*>(user_data);
+  g_output_stream_write_all_finish(G_OUTPUT_STREAM(source), result, nullptr,
+                                   nullptr);
+  // Releasing the last reference closes the connection.
+  delete connection;
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,73 @@
+#ifndef FLUTTER_PLUGIN_PAYSTACK_CALLBACK_LISTENER_H_
+#define FLUTTER_PLUGIN_PAYSTACK_CALLBACK_LISTENER_H_
+
+#include <gio/gio.h>
+
+#include <functional>
+#include <string>
+#include <unordered_set>
+
+namespace all_paystack_payments {
+
+// Loopback HTTP endpoint that checkouts opened in the browser redirect back
+// to, so that the plugin learns the moment a payment completes instead of
+// polling for it.
+//
+// Once started it listens on an ephemeral 127.0.0.1 port, and url() is the
+// callback URL to initialize transactions with. For each GET of that URL
+// carrying a reference (or trxref) parameter, the callback is invoked with
+// the reference and the browser is shown a page telling the customer to go
+// back to the app.
+//
+// Connections are served asynchronously on the thread-default GMainContext
+// of the thread that starts the listener, which must also be the thread the
+// listener is used on. It must be destroyed once that context is no longer
+// iterated: the connections still being served are freed with it, and their
+// pending reads and writes never complete.
+class CallbackListener {
+ public:
+  using Callback = std::function<void(const std::string& reference)>;
+
+  // The path of url().
+  static const char kPath[];
+
+  explicit CallbackListener(Callback callback);
+  ~CallbackListener();
+
+  // Disallow copy and assign.
+  CallbackListener(const CallbackListener&) = delete;
+  CallbackListener& operator=(const CallbackListener&) = delete;
+
+  // Starts listening, unless already started. Returns false with |error|
+  // set if no port could be bound.
+  bool Start(std::string* error);
+
+  // e.g. http://127.0.0.1:40123/paystack/callback. Empty until started.
+  const std::string& url() const { return url_; }
+
+ private:
+  struct Connection;
+
+  static gboolean OnIncoming(GSocketService* service,
+                             GSocketConnection* connection,
+                             GObject* source_object, gpointer user_data);
+  static void Read(Connection* connection);
+  static void OnRead(GObject* source, GAsyncResult* result,
+                     gpointer user_data);
+  static void Respond(Connection* connection);
+  static void OnWritten(GObject* source, GAsyncResult* result,
+                        gpointer user_data);
+
+  Callback callback_;
+  GSocketService* service_ = nullptr;
+  // Cancelled on destruction, so that pending reads and writes no longer
+  // refer to the listener.
+  GCancellable* cancellable_;
+  // The connections being served, which free themselves once answered.
+  std::unordered_set<Connection*> connections_;
+  std::string url_;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // FLUTTER_PLUGIN_PAYSTACK_CALLBACK_LISTENER_H_
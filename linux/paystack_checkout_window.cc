@@ -0,0 +1,166 @@
+#include "paystack_checkout_window.h"
+
+#include <utility>
+
+#ifdef PAYSTACK_CHECKOUT_WEBKIT
+#include <webkit2/webkit2.h>
+
+#include "paystack_callback_listener.h"
+#include "paystack_callback_request.h"
+#endif
+
+namespace all_paystack_payments {
+
+#ifdef PAYSTACK_CHECKOUT_WEBKIT
+
+// Loaded by Prewarm(). Checkout pages are served from this origin, so the
+// load leaves its connection, TLS session and static assets behind.
+static constexpr char kCheckoutHost[] = "checkout.paystack.com";
+static constexpr char kCheckoutOrigin[] = "https://checkout.paystack.com/";
+
+bool CheckoutWindow::Available() { return true; }
+
+CheckoutWindow::CheckoutWindow(Callback callback)
+    : callback_(std::move(callback)) {}
+
+CheckoutWindow::~CheckoutWindow() {
+  // Destroying the window does not emit delete-event, so the checkout being
+  // shown, if any, is not reported.
+  if (window_ != nullptr) {
+    g_signal_handlers_disconnect_by_data(window_, this);
+    gtk_widget_destroy(window_);
+  }
+  if (context_ != nullptr) {
+    g_object_unref(context_);
+  }
+}
+
+void CheckoutWindow::Prewarm() {
+  if (window_ != nullptr) {
+    return;
+  }
+  // A context of the plugin's own, so that its network process and cache
+  // are not shared with, or evicted by, web views the app shows.
+  // Kept when the window is destroyed with the app's, for the next one.
+  if (context_ == nullptr) {
+    context_ = webkit_web_context_new();
+    webkit_web_context_set_cache_model(context_,
+                                       WEBKIT_CACHE_MODEL_WEB_BROWSER);
+    webkit_web_context_prefetch_dns(context_, kCheckoutHost);
+  }
+
+  web_view_ = WEBKIT_WEB_VIEW(webkit_web_view_new_with_context(context_));
+  g_signal_connect(web_view_, "decide-policy", G_CALLBACK(OnDecidePolicy),
+                   this);
+  window_ = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_title(GTK_WINDOW(window_), "Paystack Checkout");
+  gtk_window_set_default_size(GTK_WINDOW(window_), 480, 760);
+  gtk_window_set_destroy_with_parent(GTK_WINDOW(window_), TRUE);
+  gtk_container_add(GTK_CONTAINER(window_), GTK_WIDGET(web_view_));
+  gtk_widget_show(GTK_WIDGET(web_view_));
+  g_signal_connect(window_, "delete-event", G_CALLBACK(OnDeleteEvent), this);
+  g_signal_connect(window_, "destroy", G_CALLBACK(OnDestroy), this);
+
+  // Starts the web process and loads the checkout origin while hidden.
+  webkit_web_view_load_uri(web_view_, kCheckoutOrigin);
+}
+
+bool CheckoutWindow::Show(const std::string& checkout_url, GtkWindow* parent) {
+  Prewarm();
+  if (showing()) {
+    Finish(std::string());
+  }
+  checkout_url_ = checkout_url;
+  webkit_web_view_load_uri(web_view_, checkout_url_.c_str());
+  gtk_window_set_transient_for(GTK_WINDOW(window_), parent);
+  gtk_window_present(GTK_WINDOW(window_));
+  return true;
+}
+
+void CheckoutWindow::Close() {
+  if (showing()) {
+    Finish(std::string());
+  } else if (window_ != nullptr) {
+    gtk_widget_hide(window_);
+  }
+}
+
+void CheckoutWindow::Finish(const std::string& reference) {
+  std::string checkout_url = std::move(checkout_url_);
+  checkout_url_.clear();
+  gtk_widget_hide(window_);
+  // Unloads the checkout, keeping the web process for the next one.
+  webkit_web_view_load_uri(web_view_, "about:blank");
+  callback_(checkout_url, reference);
+}
+
+gboolean CheckoutWindow::OnDecidePolicy(WebKitWebView* web_view,
+                                        WebKitPolicyDecision* decision,
+                                        int decision_type,
+                                        gpointer user_data) {
+  CheckoutWindow* self = static_cast<CheckoutWindow*>(user_data);
+  if (decision_type != WEBKIT_POLICY_DECISION_TYPE_NAVIGATION_ACTION &&
+      decision_type != WEBKIT_POLICY_DECISION_TYPE_NEW_WINDOW_ACTION) {
+    return FALSE;
+  }
+  WebKitNavigationAction* action =
+      webkit_navigation_policy_decision_get_navigation_action(
+          WEBKIT_NAVIGATION_POLICY_DECISION(decision));
+  WebKitURIRequest* request = webkit_navigation_action_get_request(action);
+  std::string reference;
+  if (self->showing() &&
+      read_callback_url(webkit_uri_request_get_uri(request),
+                        CallbackListener::kPath, &reference)) {
+    // The redirect is not loaded: the listener would only learn the same.
+    webkit_policy_decision_ignore(decision);
+    self->Finish(reference);
+    return TRUE;
+  }
+  if (decision_type == WEBKIT_POLICY_DECISION_TYPE_NEW_WINDOW_ACTION) {
+    // Pages checkout opens in a new window, such as a bank's, replace it.
+    webkit_policy_decision_ignore(decision);
+    webkit_web_view_load_request(web_view, request);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+gboolean CheckoutWindow::OnDeleteEvent(GtkWidget* window, GdkEvent* event,
+                                       gpointer user_data) {
+  static_cast<CheckoutWindow*>(user_data)->Close();
+  // Kept for the next checkout.
+  return TRUE;
+}
+
+void CheckoutWindow::OnDestroy(GtkWidget* window, gpointer user_data) {
+  CheckoutWindow* self = static_cast<CheckoutWindow*>(user_data);
+  self->window_ = nullptr;
+  self->web_view_ = nullptr;
+  // The next Show() builds a new window.
+  if (self->showing()) {
+    std::string checkout_url = std::move(self->checkout_url_);
+    self->checkout_url_.clear();
+    self->callback_(checkout_url, std::string());
+  }
+}
+
+#else  // !PAYSTACK_CHECKOUT_WEBKIT
+
+bool CheckoutWindow::Available() { return false; }
+
+CheckoutWindow::CheckoutWindow(Callback callback)
+    : callback_(std::move(callback)) {}
+
+CheckoutWindow::~CheckoutWindow() = default;
+
+void CheckoutWindow::Prewarm() {}
+
+void CheckoutWindow::Close() {}
+
+bool CheckoutWindow::Show(const std::string& checkout_url, GtkWindow* parent) {
+  return false;
+}
+
+#endif  // PAYSTACK_CHECKOUT_WEBKIT
+
+}  // namespace all_paystack_payments
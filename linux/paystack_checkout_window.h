@@ -0,0 +1,88 @@
+#ifndef FLUTTER_PLUGIN_PAYSTACK_CHECKOUT_WINDOW_H_
+#define FLUTTER_PLUGIN_PAYSTACK_CHECKOUT_WINDOW_H_
+
+#include <gtk/gtk.h>
+
+#include <functional>
+#include <string>
+
+typedef struct _WebKitPolicyDecision WebKitPolicyDecision;
+typedef struct _WebKitWebContext WebKitWebContext;
+typedef struct _WebKitWebView WebKitWebView;
+
+namespace all_paystack_payments {
+
+// In-process checkout window: a WebKitGTK web view that shows checkouts
+// instead of a browser, and sees the moment they redirect to their callback
+// URL instead of letting the redirect load.
+//
+// Prewarm() creates the window hidden, with a web context of its own, and
+// loads Paystack's checkout origin in it, so that the web process is
+// running and the DNS lookup, TLS session and HTTP cache are ready by the
+// time the first checkout is shown. Finished checkouts hide the window and
+// blank it rather than destroying it, so every later one starts as warm.
+//
+// Only available when the plugin is built with WebKitGTK (see Available()).
+// Must be used on the platform thread.
+class CheckoutWindow {
+ public:
+  // Called when the checkout navigates to a loopback callback URL, with the
+  // reference it carries, or when the customer closes the window first,
+  // with an empty reference. The window is hidden by then.
+  using Callback = std::function<void(const std::string& checkout_url,
+                                      const std::string& reference)>;
+
+  // Whether the plugin was built with WebKitGTK. Without it, the window
+  // does nothing and Show() returns false.
+  static bool Available();
+
+  explicit CheckoutWindow(Callback callback);
+  ~CheckoutWindow();
+
+  // Disallow copy and assign.
+  CheckoutWindow(const CheckoutWindow&) = delete;
+  CheckoutWindow& operator=(const CheckoutWindow&) = delete;
+
+  // Creates the hidden window and starts loading the checkout origin,
+  // unless already done.
+  void Prewarm();
+
+  // Shows |checkout_url|, prewarming first if needed, transient for
+  // |parent| if not nullptr. A checkout still being shown is reported
+  // closed and replaced.
+  bool Show(const std::string& checkout_url, GtkWindow* parent);
+
+  // Hides the window, reporting the checkout being shown, if any, as closed
+  // by the customer.
+  void Close();
+
+  // Whether a checkout is being shown.
+  bool showing() const { return !checkout_url_.empty(); }
+
+ private:
+  // Hides and blanks the window, then reports the checkout.
+  void Finish(const std::string& reference);
+
+  // |decision_type| is a WebKitPolicyDecisionType.
+  static gboolean OnDecidePolicy(WebKitWebView* web_view,
+                                 WebKitPolicyDecision* decision,
+                                 int decision_type, gpointer user_data);
+  static gboolean OnDeleteEvent(GtkWidget* window, GdkEvent* event,
+                                gpointer user_data);
+  // The window is destroyed with its parent, the app's window, which may
+  // happen before the plugin lets go of this object.
+  static void OnDestroy(GtkWidget* window, gpointer user_data);
+
+  Callback callback_;
+  WebKitWebContext* context_ = nullptr;
+  // Null once destroyed.
+  GtkWidget* window_ = nullptr;
+  // Owned by |window_|.
+  WebKitWebView* web_view_ = nullptr;
+  // The checkout being shown; empty while hidden.
+  std::string checkout_url_;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // FLUTTER_PLUGIN_PAYSTACK_CHECKOUT_WINDOW_H_
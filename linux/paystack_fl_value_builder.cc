@@ -0,0 +1,140 @@
+#include "paystack_fl_value_builder.h"
+
+#include <cstring>
+
+namespace all_paystack_payments {
+
+FlValueBuilder::FlValueBuilder(const std::vector<std::string>* fields)
+    : fields_(fields != nullptr && !fields->empty() ? fields : nullptr) {}
+
+FlValueBuilder::~FlValueBuilder() {
+  for (FlValue* key : keys_) {
+    if (key != nullptr) fl_value_unref(key);
+  }
+  if (root_ != nullptr) {
+    fl_value_unref(root_);
+  }
+}
+
+FlValue* FlValueBuilder::TakeValue() {
+  FlValue* value = root_;
+  root_ = nullptr;
+  return value;
+}
+
+bool FlValueBuilder::Null() {
+  if (!Skip(0)) Add(fl_value_new_null());
+  return true;
+}
+
+bool FlValueBuilder::Bool(bool value) {
+  if (!Skip(0)) Add(fl_value_new_bool(value));
+  return true;
+}
+
+bool FlValueBuilder::Int(int64_t value) {
+  if (!Skip(0)) Add(fl_value_new_int(value));
+  return true;
+}
+
+bool FlValueBuilder::Double(double value) {
+  if (!Skip(0)) Add(fl_value_new_float(value));
+  return true;
+}
+
+bool FlValueBuilder::String(const char* data, size_t length) {
+  if (!Skip(0)) Add(fl_value_new_string_sized(data, length));
+  return true;
+}
+
+bool FlValueBuilder::StartObject() {
+  if (!Skip(1)) Open(fl_value_new_map());
+  return true;
+}
+
+bool FlValueBuilder::Key(const char* data, size_t length) {
+  if (skipping_) {
+    return true;
+  }
+  if (fields_ != nullptr && containers_.size() == 1 &&
+      !IsProjected(data, length)) {
+    skipping_ = true;
+    skip_depth_ = 0;
+    return true;
+  }
+  keys_.back() = fl_value_new_string_sized(data, length);
+  return true;
+}
+
+bool FlValueBuilder::EndObject() {
+  if (!Skip(-1)) Close();
+  return true;
+}
+
+bool FlValueBuilder::StartArray() {
+  if (!Skip(1)) Open(fl_value_new_list());
+  return true;
+}
+
+bool FlValueBuilder::EndArray() {
+  if (!Skip(-1)) Close();
+  return true;
+}
+
+void FlValueBuilder::Add(FlValue* value) {
+  if (containers_.empty()) {
+    root_ = value;
+    return;
+  }
+  FlValue* container = containers_.back();
+  if (fl_value_get_type(container) == FL_VALUE_TYPE_MAP) {
+    fl_value_set_take(container, keys_.back(), value);
+    keys_.back() = nullptr;
+  } else {
+    fl_value_append_take(container, value);
+  }
+}
+
+void FlValueBuilder::Open(FlValue* container) {
+  Add(container);
+  containers_.push_back(container);
+  keys_.push_back(nullptr);
+}
+
+void FlValueBuilder::Close() {
+  containers_.pop_back();
+  keys_.pop_back();
+}
+
+bool FlValueBuilder::Skip(int depth_change) {
+  if (!skipping_) {
+    return false;
+  }
+  skip_depth_ += depth_change;
+  // The skipped value ends with a scalar or with its closing bracket.
+  if (skip_depth_ == 0 && depth_change <= 0) {
+    skipping_ = false;
+  }
+  return true;
+}
+
+bool FlValueBuilder::IsProjected(const char* key, size_t length) const {
+  for (const std::string& field : *fields_) {
+    if (field.size() == length && memcmp(field.data(), key, length) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+FlValue* json_to_fl_value(const char* json, size_t length,
+                          const std::vector<std::string>& fields) {
+  FlValueBuilder builder(&fields);
+  JsonStreamParser parser(&builder);
+  if (!parser.Feed(json, length) || !parser.Finish()) {
+    return nullptr;
+  }
+  return builder.TakeValue();
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,76 @@
+#ifndef FLUTTER_PLUGIN_PAYSTACK_FL_VALUE_BUILDER_H_
+#define FLUTTER_PLUGIN_PAYSTACK_FL_VALUE_BUILDER_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <string>
+#include <vector>
+
+#include "paystack_json_stream.h"
+
+namespace all_paystack_payments {
+
+// Builds an FlValue tree straight from JsonStreamParser events: strings and
+// keys are copied once, from the parser into their FlValue.
+//
+// With a field projection, only the listed members of the top-level object
+// are built; the values of other members are skipped.
+class FlValueBuilder : public JsonHandler {
+ public:
+  // |fields| must outlive the builder. nullptr or an empty list keeps every
+  // member.
+  explicit FlValueBuilder(const std::vector<std::string>* fields = nullptr);
+  ~FlValueBuilder() override;
+
+  // Disallow copy and assign.
+  FlValueBuilder(const FlValueBuilder&) = delete;
+  FlValueBuilder& operator=(const FlValueBuilder&) = delete;
+
+  // Returns the value built so far, transferring ownership, or nullptr if
+  // there is none.
+  FlValue* TakeValue();
+
+  // JsonHandler:
+  bool Null() override;
+  bool Bool(bool value) override;
+  bool Int(int64_t value) override;
+  bool Double(double value) override;
+  bool String(const char* data, size_t length) override;
+  bool StartObject() override;
+  bool Key(const char* data, size_t length) override;
+  bool EndObject() override;
+  bool StartArray() override;
+  bool EndArray() override;
+
+ private:
+  // Adds |value| to the open container, or makes it the root. Takes
+  // ownership.
+  void Add(FlValue* value);
+  void Open(FlValue* container);
+  void Close();
+  // Returns true if a skipped value is being read, after updating the skip
+  // state for an event that starts (+1), ends (-1) or is (0) a value.
+  bool Skip(int depth_change);
+  bool IsProjected(const char* key, size_t length) const;
+
+  const std::vector<std::string>* fields_;
+
+  FlValue* root_ = nullptr;
+  // Open containers, borrowed from their parents, and the key waiting for a
+  // value in each; nullptr for lists.
+  std::vector<FlValue*> containers_;
+  std::vector<FlValue*> keys_;
+
+  bool skipping_ = false;
+  int skip_depth_ = 0;
+};
+
+// Converts the JSON document |json| to an FlValue, keeping only |fields| of
+// its top-level object if the list is not empty. Returns nullptr if |json| is
+// not valid JSON.
+FlValue* json_to_fl_value(const char* json, size_t length,
+                          const std::vector<std::string>& fields);
+
+}  // namespace all_paystack_payments
+
+#endif  // FLUTTER_PLUGIN_PAYSTACK_FL_VALUE_BUILDER_H_
@@ -0,0 +1,113 @@
+#include "paystack_fl_value_writer.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "paystack_json_writer.h"
+
+namespace all_paystack_payments {
+
+namespace {
+
+// Far deeper than any metadata, and shallow enough for the stack.
+constexpr int kMaxDepth = 64;
+
+template <typename T, typename Append>
+void AppendArray(std::string* out, const T* values, size_t length,
+                 Append append) {
+  out->push_back('[');
+  for (size_t i = 0; i < length; i++) {
+    if (i > 0) out->push_back(',');
+    append(out, values[i]);
+  }
+  out->push_back(']');
+}
+
+bool AppendValue(FlValue* value, int depth, std::string* out) {
+  switch (fl_value_get_type(value)) {
+    case FL_VALUE_TYPE_NULL:
+      out->append("null");
+      return true;
+    case FL_VALUE_TYPE_BOOL:
+      out->append(fl_value_get_bool(value) ? "true" : "false");
+      return true;
+    case FL_VALUE_TYPE_INT:
+      json_append_int(out, fl_value_get_int(value));
+      return true;
+    case FL_VALUE_TYPE_FLOAT:
+      return json_append_double(out, fl_value_get_float(value));
+    case FL_VALUE_TYPE_STRING: {
+      const gchar* string = fl_value_get_string(value);
+      json_append_string(out, string, strlen(string));
+      return true;
+    }
+    case FL_VALUE_TYPE_UINT8_LIST:
+      AppendArray(out, fl_value_get_uint8_list(value),
+                  fl_value_get_length(value),
+                  [](std::string* o, uint8_t v) { json_append_int(o, v); });
+      return true;
+    case FL_VALUE_TYPE_INT32_LIST:
+      AppendArray(out, fl_value_get_int32_list(value),
+                  fl_value_get_length(value),
+                  [](std::string* o, int32_t v) { json_append_int(o, v); });
+      return true;
+    case FL_VALUE_TYPE_INT64_LIST:
+      AppendArray(out, fl_value_get_int64_list(value),
+                  fl_value_get_length(value),
+                  [](std::string* o, int64_t v) { json_append_int(o, v); });
+      return true;
+    case FL_VALUE_TYPE_FLOAT_LIST: {
+      const double* values = fl_value_get_float_list(value);
+      size_t length = fl_value_get_length(value);
+      for (size_t i = 0; i < length; i++) {
+        if (!std::isfinite(values[i])) return false;
+      }
+      AppendArray(out, values, length,
+                  [](std::string* o, double v) { json_append_double(o, v); });
+      return true;
+    }
+    case FL_VALUE_TYPE_LIST: {
+      if (depth == kMaxDepth) return false;
+      out->push_back('[');
+      size_t length = fl_value_get_length(value);
+      for (size_t i = 0; i < length; i++) {
+        if (i > 0) out->push_back(',');
+        if (!AppendValue(fl_value_get_list_value(value, i), depth + 1, out)) {
+          return false;
+        }
+      }
+      out->push_back(']');
+      return true;
+    }
+    case FL_VALUE_TYPE_MAP: {
+      if (depth == kMaxDepth) return false;
+      out->push_back('{');
+      size_t length = fl_value_get_length(value);
+      for (size_t i = 0; i < length; i++) {
+        FlValue* key = fl_value_get_map_key(value, i);
+        if (fl_value_get_type(key) != FL_VALUE_TYPE_STRING) return false;
+        if (i > 0) out->push_back(',');
+        const gchar* key_string = fl_value_get_string(key);
+        json_append_string(out, key_string, strlen(key_string));
+        out->push_back(':');
+        if (!AppendValue(fl_value_get_map_value(value, i), depth + 1, out)) {
+          return false;
+        }
+      }
+      out->push_back('}');
+      return true;
+    }
+    default:
+      // Float32 lists and custom values, in Flutter versions that have them.
+      return false;
+  }
+}
+
+}  // namespace
+
+bool fl_value_to_json(FlValue* value, std::string* out) {
+  return AppendValue(value, 0, out);
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,21 @@
+#ifndef FLUTTER_PLUGIN_PAYSTACK_FL_VALUE_WRITER_H_
+#define FLUTTER_PLUGIN_PAYSTACK_FL_VALUE_WRITER_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <string>
+
+namespace all_paystack_payments {
+
+// Appends |value| to |out| as JSON in a single pass over the FlValue tree,
+// without building an intermediate document. Maps, lists and typed lists
+// become objects and arrays; map keys must be strings and floats must be
+// finite. Scalars are written with the core's json_append_* functions.
+//
+// Returns false, leaving |out| partly written, if |value| holds anything
+// that has no JSON form or is nested too deeply.
+bool fl_value_to_json(FlValue* value, std::string* out);
+
+}  // namespace all_paystack_payments
+
+#endif  // FLUTTER_PLUGIN_PAYSTACK_FL_VALUE_WRITER_H_
@@ -0,0 +1,422 @@
+#include "paystack_http_client.h"
+
+#include <utility>
+
+#include "paystack_rate_limiter.h"
+
+namespace all_paystack_payments {
+
+// Idle handles kept for reuse. Extra handles are cleaned up when released.
+static constexpr size_t kMaxIdleHandles = 8;
+
+// How long resolved addresses stay in the shared DNS cache, in seconds.
+static constexpr long kDnsCacheTimeoutSeconds = 300;
+
+// TCP keep-alive probing for pooled connections, in seconds.
+static constexpr long kKeepAliveIdleSeconds = 60;
+static constexpr long kKeepAliveIntervalSeconds = 30;
+
+// Reads when a finished transfer on |handle| reached each phase.
+static void ReadTimings(CURL* handle, HttpTimings* timings) {
+  const struct {
+    CURLINFO info;
+    int64_t* micros;
+  } phases[] = {
+      {CURLINFO_NAMELOOKUP_TIME_T, &timings->name_lookup},
+      {CURLINFO_CONNECT_TIME_T, &timings->connect},
+      {CURLINFO_APPCONNECT_TIME_T, &timings->tls},
+      {CURLINFO_STARTTRANSFER_TIME_T, &timings->first_byte},
+      {CURLINFO_TOTAL_TIME_T, &timings->total},
+  };
+  for (const auto& phase : phases) {
+    curl_off_t micros = 0;
+    if (curl_easy_getinfo(handle, phase.info, &micros) == CURLE_OK) {
+      *phase.micros = micros;
+    }
+  }
+}
+
+struct HttpClient::Transfer {
+  // 0 until the transfer starts.
+  RequestId id = 0;
+  CURL* handle = nullptr;
+  curl_slist* headers = nullptr;
+  std::string request_body;
+  HttpResponse response;
+  HttpCallback callback;
+  BodySink sink;
+};
+
+struct HttpClient::Timer {
+  HttpClient* client;
+  GSource* source;
+  DelayedTask task;
+};
+
+struct HttpClient::CurlSource {
+  GSource source;
+  HttpClient* client;
+};
+
+GSourceFuncs HttpClient::source_funcs_ = {
+    nullptr,  // prepare: readiness comes from unix fds and the ready time.
+    nullptr,  // check
+    HttpClient::DispatchSource,
+    nullptr,  // finalize
+};
+
+HttpClient::HttpClient(GMainContext* context,
+                       const HttpClientOptions& options) {
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+
+  HttpVersion version = options.http_version;
+  if (version != HttpVersion::kHttp1 &&
+      !(curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP2)) {
+    g_debug("libcurl was built without HTTP/2 support, using HTTP/1.1");
+    version = HttpVersion::kHttp1;
+  }
+  switch (version) {
+    case HttpVersion::kHttp1:
+      http_version_ = CURL_HTTP_VERSION_1_1;
+      break;
+    case HttpVersion::kHttp2:
+      http_version_ = CURL_HTTP_VERSION_2TLS;
+      break;
+    case HttpVersion::kHttp2PriorKnowledge:
+      http_version_ = CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+      break;
+  }
+
+  source_ = g_source_new(&source_funcs_, sizeof(CurlSource));
+  reinterpret_cast<CurlSource*>(source_)->client = this;
+  g_source_set_name(source_, "paystack-curl");
+  g_source_attach(source_, context);
+
+  // Every transfer runs on the context's thread, so the share needs no locks.
+  // Connections are not shared here: the multi handle keeps them.
+  share_ = curl_share_init();
+  curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+  multi_ = curl_multi_init();
+  curl_multi_setopt(multi_, CURLMOPT_SOCKETFUNCTION, SocketCallback);
+  curl_multi_setopt(multi_, CURLMOPT_SOCKETDATA, this);
+  curl_multi_setopt(multi_, CURLMOPT_TIMERFUNCTION, TimerCallback);
+  curl_multi_setopt(multi_, CURLMOPT_TIMERDATA, this);
+  curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#if LIBCURL_VERSION_NUM >= 0x074300  // 7.67.0
+  curl_multi_setopt(multi_, CURLMOPT_MAX_CONCURRENT_STREAMS,
+                    options.max_concurrent_streams);
+#endif
+}
+
+HttpClient::~HttpClient() {
+  destroying_ = true;
+  std::vector<Timer*> timers(timers_.begin(), timers_.end());
+  timers_.clear();
+  for (Timer* timer : timers) {
+    g_source_destroy(timer->source);
+    g_source_unref(timer->source);
+    timer->task(true);
+    delete timer;
+  }
+  std::vector<Transfer*> in_flight;
+  for (const auto& entry : in_flight_) {
+    in_flight.push_back(entry.second);
+  }
+  for (Transfer* transfer : in_flight) {
+    Finish(transfer, CURLE_ABORTED_BY_CALLBACK);
+  }
+
+  for (CURL* handle : idle_handles_) {
+    curl_easy_cleanup(handle);
+  }
+  idle_handles_.clear();
+  curl_multi_cleanup(multi_);
+  curl_share_cleanup(share_);
+
+  g_source_destroy(source_);
+  g_source_unref(source_);
+  curl_global_cleanup();
+}
+
+RequestId HttpClient::Send(HttpRequest request, HttpCallback callback,
+                           BodySink sink) {
+  Transfer* transfer = new Transfer();
+  transfer->callback = std::move(callback);
+  transfer->sink = std::move(sink);
+  transfer->handle = AcquireHandle();
+  if (!transfer->handle) {
+    Finish(transfer, CURLE_FAILED_INIT);
+    return 0;
+  }
+  CURL* curl = transfer->handle;
+  curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+  if (request.method == HttpMethod::kPost) {
+    transfer->request_body = std::move(request.body);
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, transfer->request_body.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
+                     static_cast<long>(transfer->request_body.size()));
+    transfer->headers =
+        curl_slist_append(transfer->headers, "Content-Type: application/json");
+  } else {
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+  }
+  if (request.fresh_connection) {
+    curl_easy_setopt(curl, CURLOPT_FRESH_CONNECT, 1L);
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 0L);
+  }
+  curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS,
+                   static_cast<long>(request.connect_timeout_ms));
+  curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS,
+                   static_cast<long>(request.timeout_ms));
+  std::string auth_header = "Authorization: Bearer " + request.public_key;
+  transfer->headers = curl_slist_append(transfer->headers, auth_header.c_str());
+  return Start(transfer);
+}
+
+void HttpClient::Cancel(RequestId id) {
+  auto it = in_flight_.find(id);
+  if (it != in_flight_.end()) {
+    Finish(it->second, CURLE_ABORTED_BY_CALLBACK);
+  }
+}
+
+void HttpClient::RunAfter(int64_t delay_ms, DelayedTask task) {
+  if (destroying_) {
+    task(true);
+    return;
+  }
+  Timer* timer =
+      new Timer{this, g_timeout_source_new(static_cast<guint>(delay_ms)),
+                std::move(task)};
+  g_source_set_callback(timer->source, FireTimer, timer, nullptr);
+  g_source_attach(timer->source, g_source_get_context(source_));
+  timers_.insert(timer);
+}
+
+gboolean HttpClient::FireTimer(gpointer data) {
+  Timer* timer = static_cast<Timer*>(data);
+  timer->client->timers_.erase(timer);
+  DelayedTask task = std::move(timer->task);
+  g_source_unref(timer->source);
+  delete timer;
+  task(false);
+  return G_SOURCE_REMOVE;
+}
+
+RequestId HttpClient::Post(const std::string& url,
+                           const std::string& json_body,
+                           const std::string& public_key,
+                           HttpCallback callback, BodySink sink) {
+  HttpRequest request;
+  request.method = HttpMethod::kPost;
+  request.url = url;
+  request.public_key = public_key;
+  request.body = json_body;
+  return Send(std::move(request), std::move(callback), std::move(sink));
+}
+
+RequestId HttpClient::Get(const std::string& url,
+                          const std::string& public_key,
+                          HttpCallback callback, BodySink sink) {
+  HttpRequest request;
+  request.url = url;
+  request.public_key = public_key;
+  return Send(std::move(request), std::move(callback), std::move(sink));
+}
+
+CURL* HttpClient::AcquireHandle() {
+  CURL* handle = nullptr;
+  if (!idle_handles_.empty()) {
+    handle = idle_handles_.back();
+    idle_handles_.pop_back();
+    // Clears the previous request's options but keeps the handle's caches.
+    curl_easy_reset(handle);
+  } else {
+    handle = curl_easy_init();
+    if (!handle) return nullptr;
+  }
+  curl_easy_setopt(handle, CURLOPT_SHARE, share_);
+  curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(handle, CURLOPT_DNS_CACHE_TIMEOUT, kDnsCacheTimeoutSeconds);
+  curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(handle, CURLOPT_TCP_KEEPIDLE, kKeepAliveIdleSeconds);
+  curl_easy_setopt(handle, CURLOPT_TCP_KEEPINTVL, kKeepAliveIntervalSeconds);
+  curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteCallback);
+  curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, HeaderCallback);
+  curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, http_version_);
+  if (http_version_ != CURL_HTTP_VERSION_1_1) {
+    // Prefer waiting for a connection that can multiplex over opening more.
+    curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+  }
+  return handle;
+}
+
+void HttpClient::ReleaseHandle(CURL* handle) {
+  if (idle_handles_.size() < kMaxIdleHandles) {
+    idle_handles_.push_back(handle);
+  } else {
+    curl_easy_cleanup(handle);
+  }
+}
+
+RequestId HttpClient::Start(Transfer* transfer) {
+  if (destroying_) {
+    Finish(transfer, CURLE_ABORTED_BY_CALLBACK);
+    return 0;
+  }
+  CURL* curl = transfer->handle;
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer);
+  curl_easy_setopt(curl, CURLOPT_HEADERDATA, transfer);
+  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers);
+  curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+  transfer->id = ++last_id_;
+  in_flight_[transfer->id] = transfer;
+  CURLMcode res = curl_multi_add_handle(multi_, curl);
+  if (res != CURLM_OK) {
+    Finish(transfer, CURLE_FAILED_INIT);
+    return 0;
+  }
+  return transfer->id;
+}
+
+void HttpClient::Finish(Transfer* transfer, CURLcode result) {
+  HttpResponse response = std::move(transfer->response);
+  if (result != CURLE_OK) response.error = curl_easy_strerror(result);
+  in_flight_.erase(transfer->id);
+  if (transfer->handle) {
+    CURL* curl = transfer->handle;
+    curl_multi_remove_handle(multi_, curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status_code);
+    long http_version = 0;
+    curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &http_version);
+    if (http_version == CURL_HTTP_VERSION_2_0) {
+      response.http_version = 2;
+    } else if (http_version != 0) {
+      response.http_version = 1;
+    }
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS,
+                      &response.connections_opened);
+    ReadTimings(curl, &response.timings);
+    // Drop references to the transfer before the handle goes back to the pool.
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, nullptr);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, nullptr);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, nullptr);
+    ReleaseHandle(curl);
+  }
+  curl_slist_free_all(transfer->headers);
+  HttpCallback callback = std::move(transfer->callback);
+  delete transfer;
+  callback(response);
+}
+
+void HttpClient::ProcessCompletedTransfers() {
+  CURLMsg* message = nullptr;
+  int messages_left = 0;
+  while ((message = curl_multi_info_read(multi_, &messages_left)) != nullptr) {
+    if (message->msg != CURLMSG_DONE) continue;
+    // |message| is invalidated once the handle leaves the multi handle.
+    CURLcode result = message->data.result;
+    Transfer* transfer = nullptr;
+    curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &transfer);
+    Finish(transfer, result);
+  }
+}
+
+void HttpClient::OnSocketAction(curl_socket_t socket, int event_mask) {
+  int running_handles = 0;
+  curl_multi_socket_action(multi_, socket, event_mask, &running_handles);
+}
+
+int HttpClient::SocketCallback(CURL* handle, curl_socket_t socket, int what,
+                               void* user_data, void* socket_data) {
+  HttpClient* self = static_cast<HttpClient*>(user_data);
+  if (what == CURL_POLL_REMOVE) {
+    if (socket_data) {
+      g_source_remove_unix_fd(self->source_, socket_data);
+    }
+    curl_multi_assign(self->multi_, socket, nullptr);
+    self->sockets_.erase(socket);
+    return 0;
+  }
+
+  int condition = G_IO_ERR | G_IO_HUP;
+  if (what & CURL_POLL_IN) condition |= G_IO_IN;
+  if (what & CURL_POLL_OUT) condition |= G_IO_OUT;
+  if (socket_data) {
+    g_source_modify_unix_fd(self->source_, socket_data,
+                            static_cast<GIOCondition>(condition));
+  } else {
+    gpointer tag = g_source_add_unix_fd(self->source_, socket,
+                                        static_cast<GIOCondition>(condition));
+    curl_multi_assign(self->multi_, socket, tag);
+    self->sockets_[socket] = tag;
+  }
+  return 0;
+}
+
+int HttpClient::TimerCallback(CURLM* multi, long timeout_ms, void* user_data) {
+  HttpClient* self = static_cast<HttpClient*>(user_data);
+  if (timeout_ms < 0) {
+    g_source_set_ready_time(self->source_, -1);
+  } else {
+    g_source_set_ready_time(
+        self->source_,
+        g_get_monotonic_time() + static_cast<gint64>(timeout_ms) * 1000);
+  }
+  return 0;
+}
+
+gboolean HttpClient::DispatchSource(GSource* source, GSourceFunc callback,
+                                    gpointer user_data) {
+  HttpClient* self = reinterpret_cast<CurlSource*>(source)->client;
+
+  // Collect ready sockets first: curl adds and removes watches while acting.
+  std::vector<std::pair<curl_socket_t, int>> ready;
+  for (const auto& entry : self->sockets_) {
+    GIOCondition condition = g_source_query_unix_fd(source, entry.second);
+    int event_mask = 0;
+    if (condition & G_IO_IN) event_mask |= CURL_CSELECT_IN;
+    if (condition & G_IO_OUT) event_mask |= CURL_CSELECT_OUT;
+    if (condition & (G_IO_ERR | G_IO_HUP)) event_mask |= CURL_CSELECT_ERR;
+    if (event_mask != 0) ready.emplace_back(entry.first, event_mask);
+  }
+  for (const auto& entry : ready) {
+    self->OnSocketAction(entry.first, entry.second);
+  }
+
+  gint64 ready_time = g_source_get_ready_time(source);
+  if (ready_time >= 0 && g_source_get_time(source) >= ready_time) {
+    // curl re-arms the timer through TimerCallback if it still needs it.
+    g_source_set_ready_time(source, -1);
+    self->OnSocketAction(CURL_SOCKET_TIMEOUT, 0);
+  }
+
+  self->ProcessCompletedTransfers();
+  return G_SOURCE_CONTINUE;
+}
+
+size_t HttpClient::WriteCallback(char* data, size_t size, size_t nmemb,
+                                 void* user_data) {
+  Transfer* transfer = static_cast<Transfer*>(user_data);
+  size_t total_size = size * nmemb;
+  if (transfer->sink) {
+    // Any other return value makes curl fail the transfer.
+    return transfer->sink(data, total_size) ? total_size : 0;
+  }
+  transfer->response.body.append(data, total_size);
+  return total_size;
+}
+
+size_t HttpClient::HeaderCallback(char* data, size_t size, size_t nmemb,
+                                  void* user_data) {
+  Transfer* transfer = static_cast<Transfer*>(user_data);
+  size_t total_size = size * nmemb;
+  read_rate_limit_header(data, total_size, &transfer->response.rate_limit);
+  return total_size;
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,140 @@
+#ifndef FLUTTER_PLUGIN_PAYSTACK_HTTP_CLIENT_H_
+#define FLUTTER_PLUGIN_PAYSTACK_HTTP_CLIENT_H_
+
+#include <curl/curl.h>
+#include <glib.h>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "paystack_transport.h"
+
+namespace all_paystack_payments {
+
+// HTTP versions the client can be asked to speak.
+enum class HttpVersion {
+  // HTTP/1.1 only. Concurrent requests each need their own connection.
+  kHttp1,
+  // HTTP/2 negotiated through TLS ALPN, falling back to HTTP/1.1 for servers
+  // that do not offer it. Concurrent requests are multiplexed as streams over
+  // one connection.
+  kHttp2,
+  // Cleartext HTTP/2 without negotiation. Only meant for local test servers.
+  kHttp2PriorKnowledge,
+};
+
+struct HttpClientOptions {
+  HttpVersion http_version = HttpVersion::kHttp2;
+  // Cap on the streams multiplexed over one HTTP/2 connection. Once it is
+  // reached further requests open another connection.
+  long max_concurrent_streams = 100;
+};
+
+// Non-blocking HTTP client for the Paystack API.
+//
+// Transfers run on a curl multi handle driven by curl_multi_socket_action.
+// Its sockets and timer are watched by a GSource attached to the GMainContext
+// passed to the constructor, so every in-flight request is multiplexed on
+// the thread iterating that context without blocking it.
+//
+// With HTTP/2, concurrent requests to the same host wait for the first
+// connection to finish negotiating and are then sent as streams over it.
+//
+// Open connections are kept in the connection cache of the one multi handle
+// every transfer runs on, so any later request can reuse them. Easy handles
+// are pooled and reused between requests, and all of them are attached to
+// one CURLSH that shares the DNS cache and TLS session IDs. Back to back
+// calls to api.paystack.co therefore skip the DNS lookup, the TCP handshake
+// and the full TLS handshake.
+//
+// This is the Transport PaystackClient sends requests through on Linux. All
+// methods must be called on the thread iterating the context, and callbacks
+// are invoked on it.
+class HttpClient : public Transport {
+ public:
+  explicit HttpClient(GMainContext* context,
+                      const HttpClientOptions& options = HttpClientOptions());
+
+  // Cancels pending timers and aborts transfers that are still running.
+  // Their callbacks are invoked with the error for CURLE_ABORTED_BY_CALLBACK,
+  // as are those of requests they send meanwhile.
+  ~HttpClient() override;
+
+  // Disallow copy and assign.
+  HttpClient(const HttpClient&) = delete;
+  HttpClient& operator=(const HttpClient&) = delete;
+
+  // Starts |request|, bounded by its timeouts. A fresh connection is opened
+  // for it, rather than reusing or multiplexing over a pooled one, if it
+  // asks for one.
+  RequestId Send(HttpRequest request, HttpCallback callback,
+                 BodySink sink) override;
+
+  // Aborts the transfer with CURLE_ABORTED_BY_CALLBACK's error.
+  void Cancel(RequestId id) override;
+
+  // Runs |callback| from a GLib timeout on the client's context.
+  void RunAfter(int64_t delay_ms, DelayedTask task) override;
+
+  // Starts a JSON POST request. If |sink| is set, the response body is
+  // streamed to it rather than collected in HttpResponse::body.
+  RequestId Post(const std::string& url, const std::string& json_body,
+                 const std::string& public_key, HttpCallback callback,
+                 BodySink sink = BodySink());
+
+  // Starts a GET request. If |sink| is set, the response body is streamed to
+  // it rather than collected in HttpResponse::body.
+  RequestId Get(const std::string& url, const std::string& public_key,
+                HttpCallback callback, BodySink sink = BodySink());
+
+ private:
+  struct Transfer;
+  struct CurlSource;
+  struct Timer;
+
+  CURL* AcquireHandle();
+  void ReleaseHandle(CURL* handle);
+  // Returns the transfer's id, or 0 if it failed to start.
+  RequestId Start(Transfer* transfer);
+  void Finish(Transfer* transfer, CURLcode result);
+  void ProcessCompletedTransfers();
+  void OnSocketAction(curl_socket_t socket, int event_mask);
+
+  static size_t WriteCallback(char* data, size_t size, size_t nmemb,
+                              void* user_data);
+  static size_t HeaderCallback(char* data, size_t size, size_t nmemb,
+                               void* user_data);
+  static int SocketCallback(CURL* handle, curl_socket_t socket, int what,
+                            void* user_data, void* socket_data);
+  static int TimerCallback(CURLM* multi, long timeout_ms, void* user_data);
+  static gboolean DispatchSource(GSource* source, GSourceFunc callback,
+                                 gpointer user_data);
+  static gboolean FireTimer(gpointer data);
+
+  static GSourceFuncs source_funcs_;
+
+  // CURL_HTTP_VERSION_* value requested for every transfer.
+  long http_version_ = CURL_HTTP_VERSION_1_1;
+
+  CURLM* multi_;
+  CURLSH* share_;
+  GSource* source_;
+
+  // Tags returned by g_source_add_unix_fd for the sockets curl watches.
+  std::unordered_map<curl_socket_t, gpointer> sockets_;
+
+  std::unordered_map<RequestId, Transfer*> in_flight_;
+  RequestId last_id_ = 0;
+  std::unordered_set<Timer*> timers_;
+  // Set once the destructor runs, so that callbacks cannot start new work.
+  bool destroying_ = false;
+
+  std::vector<CURL*> idle_handles_;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // FLUTTER_PLUGIN_PAYSTACK_HTTP_CLIENT_H_
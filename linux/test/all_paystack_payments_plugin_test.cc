@@ -2,8 +2,17 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <vector>
+
 #include "include/all_paystack_payments/all_paystack_payments_plugin.h"
 #include "all_paystack_payments_plugin_private.h"
+#include "paystack_fl_value_builder.h"
+#include "paystack_fl_value_writer.h"
 
 // This demonstrates a simple unit test of the C portion of this plugin's
 // implementation.
@@ -27,5 +36,319 @@ TEST(AllPaystackPaymentsPlugin, GetPlatformVersion) {
   EXPECT_THAT(fl_value_get_string(result), testing::StartsWith("Linux "));
 }
 
+TEST(AllPaystackPaymentsPlugin, ChecksArgumentsAgainstTheRegistry) {
+  const PluginMethod* checkout = plugin_method_from_name("getCheckoutUrl");
+  ASSERT_NE(checkout, nullptr);
+  EXPECT_TRUE(checkout->async);
+  EXPECT_EQ(plugin_method_from_name("getCheckoutURL"), nullptr);
+
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "amount", fl_value_new_string("5000"));
+  fl_value_set_string_take(args, "email", fl_value_new_string("a@b.co"));
+  g_autoptr(FlMethodResponse) invalid = check_method_args(*checkout, args);
+  ASSERT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(invalid));
+  EXPECT_STREQ(fl_method_error_response_get_message(FL_METHOD_ERROR_RESPONSE(invalid)), "amount must be an integer");
+
+  fl_value_set_string_take(args, "amount", fl_value_new_int(5000));
+  fl_value_set_string_take(args, "currency", fl_value_new_null());
+  EXPECT_EQ(check_method_args(*checkout, args), nullptr);
+
+  // Methods without required arguments may be called without any.
+  EXPECT_EQ(check_method_args(*plugin_method_from_name("invalidateVerificationCache"), nullptr), nullptr);
+}
+
+TEST(AllPaystackPaymentsPlugin, ReportsMetrics) {
+  all_paystack_payments::ClientMetrics metrics;
+  all_paystack_payments::HttpResponse http_response;
+  http_response.timings.total = 120000;
+  metrics.RecordExchange(all_paystack_payments::Endpoint::kVerify, http_response, "API_ERROR");
+  metrics.Record(all_paystack_payments::Endpoint::kVerify, all_paystack_payments::Phase::kBuild, 40);
+
+  g_autoptr(FlValue) value = metrics_to_fl_value(metrics);
+  FlValue* verify = fl_value_lookup_string(value, "verify");
+  ASSERT_NE(verify, nullptr);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(verify, "requests")), 1);
+  FlValue* errors = fl_value_lookup_string(verify, "errors");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(errors, "API_ERROR")), 1);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(errors, "HTTP_ERROR")), 0);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(verify, "retries")), 0);
+  FlValue* phases = fl_value_lookup_string(verify, "phases");
+  FlValue* total = fl_value_lookup_string(phases, "total");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(total, "count")), 1);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(total, "p99")), 120000);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(fl_value_lookup_string(phases, "build"), "max")), 40);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(fl_value_lookup_string(phases, "dns"), "count")), 0);
+  EXPECT_NE(fl_value_lookup_string(value, "initialize"), nullptr);
+}
+
+TEST(AllPaystackPaymentsPlugin, ReportsTransportStats) {
+  // Nothing is sent, so the client needs no transport.
+  all_paystack_payments::PaystackClient client(nullptr);
+  g_autoptr(FlValue) value = transport_stats_to_fl_value(client);
+  FlValue* verify = fl_value_lookup_string(fl_value_lookup_string(value, "circuits"), "verify");
+  ASSERT_NE(verify, nullptr);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(verify, "state")), "closed");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(verify, "rejected")), 0);
+  FlValue* limiter = fl_value_lookup_string(value, "limiter");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(limiter, "limit")), 20);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(limiter, "inFlight")), 0);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(limiter, "queued")), 0);
+  FlValue* rate_limit = fl_value_lookup_string(fl_value_lookup_string(value, "rateLimits"), "initialize");
+  ASSERT_NE(rate_limit, nullptr);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(rate_limit, "waiting")), 0);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(rate_limit, "expired")), 0);
+}
+
+TEST(AllPaystackPaymentsPlugin, ParseVerifyResponse) {
+  all_paystack_payments::HttpResponse http_response;
+  http_response.status_code = 200;
+  http_response.body =
+      R"({"status":true,"message":"Verification successful","data":{)"
+      R"("reference":"ref_123","status":"success","amount":50000,)"
+      R"("currency":"NGN","gateway_response":"Successful",)"
+      R"("channel":"bank_transfer","customer":{"email":"a@b.co"}}})";
+  g_autoptr(FlMethodResponse) response = parse_verify_response(http_response);
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(response));
+  FlValue* result = fl_method_success_response_get_result(
+      FL_METHOD_SUCCESS_RESPONSE(response));
+  ASSERT_EQ(fl_value_get_type(result), FL_VALUE_TYPE_MAP);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(result, "reference")),
+               "ref_123");
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(result, "status")),
+               "success");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(result, "amount")), 50000);
+  EXPECT_STREQ(
+      fl_value_get_string(fl_value_lookup_string(result, "gateway_response")),
+      "Successful");
+  EXPECT_STREQ(
+      fl_value_get_string(fl_value_lookup_string(result, "payment_method")),
+      "bank_transfer");
+  FlValue* customer = fl_value_lookup_string(result, "customer");
+  ASSERT_NE(customer, nullptr);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(customer, "email")),
+               "a@b.co");
+}
+
+TEST(AllPaystackPaymentsPlugin, MakeVerifyResponseProjectsFields) {
+  const std::string body =
+      R"({"status":true,"message":"ok","data":{"id":7,"reference":"r",)"
+      R"("status":"success","amount":1,"currency":"NGN",)"
+      R"("log":{"history":[1,2]},"customer":{"email":"a@b.co"}}})";
+  VerifyResponseParser parser;
+  ASSERT_TRUE(parser.Feed(body.data(), body.size()));
+  VerifyResult verify_result = parser.Finish(HttpResponse());
+  ASSERT_TRUE(verify_result.ok()) << verify_result.error_code;
+
+  g_autoptr(FlMethodResponse) response =
+      make_verify_response(verify_result, {"customer"});
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(response));
+  FlValue* result = fl_method_success_response_get_result(
+      FL_METHOD_SUCCESS_RESPONSE(response));
+  EXPECT_NE(fl_value_lookup_string(result, "customer"), nullptr);
+  EXPECT_NE(fl_value_lookup_string(result, "reference"), nullptr);
+  EXPECT_EQ(fl_value_lookup_string(result, "id"), nullptr);
+  EXPECT_EQ(fl_value_lookup_string(result, "log"), nullptr);
+  EXPECT_STREQ(
+      fl_value_get_string(fl_value_lookup_string(result, "payment_method")),
+      "card");
+}
+
+TEST(AllPaystackPaymentsPlugin, ParseVerifyResponseTransferFailure) {
+  all_paystack_payments::HttpResponse http_response;
+  http_response.error = "Couldn't connect to server";
+  g_autoptr(FlMethodResponse) response = parse_verify_response(http_response);
+  ASSERT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(response));
+  EXPECT_STREQ(fl_method_error_response_get_code(
+                   FL_METHOD_ERROR_RESPONSE(response)),
+               "HTTP_ERROR");
+}
+
+TEST(AllPaystackPaymentsPlugin, ParseCheckoutResponseApiError) {
+  all_paystack_payments::HttpResponse http_response;
+  http_response.status_code = 400;
+  http_response.body = R"({"status":false,"message":"Invalid key"})";
+  g_autoptr(FlMethodResponse) response = parse_checkout_response(http_response);
+  ASSERT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(response));
+  EXPECT_STREQ(fl_method_error_response_get_code(
+                   FL_METHOD_ERROR_RESPONSE(response)),
+               "API_ERROR");
+  EXPECT_STREQ(fl_method_error_response_get_message(
+                   FL_METHOD_ERROR_RESPONSE(response)),
+               "Invalid key");
+}
+
+TEST(AllPaystackPaymentsPlugin, AnswersShowWebViewWithTheVerifiedCheckout) {
+  all_paystack_payments::VerifyResult verified;
+  verified.reference = "ref_1";
+  verified.status = "success";
+  verified.channel = "bank_transfer";
+  verified.data_json = R"({"reference":"ref_1","status":"success","amount":50000})";
+  g_autoptr(FlMethodResponse) completed = make_checkout_completed_response(verified);
+  ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(completed));
+  FlValue* result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(completed));
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(result, "status")), "success");
+  FlValue* data = fl_value_lookup_string(result, "data");
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(data, "reference")), "ref_1");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(data, "amount")), 50000);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(data, "payment_method")), "bank_transfer");
+
+  all_paystack_payments::VerifyResult failed;
+  failed.error_code = "HTTP_ERROR";
+  failed.error_message = "Couldn't connect to server";
+  g_autoptr(FlMethodResponse) error = make_checkout_completed_response(failed);
+  ASSERT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(error));
+  EXPECT_STREQ(fl_method_error_response_get_code(FL_METHOD_ERROR_RESPONSE(error)), "HTTP_ERROR");
+
+  // Checkouts the listener is not the callback of are only reported opened.
+  g_autoptr(FlMethodResponse) opened = make_checkout_opened_response();
+  FlValue* opened_data = fl_value_lookup_string(fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(opened)), "data");
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(opened_data, "status")), "pending");
+  EXPECT_EQ(fl_value_lookup_string(opened_data, "reference"), nullptr);
+}
+
+TEST(AllPaystackPaymentsPlugin, MakeBatchEntry) {
+  g_autoptr(FlValue) data = fl_value_new_map();
+  fl_value_set_string_take(data, "status", fl_value_new_string("success"));
+  g_autoptr(FlMethodResponse) success =
+      FL_METHOD_RESPONSE(fl_method_success_response_new(data));
+  g_autoptr(FlValue) success_entry = make_batch_entry("ref_ok", success);
+  EXPECT_STREQ(
+      fl_value_get_string(fl_value_lookup_string(success_entry, "reference")),
+      "ref_ok");
+  EXPECT_TRUE(
+      fl_value_get_bool(fl_value_lookup_string(success_entry, "success")));
+  EXPECT_EQ(fl_value_lookup_string(success_entry, "data"), data);
+
+  g_autoptr(FlMethodResponse) error = FL_METHOD_RESPONSE(
+      fl_method_error_response_new("API_ERROR", "Transaction not found",
+                                   nullptr));
+  g_autoptr(FlValue) error_entry = make_batch_entry("ref_bad", error);
+  EXPECT_FALSE(
+      fl_value_get_bool(fl_value_lookup_string(error_entry, "success")));
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(error_entry, "code")),
+               "API_ERROR");
+  EXPECT_STREQ(
+      fl_value_get_string(fl_value_lookup_string(error_entry, "message")),
+      "Transaction not found");
+}
+
+TEST(AllPaystackPaymentsPlugin, MakesPaymentStatusEvents) {
+  all_paystack_payments::PaymentStatusUpdate update;
+  update.reference = "ref_1";
+  update.status = "abandoned";
+  update.final = true;
+  update.timed_out = true;
+  g_autoptr(FlValue) event = payment_status_update_to_fl_value(update);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(event, "reference")),
+               "ref_1");
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(event, "status")),
+               "abandoned");
+  EXPECT_TRUE(fl_value_get_bool(fl_value_lookup_string(event, "final")));
+  EXPECT_TRUE(fl_value_get_bool(fl_value_lookup_string(event, "timedOut")));
+
+  const PluginMethod* watch = plugin_method_from_name("watchPayment");
+  ASSERT_NE(watch, nullptr);
+  EXPECT_TRUE(watch->async);
+  EXPECT_NE(plugin_method_from_name("unwatchPayment"), nullptr);
+}
+
+TEST(FlValueBuilder, ConvertsJson) {
+  const std::string json =
+      R"({"s":"a\"b","i":-3,"d":1.5,"b":true,"n":null,"l":[1,{"k":[]}]})";
+  g_autoptr(FlValue) value =
+      json_to_fl_value(json.data(), json.size(), std::vector<std::string>());
+  ASSERT_NE(value, nullptr);
+  ASSERT_EQ(fl_value_get_type(value), FL_VALUE_TYPE_MAP);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(value, "s")), "a\"b");
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(value, "i")), -3);
+  EXPECT_EQ(fl_value_get_float(fl_value_lookup_string(value, "d")), 1.5);
+  EXPECT_TRUE(fl_value_get_bool(fl_value_lookup_string(value, "b")));
+  EXPECT_EQ(fl_value_get_type(fl_value_lookup_string(value, "n")),
+            FL_VALUE_TYPE_NULL);
+  FlValue* list = fl_value_lookup_string(value, "l");
+  ASSERT_EQ(fl_value_get_length(list), 2u);
+  FlValue* inner = fl_value_get_list_value(list, 1);
+  EXPECT_EQ(fl_value_get_type(fl_value_lookup_string(inner, "k")),
+            FL_VALUE_TYPE_LIST);
+
+  EXPECT_EQ(json_to_fl_value("{\"a\":", 5, std::vector<std::string>()),
+            nullptr);
+}
+
+TEST(FlValueBuilder, ProjectsTopLevelFields) {
+  const std::string json =
+      R"({"skip":{"a":[1,{"b":2}]},"keep":{"x":1},"drop":"y","also":[3]})";
+  g_autoptr(FlValue) value =
+      json_to_fl_value(json.data(), json.size(), {"keep", "also", "missing"});
+  ASSERT_NE(value, nullptr);
+  EXPECT_EQ(fl_value_get_length(value), 2u);
+  FlValue* keep = fl_value_lookup_string(value, "keep");
+  ASSERT_NE(keep, nullptr);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(keep, "x")), 1);
+  EXPECT_EQ(fl_value_get_length(fl_value_lookup_string(value, "also")), 1u);
+}
+
+TEST(FlValueToJson, WritesNestedValues) {
+  g_autoptr(FlValue) value = fl_value_new_map();
+  fl_value_set_string_take(value, "s", fl_value_new_string("a\"\\\n\x01\xc3\xa9"));
+  fl_value_set_string_take(value, "i", fl_value_new_int(std::numeric_limits<int64_t>::min()));
+  fl_value_set_string_take(value, "d", fl_value_new_float(0.1));
+  fl_value_set_string_take(value, "w", fl_value_new_float(2));
+  fl_value_set_string_take(value, "b", fl_value_new_bool(false));
+  fl_value_set_string_take(value, "n", fl_value_new_null());
+  FlValue* list = fl_value_new_list();
+  fl_value_append_take(list, fl_value_new_int(1));
+  fl_value_append_take(list, fl_value_new_map());
+  fl_value_set_string_take(value, "l", list);
+  const int32_t ints[] = {-1, 2};
+  fl_value_set_string_take(value, "t", fl_value_new_int32_list(ints, 2));
+
+  std::string json;
+  ASSERT_TRUE(fl_value_to_json(value, &json));
+  EXPECT_EQ(json,
+            R"({"s":"a\"\\\n\u0001)" "\xc3\xa9" R"(","i":-9223372036854775808,)"
+            R"("d":0.1,"w":2.0,"b":false,"n":null,"l":[1,{}],"t":[-1,2]})");
+}
+
+TEST(FlValueToJson, RejectsValuesWithoutJsonForm) {
+  std::string json;
+  g_autoptr(FlValue) nan = fl_value_new_float(std::nan(""));
+  EXPECT_FALSE(fl_value_to_json(nan, &json));
+
+  g_autoptr(FlValue) int_key = fl_value_new_map();
+  fl_value_set_take(int_key, fl_value_new_int(1), fl_value_new_null());
+  EXPECT_FALSE(fl_value_to_json(int_key, &json));
+
+  g_autoptr(FlValue) deep = fl_value_new_list();
+  FlValue* inner = deep;
+  for (int i = 0; i < 100; i++) {
+    FlValue* next = fl_value_new_list();
+    fl_value_append_take(inner, next);
+    inner = next;
+  }
+  EXPECT_FALSE(fl_value_to_json(deep, &json));
+}
+
+TEST(FlValueToJson, WritesLargeCarts) {
+  g_autoptr(FlValue) metadata = fl_value_new_map();
+  FlValue* items = fl_value_new_list();
+  nlohmann::json expected_items = nlohmann::json::array();
+  for (int i = 0; i < 500; i++) {
+    std::string name = "Item \"" + std::to_string(i) + "\"";
+    FlValue* item = fl_value_new_map();
+    fl_value_set_string_take(item, "name", fl_value_new_string(name.c_str()));
+    fl_value_set_string_take(item, "quantity", fl_value_new_int(i));
+    fl_value_set_string_take(item, "price", fl_value_new_float(i * 1.25));
+    fl_value_append_take(items, item);
+    expected_items.push_back({{"name", name}, {"quantity", i}, {"price", i * 1.25}});
+  }
+  fl_value_set_string_take(metadata, "cart", items);
+
+  std::string json;
+  ASSERT_TRUE(fl_value_to_json(metadata, &json));
+  nlohmann::json parsed = nlohmann::json::parse(json);
+  EXPECT_EQ(parsed["cart"], expected_items);
+}
+
 }  // namespace test
 }  // namespace all_paystack_payments
@@ -0,0 +1,663 @@
+#include "paystack_mock_server.h"
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "paystack_json_stream.h"
+#include "paystack_json_writer.h"
+
+namespace all_paystack_payments {
+
+namespace {
+
+constexpr char kInitializePath[] = "/transaction/initialize";
+constexpr char kVerifyPath[] = "/transaction/verify/";
+
+// Larger requests are refused; the plugin's are a few hundred bytes.
+constexpr size_t kMaxHeaderBytes = 16 * 1024;
+constexpr size_t kMaxBodyBytes = 1024 * 1024;
+
+// How often the accept loop checks whether the server is stopping.
+constexpr int kAcceptPollMilliseconds = 100;
+
+bool ParseNumber(const std::string& text, double* value) {
+  if (text.empty()) return false;
+  char* end = nullptr;
+  *value = strtod(text.c_str(), &end);
+  return *end == '\0' && std::isfinite(*value) && *value >= 0;
+}
+
+// Splits "A,B" into two numbers.
+bool ParsePair(const std::string& text, double* first, double* second) {
+  size_t comma = text.find(',');
+  return comma != std::string::npos &&
+         ParseNumber(text.substr(0, comma), first) &&
+         ParseNumber(text.substr(comma + 1), second);
+}
+
+const char* ReasonPhrase(long status_code) {
+  switch (status_code) {
+    case 200:
+      return "OK";
+    case 400:
+      return "Bad Request";
+    case 401:
+      return "Unauthorized";
+    case 404:
+      return "Not Found";
+    case 413:
+      return "Payload Too Large";
+    case 429:
+      return "Too Many Requests";
+    case 500:
+      return "Internal Server Error";
+    case 502:
+      return "Bad Gateway";
+    default:
+      return "Unknown";
+  }
+}
+
+MockFixture Failure(long status_code, const char* message) {
+  MockFixture fixture;
+  fixture.status_code = status_code;
+  fixture.body = R"({"status":false,"message":)";
+  json_append_string(&fixture.body, message, strlen(message));
+  fixture.body.push_back('}');
+  return fixture;
+}
+
+// Reads the top-level "reference" member of an initialize request body.
+class ReferenceReader : public JsonHandler {
+ public:
+  explicit ReferenceReader(std::string* reference) : reference_(reference) {}
+
+  bool Null() override { return Value(); }
+  bool Bool(bool) override { return Value(); }
+  bool Int(int64_t) override { return Value(); }
+  bool Double(double) override { return Value(); }
+  bool String(const char* data, size_t length) override {
+    if (depth_ == 1 && in_reference_) reference_->assign(data, length);
+    return Value();
+  }
+  bool StartObject() override { return Open(); }
+  bool Key(const char* data, size_t length) override {
+    in_reference_ = depth_ == 1 && length == strlen("reference") &&
+                    memcmp(data, "reference", length) == 0;
+    return true;
+  }
+  bool EndObject() override { return Close(); }
+  bool StartArray() override { return Open(); }
+  bool EndArray() override { return Close(); }
+
+ private:
+  bool Value() {
+    in_reference_ = false;
+    return true;
+  }
+  bool Open() {
+    in_reference_ = false;
+    depth_++;
+    return true;
+  }
+  bool Close() {
+    depth_--;
+    return true;
+  }
+
+  std::string* reference_;
+  int depth_ = 0;
+  bool in_reference_ = false;
+};
+
+// Keeps fixture names to a single path component.
+std::string FixtureName(const std::string& reference) {
+  std::string name = "verify_";
+  for (char c : reference) {
+    bool safe = isalnum(static_cast<unsigned char>(c)) || c == '-' ||
+                c == '_' || c == '.';
+    name.push_back(safe ? c : '_');
+  }
+  name.append(".json");
+  return name;
+}
+
+bool ReadFixture(const std::string& path, MockFixture* fixture) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+  std::string status_line;
+  if (!std::getline(file, status_line)) return false;
+  char* end = nullptr;
+  fixture->status_code = strtol(status_line.c_str(), &end, 10);
+  if (end == status_line.c_str() || fixture->status_code < 100 ||
+      fixture->status_code > 599) {
+    return false;
+  }
+  std::ostringstream body;
+  body << file.rdbuf();
+  fixture->body = body.str();
+  return true;
+}
+
+bool WriteFixture(const std::string& path, const MockFixture& fixture) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << fixture.status_code << '\n' << fixture.body;
+  return static_cast<bool>(file);
+}
+
+bool SendAll(int fd, const char* data, size_t size) {
+#ifdef MSG_NOSIGNAL
+  const int flags = MSG_NOSIGNAL;
+#else
+  const int flags = 0;
+#endif
+  while (size > 0) {
+    ssize_t sent = send(fd, data, size, flags);
+    if (sent < 0 && errno == EINTR) continue;
+    if (sent <= 0) return false;
+    data += sent;
+    size -= static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+bool EqualsIgnoringCase(const std::string& a, const char* b) {
+  size_t length = strlen(b);
+  if (a.size() != length) return false;
+  for (size_t i = 0; i < length; i++) {
+    if (tolower(static_cast<unsigned char>(a[i])) !=
+        tolower(static_cast<unsigned char>(b[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool parse_latency_distribution(const std::string& spec,
+                                LatencyDistribution* latency) {
+  LatencyDistribution parsed;
+  size_t colon = spec.find(':');
+  std::string kind = spec.substr(0, colon);
+  std::string arguments =
+      colon == std::string::npos ? std::string() : spec.substr(colon + 1);
+  if (kind == "none" && colon == std::string::npos) {
+    parsed.kind = LatencyDistribution::Kind::kNone;
+  } else if (kind == "fixed") {
+    parsed.kind = LatencyDistribution::Kind::kFixed;
+    if (!ParseNumber(arguments, &parsed.first)) return false;
+  } else if (kind == "uniform") {
+    parsed.kind = LatencyDistribution::Kind::kUniform;
+    if (!ParsePair(arguments, &parsed.first, &parsed.second) ||
+        parsed.first > parsed.second) {
+      return false;
+    }
+  } else if (kind == "exponential") {
+    parsed.kind = LatencyDistribution::Kind::kExponential;
+    if (!ParseNumber(arguments, &parsed.first)) return false;
+  } else if (kind == "lognormal") {
+    parsed.kind = LatencyDistribution::Kind::kLogNormal;
+    if (!ParsePair(arguments, &parsed.first, &parsed.second) ||
+        parsed.first == 0) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  *latency = parsed;
+  return true;
+}
+
+struct MockServer::Connection {
+  int fd = -1;
+  std::thread thread;
+  std::atomic<bool> done{false};
+};
+
+struct MockServer::Request {
+  std::string method;
+  std::string path;
+  std::string authorization;
+  std::string body;
+  bool keep_alive = true;
+};
+
+MockServer::MockServer(MockServerOptions options)
+    : options_(std::move(options)),
+      random_(options_.seed != 0 ? options_.seed : std::random_device()()) {}
+
+MockServer::~MockServer() {
+  Stop();
+}
+
+bool MockServer::Start(std::string* error) {
+  if (!LoadFixtures(error)) return false;
+
+  listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    *error = strerror(errno);
+    return false;
+  }
+  int reuse = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(options_.port));
+  if (inet_pton(AF_INET, options_.bind_address.c_str(), &address.sin_addr) !=
+      1) {
+    *error = "Invalid bind address " + options_.bind_address;
+    close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  socklen_t length = sizeof(address);
+  if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+      listen(listen_fd_, SOMAXCONN) != 0 ||
+      getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+                  &length) != 0) {
+    *error = strerror(errno);
+    close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  port_ = ntohs(address.sin_port);
+  accept_thread_ = std::thread(&MockServer::AcceptLoop, this);
+  return true;
+}
+
+void MockServer::Stop() {
+  if (stopping_.exchange(true)) return;
+  {
+    std::lock_guard<std::mutex> lock(stop_mutex_);
+  }
+  stop_condition_.notify_all();
+  if (accept_thread_.joinable()) accept_thread_.join();
+  if (listen_fd_ >= 0) close(listen_fd_);
+
+  // Unblocks the connection threads' reads and writes.
+  std::list<std::unique_ptr<Connection>> connections;
+  {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    for (auto& connection : connections_) {
+      shutdown(connection->fd, SHUT_RDWR);
+    }
+    connections.swap(connections_);
+  }
+  for (auto& connection : connections) {
+    connection->thread.join();
+    close(connection->fd);
+  }
+}
+
+std::string MockServer::base_url() const {
+  return "http://" + options_.bind_address + ":" + std::to_string(port_);
+}
+
+MockServerStats MockServer::stats() const {
+  MockServerStats stats;
+  stats.requests = requests_.load();
+  stats.dropped = dropped_.load();
+  stats.rate_limited = rate_limited_.load();
+  stats.errors = errors_.load();
+  stats.slow_bodies = slow_bodies_.load();
+  stats.replayed = replayed_.load();
+  stats.recorded = recorded_.load();
+  return stats;
+}
+
+void MockServer::AcceptLoop() {
+  while (!stopping_) {
+    pollfd listener = {listen_fd_, POLLIN, 0};
+    if (poll(&listener, 1, kAcceptPollMilliseconds) <= 0) continue;
+    int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) continue;
+    int no_delay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    // Reaps the connections that have been closed since the last one.
+    for (auto it = connections_.begin(); it != connections_.end();) {
+      if ((*it)->done) {
+        (*it)->thread.join();
+        close((*it)->fd);
+        it = connections_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    auto connection = std::make_unique<Connection>();
+    connection->fd = fd;
+    connection->thread = std::thread(&MockServer::Serve, this,
+                                     connection.get());
+    connections_.push_back(std::move(connection));
+  }
+}
+
+void MockServer::Serve(Connection* connection) {
+  int fd = connection->fd;
+  std::string buffer;
+  char chunk[4096];
+  bool open = true;
+  while (open && !stopping_) {
+    size_t header_end = buffer.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+      if (buffer.size() > kMaxHeaderBytes) break;
+      ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+      if (received < 0 && errno == EINTR) continue;
+      if (received <= 0) break;
+      buffer.append(chunk, static_cast<size_t>(received));
+      continue;
+    }
+
+    Request request;
+    std::istringstream head(buffer.substr(0, header_end));
+    std::string line;
+    std::getline(head, line);
+    std::istringstream request_line(line);
+    std::string version;
+    request_line >> request.method >> request.path >> version;
+    request.keep_alive = version == "HTTP/1.1";
+    size_t content_length = 0;
+    while (std::getline(head, line)) {
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      size_t colon = line.find(':');
+      if (colon == std::string::npos) continue;
+      std::string name = line.substr(0, colon);
+      size_t value_start = line.find_first_not_of(' ', colon + 1);
+      std::string value = value_start == std::string::npos
+                              ? std::string()
+                              : line.substr(value_start);
+      if (EqualsIgnoringCase(name, "content-length")) {
+        content_length = strtoul(value.c_str(), nullptr, 10);
+      } else if (EqualsIgnoringCase(name, "authorization")) {
+        request.authorization = value;
+      } else if (EqualsIgnoringCase(name, "connection")) {
+        if (EqualsIgnoringCase(value, "close")) request.keep_alive = false;
+        if (EqualsIgnoringCase(value, "keep-alive")) request.keep_alive = true;
+      }
+    }
+    if (content_length > kMaxBodyBytes) {
+      MockFixture response = Failure(413, "Request body too large");
+      std::string head_out = "HTTP/1.1 413 Payload Too Large\r\n"
+                             "Content-Type: application/json\r\n"
+                             "Content-Length: " +
+                             std::to_string(response.body.size()) +
+                             "\r\nConnection: close\r\n\r\n";
+      SendAll(fd, head_out.data(), head_out.size());
+      SendAll(fd, response.body.data(), response.body.size());
+      break;
+    }
+
+    size_t request_end = header_end + 4 + content_length;
+    while (buffer.size() < request_end && !stopping_) {
+      ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+      if (received < 0 && errno == EINTR) continue;
+      if (received <= 0) {
+        open = false;
+        break;
+      }
+      buffer.append(chunk, static_cast<size_t>(received));
+    }
+    if (!open || buffer.size() < request_end) break;
+    request.body = buffer.substr(header_end + 4, content_length);
+    buffer.erase(0, request_end);
+
+    open = Respond(fd, request) && request.keep_alive;
+  }
+  shutdown(fd, SHUT_RDWR);
+  connection->done = true;
+}
+
+bool MockServer::Respond(int fd, const Request& request) {
+  requests_++;
+  if (!Sleep(DrawLatency())) return false;
+
+  double fault = Draw();
+  bool slow = Draw() < options_.slow_body_rate;
+  MockFixture response;
+  bool replayed = false;
+  bool recorded = false;
+  if (fault < options_.drop_rate) {
+    // The connection is closed without a response.
+    dropped_++;
+    return false;
+  } else if (fault < options_.drop_rate + options_.rate_limit_rate) {
+    rate_limited_++;
+    response = Failure(429, "Too many requests");
+  } else if (fault < options_.drop_rate + options_.rate_limit_rate +
+                         options_.error_rate) {
+    errors_++;
+    response = Failure(500, "Internal server error");
+  } else {
+    response = Answer(request, &replayed, &recorded);
+  }
+  if (replayed) replayed_++;
+  if (recorded) recorded_++;
+
+  std::string head = "HTTP/1.1 " + std::to_string(response.status_code) +
+                     " " + ReasonPhrase(response.status_code) +
+                     "\r\nContent-Type: application/json\r\nContent-Length: " +
+                     std::to_string(response.body.size()) + "\r\n";
+  if (response.status_code == 429) {
+    head += "Retry-After: " + std::to_string(options_.retry_after_seconds) +
+            "\r\n";
+  }
+  if (!request.keep_alive) head += "Connection: close\r\n";
+  head += "\r\n";
+  if (!slow || response.body.empty()) {
+    head += response.body;
+    return SendAll(fd, head.data(), head.size());
+  }
+
+  slow_bodies_++;
+  if (!SendAll(fd, head.data(), head.size())) return false;
+  size_t chunk_bytes = std::max<size_t>(options_.slow_body_chunk_bytes, 1);
+  for (size_t offset = 0; offset < response.body.size();
+       offset += chunk_bytes) {
+    if (offset > 0 && !Sleep(options_.slow_body_interval_ms)) return false;
+    size_t size = std::min(chunk_bytes, response.body.size() - offset);
+    if (!SendAll(fd, response.body.data() + offset, size)) return false;
+  }
+  return true;
+}
+
+MockFixture MockServer::Answer(const Request& request, bool* replayed,
+                               bool* recorded) {
+  const size_t verify_path_length = strlen(kVerifyPath);
+  bool initialize = request.path == kInitializePath;
+  bool verify = request.path.compare(0, verify_path_length, kVerifyPath) == 0 &&
+                request.path.size() > verify_path_length;
+  if ((initialize && request.method != "POST") ||
+      (verify && request.method != "GET") || (!initialize && !verify)) {
+    return Failure(404, "Not found");
+  }
+  if (request.authorization.compare(0, strlen("Bearer "), "Bearer ") != 0 ||
+      request.authorization.size() == strlen("Bearer ")) {
+    return Failure(401, "Invalid key");
+  }
+
+  std::string reference;
+  std::string fixture;
+  if (initialize) {
+    fixture = "initialize.json";
+  } else {
+    reference = request.path.substr(verify_path_length);
+    fixture = FixtureName(reference);
+  }
+  {
+    std::lock_guard<std::mutex> lock(fixtures_mutex_);
+    auto it = fixtures_.find(fixture);
+    if (it == fixtures_.end() && verify && options_.upstream == nullptr) {
+      it = fixtures_.find("verify.json");
+    }
+    if (it != fixtures_.end()) {
+      *replayed = true;
+      return it->second;
+    }
+  }
+  if (options_.upstream != nullptr) {
+    MockFixture response;
+    *recorded = Forward(request, fixture, &response);
+    return response;
+  }
+
+  MockFixture response;
+  if (initialize) {
+    ReferenceReader reader(&reference);
+    JsonStreamParser parser(&reader);
+    if (!parser.Feed(request.body.data(), request.body.size()) ||
+        !parser.Finish()) {
+      return Failure(400, "Invalid JSON body");
+    }
+    if (reference.empty()) {
+      reference = "mock_" + std::to_string(next_reference_++);
+    }
+    std::string url = "https://checkout.paystack.com/" + reference;
+    response.body =
+        R"({"status":true,"message":"Authorization URL created","data":{)"
+        R"("authorization_url":)";
+    json_append_string(&response.body, url.data(), url.size());
+    response.body.append(R"(,"access_code":)");
+    json_append_string(&response.body, reference.data(), reference.size());
+    response.body.append(R"(,"reference":)");
+    json_append_string(&response.body, reference.data(), reference.size());
+    response.body.append("}}");
+  } else {
+    response.body =
+        R"({"status":true,"message":"Verification successful","data":{)"
+        R"("id":1,"domain":"test","status":"success","reference":)";
+    json_append_string(&response.body, reference.data(), reference.size());
+    response.body.append(
+        R"(,"amount":50000,"gateway_response":"Successful",)"
+        R"("paid_at":"2024-01-01T00:00:00.000Z",)"
+        R"("created_at":"2024-01-01T00:00:00.000Z","channel":"card",)"
+        R"("currency":"NGN","metadata":null,"fees":750,)"
+        R"("customer":{"id":1,"email":"customer@example.com"},)"
+        R"("authorization":{"authorization_code":"AUTH_mock",)"
+        R"("bin":"408408","last4":"4081","card_type":"visa",)"
+        R"("bank":"TEST BANK","reusable":true}}})");
+  }
+  return response;
+}
+
+bool MockServer::Forward(const Request& request, const std::string& fixture,
+                         MockFixture* response) {
+  HttpRequest upstream_request;
+  upstream_request.method =
+      request.method == "POST" ? HttpMethod::kPost : HttpMethod::kGet;
+  upstream_request.url = options_.upstream_base_url + request.path;
+  upstream_request.public_key =
+      request.authorization.substr(strlen("Bearer "));
+  upstream_request.body = request.body;
+  auto done = std::make_shared<std::promise<HttpResponse>>();
+  std::future<HttpResponse> result = done->get_future();
+  options_.upstream->Send(
+      std::move(upstream_request),
+      [done](HttpResponse& response) { done->set_value(response); }, nullptr);
+  HttpResponse upstream_response = result.get();
+  if (!upstream_response.ok()) {
+    *response = Failure(502, upstream_response.error.c_str());
+    return false;
+  }
+
+  response->status_code = upstream_response.status_code;
+  response->body = upstream_response.body;
+  {
+    std::lock_guard<std::mutex> lock(fixtures_mutex_);
+    fixtures_[fixture] = *response;
+  }
+  if (!options_.fixtures_dir.empty()) {
+    WriteFixture(options_.fixtures_dir + "/" + fixture, *response);
+  }
+  return true;
+}
+
+bool MockServer::LoadFixtures(std::string* error) {
+  if (options_.fixtures_dir.empty()) return true;
+  DIR* directory = opendir(options_.fixtures_dir.c_str());
+  if (directory == nullptr) {
+    *error = options_.fixtures_dir + ": " + strerror(errno);
+    return false;
+  }
+  std::vector<std::string> names;
+  while (dirent* entry = readdir(directory)) {
+    std::string name = entry->d_name;
+    const std::string extension = ".json";
+    if (name.size() > extension.size() &&
+        name.compare(name.size() - extension.size(), extension.size(),
+                     extension) == 0) {
+      names.push_back(name);
+    }
+  }
+  closedir(directory);
+
+  std::lock_guard<std::mutex> lock(fixtures_mutex_);
+  for (const std::string& name : names) {
+    MockFixture fixture;
+    if (!ReadFixture(options_.fixtures_dir + "/" + name, &fixture)) {
+      *error = options_.fixtures_dir + "/" + name +
+               ": expected a status code on the first line";
+      return false;
+    }
+    fixtures_[name] = std::move(fixture);
+  }
+  return true;
+}
+
+bool MockServer::Sleep(double milliseconds) {
+  std::unique_lock<std::mutex> lock(stop_mutex_);
+  if (milliseconds > 0) {
+    stop_condition_.wait_for(
+        lock, std::chrono::duration<double, std::milli>(milliseconds),
+        [this] { return stopping_.load(); });
+  }
+  return !stopping_;
+}
+
+double MockServer::Draw() {
+  std::lock_guard<std::mutex> lock(random_mutex_);
+  return std::uniform_real_distribution<double>(0, 1)(random_);
+}
+
+double MockServer::DrawLatency() {
+  const LatencyDistribution& latency = options_.latency;
+  std::lock_guard<std::mutex> lock(random_mutex_);
+  switch (latency.kind) {
+    case LatencyDistribution::Kind::kNone:
+      return 0;
+    case LatencyDistribution::Kind::kFixed:
+      return latency.first;
+    case LatencyDistribution::Kind::kUniform:
+      return std::uniform_real_distribution<double>(latency.first,
+                                                    latency.second)(random_);
+    case LatencyDistribution::Kind::kExponential:
+      if (latency.first == 0) return 0;
+      return std::exponential_distribution<double>(1 / latency.first)(random_);
+    case LatencyDistribution::Kind::kLogNormal:
+      return std::lognormal_distribution<double>(std::log(latency.first),
+                                                 latency.second)(random_);
+  }
+  return 0;
+}
+
+}  // namespace all_paystack_payments
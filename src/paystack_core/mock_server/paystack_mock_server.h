@@ -0,0 +1,184 @@
+#ifndef PAYSTACK_CORE_MOCK_SERVER_PAYSTACK_MOCK_SERVER_H_
+#define PAYSTACK_CORE_MOCK_SERVER_PAYSTACK_MOCK_SERVER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "paystack_transport.h"
+
+namespace all_paystack_payments {
+
+// How long the mock server waits before answering each request, in
+// milliseconds.
+struct LatencyDistribution {
+  enum class Kind { kNone, kFixed, kUniform, kExponential, kLogNormal };
+
+  Kind kind = Kind::kNone;
+  // kFixed: the delay. kUniform: the lower bound. kExponential: the mean.
+  // kLogNormal: the median.
+  double first = 0;
+  // kUniform: the upper bound. kLogNormal: the standard deviation of the
+  // delay's logarithm, which sets how heavy its tail is.
+  double second = 0;
+};
+
+// Parses "none", "fixed:MS", "uniform:MIN,MAX", "exponential:MEAN" or
+// "lognormal:MEDIAN,SIGMA" into |latency|. Returns false if |spec| is none of
+// those, or has negative or inverted bounds.
+bool parse_latency_distribution(const std::string& spec,
+                                LatencyDistribution* latency);
+
+// A stored response, as replayed from a fixture file.
+struct MockFixture {
+  long status_code = 200;
+  std::string body;
+};
+
+struct MockServerOptions {
+  std::string bind_address = "127.0.0.1";
+  // 0 picks a free port; MockServer::port() tells which.
+  int port = 0;
+  LatencyDistribution latency;
+
+  // Probabilities, from 0 to 1, that a request ends with each fault. They
+  // are exclusive and checked in this order.
+  //
+  // The connection is closed without a response.
+  double drop_rate = 0;
+  // 429 Too Many Requests, with a Retry-After header.
+  double rate_limit_rate = 0;
+  // 500 Internal Server Error.
+  double error_rate = 0;
+  int retry_after_seconds = 1;
+
+  // Probability that a response body is written |slow_body_chunk_bytes| at a
+  // time, |slow_body_interval_ms| apart, instead of at once.
+  double slow_body_rate = 0;
+  size_t slow_body_chunk_bytes = 16;
+  int slow_body_interval_ms = 50;
+
+  // Seeds the fault and latency draws, so a run can be repeated. 0 seeds
+  // them randomly.
+  uint64_t seed = 0;
+
+  // Directory of response fixtures, replayed instead of the built-in
+  // responses. Each file holds the status code on its first line and the
+  // body after it:
+  //
+  //   initialize.json         POST /transaction/initialize
+  //   verify_<reference>.json GET /transaction/verify/<reference>
+  //   verify.json             any other verification
+  std::string fixtures_dir;
+
+  // If set, requests without a fixture are forwarded to |upstream_base_url|
+  // through |upstream| and their responses saved to |fixtures_dir|, so that
+  // later runs replay them without network access.
+  Transport* upstream = nullptr;
+  std::string upstream_base_url;
+};
+
+// Requests a MockServer has handled, by outcome.
+struct MockServerStats {
+  uint64_t requests = 0;
+  uint64_t dropped = 0;
+  uint64_t rate_limited = 0;
+  uint64_t errors = 0;
+  uint64_t slow_bodies = 0;
+  uint64_t replayed = 0;
+  uint64_t recorded = 0;
+};
+
+// Local stand-in for the Paystack API, for measuring throughput and tail
+// latency without network access. It serves POST /transaction/initialize
+// and GET /transaction/verify/:reference over HTTP/1.1 with keep-alive, and
+// injects the latency and faults its options ask for.
+//
+// Each connection is served on its own thread. POSIX only.
+class MockServer {
+ public:
+  explicit MockServer(MockServerOptions options);
+  ~MockServer();
+
+  // Disallow copy and assign.
+  MockServer(const MockServer&) = delete;
+  MockServer& operator=(const MockServer&) = delete;
+
+  // Starts listening and serving on background threads. Returns false, with
+  // |error| set, if the address cannot be bound or the fixtures cannot be
+  // read.
+  bool Start(std::string* error);
+
+  // Closes every connection and waits for the threads to exit. Called by the
+  // destructor.
+  void Stop();
+
+  int port() const { return port_; }
+
+  // The URL to pass to initialize as baseUrl.
+  std::string base_url() const;
+
+  MockServerStats stats() const;
+
+ private:
+  struct Connection;
+  struct Request;
+
+  void AcceptLoop();
+  void Serve(Connection* connection);
+  // Returns false if the connection must be closed afterwards.
+  bool Respond(int fd, const Request& request);
+  MockFixture Answer(const Request& request, bool* replayed, bool* recorded);
+  // Fills |response| from upstream. Returns false if the request failed,
+  // leaving a 502 in |response|.
+  bool Forward(const Request& request, const std::string& fixture,
+               MockFixture* response);
+  bool LoadFixtures(std::string* error);
+
+  // Waits |milliseconds| unless the server stops first. Returns false if it
+  // did.
+  bool Sleep(double milliseconds);
+  double Draw();
+  double DrawLatency();
+
+  const MockServerOptions options_;
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::thread accept_thread_;
+  std::atomic<bool> stopping_{false};
+
+  std::mutex connections_mutex_;
+  std::list<std::unique_ptr<Connection>> connections_;
+
+  std::mutex stop_mutex_;
+  std::condition_variable stop_condition_;
+
+  std::mutex random_mutex_;
+  std::mt19937_64 random_;
+
+  // By file name.
+  std::mutex fixtures_mutex_;
+  std::map<std::string, MockFixture> fixtures_;
+
+  std::atomic<uint64_t> next_reference_{1};
+
+  std::atomic<uint64_t> requests_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> rate_limited_{0};
+  std::atomic<uint64_t> errors_{0};
+  std::atomic<uint64_t> slow_bodies_{0};
+  std::atomic<uint64_t> replayed_{0};
+  std::atomic<uint64_t> recorded_{0};
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_MOCK_SERVER_PAYSTACK_MOCK_SERVER_H_
@@ -0,0 +1,242 @@
+// Serves a local stand-in for the Paystack API, so that the plugins can be
+// load-tested without network access. Point them at it with
+//
+//   await AllPaystackPayments.initialize(key, baseUrl: 'http://127.0.0.1:8089');
+//
+// and shape its behaviour with the options below, for example:
+//
+// $ ./paystack_mock_server --latency lognormal:80,0.6 --error-rate 0.01
+//
+// answers after a median of 80 ms, with a long tail, and fails 1% of the
+// requests with a 500.
+//
+// Real responses can be captured once and replayed afterwards:
+//
+// $ ./paystack_mock_server --fixtures f --record-from https://api.paystack.co
+// $ ./paystack_mock_server --fixtures f
+//
+// Interrupting it prints how many requests it handled, by outcome.
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#ifdef PAYSTACK_MOCK_SERVER_RECORD
+#include <curl/curl.h>
+#endif
+
+#include "paystack_mock_server.h"
+
+using all_paystack_payments::MockServer;
+using all_paystack_payments::MockServerOptions;
+using all_paystack_payments::MockServerStats;
+
+namespace {
+
+constexpr char kUsage[] =
+    "Usage: paystack_mock_server [options]\n"
+    "  --bind ADDRESS             IPv4 address to listen on (127.0.0.1)\n"
+    "  --port PORT                port to listen on, 0 for any (8089)\n"
+    "  --latency SPEC             none, fixed:MS, uniform:MIN,MAX,\n"
+    "                             exponential:MEAN or lognormal:MEDIAN,SIGMA\n"
+    "  --drop-rate P              share of connections closed unanswered\n"
+    "  --rate-limit-rate P        share of requests answered with 429\n"
+    "  --retry-after SECONDS      Retry-After sent with 429 (1)\n"
+    "  --error-rate P             share of requests answered with 500\n"
+    "  --slow-body-rate P         share of bodies written slowly\n"
+    "  --slow-body-chunk BYTES    bytes per slow write (16)\n"
+    "  --slow-body-interval MS    delay between slow writes (50)\n"
+    "  --seed N                   repeatable fault and latency draws\n"
+    "  --fixtures DIR             replay responses stored in DIR\n"
+    "  --record-from URL          forward requests without a fixture to URL\n"
+    "                             and store the responses in DIR\n";
+
+volatile sig_atomic_t g_interrupted = 0;
+
+void OnSignal(int) {
+  g_interrupted = 1;
+}
+
+bool ParseRate(const char* text, double* rate) {
+  char* end = nullptr;
+  *rate = strtod(text, &end);
+  return *end == '\0' && *rate >= 0 && *rate <= 1;
+}
+
+bool ParseInt(const char* text, long long min, long long* value) {
+  char* end = nullptr;
+  *value = strtoll(text, &end, 10);
+  return *end == '\0' && end != text && *value >= min;
+}
+
+#ifdef PAYSTACK_MOCK_SERVER_RECORD
+using all_paystack_payments::HttpCallback;
+using all_paystack_payments::HttpMethod;
+using all_paystack_payments::HttpRequest;
+using all_paystack_payments::HttpResponse;
+
+size_t Collect(char* data, size_t size, size_t nmemb, void* user_data) {
+  static_cast<std::string*>(user_data)->append(data, size * nmemb);
+  return size * nmemb;
+}
+
+// Forwards recorded requests to the real API, one at a time.
+class UpstreamTransport : public all_paystack_payments::Transport {
+ public:
+  all_paystack_payments::RequestId Send(
+      HttpRequest request, HttpCallback callback,
+      all_paystack_payments::BodySink) override {
+    HttpResponse response;
+    CURL* handle = curl_easy_init();
+    curl_slist* headers = nullptr;
+    std::string auth_header = "Authorization: Bearer " + request.public_key;
+    headers = curl_slist_append(headers, auth_header.c_str());
+    curl_easy_setopt(handle, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, Collect);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &response.body);
+    if (request.method == HttpMethod::kPost) {
+      headers = curl_slist_append(headers, "Content-Type: application/json");
+      curl_easy_setopt(handle, CURLOPT_POSTFIELDS, request.body.c_str());
+      curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE,
+                       static_cast<long>(request.body.size()));
+    }
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
+    CURLcode result = curl_easy_perform(handle);
+    if (result != CURLE_OK) response.error = curl_easy_strerror(result);
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response.status_code);
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(handle);
+    callback(response);
+    return 0;
+  }
+
+  // Requests complete inside Send.
+  void Cancel(all_paystack_payments::RequestId) override {}
+
+  void RunAfter(int64_t delay_ms,
+                all_paystack_payments::DelayedTask task) override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    task(false);
+  }
+};
+#endif
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  MockServerOptions options;
+  options.port = 8089;
+  std::string record_from;
+  for (int i = 1; i < argc; i++) {
+    const char* flag = argv[i];
+    if (strcmp(flag, "--help") == 0) {
+      fputs(kUsage, stdout);
+      return 0;
+    }
+    if (i + 1 == argc) {
+      fprintf(stderr, "%s needs a value\n%s", flag, kUsage);
+      return 2;
+    }
+    const char* value = argv[++i];
+    long long number = 0;
+    bool valid = true;
+    if (strcmp(flag, "--bind") == 0) {
+      options.bind_address = value;
+    } else if (strcmp(flag, "--port") == 0) {
+      valid = ParseInt(value, 0, &number) && number <= 65535;
+      options.port = static_cast<int>(number);
+    } else if (strcmp(flag, "--latency") == 0) {
+      valid = all_paystack_payments::parse_latency_distribution(
+          value, &options.latency);
+    } else if (strcmp(flag, "--drop-rate") == 0) {
+      valid = ParseRate(value, &options.drop_rate);
+    } else if (strcmp(flag, "--rate-limit-rate") == 0) {
+      valid = ParseRate(value, &options.rate_limit_rate);
+    } else if (strcmp(flag, "--retry-after") == 0) {
+      valid = ParseInt(value, 0, &number);
+      options.retry_after_seconds = static_cast<int>(number);
+    } else if (strcmp(flag, "--error-rate") == 0) {
+      valid = ParseRate(value, &options.error_rate);
+    } else if (strcmp(flag, "--slow-body-rate") == 0) {
+      valid = ParseRate(value, &options.slow_body_rate);
+    } else if (strcmp(flag, "--slow-body-chunk") == 0) {
+      valid = ParseInt(value, 1, &number);
+      options.slow_body_chunk_bytes = static_cast<size_t>(number);
+    } else if (strcmp(flag, "--slow-body-interval") == 0) {
+      valid = ParseInt(value, 0, &number);
+      options.slow_body_interval_ms = static_cast<int>(number);
+    } else if (strcmp(flag, "--seed") == 0) {
+      valid = ParseInt(value, 1, &number);
+      options.seed = static_cast<uint64_t>(number);
+    } else if (strcmp(flag, "--fixtures") == 0) {
+      options.fixtures_dir = value;
+    } else if (strcmp(flag, "--record-from") == 0) {
+      record_from = value;
+    } else {
+      fprintf(stderr, "Unknown option %s\n%s", flag, kUsage);
+      return 2;
+    }
+    if (!valid) {
+      fprintf(stderr, "Invalid value for %s: %s\n", flag, value);
+      return 2;
+    }
+  }
+  if (options.drop_rate + options.rate_limit_rate + options.error_rate > 1) {
+    fputs("The drop, rate limit and error rates add up to more than 1\n",
+          stderr);
+    return 2;
+  }
+
+#ifdef PAYSTACK_MOCK_SERVER_RECORD
+  UpstreamTransport upstream;
+  if (!record_from.empty()) {
+    if (options.fixtures_dir.empty()) {
+      fputs("--record-from needs --fixtures\n", stderr);
+      return 2;
+    }
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    options.upstream = &upstream;
+    options.upstream_base_url = record_from;
+  }
+#else
+  if (!record_from.empty()) {
+    fputs("Recording needs a build with libcurl\n", stderr);
+    return 2;
+  }
+#endif
+
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, OnSignal);
+  signal(SIGTERM, OnSignal);
+
+  MockServer server(options);
+  std::string error;
+  if (!server.Start(&error)) {
+    fprintf(stderr, "Failed to start: %s\n", error.c_str());
+    return 1;
+  }
+  printf("Serving on %s\n", server.base_url().c_str());
+  fflush(stdout);
+  while (!g_interrupted) {
+    pause();
+  }
+  server.Stop();
+
+  MockServerStats stats = server.stats();
+  printf("%llu requests: %llu dropped, %llu rate limited, %llu errors, "
+         "%llu slow bodies, %llu replayed, %llu recorded\n",
+         static_cast<unsigned long long>(stats.requests),
+         static_cast<unsigned long long>(stats.dropped),
+         static_cast<unsigned long long>(stats.rate_limited),
+         static_cast<unsigned long long>(stats.errors),
+         static_cast<unsigned long long>(stats.slow_bodies),
+         static_cast<unsigned long long>(stats.replayed),
+         static_cast<unsigned long long>(stats.recorded));
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include "paystack_callback_request.h"
+
+#include <cstring>
+
+namespace all_paystack_payments {
+
+namespace {
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Decodes the query component [begin, end), in which '+' stands for a space.
+// Returns false for a malformed escape.
+bool Decode(const char* begin, const char* end, std::string* out) {
+  out->clear();
+  for (const char* c = begin; c < end; c++) {
+    if (*c == '+') {
+      out->push_back(' ');
+    } else if (*c != '%') {
+      out->push_back(*c);
+    } else {
+      if (end - c < 3 || HexValue(c[1]) < 0 || HexValue(c[2]) < 0) {
+        return false;
+      }
+      out->push_back(static_cast<char>(HexValue(c[1]) * 16 + HexValue(c[2])));
+      c += 2;
+    }
+  }
+  return true;
+}
+
+// Reads the reference out of the request target [target, end), which must
+// be |path| followed by a query.
+bool ReadTarget(const char* target, const char* end, const std::string& path,
+                std::string* reference) {
+  if (static_cast<size_t>(end - target) <= path.size() ||
+      memcmp(target, path.data(), path.size()) != 0 ||
+      target[path.size()] != '?') {
+    return false;
+  }
+
+  // Paystack sends both parameters with the same value; reference wins.
+  bool found = false;
+  std::string value;
+  const char* parameter = target + path.size() + 1;
+  while (parameter < end) {
+    const char* next = parameter;
+    while (next < end && *next != '&' && *next != '#') next++;
+    const char* equals = parameter;
+    while (equals < next && *equals != '=') equals++;
+    size_t name_size = equals - parameter;
+    bool is_reference =
+        name_size == 9 && memcmp(parameter, "reference", 9) == 0;
+    bool is_trxref = name_size == 6 && memcmp(parameter, "trxref", 6) == 0;
+    if ((is_reference || (is_trxref && !found)) && equals < next &&
+        Decode(equals + 1, next, &value) && !value.empty()) {
+      *reference = value;
+      found = true;
+      if (is_reference) {
+        return true;
+      }
+    }
+    if (next < end && *next == '#') {
+      break;
+    }
+    parameter = next + 1;
+  }
+  return found;
+}
+
+}  // namespace
+
+bool read_callback_reference(const char* line, size_t size,
+                             const std::string& path, std::string* reference) {
+  const char* end = line + size;
+  const char* space = static_cast<const char*>(memchr(line, ' ', size));
+  if (space == nullptr || space - line != 3 || memcmp(line, "GET", 3) != 0) {
+    return false;
+  }
+  const char* target = space + 1;
+  const char* target_end = target;
+  while (target_end < end && *target_end != ' ' && *target_end != '\r' &&
+         *target_end != '\n') {
+    target_end++;
+  }
+  return ReadTarget(target, target_end, path, reference);
+}
+
+bool read_callback_url(const std::string& url, const std::string& path,
+                       std::string* reference) {
+  static constexpr char kLoopback[] = "http://127.0.0.1:";
+  constexpr size_t kLoopbackSize = sizeof(kLoopback) - 1;
+  if (url.compare(0, kLoopbackSize, kLoopback) != 0) {
+    return false;
+  }
+  size_t port_end = url.find_first_not_of("0123456789", kLoopbackSize);
+  if (port_end == kLoopbackSize || port_end == std::string::npos) {
+    return false;
+  }
+  return ReadTarget(url.data() + port_end, url.data() + url.size(), path,
+                    reference);
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,31 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_CALLBACK_REQUEST_H_
+#define PAYSTACK_CORE_PAYSTACK_CALLBACK_REQUEST_H_
+
+#include <cstddef>
+#include <string>
+
+namespace all_paystack_payments {
+
+// Reads the request line of the request a browser sends when checkout
+// redirects it to the transaction's callback URL, such as
+// "GET /paystack/callback?trxref=T1&reference=T1 HTTP/1.1", and sets
+// |reference| to the percent-decoded reference parameter, or trxref if
+// there is none. |line| may run on into the headers.
+//
+// Returns false if the request is not a GET of |path| with either
+// parameter.
+bool read_callback_reference(const char* line, size_t size,
+                             const std::string& path, std::string* reference);
+
+// Reads a URL that checkout navigates to when it redirects to the callback
+// URL of a loopback listener on any port, such as
+// "http://127.0.0.1:40123/paystack/callback?trxref=T1&reference=T1", and
+// sets |reference| like read_callback_reference.
+//
+// Returns false if |url| is not of a 127.0.0.1 |path| with either parameter.
+bool read_callback_url(const std::string& url, const std::string& path,
+                       std::string* reference);
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_CALLBACK_REQUEST_H_
@@ -0,0 +1,64 @@
+#include "paystack_circuit_breaker.h"
+
+namespace all_paystack_payments {
+
+CircuitBreaker::CircuitBreaker(const CircuitBreakerPolicy& policy)
+    : policy_(policy) {}
+
+bool CircuitBreaker::Allow(Clock::time_point now) {
+  if (state_ == State::kOpen && now - opened_at_ >= policy_.open_duration) {
+    state_ = State::kHalfOpen;
+    probes_in_flight_ = 0;
+  }
+  switch (state_) {
+    case State::kClosed:
+      return true;
+    case State::kHalfOpen:
+      if (probes_in_flight_ < policy_.half_open_probes) {
+        probes_in_flight_++;
+        return true;
+      }
+      break;
+    case State::kOpen:
+      break;
+  }
+  rejected_++;
+  return false;
+}
+
+void CircuitBreaker::OnSuccess() {
+  state_ = State::kClosed;
+  consecutive_failures_ = 0;
+}
+
+void CircuitBreaker::OnFailure(Clock::time_point now) {
+  consecutive_failures_++;
+  // Requests allowed before the circuit opened may still fail afterwards;
+  // they do not extend the open period.
+  if (state_ == State::kHalfOpen ||
+      (state_ == State::kClosed &&
+       consecutive_failures_ >= policy_.failure_threshold)) {
+    state_ = State::kOpen;
+    opened_at_ = now;
+  }
+}
+
+void CircuitBreaker::OnCancelled() {
+  if (state_ == State::kHalfOpen && probes_in_flight_ > 0) {
+    probes_in_flight_--;
+  }
+}
+
+const char* circuit_state_name(CircuitBreaker::State state) {
+  switch (state) {
+    case CircuitBreaker::State::kClosed:
+      return "closed";
+    case CircuitBreaker::State::kOpen:
+      return "open";
+    case CircuitBreaker::State::kHalfOpen:
+      return "halfOpen";
+  }
+  return "";
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,71 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_CIRCUIT_BREAKER_H_
+#define PAYSTACK_CORE_PAYSTACK_CIRCUIT_BREAKER_H_
+
+#include <chrono>
+#include <cstdint>
+
+namespace all_paystack_payments {
+
+struct CircuitBreakerPolicy {
+  // Consecutive transient failures that open the circuit.
+  int failure_threshold = 5;
+  // How long the circuit stays open before it lets probes through.
+  std::chrono::milliseconds open_duration = std::chrono::seconds(5);
+  // Probes allowed in flight while half open.
+  int half_open_probes = 1;
+};
+
+// Stops sending requests to an endpoint that keeps failing, so that callers
+// get an answer at once instead of each waiting for the transport to give
+// up.
+//
+// The circuit starts closed and opens after |failure_threshold| transient
+// failures in a row. While open, Allow refuses every request. Once
+// |open_duration| has passed it is half open and lets |half_open_probes|
+// requests through: the first outcome closes the circuit again if it
+// succeeded, and reopens it otherwise.
+//
+// Not thread safe; PaystackClient keeps one per endpoint on its thread.
+class CircuitBreaker {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class State { kClosed, kOpen, kHalfOpen };
+
+  explicit CircuitBreaker(
+      const CircuitBreakerPolicy& policy = CircuitBreakerPolicy());
+
+  // Whether a request may be sent now. Each request it allows must report
+  // its outcome with OnSuccess or OnFailure.
+  bool Allow(Clock::time_point now = Clock::now());
+
+  // The endpoint answered, even if with an error of the caller's.
+  void OnSuccess();
+
+  // The transport failed or the endpoint answered with a server error.
+  void OnFailure(Clock::time_point now = Clock::now());
+
+  // The request was cancelled before its outcome was known. Frees its probe
+  // if the circuit is half open.
+  void OnCancelled();
+
+  State state() const { return state_; }
+  int consecutive_failures() const { return consecutive_failures_; }
+  // Requests Allow refused.
+  uint64_t rejected() const { return rejected_; }
+
+ private:
+  CircuitBreakerPolicy policy_;
+  State state_ = State::kClosed;
+  int consecutive_failures_ = 0;
+  int probes_in_flight_ = 0;
+  Clock::time_point opened_at_;
+  uint64_t rejected_ = 0;
+};
+
+// Camel case, as getTransportStats reports it.
+const char* circuit_state_name(CircuitBreaker::State state);
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_CIRCUIT_BREAKER_H_
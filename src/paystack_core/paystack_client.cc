@@ -0,0 +1,623 @@
+#include "paystack_client.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+namespace all_paystack_payments {
+
+namespace {
+
+constexpr char kInitializePath[] = "/transaction/initialize";
+constexpr char kVerifyPath[] = "/transaction/verify/";
+
+bool StartsWith(const std::string& text, const char* prefix) {
+  return text.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// A response parser and the time spent in it, recorded as Phase::kParse.
+// While |tracer| is tracing, each call into the parser is also kept to be
+// traced as a parse span once the reference is known.
+template <typename Parser, typename Result>
+class TimedParser {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit TimedParser(Tracer* tracer) : tracer_(tracer) {}
+
+  bool Feed(const char* data, size_t size) {
+    Clock::time_point start = Clock::now();
+    bool ok = parser_.Feed(data, size);
+    Add(start);
+    return ok;
+  }
+
+  Result Finish(const HttpResponse& response) {
+    Clock::time_point start = Clock::now();
+    Result result = parser_.Finish(response);
+    Add(start);
+    return result;
+  }
+
+  int64_t elapsed_micros() const { return Micros(elapsed_); }
+
+  void Trace(const TraceArgs& args) const {
+    for (const auto& span : spans_) {
+      tracer_->Span("parse", span.first, span.second, args);
+    }
+  }
+
+ private:
+  static int64_t Micros(Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+        .count();
+  }
+
+  void Add(Clock::time_point start) {
+    Clock::duration elapsed = Clock::now() - start;
+    elapsed_ += elapsed;
+    if (tracer_ != nullptr && tracer_->enabled()) {
+      spans_.emplace_back(Micros(start.time_since_epoch()), Micros(elapsed));
+    }
+  }
+
+  Parser parser_;
+  Clock::duration elapsed_{0};
+  Tracer* tracer_;
+  // Start and duration of each call, in Tracer::Now microseconds.
+  std::vector<std::pair<int64_t, int64_t>> spans_;
+};
+
+}  // namespace
+
+bool normalize_base_url(std::string* url) {
+  const char* scheme_end = "://";
+  size_t authority = url->find(scheme_end);
+  if ((!StartsWith(*url, "http://") && !StartsWith(*url, "https://")) ||
+      url->size() == authority + strlen(scheme_end)) {
+    return false;
+  }
+  while (url->back() == '/') {
+    url->pop_back();
+  }
+  return true;
+}
+
+// A request to an endpoint and the state of its retries.
+struct PaystackClient::Call {
+  Endpoint endpoint;
+  HttpRequest request;
+  // Whether sending the request again cannot repeat its effect.
+  bool idempotent;
+  // What the call is about, for tracing. Empty for checkouts whose reference
+  // Paystack generates.
+  std::string reference;
+  int attempts = 0;
+  // Attempts answered with a 429, which do not count against the retry
+  // policy's.
+  int rate_limited = 0;
+  int64_t backoff_ms = 0;
+  // When the call gives up waiting for the rate limiter. Set the first time
+  // it waits.
+  TokenBucket::Clock::time_point rate_limit_deadline;
+  // Answers the call with an error instead of a result. Set by Send.
+  std::function<void(const char* code, const char* message)> fail;
+  bool cancelled = false;
+  // How long an attempt may go unanswered before it is hedged. 0 if the
+  // call is not hedged.
+  int64_t hedge_after_ms = 0;
+  // The exchanges of the current attempt: its request and any hedge.
+  std::vector<std::shared_ptr<Exchange>> exchanges;
+};
+
+// One request of an attempt.
+struct PaystackClient::Exchange {
+  // 0 until the transport returns it, and if the exchange completed first.
+  RequestId id = 0;
+  bool hedge = false;
+  // Answered, or abandoned because another exchange of the attempt was.
+  bool done = false;
+};
+
+// State of a VerifyTransactions call, shared by the verifications it runs.
+struct PaystackClient::VerifyBatch {
+  std::vector<std::string> references;
+  ApiConfig api;
+  VerifyBatchCallback callback;
+  std::vector<VerifyResult> results;
+  size_t next = 0;
+  size_t remaining = 0;
+  // Verifications that may start before |max_concurrency| are in flight.
+  size_t free_slots = 0;
+  // Whether StartBatchVerifications() is on the stack.
+  bool starting = false;
+};
+
+PaystackClient::PaystackClient(Transport* transport)
+    : transport_(transport),
+      retry_budget_(retry_policy_.budget_ratio, retry_policy_.budget_reserve),
+      hedge_budget_(hedge_policy_.budget_ratio, hedge_policy_.budget_reserve),
+      random_(std::random_device()()) {}
+
+void PaystackClient::set_retry_policy(const RetryPolicy& policy) {
+  retry_policy_ = policy;
+  retry_budget_ = RetryBudget(policy.budget_ratio, policy.budget_reserve);
+}
+
+void PaystackClient::set_hedge_policy(const HedgePolicy& policy) {
+  hedge_policy_ = policy;
+  hedge_budget_ = RetryBudget(policy.budget_ratio, policy.budget_reserve);
+}
+
+int64_t PaystackClient::HedgeDelayMs() {
+  if (hedge_policy_.percentile <= 0) {
+    return 0;
+  }
+  hedge_budget_.OnCall();
+  const LatencyHistogram& total =
+      metrics_.endpoint(Endpoint::kVerify).phase(Phase::kTotal);
+  if (total.count() < hedge_policy_.min_samples) {
+    return 0;
+  }
+  int64_t delay_ms = total.ValueAtPercentile(hedge_policy_.percentile) / 1000;
+  return std::max(delay_ms, hedge_policy_.min_delay_ms);
+}
+
+void PaystackClient::set_circuit_breaker_policy(
+    const CircuitBreakerPolicy& policy) {
+  for (auto& breaker : breakers_) {
+    breaker = CircuitBreaker(policy);
+  }
+}
+
+void PaystackClient::set_concurrency_limit_policy(
+    const ConcurrencyLimitPolicy& policy) {
+  limiter_ = ConcurrencyLimiter(policy);
+}
+
+void PaystackClient::set_rate_limit_policy(const RateLimitPolicy& policy) {
+  rate_limit_policy_ = policy;
+  for (auto& rate_limit : rate_limits_) {
+    rate_limit.bucket = TokenBucket(policy.requests_per_second, policy.burst);
+  }
+}
+
+template <typename Parser, typename Result>
+void PaystackClient::Send(const std::shared_ptr<Call>& call,
+                          std::function<void(const Result& result)> callback) {
+  // The call can be cancelled from its first attempt until it is answered.
+  if (!call->fail) {
+    calls_.emplace(call->reference, call);
+    Call* registered = call.get();
+    callback = [this, registered, callback](const Result& result) {
+      auto range = calls_.equal_range(registered->reference);
+      for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.get() == registered) {
+          calls_.erase(it);
+          break;
+        }
+      }
+      callback(result);
+    };
+    call->fail = [callback](const char* code, const char* message) {
+      Result result;
+      result.error_code = code;
+      result.error_message = message;
+      callback(result);
+    };
+  }
+  RateLimit& rate_limit = rate_limits_[static_cast<size_t>(call->endpoint)];
+  // Nothing overtakes the attempts already waiting.
+  if (rate_limit.waiting.empty() && rate_limit.bucket.TryTake()) {
+    StartAttempt<Parser, Result>(call, std::move(callback));
+    return;
+  }
+  if (call->rate_limit_deadline == TokenBucket::Clock::time_point()) {
+    call->rate_limit_deadline =
+        TokenBucket::Clock::now() + rate_limit_policy_.max_wait;
+  }
+  auto start = [this, call, callback](bool expired) {
+    if (expired) {
+      call->fail(kRateLimitedError,
+                 "Too many requests to Paystack; try again shortly");
+      return;
+    }
+    StartAttempt<Parser, Result>(call, callback);
+  };
+  rate_limit.waiting.push_back(
+      {call, call->rate_limit_deadline, std::move(start)});
+  DrainRateLimit(call->endpoint);
+}
+
+template <typename Parser, typename Result>
+void PaystackClient::StartAttempt(
+    const std::shared_ptr<Call>& call,
+    std::function<void(const Result& result)> callback) {
+  if (!breakers_[static_cast<size_t>(call->endpoint)].Allow()) {
+    Result result;
+    result.error_code = kCircuitOpenError;
+    result.error_message =
+        "Paystack is failing, so the request was not sent; try again shortly";
+    callback(result);
+    return;
+  }
+  if (call->attempts++ == 0) {
+    retry_budget_.OnCall();
+  }
+  call->exchanges.clear();
+  std::shared_ptr<Exchange> first =
+      SendExchange<Parser, Result>(call, false, callback);
+  if (call->hedge_after_ms == 0 || first->done) {
+    return;
+  }
+  auto hedge = [this, call, first, callback](bool cancelled) {
+    // Nothing to do if the request answered in time, or the budget is spent.
+    // A request still queued would only have its hedge queue behind it.
+    if (cancelled || first->done || first->id == 0 ||
+        call->exchanges.size() > 1) {
+      return;
+    }
+    // Nor while calls wait for the rate limiter, which a hedge would
+    // overtake.
+    RateLimit& rate_limit = rate_limits_[static_cast<size_t>(call->endpoint)];
+    if (!rate_limit.waiting.empty() || !rate_limit.bucket.TryTake() ||
+        !hedge_budget_.TryRetry()) {
+      return;
+    }
+    metrics_.endpoint(call->endpoint)
+        .hedges.fetch_add(1, std::memory_order_relaxed);
+    SendExchange<Parser, Result>(call, true, callback);
+  };
+  transport_->RunAfter(call->hedge_after_ms, std::move(hedge));
+}
+
+template <typename Parser, typename Result>
+std::shared_ptr<PaystackClient::Exchange> PaystackClient::SendExchange(
+    const std::shared_ptr<Call>& call, bool hedge,
+    std::function<void(const Result& result)> callback) {
+  auto exchange = std::make_shared<Exchange>();
+  exchange->hedge = hedge;
+  call->exchanges.push_back(exchange);
+  bool may_retry = call->idempotent && retry_policy_.max_attempts > 1;
+  // Copied, not moved: any call is sent again if Paystack throttles it.
+  HttpRequest request = call->request;
+  // A hedge must not wait behind the request it stands in for.
+  request.fresh_connection = hedge;
+  // The body is parsed as it arrives, keeping only the fields we return.
+  auto parser = std::make_shared<TimedParser<Parser, Result>>(tracer_);
+  // Returns whether the response signals that Paystack is overloaded.
+  auto handle = [this, call, exchange, parser, may_retry,
+                 callback](HttpResponse& response) {
+    // Cancelled after another exchange of the attempt answered.
+    if (exchange->done) {
+      return false;
+    }
+    exchange->done = true;
+    int64_t end = Tracer::Now();
+    Result result = parser->Finish(response);
+    EndpointMetrics& metrics = metrics_.endpoint(call->endpoint);
+    metrics_.RecordExchange(call->endpoint, response, result.error_code);
+    metrics.phase(Phase::kParse).Record(parser->elapsed_micros());
+    TraceArgs args;
+    if (tracer_ != nullptr && tracer_->enabled()) {
+      // Paystack generates the reference if the request had none.
+      args.reference =
+          call->reference.empty() ? result.reference : call->reference;
+      tracer_->Transfer(response, end, args);
+      parser->Trace(args);
+    }
+    ObserveRateLimit(call->endpoint, response);
+
+    // The transport failing, other than because the body did not parse,
+    // and server errors are worth another attempt.
+    bool transient = (!response.ok() && result.error_code == "HTTP_ERROR") ||
+                     response.status_code >= 500;
+    bool throttled = response.status_code == 429;
+    bool overloaded = transient || throttled;
+    // Anything else answers the call, and the other exchanges of the
+    // attempt lose. A transient failure leaves it to them.
+    for (const auto& other : call->exchanges) {
+      if (transient && !other->done) {
+        return overloaded;
+      }
+    }
+    for (const auto& other : call->exchanges) {
+      if (!other->done) {
+        other->done = true;
+        if (other->id != 0) {
+          transport_->Cancel(other->id);
+        }
+      }
+    }
+    if (exchange->hedge && !transient) {
+      metrics.hedges_won.fetch_add(1, std::memory_order_relaxed);
+    }
+    CircuitBreaker& breaker = breakers_[static_cast<size_t>(call->endpoint)];
+    if (transient) {
+      breaker.OnFailure();
+    } else {
+      breaker.OnSuccess();
+    }
+
+    // Paystack refused the request without acting on it, so it is sent
+    // again once the rate limiter allows, however the call was made.
+    if (throttled) {
+      metrics.rate_limited.fetch_add(1, std::memory_order_relaxed);
+      call->rate_limited++;
+      Send<Parser, Result>(call, callback);
+      return overloaded;
+    }
+    if (!transient || !may_retry ||
+        call->attempts - call->rate_limited >= retry_policy_.max_attempts) {
+      callback(result);
+      return overloaded;
+    }
+    if (!retry_budget_.TryRetry()) {
+      metrics.throttled_retries.fetch_add(1, std::memory_order_relaxed);
+      callback(result);
+      return overloaded;
+    }
+    metrics.retries.fetch_add(1, std::memory_order_relaxed);
+    call->backoff_ms =
+        decorrelated_jitter(retry_policy_, call->backoff_ms, &random_);
+    int64_t backoff_start = Tracer::Now();
+    auto retry = [this, call, callback, result, args,
+                  backoff_start](bool cancelled) {
+      // Answered when it was cancelled.
+      if (call->cancelled) {
+        return;
+      }
+      // The transport is going away; the last attempt's result stands.
+      if (cancelled) {
+        callback(result);
+        return;
+      }
+      if (tracer_ != nullptr) {
+        tracer_->Span("backoff", backoff_start, Tracer::Now() - backoff_start,
+                      args);
+      }
+      Send<Parser, Result>(call, callback);
+    };
+    transport_->RunAfter(call->backoff_ms, std::move(retry));
+    return overloaded;
+  };
+  // The slot is given back once the response has been handled, so that a
+  // queued exchange of the same attempt cannot start and answer it first.
+  HttpCallback on_response = [this, handle](HttpResponse& response) {
+    limiter_.Release(handle(response));
+    StartQueued();
+  };
+  BodySink sink = [parser](const char* data, size_t size) {
+    return parser->Feed(data, size);
+  };
+  if (!limiter_.TryAcquire()) {
+    queued_.push_back({exchange, std::move(request), std::move(on_response),
+                       std::move(sink)});
+    return exchange;
+  }
+  StartExchange(exchange, std::move(request), std::move(on_response),
+                std::move(sink));
+  return exchange;
+}
+
+void PaystackClient::StartExchange(const std::shared_ptr<Exchange>& exchange,
+                                   HttpRequest request, HttpCallback callback,
+                                   BodySink sink) {
+  RequestId id = transport_->Send(std::move(request), std::move(callback),
+                                  std::move(sink));
+  if (!exchange->done) {
+    exchange->id = id;
+  }
+}
+
+void PaystackClient::StartQueued() {
+  while (!queued_.empty()) {
+    // Exchanges abandoned while they waited are dropped without a slot.
+    if (queued_.front().exchange->done) {
+      queued_.pop_front();
+      continue;
+    }
+    if (!limiter_.TryAcquire()) {
+      return;
+    }
+    QueuedExchange next = std::move(queued_.front());
+    queued_.pop_front();
+    StartExchange(next.exchange, std::move(next.request),
+                  std::move(next.callback), std::move(next.sink));
+  }
+}
+
+void PaystackClient::DrainRateLimit(Endpoint endpoint) {
+  RateLimit& rate_limit = rate_limits_[static_cast<size_t>(endpoint)];
+  while (!rate_limit.waiting.empty()) {
+    TokenBucket::Clock::time_point now = TokenBucket::Clock::now();
+    bool expired = now >= rate_limit.waiting.front().deadline;
+    if (!expired && !rate_limit.bucket.TryTake(now)) {
+      if (rate_limit.drain_scheduled) {
+        return;
+      }
+      TokenBucket::Clock::duration wait =
+          std::min(rate_limit.bucket.TimeUntilAvailable(now),
+                   rate_limit.waiting.front().deadline - now);
+      // Rounded up, so that the timer does not fire just before it is due.
+      int64_t wait_ms =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              wait + std::chrono::milliseconds(1) -
+              TokenBucket::Clock::duration(1))
+              .count();
+      rate_limit.drain_scheduled = true;
+      transport_->RunAfter(wait_ms, [this, endpoint](bool cancelled) {
+        RateLimit& rate_limit = rate_limits_[static_cast<size_t>(endpoint)];
+        rate_limit.drain_scheduled = false;
+        // The transport is going away; nothing that waits will be sent.
+        if (cancelled) {
+          std::deque<RateLimitedAttempt> waiting;
+          waiting.swap(rate_limit.waiting);
+          for (auto& attempt : waiting) {
+            attempt.start(true);
+          }
+          return;
+        }
+        DrainRateLimit(endpoint);
+      });
+      return;
+    }
+    RateLimitedAttempt next = std::move(rate_limit.waiting.front());
+    rate_limit.waiting.pop_front();
+    if (expired) {
+      rate_limit.expired++;
+    }
+    next.start(expired);
+  }
+}
+
+bool PaystackClient::Cancel(const std::string& reference) {
+  // Checkouts whose reference Paystack generates cannot be told apart.
+  if (reference.empty()) {
+    return false;
+  }
+  std::vector<std::shared_ptr<Call>> calls;
+  auto range = calls_.equal_range(reference);
+  for (auto it = range.first; it != range.second; ++it) {
+    calls.push_back(it->second);
+  }
+  for (const auto& call : calls) {
+    CancelCall(call);
+  }
+  return !calls.empty();
+}
+
+void PaystackClient::CancelCall(const std::shared_ptr<Call>& call) {
+  call->cancelled = true;
+  std::deque<RateLimitedAttempt>& waiting =
+      rate_limits_[static_cast<size_t>(call->endpoint)].waiting;
+  waiting.erase(std::remove_if(waiting.begin(), waiting.end(),
+                               [&call](const RateLimitedAttempt& attempt) {
+                                 return attempt.call == call;
+                               }),
+                waiting.end());
+  // Exchanges still queued are dropped by StartQueued, and those in flight
+  // give back their slots once the transport has aborted them.
+  bool attempt_open = false;
+  for (const auto& exchange : call->exchanges) {
+    if (!exchange->done) {
+      exchange->done = true;
+      attempt_open = true;
+      if (exchange->id != 0) {
+        transport_->Cancel(exchange->id);
+      }
+    }
+  }
+  if (attempt_open) {
+    breakers_[static_cast<size_t>(call->endpoint)].OnCancelled();
+  }
+  call->fail(kCancelledError, "The request was cancelled");
+}
+
+void PaystackClient::ObserveRateLimit(Endpoint endpoint,
+                                      const HttpResponse& response) {
+  const RateLimitHeaders& headers = response.rate_limit;
+  TokenBucket::Clock::duration pause(0);
+  if (response.status_code == 429) {
+    // Retry-After: 0 says nothing about how long to wait.
+    pause = headers.retry_after > 0
+                ? std::chrono::seconds(headers.retry_after)
+                : rate_limit_policy_.default_retry_after;
+  } else if (headers.remaining == 0 && headers.reset > 0) {
+    pause = std::chrono::seconds(headers.reset);
+  } else {
+    return;
+  }
+  rate_limits_[static_cast<size_t>(endpoint)].bucket.PauseUntil(
+      TokenBucket::Clock::now() + pause);
+}
+
+void PaystackClient::InitializeTransaction(const CheckoutRequest& request,
+                                           const ApiConfig& api,
+                                           CheckoutCallback callback) {
+  auto call = std::make_shared<Call>();
+  call->endpoint = Endpoint::kInitialize;
+  call->request.method = HttpMethod::kPost;
+  call->request.url = api.base_url + kInitializePath;
+  call->request.public_key = api.public_key;
+  call->request.body = build_initialize_body(request);
+  call->request.connect_timeout_ms = api.connect_timeout_ms;
+  call->request.timeout_ms = api.timeout_ms;
+  // Paystack refuses a second transaction with the same reference, so only
+  // a reference the caller chose makes a repeated checkout safe.
+  call->idempotent = request.has_reference;
+  if (request.has_reference) {
+    call->reference = request.reference;
+  }
+  Send<CheckoutResponseParser, CheckoutResult>(call, std::move(callback));
+}
+
+void PaystackClient::VerifyTransaction(const std::string& reference,
+                                       const ApiConfig& api,
+                                       VerifyCallback callback) {
+  if (!verify_in_flight_.Join(reference, std::move(callback))) {
+    return;
+  }
+  auto call = std::make_shared<Call>();
+  call->endpoint = Endpoint::kVerify;
+  call->request.url = api.base_url + kVerifyPath + reference;
+  call->request.public_key = api.public_key;
+  call->request.connect_timeout_ms = api.connect_timeout_ms;
+  call->request.timeout_ms = api.timeout_ms;
+  call->idempotent = true;
+  call->reference = reference;
+  call->hedge_after_ms = HedgeDelayMs();
+  Send<VerifyResponseParser, VerifyResult>(
+      call, [this, reference](const VerifyResult& result) {
+        verify_cache_.Put(reference, result);
+        verify_in_flight_.Complete(reference, result);
+      });
+}
+
+void PaystackClient::VerifyTransactions(
+    const std::vector<std::string>& references, size_t max_concurrency,
+    const ApiConfig& api, VerifyBatchCallback callback) {
+  if (references.empty()) {
+    callback(std::vector<VerifyResult>());
+    return;
+  }
+  auto batch = std::make_shared<VerifyBatch>();
+  batch->references = references;
+  batch->api = api;
+  batch->callback = std::move(callback);
+  batch->results.resize(references.size());
+  batch->remaining = references.size();
+  // Each completed verification frees the slot of the next one, so at
+  // most |max_concurrency| requests are in flight.
+  batch->free_slots = std::max<size_t>(max_concurrency, 1);
+  StartBatchVerifications(batch);
+}
+
+void PaystackClient::StartBatchVerifications(
+    const std::shared_ptr<VerifyBatch>& batch) {
+  // Verifications that complete inside VerifyTransaction, such as those an
+  // open circuit or the rate limiter fails, or all of them with a blocking
+  // transport, only free their slot; this loop starts the next one, so the
+  // stack does not grow with the batch.
+  batch->starting = true;
+  while (batch->free_slots > 0 && batch->next < batch->references.size()) {
+    batch->free_slots--;
+    size_t index = batch->next++;
+    VerifyTransaction(
+        batch->references[index], batch->api,
+        [this, batch, index](const VerifyResult& result) {
+          batch->results[index] = result;
+          batch->free_slots++;
+          if (!batch->starting) {
+            StartBatchVerifications(batch);
+          }
+          if (--batch->remaining == 0) {
+            batch->callback(batch->results);
+          }
+        });
+  }
+  batch->starting = false;
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,271 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_CLIENT_H_
+#define PAYSTACK_CORE_PAYSTACK_CLIENT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paystack_circuit_breaker.h"
+#include "paystack_concurrency_limiter.h"
+#include "paystack_metrics.h"
+#include "paystack_rate_limiter.h"
+#include "paystack_request_body.h"
+#include "paystack_response_parser.h"
+#include "paystack_retry.h"
+#include "paystack_single_flight.h"
+#include "paystack_trace.h"
+#include "paystack_transport.h"
+#include "paystack_verify_cache.h"
+
+namespace all_paystack_payments {
+
+// The production Paystack API.
+constexpr char kDefaultBaseUrl[] = "https://api.paystack.co";
+
+// Error code of calls refused because the endpoint's circuit is open.
+constexpr char kCircuitOpenError[] = "CIRCUIT_OPEN";
+
+// Error code of calls that waited for the rate limiter longer than
+// RateLimitPolicy::max_wait.
+constexpr char kRateLimitedError[] = "RATE_LIMITED";
+
+// Error code of calls aborted by PaystackClient::Cancel.
+constexpr char kCancelledError[] = "CANCELLED";
+
+// Where requests go and how they authenticate.
+struct ApiConfig {
+  // Scheme and authority, optionally followed by a path prefix, without a
+  // trailing slash. Pointing it at a local stand-in such as
+  // paystack_mock_server allows load tests without network access.
+  std::string base_url = kDefaultBaseUrl;
+  // Sent as the bearer token.
+  std::string public_key;
+  // Limits on connecting to Paystack and on each request, in milliseconds,
+  // so that a stuck connection cannot hold a call forever.
+  int64_t connect_timeout_ms = 10000;
+  int64_t timeout_ms = 30000;
+};
+
+// Checks that |url| is an http or https URL and strips trailing slashes, so
+// that it can be used as ApiConfig::base_url. Returns false if it is not.
+bool normalize_base_url(std::string* url);
+
+// The Paystack API as the plugins use it, over a pluggable Transport and
+// independent of any platform or Flutter type.
+//
+// Request bodies are written with build_initialize_body and responses are
+// streamed through the response parsers as they arrive. Verifications fill
+// a VerifyCache, and concurrent verifications of the same reference share
+// one request. Transient failures of verifications, and of checkouts whose
+// reference the caller chose, are retried as the RetryPolicy allows, and
+// slow verifications are hedged as the HedgePolicy allows. Every exchange
+// records its phases, parse time and outcome in metrics(), and traces them
+// to the tracer, if set.
+//
+// Each endpoint has a CircuitBreaker: while it is open, calls fail at once
+// with kCircuitOpenError. Requests beyond the ConcurrencyLimiter's limit
+// wait in a queue until a request in flight completes.
+//
+// Each endpoint also has a TokenBucket, paused whenever a response says
+// Paystack's limit is reached. Calls it has no token for wait their turn in
+// a queue of their own, first in first out, and fail with
+// kRateLimitedError once they have waited RateLimitPolicy::max_wait. A
+// call answered with a 429 joins the queue again instead of failing.
+//
+// Calls can be cancelled by reference with Cancel, and every request is
+// bounded by the timeouts of its ApiConfig.
+//
+// Must be used on the thread the transport runs its callbacks on, and
+// callbacks are invoked on it. The exceptions are verify_cache() and
+// metrics(), which are thread safe.
+class PaystackClient {
+ public:
+  using CheckoutCallback = std::function<void(const CheckoutResult& result)>;
+  using VerifyCallback = std::function<void(const VerifyResult& result)>;
+  // One result per reference, in the order the references were given.
+  using VerifyBatchCallback =
+      std::function<void(const std::vector<VerifyResult>& results)>;
+
+  // |transport| must outlive the client, and the client must outlive the
+  // callbacks of the requests it sent.
+  explicit PaystackClient(Transport* transport);
+
+  // Disallow copy and assign.
+  PaystackClient(const PaystackClient&) = delete;
+  PaystackClient& operator=(const PaystackClient&) = delete;
+
+  // Starts a transaction with /transaction/initialize.
+  void InitializeTransaction(const CheckoutRequest& request,
+                             const ApiConfig& api, CheckoutCallback callback);
+
+  // Verifies the transaction |reference| with /transaction/verify, joining
+  // a verification of the same reference that is already in flight.
+  void VerifyTransaction(const std::string& reference, const ApiConfig& api,
+                         VerifyCallback callback);
+
+  // Verifies each of |references| with at most |max_concurrency|
+  // verifications in flight.
+  void VerifyTransactions(const std::vector<std::string>& references,
+                          size_t max_concurrency, const ApiConfig& api,
+                          VerifyBatchCallback callback);
+
+  // Aborts every call about |reference|, whether its request is in flight,
+  // queued or waiting to be retried, and answers it with kCancelledError
+  // before returning. Returns false if there was none.
+  bool Cancel(const std::string& reference);
+
+  // Calls not answered yet.
+  size_t pending_calls() const { return calls_.size(); }
+
+  VerifyCache& verify_cache() { return verify_cache_; }
+
+  // Callers record the time they take to turn results into their platform's
+  // responses as Phase::kBuild.
+  ClientMetrics& metrics() { return metrics_; }
+
+  // Traces the phases of every exchange, and each call into its response
+  // parser, while |tracer| is tracing. |tracer| must outlive the client;
+  // nullptr stops tracing.
+  void set_tracer(Tracer* tracer) { tracer_ = tracer; }
+
+  // Replaces the default policy and refills the retry budget.
+  void set_retry_policy(const RetryPolicy& policy);
+
+  // Replaces the default policy, which does not hedge, and refills the hedge
+  // budget.
+  void set_hedge_policy(const HedgePolicy& policy);
+
+  // Replaces the default policy and closes every circuit.
+  void set_circuit_breaker_policy(const CircuitBreakerPolicy& policy);
+
+  // Replaces the default policy. Must be called before the first request.
+  void set_concurrency_limit_policy(const ConcurrencyLimitPolicy& policy);
+
+  // Replaces the default policy, which sets no limit of its own, and
+  // refills every bucket. Calls already waiting keep their deadlines.
+  void set_rate_limit_policy(const RateLimitPolicy& policy);
+
+  const CircuitBreaker& circuit_breaker(Endpoint endpoint) const {
+    return breakers_[static_cast<size_t>(endpoint)];
+  }
+
+  const ConcurrencyLimiter& concurrency_limiter() const { return limiter_; }
+
+  // Requests waiting for the concurrency limiter.
+  size_t queued() const { return queued_.size(); }
+
+  // Calls waiting for |endpoint|'s rate limiter, and those that gave up.
+  size_t rate_limited(Endpoint endpoint) const {
+    return rate_limits_[static_cast<size_t>(endpoint)].waiting.size();
+  }
+  uint64_t rate_limit_expired(Endpoint endpoint) const {
+    return rate_limits_[static_cast<size_t>(endpoint)].expired;
+  }
+
+ private:
+  struct Call;
+  struct Exchange;
+  struct VerifyBatch;
+
+  // An exchange waiting for the concurrency limiter.
+  struct QueuedExchange {
+    std::shared_ptr<Exchange> exchange;
+    HttpRequest request;
+    HttpCallback callback;
+    BodySink sink;
+  };
+
+  // An attempt waiting for its endpoint's rate limiter. |start| sends it,
+  // or fails its call if |expired|.
+  struct RateLimitedAttempt {
+    std::shared_ptr<Call> call;
+    TokenBucket::Clock::time_point deadline;
+    std::function<void(bool expired)> start;
+  };
+
+  struct RateLimit {
+    TokenBucket bucket;
+    std::deque<RateLimitedAttempt> waiting;
+    // Whether a timer will drain |waiting|.
+    bool drain_scheduled = false;
+    uint64_t expired = 0;
+  };
+
+  // Sends |call|'s request, streaming the response through a Parser, and
+  // retries it until it succeeds, fails for good or runs out of attempts.
+  // An attempt still unanswered after Call::hedge_after_ms is hedged, and
+  // the first of its exchanges to answer decides it. |callback| receives the
+  // result of the last attempt.
+  //
+  // Each attempt first waits for the rate limiter.
+  template <typename Parser, typename Result>
+  void Send(const std::shared_ptr<Call>& call,
+            std::function<void(const Result& result)> callback);
+
+  // Aborts |call| and answers it with kCancelledError.
+  void CancelCall(const std::shared_ptr<Call>& call);
+
+  // Sends an attempt the rate limiter let through.
+  template <typename Parser, typename Result>
+  void StartAttempt(const std::shared_ptr<Call>& call,
+                    std::function<void(const Result& result)> callback);
+
+  // Sends one exchange of |call|'s current attempt, or queues it if the
+  // concurrency limit is reached.
+  template <typename Parser, typename Result>
+  std::shared_ptr<Exchange> SendExchange(
+      const std::shared_ptr<Call>& call, bool hedge,
+      std::function<void(const Result& result)> callback);
+
+  void StartExchange(const std::shared_ptr<Exchange>& exchange,
+                     HttpRequest request, HttpCallback callback,
+                     BodySink sink);
+
+  // Starts queued exchanges while the concurrency limit allows.
+  void StartQueued();
+
+  // Starts the attempts waiting for |endpoint|'s rate limiter that it has
+  // tokens for and fails those past their deadline, then schedules itself
+  // for when the next may go.
+  void DrainRateLimit(Endpoint endpoint);
+
+  // Pauses |endpoint|'s rate limiter as |response| asks: until Retry-After
+  // has passed after a 429, or until the window resets once no request is
+  // left in it.
+  void ObserveRateLimit(Endpoint endpoint, const HttpResponse& response);
+
+  // How long a verification may go unanswered before it is hedged, from the
+  // latencies of those before it. 0 if it is not hedged.
+  int64_t HedgeDelayMs();
+
+  void StartBatchVerifications(const std::shared_ptr<VerifyBatch>& batch);
+
+  Transport* transport_;
+  VerifyCache verify_cache_;
+  ClientMetrics metrics_;
+  Tracer* tracer_ = nullptr;
+  RetryPolicy retry_policy_;
+  RetryBudget retry_budget_;
+  HedgePolicy hedge_policy_;
+  RetryBudget hedge_budget_;
+  CircuitBreaker breakers_[kEndpointCount];
+  ConcurrencyLimiter limiter_;
+  std::deque<QueuedExchange> queued_;
+  RateLimitPolicy rate_limit_policy_;
+  RateLimit rate_limits_[kEndpointCount];
+  std::minstd_rand random_;
+  SingleFlight<VerifyResult> verify_in_flight_;
+  // Calls not answered yet, by reference. Checkouts whose reference
+  // Paystack generates are under the empty string.
+  std::unordered_multimap<std::string, std::shared_ptr<Call>> calls_;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_CLIENT_H_
@@ -0,0 +1,27 @@
+#include "paystack_concurrency_limiter.h"
+
+#include <algorithm>
+
+namespace all_paystack_payments {
+
+ConcurrencyLimiter::ConcurrencyLimiter(const ConcurrencyLimitPolicy& policy)
+    : policy_(policy), limit_(policy.initial_limit) {}
+
+bool ConcurrencyLimiter::TryAcquire() {
+  if (in_flight_ >= limit()) {
+    return false;
+  }
+  in_flight_++;
+  return true;
+}
+
+void ConcurrencyLimiter::Release(bool overloaded) {
+  in_flight_--;
+  if (overloaded) {
+    limit_ = std::max(limit_ * policy_.backoff_ratio, policy_.min_limit);
+  } else {
+    limit_ = std::min(limit_ + 1 / limit_, policy_.max_limit);
+  }
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,47 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_CONCURRENCY_LIMITER_H_
+#define PAYSTACK_CORE_PAYSTACK_CONCURRENCY_LIMITER_H_
+
+namespace all_paystack_payments {
+
+struct ConcurrencyLimitPolicy {
+  // Requests allowed in flight at first, and the bounds of the limit.
+  double initial_limit = 20;
+  double min_limit = 1;
+  double max_limit = 200;
+  // Factor the limit is multiplied by when a request signals overload.
+  double backoff_ratio = 0.75;
+};
+
+// Caps the requests in flight with a limit that adapts to how the server
+// copes, by additive increase and multiplicative decrease (AIMD): every
+// request that completes normally raises the limit by 1/limit, about one
+// per round trip's worth of requests, and every request that signals
+// overload (a transport failure, a 5xx or a 429) multiplies it by
+// |backoff_ratio|.
+//
+// Not thread safe; PaystackClient keeps one in front of its transport and
+// queues the requests it refuses.
+class ConcurrencyLimiter {
+ public:
+  explicit ConcurrencyLimiter(
+      const ConcurrencyLimitPolicy& policy = ConcurrencyLimitPolicy());
+
+  // Takes a slot for a request, or returns false if the limit is reached.
+  bool TryAcquire();
+
+  // Gives back the slot of a completed request.
+  void Release(bool overloaded);
+
+  // Whole requests allowed in flight.
+  int limit() const { return static_cast<int>(limit_); }
+  int in_flight() const { return in_flight_; }
+
+ private:
+  ConcurrencyLimitPolicy policy_;
+  double limit_;
+  int in_flight_ = 0;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_CONCURRENCY_LIMITER_H_
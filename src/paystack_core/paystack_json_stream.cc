@@ -0,0 +1,409 @@
+#include "paystack_json_stream.h"
+
+#include <limits>
+#include <locale>
+#include <sstream>
+
+namespace all_paystack_payments {
+
+namespace {
+
+bool IsWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool IsNumberChar(char c) {
+  return IsDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' ||
+         c == 'E';
+}
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Checks |number| against the JSON number grammar and reports whether it is
+// an integer, i.e. has no fraction or exponent.
+bool IsValidNumber(const std::string& number, bool* is_integer) {
+  size_t i = 0;
+  size_t size = number.size();
+  if (i < size && number[i] == '-') i++;
+  if (i == size) return false;
+  if (number[i] == '0') {
+    i++;
+  } else if (IsDigit(number[i])) {
+    while (i < size && IsDigit(number[i])) i++;
+  } else {
+    return false;
+  }
+  *is_integer = true;
+  if (i < size && number[i] == '.') {
+    *is_integer = false;
+    i++;
+    size_t digits = i;
+    while (i < size && IsDigit(number[i])) i++;
+    if (i == digits) return false;
+  }
+  if (i < size && (number[i] == 'e' || number[i] == 'E')) {
+    *is_integer = false;
+    i++;
+    if (i < size && (number[i] == '+' || number[i] == '-')) i++;
+    size_t digits = i;
+    while (i < size && IsDigit(number[i])) i++;
+    if (i == digits) return false;
+  }
+  return i == size;
+}
+
+// Parses a valid JSON integer, failing if it does not fit in 64 bits.
+bool ParseInt(const std::string& number, int64_t* value) {
+  bool negative = number[0] == '-';
+  // Accumulate as a negative value, which has the larger range.
+  int64_t result = 0;
+  for (size_t i = negative ? 1 : 0; i < number.size(); i++) {
+    int digit = number[i] - '0';
+    if (result < (std::numeric_limits<int64_t>::min() + digit) / 10) {
+      return false;
+    }
+    result = result * 10 - digit;
+  }
+  if (!negative) {
+    if (result == std::numeric_limits<int64_t>::min()) return false;
+    result = -result;
+  }
+  *value = result;
+  return true;
+}
+
+void AppendUtf8(std::string* out, uint32_t code_point) {
+  if (code_point < 0x80) {
+    out->push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out->push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    out->push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    out->push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+}  // namespace
+
+JsonStreamParser::JsonStreamParser(JsonHandler* handler) : handler_(handler) {}
+
+bool JsonStreamParser::Feed(const char* data, size_t size) {
+  position_ = 0;
+  while (position_ < size && state_ != State::kError) {
+    position_ += Step(data + position_, size - position_);
+  }
+  return state_ != State::kError;
+}
+
+bool JsonStreamParser::Finish() {
+  // A number only ends at the next character, which a top-level number lacks.
+  if (state_ == State::kNumber && containers_.empty()) {
+    if (EmitNumber()) {
+      EndValue();
+    }
+  }
+  return state_ == State::kDone;
+}
+
+size_t JsonStreamParser::Step(const char* data, size_t size) {
+  switch (state_) {
+    case State::kString:
+      return ReadString(data, size);
+    case State::kEscape:
+      return ReadEscape(*data);
+    case State::kUnicodeEscape:
+      return ReadUnicodeEscape(*data);
+    case State::kNumber:
+      return ReadNumber(data, size);
+    case State::kLiteral:
+      return ReadLiteral(*data);
+    case State::kError:
+      return size;
+    default:
+      break;
+  }
+
+  char c = *data;
+  if (IsWhitespace(c)) {
+    return 1;
+  }
+  switch (state_) {
+    case State::kValue:
+      return StartValue(c);
+    case State::kFirstValueOrArrayEnd:
+      if (c == ']') {
+        containers_.pop_back();
+        if (!handler_->EndArray()) return Fail();
+        EndValue();
+        return 1;
+      }
+      return StartValue(c);
+    case State::kFirstKeyOrObjectEnd:
+      if (c == '}') {
+        containers_.pop_back();
+        if (!handler_->EndObject()) return Fail();
+        EndValue();
+        return 1;
+      }
+      if (c != '"') return Fail();
+      token_.clear();
+      token_is_key_ = true;
+      state_ = State::kString;
+      return 1;
+    case State::kKey:
+      if (c != '"') return Fail();
+      token_.clear();
+      token_is_key_ = true;
+      state_ = State::kString;
+      return 1;
+    case State::kColon:
+      if (c != ':') return Fail();
+      state_ = State::kValue;
+      return 1;
+    case State::kCommaOrEnd:
+      if (c == ',') {
+        state_ = containers_.back() == '{' ? State::kKey : State::kValue;
+        return 1;
+      }
+      if (c == '}' && containers_.back() == '{') {
+        containers_.pop_back();
+        if (!handler_->EndObject()) return Fail();
+        EndValue();
+        return 1;
+      }
+      if (c == ']' && containers_.back() == '[') {
+        containers_.pop_back();
+        if (!handler_->EndArray()) return Fail();
+        EndValue();
+        return 1;
+      }
+      return Fail();
+    default:
+      // Anything but whitespace after the document.
+      return Fail();
+  }
+}
+
+size_t JsonStreamParser::StartValue(char c) {
+  switch (c) {
+    case '{':
+      containers_.push_back('{');
+      if (!handler_->StartObject()) return Fail();
+      state_ = State::kFirstKeyOrObjectEnd;
+      return 1;
+    case '[':
+      containers_.push_back('[');
+      if (!handler_->StartArray()) return Fail();
+      state_ = State::kFirstValueOrArrayEnd;
+      return 1;
+    case '"':
+      token_.clear();
+      token_is_key_ = false;
+      state_ = State::kString;
+      return 1;
+    case 't':
+      literal_rest_ = "rue";
+      break;
+    case 'f':
+      literal_rest_ = "alse";
+      break;
+    case 'n':
+      literal_rest_ = "ull";
+      break;
+    default:
+      if (c == '-' || IsDigit(c)) {
+        token_.clear();
+        state_ = State::kNumber;
+        // Read by ReadNumber.
+        return 0;
+      }
+      return Fail();
+  }
+  token_.assign(1, c);
+  state_ = State::kLiteral;
+  return 1;
+}
+
+size_t JsonStreamParser::ReadString(const char* data, size_t size) {
+  if (high_surrogate_ != 0 && data[0] != '\\') {
+    // A high surrogate must be followed by an escaped low surrogate.
+    return Fail();
+  }
+  size_t i = 0;
+  while (i < size && data[i] != '"' && data[i] != '\\') {
+    if (static_cast<unsigned char>(data[i]) < 0x20) return Fail();
+    i++;
+  }
+  token_.append(data, i);
+  if (i == size) {
+    return size;
+  }
+  if (data[i] == '\\') {
+    state_ = State::kEscape;
+    return i + 1;
+  }
+  if (token_is_key_) {
+    if (!handler_->Key(token_.data(), token_.size())) return Fail();
+    state_ = State::kColon;
+  } else {
+    if (!handler_->String(token_.data(), token_.size())) return Fail();
+    EndValue();
+  }
+  return i + 1;
+}
+
+size_t JsonStreamParser::ReadEscape(char c) {
+  if (high_surrogate_ != 0 && c != 'u') {
+    return Fail();
+  }
+  switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      token_.push_back(c);
+      break;
+    case 'b':
+      token_.push_back('\b');
+      break;
+    case 'f':
+      token_.push_back('\f');
+      break;
+    case 'n':
+      token_.push_back('\n');
+      break;
+    case 'r':
+      token_.push_back('\r');
+      break;
+    case 't':
+      token_.push_back('\t');
+      break;
+    case 'u':
+      unicode_digits_ = 0;
+      unicode_value_ = 0;
+      state_ = State::kUnicodeEscape;
+      return 1;
+    default:
+      return Fail();
+  }
+  state_ = State::kString;
+  return 1;
+}
+
+size_t JsonStreamParser::ReadUnicodeEscape(char c) {
+  int digit = HexValue(c);
+  if (digit < 0) {
+    return Fail();
+  }
+  unicode_value_ = unicode_value_ * 16 + static_cast<uint32_t>(digit);
+  if (++unicode_digits_ < 4) {
+    return 1;
+  }
+
+  uint32_t value = unicode_value_;
+  bool is_high = value >= 0xD800 && value <= 0xDBFF;
+  bool is_low = value >= 0xDC00 && value <= 0xDFFF;
+  if (high_surrogate_ != 0) {
+    if (!is_low) return Fail();
+    AppendUtf8(&token_,
+               0x10000 + ((high_surrogate_ - 0xD800) << 10) + (value - 0xDC00));
+    high_surrogate_ = 0;
+  } else if (is_high) {
+    high_surrogate_ = value;
+  } else if (is_low) {
+    return Fail();
+  } else {
+    AppendUtf8(&token_, value);
+  }
+  state_ = State::kString;
+  return 1;
+}
+
+size_t JsonStreamParser::ReadNumber(const char* data, size_t size) {
+  size_t i = 0;
+  while (i < size && IsNumberChar(data[i])) i++;
+  token_.append(data, i);
+  if (i == size) {
+    return size;
+  }
+  // The number ends here; the next character is parsed in the new state.
+  if (EmitNumber()) {
+    EndValue();
+  }
+  return i;
+}
+
+size_t JsonStreamParser::ReadLiteral(char c) {
+  if (c != *literal_rest_) {
+    return Fail();
+  }
+  if (*++literal_rest_ != '\0') {
+    return 1;
+  }
+  bool ok;
+  switch (token_[0]) {
+    case 't':
+      ok = handler_->Bool(true);
+      break;
+    case 'f':
+      ok = handler_->Bool(false);
+      break;
+    default:
+      ok = handler_->Null();
+      break;
+  }
+  if (!ok) return Fail();
+  EndValue();
+  return 1;
+}
+
+bool JsonStreamParser::EmitNumber() {
+  bool is_integer = false;
+  if (!IsValidNumber(token_, &is_integer)) {
+    Fail();
+    return false;
+  }
+  int64_t int_value;
+  bool ok;
+  if (is_integer && ParseInt(token_, &int_value)) {
+    ok = handler_->Int(int_value);
+  } else {
+    // Numbers with a fraction or exponent are rare in Paystack responses.
+    // Parse them in the classic locale rather than the process one, which
+    // may not use '.' as the decimal point.
+    std::istringstream stream(token_);
+    stream.imbue(std::locale::classic());
+    double double_value = 0;
+    stream >> double_value;
+    ok = handler_->Double(double_value);
+  }
+  if (!ok) {
+    Fail();
+    return false;
+  }
+  return true;
+}
+
+void JsonStreamParser::EndValue() {
+  state_ = containers_.empty() ? State::kDone : State::kCommaOrEnd;
+}
+
+size_t JsonStreamParser::Fail() {
+  state_ = State::kError;
+  return 0;
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,109 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_JSON_STREAM_H_
+#define PAYSTACK_CORE_PAYSTACK_JSON_STREAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace all_paystack_payments {
+
+// Receives the values of a JSON document as JsonStreamParser reads them.
+// Returning false from any method stops parsing.
+//
+// String data is only valid for the duration of the call.
+class JsonHandler {
+ public:
+  virtual ~JsonHandler() = default;
+
+  virtual bool Null() = 0;
+  virtual bool Bool(bool value) = 0;
+  // Numbers without a fraction or exponent that fit in 64 bits.
+  virtual bool Int(int64_t value) = 0;
+  virtual bool Double(double value) = 0;
+  virtual bool String(const char* data, size_t length) = 0;
+  virtual bool StartObject() = 0;
+  virtual bool Key(const char* data, size_t length) = 0;
+  virtual bool EndObject() = 0;
+  virtual bool StartArray() = 0;
+  virtual bool EndArray() = 0;
+};
+
+// Incremental JSON parser that is fed a document in arbitrary chunks, such
+// as those a curl write callback delivers, and passes its values to a
+// JsonHandler as soon as they are complete. No document tree is built; only
+// the string or number being read is buffered.
+class JsonStreamParser {
+ public:
+  explicit JsonStreamParser(JsonHandler* handler);
+
+  // Disallow copy and assign.
+  JsonStreamParser(const JsonStreamParser&) = delete;
+  JsonStreamParser& operator=(const JsonStreamParser&) = delete;
+
+  // Parses the next |size| bytes of the document. Returns false once the
+  // document is invalid or the handler stopped parsing; further input is
+  // ignored.
+  bool Feed(const char* data, size_t size);
+
+  // Ends the document. Returns true if the input was exactly one complete
+  // JSON value, optionally surrounded by whitespace.
+  bool Finish();
+
+  bool failed() const { return state_ == State::kError; }
+
+  // Offset in the chunk being fed of the byte being parsed. Inside
+  // StartObject, EndObject, StartArray and EndArray this is the bracket.
+  size_t position() const { return position_; }
+
+ private:
+  enum class State {
+    kValue,
+    kFirstValueOrArrayEnd,
+    kFirstKeyOrObjectEnd,
+    kKey,
+    kColon,
+    kCommaOrEnd,
+    kString,
+    kEscape,
+    kUnicodeEscape,
+    kNumber,
+    kLiteral,
+    kDone,
+    kError,
+  };
+
+  // Parses from |data| in the current state and returns how many bytes were
+  // consumed.
+  size_t Step(const char* data, size_t size);
+
+  size_t StartValue(char c);
+  size_t ReadString(const char* data, size_t size);
+  size_t ReadEscape(char c);
+  size_t ReadUnicodeEscape(char c);
+  size_t ReadNumber(const char* data, size_t size);
+  size_t ReadLiteral(char c);
+  bool EmitNumber();
+  void EndValue();
+  size_t Fail();
+
+  JsonHandler* handler_;
+  State state_ = State::kValue;
+  size_t position_ = 0;
+  // Open containers, '{' or '['.
+  std::vector<char> containers_;
+  // The string, number or literal being read.
+  std::string token_;
+  bool token_is_key_ = false;
+  // For literals, the text still expected.
+  const char* literal_rest_ = nullptr;
+  // For \u escapes, the hex digits read so far and their value.
+  int unicode_digits_ = 0;
+  uint32_t unicode_value_ = 0;
+  // A high surrogate waiting for its low half.
+  uint32_t high_surrogate_ = 0;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_JSON_STREAM_H_
@@ -0,0 +1,107 @@
+#include "paystack_json_writer.h"
+
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace all_paystack_payments {
+
+namespace {
+
+const char kHexDigits[] = "0123456789abcdef";
+
+bool NeedsEscape(unsigned char c) { return c < 0x20 || c == '"' || c == '\\'; }
+
+}  // namespace
+
+void json_append_int(std::string* out, int64_t value) {
+  char buffer[20];
+  char* end = buffer + sizeof(buffer);
+  char* start = end;
+  // Work with the magnitude as unsigned so that INT64_MIN does not overflow.
+  uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value)
+                                 : static_cast<uint64_t>(value);
+  do {
+    *--start = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) {
+    out->push_back('-');
+  }
+  out->append(start, end - start);
+}
+
+bool json_append_double(std::string* out, double value) {
+  if (!std::isfinite(value)) {
+    return false;
+  }
+  // The shortest of these precisions that reads back exactly. Formatting and
+  // reading back both use the current locale, so they agree.
+  char buffer[32];
+  for (int precision = 15; precision <= 17; precision++) {
+    snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+    if (strtod(buffer, nullptr) == value) break;
+  }
+  const char* decimal_point = localeconv()->decimal_point;
+  char* point = strstr(buffer, decimal_point);
+  if (point != nullptr && strcmp(decimal_point, ".") != 0) {
+    out->append(buffer, point - buffer);
+    out->push_back('.');
+    out->append(point + strlen(decimal_point));
+    return true;
+  }
+  out->append(buffer);
+  // Keep whole numbers recognisable as floats, as nlohmann::json does.
+  if (point == nullptr && strchr(buffer, 'e') == nullptr) {
+    out->append(".0");
+  }
+  return true;
+}
+
+void json_append_string(std::string* out, const char* data, size_t length) {
+  out->push_back('"');
+  size_t run_start = 0;
+  for (size_t i = 0; i < length; i++) {
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    if (!NeedsEscape(c)) {
+      continue;
+    }
+    out->append(data + run_start, i - run_start);
+    run_start = i + 1;
+    switch (c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\b':
+        out->append("\\b");
+        break;
+      case '\f':
+        out->append("\\f");
+        break;
+      case '\n':
+        out->append("\\n");
+        break;
+      case '\r':
+        out->append("\\r");
+        break;
+      case '\t':
+        out->append("\\t");
+        break;
+      default: {
+        const char escape[] = {'\\', 'u', '0', '0', kHexDigits[c >> 4],
+                               kHexDigits[c & 0xF]};
+        out->append(escape, sizeof(escape));
+        break;
+      }
+    }
+  }
+  out->append(data + run_start, length - run_start);
+  out->push_back('"');
+}
+
+}  // namespace all_paystack_payments
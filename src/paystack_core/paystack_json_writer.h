@@ -0,0 +1,24 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_JSON_WRITER_H_
+#define PAYSTACK_CORE_PAYSTACK_JSON_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace all_paystack_payments {
+
+// Appends |value| to |out| as a JSON number.
+void json_append_int(std::string* out, int64_t value);
+
+// Appends |value| to |out| as a JSON number that reads back exactly, with
+// a '.' whatever the locale. Returns false, appending nothing, if |value| is
+// not finite.
+bool json_append_double(std::string* out, double value);
+
+// Appends |length| bytes of UTF-8 text to |out| as a JSON string, quotes
+// included. Runs of characters that need no escaping are copied in one go.
+void json_append_string(std::string* out, const char* data, size_t length);
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_JSON_WRITER_H_
@@ -0,0 +1,176 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_METHOD_REGISTRY_H_
+#define PAYSTACK_CORE_PAYSTACK_METHOD_REGISTRY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace all_paystack_payments {
+
+// Types of method call arguments the dispatcher checks before a handler
+// runs.
+enum class ArgType : uint8_t { kString, kInt, kBool, kMap, kStringList };
+
+// A member of a method call's arguments map.
+struct ArgSpec {
+  const char* name;
+  ArgType type;
+  // Optional arguments may also be absent or null.
+  bool required;
+};
+
+struct ArgList {
+  const ArgSpec* data;
+  size_t size;
+};
+
+template <size_t kSize>
+constexpr ArgList arg_list(const ArgSpec (&args)[kSize]) {
+  return ArgList{args, kSize};
+}
+
+constexpr ArgList kNoArgs = {nullptr, 0};
+
+// What a platform's registry declares about each method call it handles,
+// and the |Handler| that answers it.
+template <typename Handler>
+struct MethodSpec {
+  const char* name;
+  // The arguments map's members. Calls whose arguments are not a map, or
+  // whose members have the wrong type, are answered with INVALID_ARGUMENTS
+  // without reaching the handler. Calls without required arguments may pass
+  // no arguments at all.
+  ArgList args;
+  // The handler may leave the call to be answered later, from the call
+  // engine, instead of returning its response.
+  bool async;
+  Handler handler;
+};
+
+// Counters kept for each registered method, in the slot with the method's
+// index in the registry.
+struct MethodStats {
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> invalid_arguments{0};
+};
+
+// How INVALID_ARGUMENTS errors name what an argument must be.
+inline const char* arg_type_description(ArgType type) {
+  switch (type) {
+    case ArgType::kString:
+      return "a string";
+    case ArgType::kInt:
+      return "an integer";
+    case ArgType::kBool:
+      return "a bool";
+    case ArgType::kMap:
+      return "a map";
+    case ArgType::kStringList:
+      return "a list of strings";
+  }
+  return "";
+}
+
+constexpr size_t method_name_length(const char* name) {
+  size_t length = 0;
+  while (name[length] != '\0') length++;
+  return length;
+}
+
+// Multiplicative hash of |name|'s |length| bytes, four at a time, perturbed
+// by |seed| so that MethodTable can search for one without collisions.
+constexpr uint32_t method_name_hash(const char* name, size_t length,
+                                    uint32_t seed) {
+  uint32_t hash = (2166136261u ^ seed) + static_cast<uint32_t>(length);
+  size_t i = 0;
+  for (; i + 4 <= length; i += 4) {
+    uint32_t word = static_cast<uint8_t>(name[i]) |
+                    static_cast<uint8_t>(name[i + 1]) << 8 |
+                    static_cast<uint32_t>(static_cast<uint8_t>(name[i + 2]))
+                        << 16 |
+                    static_cast<uint32_t>(static_cast<uint8_t>(name[i + 3]))
+                        << 24;
+    hash = (hash ^ word) * 0x9e3779b1u;
+  }
+  for (; i < length; i++) {
+    hash = (hash ^ static_cast<uint8_t>(name[i])) * 16777619u;
+  }
+  return hash ^ (hash >> 15);
+}
+
+// A power of two at least twice |count|, so that MethodTable finds a seed
+// quickly.
+constexpr size_t method_table_slots(size_t count) {
+  size_t slots = 1;
+  while (slots < 2 * count) slots *= 2;
+  return slots;
+}
+
+// Perfect hash of the method names of a registry of |kCount| entries, built
+// at compile time:
+//
+//   constexpr MethodTable<3> kTable(kSpecs);
+//   static_assert(kTable.ok(), "No perfect hash for the method names");
+//
+// Find hashes the name once and compares it with the one candidate its slot
+// holds, however many methods there are.
+template <size_t kCount>
+class MethodTable {
+ public:
+  static constexpr size_t kNotFound = kCount;
+
+  template <typename Handler>
+  constexpr explicit MethodTable(const MethodSpec<Handler> (&specs)[kCount])
+      : names_{}, slots_{}, seed_(0) {
+    static_assert(kCount < kEmpty, "Too many methods for a byte per slot");
+    for (size_t i = 0; i < kCount; i++) names_[i] = specs[i].name;
+    for (uint32_t seed = 1; seed <= kMaxSeed; seed++) {
+      if (Fill(seed)) {
+        seed_ = seed;
+        return;
+      }
+    }
+  }
+
+  // Whether a seed without collisions was found; Find must not be used
+  // otherwise.
+  constexpr bool ok() const { return seed_ != 0; }
+
+  // Returns the index of the method called |name|, or kNotFound.
+  size_t Find(const char* name) const {
+    size_t length = strlen(name);
+    uint8_t index =
+        slots_[method_name_hash(name, length, seed_) & (kSlots - 1)];
+    if (index == kEmpty || memcmp(names_[index], name, length + 1) != 0) {
+      return kNotFound;
+    }
+    return index;
+  }
+
+ private:
+  static constexpr uint8_t kEmpty = 0xff;
+  static constexpr uint32_t kMaxSeed = 1u << 16;
+
+  static constexpr size_t kSlots = method_table_slots(kCount);
+
+  constexpr bool Fill(uint32_t seed) {
+    for (size_t slot = 0; slot < kSlots; slot++) slots_[slot] = kEmpty;
+    for (size_t i = 0; i < kCount; i++) {
+      size_t slot =
+          method_name_hash(names_[i], method_name_length(names_[i]), seed) &
+          (kSlots - 1);
+      if (slots_[slot] != kEmpty) return false;
+      slots_[slot] = static_cast<uint8_t>(i);
+    }
+    return true;
+  }
+
+  const char* names_[kCount];
+  uint8_t slots_[kSlots];
+  uint32_t seed_;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_METHOD_REGISTRY_H_
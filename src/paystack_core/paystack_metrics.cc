@@ -0,0 +1,156 @@
+#include "paystack_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace all_paystack_payments {
+
+namespace {
+
+// Index of the highest set bit of |value|, which is not 0.
+int HighestBit(uint64_t value) {
+#if defined(__GNUC__)
+  return 63 - __builtin_clzll(value);
+#else
+  int bit = 0;
+  while (value >>= 1) bit++;
+  return bit;
+#endif
+}
+
+}  // namespace
+
+constexpr int64_t LatencyHistogram::kMaxValue;
+
+// static
+size_t LatencyHistogram::BucketIndex(int64_t value) {
+  if (value < kSubBuckets) {
+    return static_cast<size_t>(value);
+  }
+  int magnitude = HighestBit(static_cast<uint64_t>(value));
+  int shift = magnitude - kSubBucketBits;
+  // |value| >> |shift| keeps the top bit and the kSubBucketBits below it.
+  int64_t sub_bucket = (value >> shift) - kSubBuckets;
+  return static_cast<size_t>(kSubBuckets * (shift + 1) + sub_bucket);
+}
+
+// static
+int64_t LatencyHistogram::BucketUpperBound(size_t index) {
+  if (index < static_cast<size_t>(kSubBuckets)) {
+    return static_cast<int64_t>(index);
+  }
+  int shift = static_cast<int>(index / kSubBuckets) - 1;
+  int64_t sub_bucket = static_cast<int64_t>(index % kSubBuckets);
+  return ((kSubBuckets + sub_bucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(int64_t micros) {
+  int64_t value = std::min(std::max<int64_t>(micros, 0), kMaxValue);
+  counts_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  int64_t max = max_.load(std::memory_order_relaxed);
+  while (value > max &&
+         !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t LatencyHistogram::count() const {
+  uint64_t total = 0;
+  for (const auto& count : counts_) {
+    total += count.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+int64_t LatencyHistogram::ValueAtPercentile(double percentile) const {
+  return ValueAtPercentile(percentile, count());
+}
+
+int64_t LatencyHistogram::ValueAtPercentile(double percentile,
+                                            uint64_t total) const {
+  if (total == 0) {
+    return 0;
+  }
+  double share = std::min(std::max(percentile, 0.0), 100.0) / 100;
+  uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(share * static_cast<double>(total))));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; i++) {
+    seen += counts_[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::min(BucketUpperBound(i), max_.load(std::memory_order_relaxed));
+    }
+  }
+  // Values were recorded after |total| was counted.
+  return max_.load(std::memory_order_relaxed);
+}
+
+LatencySummary LatencyHistogram::Summarize() const {
+  LatencySummary summary;
+  summary.count = count();
+  summary.p50 = ValueAtPercentile(50, summary.count);
+  summary.p90 = ValueAtPercentile(90, summary.count);
+  summary.p99 = ValueAtPercentile(99, summary.count);
+  summary.p999 = ValueAtPercentile(99.9, summary.count);
+  summary.max = summary.count == 0 ? 0 : max_.load(std::memory_order_relaxed);
+  return summary;
+}
+
+const char* endpoint_name(Endpoint endpoint) {
+  switch (endpoint) {
+    case Endpoint::kInitialize:
+      return "initialize";
+    case Endpoint::kVerify:
+      return "verify";
+  }
+  return "";
+}
+
+const char* phase_name(Phase phase) {
+  switch (phase) {
+    case Phase::kDns:
+      return "dns";
+    case Phase::kConnect:
+      return "connect";
+    case Phase::kTls:
+      return "tls";
+    case Phase::kFirstByte:
+      return "firstByte";
+    case Phase::kTotal:
+      return "total";
+    case Phase::kParse:
+      return "parse";
+    case Phase::kBuild:
+      return "build";
+  }
+  return "";
+}
+
+void ClientMetrics::RecordExchange(Endpoint endpoint,
+                                   const HttpResponse& response,
+                                   const std::string& error_code) {
+  EndpointMetrics& metrics = this->endpoint(endpoint);
+  metrics.requests.fetch_add(1, std::memory_order_relaxed);
+  for (size_t i = 0; i < kMetricErrorCodeCount; i++) {
+    if (error_code == kMetricErrorCodes[i]) {
+      metrics.errors[i].fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+  }
+  const HttpTimings& timings = response.timings;
+  if (timings.total == 0) {
+    return;
+  }
+  if (response.connections_opened > 0) {
+    metrics.phase(Phase::kDns).Record(timings.name_lookup);
+    metrics.phase(Phase::kConnect).Record(timings.connect);
+    if (timings.tls > 0) {
+      metrics.phase(Phase::kTls).Record(timings.tls);
+    }
+  }
+  if (timings.first_byte > 0) {
+    metrics.phase(Phase::kFirstByte).Record(timings.first_byte);
+  }
+  metrics.phase(Phase::kTotal).Record(timings.total);
+}
+
+}  // namespace all_paystack_payments
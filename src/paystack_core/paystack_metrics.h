@@ -0,0 +1,155 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_METRICS_H_
+#define PAYSTACK_CORE_PAYSTACK_METRICS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "paystack_transport.h"
+
+namespace all_paystack_payments {
+
+// Percentiles of the durations a LatencyHistogram recorded, in
+// microseconds. All zero if it recorded none.
+struct LatencySummary {
+  uint64_t count = 0;
+  int64_t p50 = 0;
+  int64_t p90 = 0;
+  int64_t p99 = 0;
+  int64_t p999 = 0;
+  int64_t max = 0;
+};
+
+// Histogram of durations in microseconds, in the style of HdrHistogram.
+// Values below 32 get a bucket each; above that every power of two is split
+// into 32 linear buckets, so a percentile is within about 3% of the value
+// recorded. Durations beyond kMaxValue are counted as kMaxValue.
+//
+// Record is a relaxed atomic increment and may be called from any thread
+// while another reads; a summary taken meanwhile may miss the values being
+// recorded.
+class LatencyHistogram {
+ public:
+  // About 71 minutes.
+  static constexpr int64_t kMaxValue = (int64_t{1} << 32) - 1;
+
+  LatencyHistogram() = default;
+
+  // Disallow copy and assign.
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void Record(int64_t micros);
+
+  // The number of values recorded.
+  uint64_t count() const;
+
+  // The highest value in the bucket holding |percentile|, from 0 to 100, of
+  // the recorded values. 0 if none were recorded.
+  int64_t ValueAtPercentile(double percentile) const;
+
+  LatencySummary Summarize() const;
+
+ private:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr int64_t kSubBuckets = int64_t{1} << kSubBucketBits;
+  // Exact buckets for [0, 32), then 32 per power of two up to 2^32.
+  static constexpr size_t kBuckets = kSubBuckets * (32 - kSubBucketBits + 1);
+
+  static size_t BucketIndex(int64_t value);
+  static int64_t BucketUpperBound(size_t index);
+
+  int64_t ValueAtPercentile(double percentile, uint64_t total) const;
+
+  std::atomic<uint64_t> counts_[kBuckets] = {};
+  std::atomic<int64_t> max_{0};
+};
+
+// The Paystack endpoints a client calls.
+enum class Endpoint { kInitialize, kVerify };
+constexpr size_t kEndpointCount = 2;
+
+// Where the time of one call to an endpoint went. The transfer phases are
+// measured from the start of the transfer, as curl reports them; the
+// connection phases are only recorded for transfers that opened a
+// connection, and kTls only for HTTPS ones.
+enum class Phase {
+  // Name resolution.
+  kDns,
+  // TCP connection established.
+  kConnect,
+  // TLS handshake completed.
+  kTls,
+  // First byte of the response received.
+  kFirstByte,
+  // Transfer completed.
+  kTotal,
+  // Streaming the body through the response parser.
+  kParse,
+  // Building the platform's method call response from the parsed result.
+  kBuild,
+};
+constexpr size_t kPhaseCount = 7;
+
+// Error codes counted per endpoint, in the order of EndpointMetrics::errors.
+constexpr const char* kMetricErrorCodes[] = {"HTTP_ERROR", "API_ERROR",
+                                             "PARSE_ERROR"};
+constexpr size_t kMetricErrorCodeCount = 3;
+
+const char* endpoint_name(Endpoint endpoint);
+// Camel case, as getMetrics reports it.
+const char* phase_name(Phase phase);
+
+struct EndpointMetrics {
+  // Exchanges that completed, successfully or not.
+  std::atomic<uint64_t> requests{0};
+  // Indexed like kMetricErrorCodes.
+  std::atomic<uint64_t> errors[kMetricErrorCodeCount] = {};
+  // Exchanges that were sent again after a transient failure, and transient
+  // failures that were not because the retry budget was spent.
+  std::atomic<uint64_t> retries{0};
+  std::atomic<uint64_t> throttled_retries{0};
+  // Second requests sent for calls that were slow to answer, and those that
+  // answered first.
+  std::atomic<uint64_t> hedges{0};
+  std::atomic<uint64_t> hedges_won{0};
+  // 429 responses, after which the call waited to be sent again.
+  std::atomic<uint64_t> rate_limited{0};
+  LatencyHistogram phases[kPhaseCount];
+
+  LatencyHistogram& phase(Phase phase) {
+    return phases[static_cast<size_t>(phase)];
+  }
+};
+
+// Latency and error counters of a PaystackClient's calls, per endpoint.
+// Everything is recorded lock free, so it may be read from any thread.
+class ClientMetrics {
+ public:
+  ClientMetrics() = default;
+
+  // Disallow copy and assign.
+  ClientMetrics(const ClientMetrics&) = delete;
+  ClientMetrics& operator=(const ClientMetrics&) = delete;
+
+  EndpointMetrics& endpoint(Endpoint endpoint) {
+    return endpoints_[static_cast<size_t>(endpoint)];
+  }
+
+  // Records the transfer phases of |response| and the outcome of the call,
+  // |error_code| being empty if it succeeded.
+  void RecordExchange(Endpoint endpoint, const HttpResponse& response,
+                      const std::string& error_code);
+
+  void Record(Endpoint endpoint, Phase phase, int64_t micros) {
+    this->endpoint(endpoint).phase(phase).Record(micros);
+  }
+
+ private:
+  EndpointMetrics endpoints_[kEndpointCount];
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_METRICS_H_
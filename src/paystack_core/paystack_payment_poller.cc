@@ -0,0 +1,146 @@
+#include "paystack_payment_poller.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "paystack_verify_cache.h"
+
+namespace all_paystack_payments {
+
+namespace {
+
+// Statuses that end a watch: the ones the verification cache keeps.
+bool IsFinal(const std::string& status) {
+  return VerifyCache::IsTerminal(status);
+}
+
+// Polls due this soon after the one a timer is armed for share its wake-up.
+constexpr std::chrono::milliseconds kCoalesceWindow(50);
+
+}  // namespace
+
+PaymentPoller::PaymentPoller(PaystackClient* client, Transport* transport,
+                             Listener listener)
+    : client_(client),
+      transport_(transport),
+      listener_(std::move(listener)) {}
+
+void PaymentPoller::Watch(const std::string& reference, const ApiConfig& api,
+                          const PollPolicy& policy) {
+  Clock::time_point now = Clock::now();
+  Watched& watch = watches_[reference];
+  if (watch.scheduled) {
+    due_.erase(watch.due);
+    watch.scheduled = false;
+  }
+  watch.api = api;
+  watch.policy = policy;
+  watch.deadline = now + std::chrono::milliseconds(policy.timeout_ms);
+  watch.interval_ms = policy.initial_interval_ms;
+  watch.generation = ++last_generation_;
+  Schedule(reference, now);
+}
+
+bool PaymentPoller::Unwatch(const std::string& reference) {
+  auto it = watches_.find(reference);
+  if (it == watches_.end()) {
+    return false;
+  }
+  if (it->second.scheduled) {
+    due_.erase(it->second.due);
+  }
+  watches_.erase(it);
+  return true;
+}
+
+void PaymentPoller::Schedule(const std::string& reference,
+                             Clock::time_point at) {
+  Watched& watch = watches_[reference];
+  watch.due = due_.emplace(at, reference);
+  watch.scheduled = true;
+  Arm();
+}
+
+void PaymentPoller::Arm() {
+  if (due_.empty() || due_.begin()->first >= armed_at_) {
+    return;
+  }
+  Clock::time_point at = due_.begin()->first;
+  armed_at_ = at;
+  Clock::duration wait = std::max(at - Clock::now(), Clock::duration(0));
+  auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(wait);
+  if (delay < wait) {
+    delay += std::chrono::milliseconds(1);
+  }
+  transport_->RunAfter(delay.count(), [this, at](bool cancelled) {
+    if (cancelled) {
+      return;
+    }
+    if (armed_at_ == at) {
+      armed_at_ = Clock::time_point::max();
+    }
+    // Measured from the time the timer was armed for rather than from now,
+    // so that a timer that fires a little early still polls.
+    while (!due_.empty() && due_.begin()->first <= at + kCoalesceWindow) {
+      std::string reference = std::move(due_.begin()->second);
+      due_.erase(due_.begin());
+      watches_[reference].scheduled = false;
+      Poll(reference);
+    }
+    Arm();
+  });
+}
+
+void PaymentPoller::Poll(const std::string& reference) {
+  const Watched& watch = watches_[reference];
+  uint64_t generation = watch.generation;
+  VerifyResult cached;
+  if (client_->verify_cache().Get(reference, &cached) &&
+      IsFinal(cached.status)) {
+    OnResult(reference, generation, cached);
+    return;
+  }
+  client_->VerifyTransaction(
+      reference, watch.api,
+      [this, reference, generation](const VerifyResult& result) {
+        OnResult(reference, generation, result);
+      });
+}
+
+void PaymentPoller::OnResult(const std::string& reference,
+                             uint64_t generation,
+                             const VerifyResult& result) {
+  auto it = watches_.find(reference);
+  if (it == watches_.end() || it->second.generation != generation) {
+    return;
+  }
+  Watched& watch = it->second;
+  Clock::time_point now = Clock::now();
+  bool changed = result.ok() && result.status != watch.status;
+  if (result.ok()) {
+    watch.status = result.status;
+  }
+  PaymentStatusUpdate update;
+  update.reference = reference;
+  update.status = watch.status;
+  update.final = result.ok() && IsFinal(result.status);
+  update.timed_out = !update.final && now >= watch.deadline;
+  if (update.final || update.timed_out) {
+    update.final = true;
+    watches_.erase(it);
+    listener_(update);
+    return;
+  }
+  Clock::time_point at = std::min(
+      now + std::chrono::milliseconds(watch.interval_ms), watch.deadline);
+  watch.interval_ms = std::min(
+      static_cast<int64_t>(watch.interval_ms * watch.policy.backoff),
+      watch.policy.max_interval_ms);
+  // Scheduled first, as the listener may unwatch the reference.
+  Schedule(reference, at);
+  if (changed) {
+    listener_(update);
+  }
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,122 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_PAYMENT_POLLER_H_
+#define PAYSTACK_CORE_PAYSTACK_PAYMENT_POLLER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include "paystack_client.h"
+#include "paystack_transport.h"
+
+namespace all_paystack_payments {
+
+// How often PaymentPoller verifies a watched reference, and for how long.
+struct PollPolicy {
+  // Delay before the second verification. Each delay after it is
+  // |backoff| times the previous one, up to |max_interval_ms|: a customer
+  // is most likely to pay soon after checkout opens.
+  int64_t initial_interval_ms = 1000;
+  int64_t max_interval_ms = 30000;
+  double backoff = 1.5;
+  // How long to watch a reference before giving up on it.
+  int64_t timeout_ms = 15 * 60 * 1000;
+};
+
+// A change in the status of a watched transaction.
+struct PaymentStatusUpdate {
+  std::string reference;
+  // Paystack's status of the transaction. Empty if it timed out before any
+  // verification succeeded.
+  std::string status;
+  // No further update follows: the status cannot change any more, or the
+  // watch timed out.
+  bool final = false;
+  bool timed_out = false;
+};
+
+// Watches the status of open checkouts by verifying their references in the
+// background, and reports each change to a listener, so that callers are
+// told when a payment completes instead of asking again and again.
+//
+// A watch verifies its reference at once, then after delays that grow from
+// PollPolicy::initial_interval_ms to max_interval_ms, until the status is
+// success, failed or reversed, or the policy's timeout passes. Paystack
+// reports abandoned until the customer pays, so that status does not end a
+// watch. Failed verifications are not reported; the watch keeps trying.
+//
+// Every watch shares a single transport timer, armed for the next poll due,
+// and polls due within a few milliseconds of each other share a wake-up, so
+// hundreds of open checkouts cost little more than one.
+//
+// Not thread safe; must be used on the thread the client runs on, and the
+// listener is invoked there.
+class PaymentPoller {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Listener = std::function<void(const PaymentStatusUpdate& update)>;
+
+  // |client| and |transport|, the client's transport, must outlive the
+  // poller, and the poller must outlive the callbacks of the client's
+  // requests.
+  PaymentPoller(PaystackClient* client, Transport* transport,
+                Listener listener);
+
+  // Disallow copy and assign.
+  PaymentPoller(const PaymentPoller&) = delete;
+  PaymentPoller& operator=(const PaymentPoller&) = delete;
+
+  // Starts watching |reference|, or restarts its watch with |api| and
+  // |policy|. Its last status is kept, so that it is not reported again.
+  void Watch(const std::string& reference, const ApiConfig& api,
+             const PollPolicy& policy = PollPolicy());
+
+  // Stops watching |reference| without reporting it. Returns false if it
+  // was not watched.
+  bool Unwatch(const std::string& reference);
+
+  size_t watched() const { return watches_.size(); }
+
+ private:
+  using DueList = std::multimap<Clock::time_point, std::string>;
+
+  struct Watched {
+    ApiConfig api;
+    PollPolicy policy;
+    Clock::time_point deadline;
+    // Delay before the next poll after the current one.
+    int64_t interval_ms = 0;
+    // The last status reported, empty before the first.
+    std::string status;
+    // Tells the results of this watch from those of an earlier watch of the
+    // same reference.
+    uint64_t generation = 0;
+    // Set with its entry in |due_| while the reference waits to be polled.
+    bool scheduled = false;
+    DueList::iterator due;
+  };
+
+  void Schedule(const std::string& reference, Clock::time_point at);
+  // Arms the timer for the first poll due, unless it already fires by then.
+  void Arm();
+  void Poll(const std::string& reference);
+  void OnResult(const std::string& reference, uint64_t generation,
+                const VerifyResult& result);
+
+  PaystackClient* client_;
+  Transport* transport_;
+  Listener listener_;
+  std::unordered_map<std::string, Watched> watches_;
+  // References to poll, by when. Those being verified are not in it.
+  DueList due_;
+  // When the armed timer fires; max() if none is armed.
+  Clock::time_point armed_at_ = Clock::time_point::max();
+  uint64_t last_generation_ = 0;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_PAYMENT_POLLER_H_
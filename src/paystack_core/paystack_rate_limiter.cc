@@ -0,0 +1,119 @@
+#include "paystack_rate_limiter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace all_paystack_payments {
+
+namespace {
+
+// X-RateLimit-Reset values above this are Unix times rather than delays.
+constexpr int64_t kMinUnixTime = 1000000000;
+
+// Whether |line| starts with header |name| and its colon, ignoring case.
+// Sets |value| past the colon.
+bool ReadName(const char* line, size_t size, const char* name,
+              const char** value) {
+  size_t length = strlen(name);
+  if (size <= length || line[length] != ':') {
+    return false;
+  }
+  for (size_t i = 0; i < length; i++) {
+    if (tolower(static_cast<unsigned char>(line[i])) != name[i]) {
+      return false;
+    }
+  }
+  *value = line + length + 1;
+  return true;
+}
+
+// Reads the non-negative integer |value| runs up to |end| with, around
+// spaces. False for anything else, such as the HTTP dates Retry-After may
+// also hold.
+bool ReadSeconds(const char* value, const char* end, int64_t* seconds) {
+  while (value < end && (*value == ' ' || *value == '\t')) value++;
+  while (end > value && isspace(static_cast<unsigned char>(end[-1]))) end--;
+  if (value == end || end - value > 18) {
+    return false;
+  }
+  int64_t result = 0;
+  for (; value < end; value++) {
+    if (!isdigit(static_cast<unsigned char>(*value))) {
+      return false;
+    }
+    result = result * 10 + (*value - '0');
+  }
+  *seconds = result;
+  return true;
+}
+
+}  // namespace
+
+TokenBucket::TokenBucket(double rate, double burst)
+    : rate_(rate), burst_(std::max(burst, 1.0)), tokens_(burst_) {}
+
+void TokenBucket::Refill(Clock::time_point now) {
+  if (refilled_at_ != Clock::time_point() && now > refilled_at_) {
+    std::chrono::duration<double> elapsed = now - refilled_at_;
+    tokens_ = std::min(tokens_ + elapsed.count() * rate_, burst_);
+  }
+  refilled_at_ = std::max(refilled_at_, now);
+}
+
+bool TokenBucket::TryTake(Clock::time_point now) {
+  if (now < paused_until_) {
+    return false;
+  }
+  if (rate_ <= 0) {
+    return true;
+  }
+  Refill(now);
+  if (tokens_ < 1) {
+    return false;
+  }
+  tokens_--;
+  return true;
+}
+
+TokenBucket::Clock::duration TokenBucket::TimeUntilAvailable(
+    Clock::time_point now) {
+  Clock::duration paused = std::max(paused_until_ - now, Clock::duration(0));
+  if (rate_ <= 0) {
+    return paused;
+  }
+  Refill(now);
+  std::chrono::duration<double> missing((1 - tokens_) / rate_);
+  return std::max(
+      paused, std::chrono::duration_cast<Clock::duration>(std::max(
+                  missing, std::chrono::duration<double>(0))));
+}
+
+void TokenBucket::PauseUntil(Clock::time_point until) {
+  paused_until_ = std::max(paused_until_, until);
+}
+
+void read_rate_limit_header(const char* line, size_t size,
+                            RateLimitHeaders* headers) {
+  const char* end = line + size;
+  const char* value = nullptr;
+  if (ReadName(line, size, "retry-after", &value)) {
+    ReadSeconds(value, end, &headers->retry_after);
+  } else if (ReadName(line, size, "x-ratelimit-remaining", &value)) {
+    ReadSeconds(value, end, &headers->remaining);
+  } else if (ReadName(line, size, "x-ratelimit-reset", &value)) {
+    int64_t reset = 0;
+    if (!ReadSeconds(value, end, &reset)) {
+      return;
+    }
+    if (reset >= kMinUnixTime) {
+      int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+      reset = std::max<int64_t>(reset - now, 0);
+    }
+    headers->reset = reset;
+  }
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,68 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_RATE_LIMITER_H_
+#define PAYSTACK_CORE_PAYSTACK_RATE_LIMITER_H_
+
+#include <chrono>
+#include <cstddef>
+
+#include "paystack_transport.h"
+
+namespace all_paystack_payments {
+
+// How fast PaystackClient sends requests to each endpoint, so that a burst
+// of calls waits its turn on the device rather than being sent and refused
+// with a 429.
+struct RateLimitPolicy {
+  // Requests per second allowed on average. 0 sets no limit of our own;
+  // the limiter still holds requests back while Paystack asks it to.
+  double requests_per_second = 0;
+  // Requests that may be sent at once after a quiet period.
+  double burst = 10;
+  // How long a call may wait to be sent before it fails with
+  // kRateLimitedError.
+  std::chrono::milliseconds max_wait = std::chrono::seconds(10);
+  // How long to hold requests back after a 429 without a Retry-After header.
+  std::chrono::milliseconds default_retry_after = std::chrono::seconds(1);
+};
+
+// A token bucket: holds up to |burst| tokens, refilled at |rate| tokens per
+// second, and each request takes one. Requests are also held back while
+// paused, which PaystackClient does when a response says the server's own
+// limit is reached.
+//
+// Not thread safe; PaystackClient keeps one per endpoint on its thread.
+class TokenBucket {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // A |rate| of 0 never runs out of tokens. The bucket starts full.
+  explicit TokenBucket(double rate = 0, double burst = 1);
+
+  // Takes a token, or returns false if there is none or the bucket is
+  // paused.
+  bool TryTake(Clock::time_point now = Clock::now());
+
+  // How long until TryTake can succeed; zero if it can now.
+  Clock::duration TimeUntilAvailable(Clock::time_point now = Clock::now());
+
+  // Holds requests back until |until|, unless already paused for longer.
+  void PauseUntil(Clock::time_point until);
+
+ private:
+  void Refill(Clock::time_point now);
+
+  double rate_;
+  double burst_;
+  double tokens_;
+  // Zero until the first request.
+  Clock::time_point refilled_at_;
+  Clock::time_point paused_until_;
+};
+
+// Reads |line|, one header line of a response, into |headers| if it is one
+// of RateLimitHeaders'. For transports, from their header callbacks.
+void read_rate_limit_header(const char* line, size_t size,
+                            RateLimitHeaders* headers);
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_RATE_LIMITER_H_
@@ -0,0 +1,93 @@
+#include "paystack_request_body.h"
+
+#include <cstddef>
+
+#include "paystack_json_writer.h"
+
+namespace all_paystack_payments {
+
+namespace {
+
+enum class FieldKind { kInt, kString, kJson };
+
+// A member of the initialize body and where its value is in the request.
+struct BodyField {
+  const char* key;
+  // `,"key":`, ready to append; the comma is dropped for the first member.
+  const char* prefix;
+  size_t prefix_length;
+  FieldKind kind;
+  int64_t CheckoutRequest::*int_value;
+  std::string CheckoutRequest::*string_value;
+  // nullptr for members that are always present.
+  bool CheckoutRequest::*present;
+};
+
+#define BODY_FIELD(key, kind, int_value, string_value, present) \
+  { key, ",\"" key "\":", sizeof(",\"" key "\":") - 1, kind, int_value, string_value, present }
+
+constexpr BodyField kInitializeBodyFields[] = {
+    BODY_FIELD("amount", FieldKind::kInt, &CheckoutRequest::amount, nullptr, nullptr),
+    BODY_FIELD("callback_url", FieldKind::kString, nullptr, &CheckoutRequest::callback_url, &CheckoutRequest::has_callback_url),
+    BODY_FIELD("currency", FieldKind::kString, nullptr, &CheckoutRequest::currency, nullptr),
+    BODY_FIELD("email", FieldKind::kString, nullptr, &CheckoutRequest::email, nullptr),
+    BODY_FIELD("metadata", FieldKind::kJson, nullptr, &CheckoutRequest::metadata_json, &CheckoutRequest::has_metadata),
+    BODY_FIELD("reference", FieldKind::kString, nullptr, &CheckoutRequest::reference, &CheckoutRequest::has_reference),
+};
+
+#undef BODY_FIELD
+
+constexpr bool KeyLess(const char* a, const char* b) {
+  while (*a != '\0' && *a == *b) {
+    a++;
+    b++;
+  }
+  return *a < *b;
+}
+
+template <size_t N>
+constexpr bool KeysSorted(const BodyField (&fields)[N]) {
+  for (size_t i = 1; i < N; i++) {
+    if (!KeyLess(fields[i - 1].key, fields[i].key)) return false;
+  }
+  return true;
+}
+
+// nlohmann::json objects are ordered by key, and the body used to be dumped
+// from one.
+static_assert(KeysSorted(kInitializeBodyFields),
+              "initialize body fields must be in key order");
+
+}  // namespace
+
+const std::string& build_initialize_body(const CheckoutRequest& request) {
+  static thread_local std::string body;
+  body.clear();
+  body.push_back('{');
+  bool first = true;
+  for (const BodyField& field : kInitializeBodyFields) {
+    if (field.present != nullptr && !(request.*field.present)) {
+      continue;
+    }
+    size_t comma = first ? 1 : 0;
+    body.append(field.prefix + comma, field.prefix_length - comma);
+    first = false;
+    switch (field.kind) {
+      case FieldKind::kInt:
+        json_append_int(&body, request.*field.int_value);
+        break;
+      case FieldKind::kString: {
+        const std::string& value = request.*field.string_value;
+        json_append_string(&body, value.data(), value.size());
+        break;
+      }
+      case FieldKind::kJson:
+        body.append(request.*field.string_value);
+        break;
+    }
+  }
+  body.push_back('}');
+  return body;
+}
+
+}  // namespace all_paystack_payments
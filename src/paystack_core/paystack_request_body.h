@@ -0,0 +1,35 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_REQUEST_BODY_H_
+#define PAYSTACK_CORE_PAYSTACK_REQUEST_BODY_H_
+
+#include <cstdint>
+#include <string>
+
+namespace all_paystack_payments {
+
+// Arguments of a getCheckoutUrl/initializePayment call, copied out of the
+// method call so they can be used on the I/O thread.
+struct CheckoutRequest {
+  int64_t amount = 0;
+  std::string email;
+  std::string currency;
+  bool has_reference = false;
+  std::string reference;
+  bool has_callback_url = false;
+  std::string callback_url;
+  // The metadata map, already serialized to JSON.
+  bool has_metadata = false;
+  std::string metadata_json;
+};
+
+// Writes the /transaction/initialize body for |request| into a buffer owned
+// by the calling thread and returns it. The buffer is reused by the next
+// call on the same thread, so once it has grown to fit a typical body no
+// allocation is made.
+//
+// The body has the members of the request in key order, as nlohmann::json
+// would dump them.
+const std::string& build_initialize_body(const CheckoutRequest& request);
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_REQUEST_BODY_H_
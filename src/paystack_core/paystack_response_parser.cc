@@ -0,0 +1,190 @@
+#include "paystack_response_parser.h"
+
+#include <utility>
+
+namespace all_paystack_payments {
+
+ResponseParser::ResponseParser(bool capture_data)
+    : parser_(this), capture_data_(capture_data) {}
+
+bool ResponseParser::Feed(const char* data, size_t size) {
+  bytes_received_ += size;
+  chunk_ = data;
+  capture_start_ = 0;
+  bool ok = parser_.Feed(data, size);
+  if (capturing_) {
+    // |data| continues in the next chunk.
+    data_json_.append(data + capture_start_, size - capture_start_);
+  }
+  return ok;
+}
+
+bool ResponseParser::Null() { return true; }
+
+bool ResponseParser::Bool(bool value) {
+  if (depth_ == 1 && top_key_ == "status") {
+    has_status_ = true;
+    status_ = value;
+  }
+  return true;
+}
+
+bool ResponseParser::Int(int64_t value) {
+  if (depth_ == 2 && in_data_) {
+    DataInt(data_key_, value);
+  }
+  return true;
+}
+
+bool ResponseParser::Double(double value) { return true; }
+
+bool ResponseParser::String(const char* data, size_t length) {
+  if (depth_ == 1 && top_key_ == "message") {
+    has_message_ = true;
+    message_.assign(data, length);
+  } else if (depth_ == 2 && in_data_) {
+    DataString(data_key_, data, length);
+  }
+  return true;
+}
+
+bool ResponseParser::StartObject() {
+  depth_++;
+  if (depth_ == 2 && top_key_ == "data") {
+    in_data_ = true;
+    if (capture_data_) {
+      capturing_ = true;
+      data_json_.clear();
+      capture_start_ = parser_.position();
+    }
+  }
+  return true;
+}
+
+bool ResponseParser::Key(const char* data, size_t length) {
+  if (depth_ == 1) {
+    top_key_.assign(data, length);
+  } else if (depth_ == 2 && in_data_) {
+    data_key_.assign(data, length);
+  }
+  return true;
+}
+
+bool ResponseParser::EndObject() {
+  if (depth_ == 2 && capturing_) {
+    size_t end = parser_.position() + 1;
+    data_json_.append(chunk_ + capture_start_, end - capture_start_);
+    capturing_ = false;
+  }
+  if (depth_ == 2) {
+    in_data_ = false;
+  }
+  depth_--;
+  return true;
+}
+
+bool ResponseParser::StartArray() {
+  depth_++;
+  return true;
+}
+
+bool ResponseParser::EndArray() {
+  depth_--;
+  return true;
+}
+
+bool ResponseParser::FinishEnvelope(const HttpResponse& response,
+                                    std::string* error_code,
+                                    std::string* error_message) {
+  // Checked first: an invalid body aborts the transfer from the sink.
+  if (parser_.failed()) {
+    *error_code = "PARSE_ERROR";
+    *error_message = "Failed to parse API response";
+    return false;
+  }
+  if (!response.ok() || bytes_received_ == 0) {
+    *error_code = "HTTP_ERROR";
+    *error_message = "Failed to make HTTP request";
+    return false;
+  }
+  if (!parser_.Finish() || !has_status_ || (!status_ && !has_message_)) {
+    *error_code = "PARSE_ERROR";
+    *error_message = "Failed to parse API response";
+    return false;
+  }
+  if (!status_) {
+    *error_code = "API_ERROR";
+    *error_message = message_;
+    return false;
+  }
+  return true;
+}
+
+VerifyResponseParser::VerifyResponseParser() : ResponseParser(true) {}
+
+VerifyResult VerifyResponseParser::Finish(const HttpResponse& response) {
+  VerifyResult result;
+  if (!FinishEnvelope(response, &result.error_code, &result.error_message)) {
+    return result;
+  }
+  if (!has_reference_ || !has_transaction_status_ || !has_amount_ ||
+      !has_currency_) {
+    result.error_code = "PARSE_ERROR";
+    result.error_message = "Failed to parse API response";
+    return result;
+  }
+  result_.data_json = std::move(data_json());
+  return std::move(result_);
+}
+
+void VerifyResponseParser::DataString(const std::string& key, const char* data,
+                                      size_t length) {
+  if (key == "reference") {
+    has_reference_ = true;
+    result_.reference.assign(data, length);
+  } else if (key == "status") {
+    has_transaction_status_ = true;
+    result_.status.assign(data, length);
+  } else if (key == "currency") {
+    has_currency_ = true;
+    result_.currency.assign(data, length);
+  } else if (key == "gateway_response") {
+    result_.has_gateway_response = true;
+    result_.gateway_response.assign(data, length);
+  } else if (key == "channel") {
+    result_.channel.assign(data, length);
+  }
+}
+
+void VerifyResponseParser::DataInt(const std::string& key, int64_t value) {
+  if (key == "amount") {
+    has_amount_ = true;
+    result_.amount = value;
+  }
+}
+
+CheckoutResult CheckoutResponseParser::Finish(const HttpResponse& response) {
+  CheckoutResult result;
+  if (!FinishEnvelope(response, &result.error_code, &result.error_message)) {
+    return result;
+  }
+  if (!has_authorization_url_ || !has_reference_) {
+    result.error_code = "PARSE_ERROR";
+    result.error_message = "Failed to parse API response";
+    return result;
+  }
+  return std::move(result_);
+}
+
+void CheckoutResponseParser::DataString(const std::string& key,
+                                        const char* data, size_t length) {
+  if (key == "authorization_url") {
+    has_authorization_url_ = true;
+    result_.authorization_url.assign(data, length);
+  } else if (key == "reference") {
+    has_reference_ = true;
+    result_.reference.assign(data, length);
+  }
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,156 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_RESPONSE_PARSER_H_
+#define PAYSTACK_CORE_PAYSTACK_RESPONSE_PARSER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "paystack_transport.h"
+#include "paystack_json_stream.h"
+
+namespace all_paystack_payments {
+
+// A transaction as reported by /transaction/verify, or why it could not be
+// verified.
+struct VerifyResult {
+  // Set when verification failed, to the method call error code.
+  std::string error_code;
+  std::string error_message;
+
+  std::string reference;
+  std::string status;
+  int64_t amount = 0;
+  std::string currency;
+  bool has_gateway_response = false;
+  std::string gateway_response;
+  // How the customer paid, e.g. card, bank_transfer or mobile_money.
+  std::string channel;
+  // The complete |data| object of the response, as JSON text. Kept instead
+  // of a parsed tree so that results can be cached and shared between
+  // threads, and converted to whatever the caller needs in one pass.
+  std::string data_json;
+
+  bool ok() const { return error_code.empty(); }
+};
+
+// A checkout started by /transaction/initialize, or why it failed.
+struct CheckoutResult {
+  // Set when initialization failed, to the method call error code.
+  std::string error_code;
+  std::string error_message;
+
+  std::string authorization_url;
+  std::string reference;
+
+  bool ok() const { return error_code.empty(); }
+};
+
+// Parses a Paystack response body while it is being received.
+//
+// Reads the {status, message, data} envelope every endpoint returns and
+// passes the string and integer members of |data| to the subclass, which
+// keeps the ones it needs. Everything else, including objects nested in
+// |data| such as log, authorization and customer, is only scanned, unless
+// the subclass asks for the raw text of |data|.
+class ResponseParser : public JsonHandler {
+ public:
+  // If |capture_data| is set, the text of the |data| object is collected as
+  // it streams past; see data_json().
+  explicit ResponseParser(bool capture_data = false);
+
+  // Disallow copy and assign.
+  ResponseParser(const ResponseParser&) = delete;
+  ResponseParser& operator=(const ResponseParser&) = delete;
+
+  // Parses the next chunk of the body, e.g. from a Transport BodySink.
+  // Returns false once the body is known to be invalid.
+  bool Feed(const char* data, size_t size);
+
+  // JsonHandler:
+  bool Null() override;
+  bool Bool(bool value) override;
+  bool Int(int64_t value) override;
+  bool Double(double value) override;
+  bool String(const char* data, size_t length) override;
+  bool StartObject() override;
+  bool Key(const char* data, size_t length) override;
+  bool EndObject() override;
+  bool StartArray() override;
+  bool EndArray() override;
+
+ protected:
+  // Called for string and integer members of |data|.
+  virtual void DataString(const std::string& key, const char* data,
+                          size_t length) {}
+  virtual void DataInt(const std::string& key, int64_t value) {}
+
+  // Ends parsing once |response| has completed. Returns true if the body was
+  // a successful API response. Otherwise sets |error_code| and
+  // |error_message| to the error to report.
+  bool FinishEnvelope(const HttpResponse& response, std::string* error_code,
+                      std::string* error_message);
+
+  // The text of the |data| object, if it is captured.
+  std::string& data_json() { return data_json_; }
+
+ private:
+  JsonStreamParser parser_;
+  size_t bytes_received_ = 0;
+
+  const bool capture_data_;
+  std::string data_json_;
+  bool capturing_ = false;
+  // The chunk being fed, and where the captured text starts in it.
+  const char* chunk_ = nullptr;
+  size_t capture_start_ = 0;
+
+  // Nesting depth of the value being read; 1 inside the top-level object.
+  int depth_ = 0;
+  // The last key read in the top-level object and in |data|.
+  std::string top_key_;
+  std::string data_key_;
+  bool in_data_ = false;
+
+  bool has_status_ = false;
+  bool status_ = false;
+  bool has_message_ = false;
+  std::string message_;
+};
+
+// Streams a /transaction/verify response into a VerifyResult.
+class VerifyResponseParser : public ResponseParser {
+ public:
+  VerifyResponseParser();
+
+  VerifyResult Finish(const HttpResponse& response);
+
+ protected:
+  void DataString(const std::string& key, const char* data,
+                  size_t length) override;
+  void DataInt(const std::string& key, int64_t value) override;
+
+ private:
+  VerifyResult result_;
+  bool has_reference_ = false;
+  bool has_transaction_status_ = false;
+  bool has_amount_ = false;
+  bool has_currency_ = false;
+};
+
+// Streams a /transaction/initialize response into a CheckoutResult.
+class CheckoutResponseParser : public ResponseParser {
+ public:
+  CheckoutResult Finish(const HttpResponse& response);
+
+ protected:
+  void DataString(const std::string& key, const char* data,
+                  size_t length) override;
+
+ private:
+  CheckoutResult result_;
+  bool has_authorization_url_ = false;
+  bool has_reference_ = false;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_RESPONSE_PARSER_H_
@@ -0,0 +1,30 @@
+#include "paystack_retry.h"
+
+#include <algorithm>
+
+namespace all_paystack_payments {
+
+RetryBudget::RetryBudget(double ratio, double reserve)
+    : ratio_(ratio), reserve_(reserve), balance_(reserve) {}
+
+void RetryBudget::OnCall() {
+  balance_ = std::min(balance_ + ratio_, reserve_);
+}
+
+bool RetryBudget::TryRetry() {
+  if (balance_ < 1) {
+    return false;
+  }
+  balance_ -= 1;
+  return true;
+}
+
+int64_t decorrelated_jitter(const RetryPolicy& policy, int64_t previous_ms,
+                            std::minstd_rand* random) {
+  int64_t low = policy.base_delay_ms;
+  int64_t high = std::max(low, std::max(previous_ms, low) * 3);
+  std::uniform_int_distribution<int64_t> delay(low, high);
+  return std::min(delay(*random), policy.max_delay_ms);
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,72 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_RETRY_H_
+#define PAYSTACK_CORE_PAYSTACK_RETRY_H_
+
+#include <cstdint>
+#include <random>
+
+namespace all_paystack_payments {
+
+// When PaystackClient sends a request again after a transient failure: the
+// transport failing to complete the exchange, or a 5xx response. Only calls
+// that are safe to repeat are retried.
+struct RetryPolicy {
+  // Attempts per call, including the first. 1 disables retries.
+  int max_attempts = 3;
+  // Bounds of the delay before each retry, in milliseconds.
+  int64_t base_delay_ms = 100;
+  int64_t max_delay_ms = 2000;
+  // Retries allowed per call made, on top of a reserve of |budget_reserve|
+  // retries. See RetryBudget.
+  double budget_ratio = 0.1;
+  double budget_reserve = 10;
+};
+
+// When PaystackClient hedges a verification: sends the same request again,
+// over a new connection, if the first has not answered by the time most
+// verifications have, and takes whichever response arrives first.
+struct HedgePolicy {
+  // Percentile of the recorded verification latencies after which to hedge.
+  // 0 disables hedging.
+  double percentile = 0;
+  // Verifications recorded before the percentile is trusted.
+  uint64_t min_samples = 20;
+  // Lower bound of the delay before hedging, in milliseconds.
+  int64_t min_delay_ms = 10;
+  // Hedges allowed per verification, on top of a reserve of
+  // |budget_reserve| hedges. See RetryBudget.
+  double budget_ratio = 0.05;
+  double budget_reserve = 2;
+};
+
+// Caps retries at a fraction of the calls made, so that an outage does not
+// multiply the load on Paystack. Each call deposits |ratio| of a retry, up to
+// |reserve| retries, and each retry withdraws one. The reserve starts full,
+// so that occasional failures are retried before there is any traffic.
+// Hedges are capped by a budget of their own.
+class RetryBudget {
+ public:
+  RetryBudget(double ratio, double reserve);
+
+  void OnCall();
+
+  // Withdraws a retry, or returns false if the budget is spent.
+  bool TryRetry();
+
+ private:
+  double ratio_;
+  double reserve_;
+  double balance_;
+};
+
+// The delay before the next retry with "decorrelated jitter": uniformly
+// random between the policy's base delay and three times |previous_ms|, the
+// previous delay, capped at its maximum. Pass 0 before the first retry.
+//
+// Delays grow exponentially on average, and clients that failed together
+// spread their retries out instead of retrying in lockstep.
+int64_t decorrelated_jitter(const RetryPolicy& policy, int64_t previous_ms,
+                            std::minstd_rand* random);
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_RETRY_H_
@@ -0,0 +1,63 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_SINGLE_FLIGHT_H_
+#define PAYSTACK_CORE_PAYSTACK_SINGLE_FLIGHT_H_
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace all_paystack_payments {
+
+// Coalesces concurrent requests for the same key into one.
+//
+// The first caller to Join a key starts the work; callers that Join while it
+// is in flight only wait for it. Complete hands the one result to every
+// waiter.
+//
+// Not thread safe; meant to be used on the thread a Transport runs its
+// callbacks on.
+template <typename Result>
+class SingleFlight {
+ public:
+  using Callback = std::function<void(const Result& result)>;
+
+  SingleFlight() = default;
+
+  // Disallow copy and assign.
+  SingleFlight(const SingleFlight&) = delete;
+  SingleFlight& operator=(const SingleFlight&) = delete;
+
+  // Adds |callback| to the waiters for |key|. Returns true if no request for
+  // |key| was in flight, in which case the caller must start one and call
+  // Complete when it finishes.
+  bool Join(const std::string& key, Callback callback) {
+    std::vector<Callback>& waiters = in_flight_[key];
+    waiters.push_back(std::move(callback));
+    return waiters.size() == 1;
+  }
+
+  // Ends the request for |key| and passes |result| to all of its waiters.
+  void Complete(const std::string& key, const Result& result) {
+    auto it = in_flight_.find(key);
+    if (it == in_flight_.end()) {
+      return;
+    }
+    // Waiters may Join |key| again, which has to start a new request.
+    std::vector<Callback> waiters = std::move(it->second);
+    in_flight_.erase(it);
+    for (Callback& waiter : waiters) {
+      waiter(result);
+    }
+  }
+
+  // Number of keys with a request in flight.
+  size_t size() const { return in_flight_.size(); }
+
+ private:
+  std::unordered_map<std::string, std::vector<Callback>> in_flight_;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_SINGLE_FLIGHT_H_
@@ -0,0 +1,168 @@
+#include "paystack_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "paystack_json_writer.h"
+
+namespace all_paystack_payments {
+
+namespace {
+
+// The writer wakes up once this much is pending, or after kFlushInterval.
+constexpr size_t kFlushBytes = 64 * 1024;
+constexpr std::chrono::milliseconds kFlushInterval(200);
+
+// Small, stable ids for the threads that record spans, in the order they
+// first do.
+int TraceThreadId() {
+  static std::atomic<int> next_id{1};
+  thread_local int id = next_id.fetch_add(1, std::memory_order_relaxed);
+  return id;
+}
+
+}  // namespace
+
+Tracer::Tracer() = default;
+
+Tracer::~Tracer() {
+  Stop();
+}
+
+// static
+int64_t Tracer::Now() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+bool Tracer::Start(const std::string& path, std::string* error) {
+  Stop();
+  file_.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!file_) {
+    file_.clear();
+    *error = "Failed to open " + path;
+    return false;
+  }
+  file_ << "[\n";
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.clear();
+    first_event_ = true;
+    stopping_ = false;
+  }
+  writer_ = std::thread(&Tracer::WriteLoop, this);
+  enabled_.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void Tracer::Stop() {
+  if (!writer_.joinable()) {
+    return;
+  }
+  enabled_.store(false, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_one();
+  writer_.join();
+  file_ << "\n]\n";
+  file_.close();
+}
+
+void Tracer::Span(const char* name, int64_t start, int64_t duration,
+                  const TraceArgs& args) {
+  if (!enabled()) {
+    return;
+  }
+  thread_local std::string event;
+  event.assign("{\"name\":");
+  json_append_string(&event, name, strlen(name));
+  event.append(",\"cat\":\"paystack\",\"ph\":\"X\",\"ts\":");
+  json_append_int(&event, start);
+  event.append(",\"dur\":");
+  json_append_int(&event, std::max<int64_t>(duration, 0));
+  event.append(",\"pid\":1,\"tid\":");
+  json_append_int(&event, TraceThreadId());
+  event.append(",\"args\":{");
+  const char* separator = "";
+  if (!args.reference.empty()) {
+    event.append("\"reference\":");
+    json_append_string(&event, args.reference.data(), args.reference.size());
+    separator = ",";
+  }
+  if (args.method != nullptr) {
+    event.append(separator);
+    event.append("\"method\":");
+    json_append_string(&event, args.method, strlen(args.method));
+  }
+  event.append("}}");
+
+  bool flush;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      return;
+    }
+    // The first event of a trace follows the opening bracket directly.
+    if (!first_event_) {
+      pending_.append(",\n");
+    }
+    first_event_ = false;
+    pending_.append(event);
+    flush = pending_.size() >= kFlushBytes;
+  }
+  if (flush) {
+    condition_.notify_one();
+  }
+}
+
+void Tracer::Transfer(const HttpResponse& response, int64_t end,
+                      const TraceArgs& args) {
+  const HttpTimings& timings = response.timings;
+  if (!enabled() || timings.total == 0) {
+    return;
+  }
+  int64_t start = end - timings.total;
+  int64_t ready = 0;
+  if (response.connections_opened > 0) {
+    Span("dns", start, timings.name_lookup, args);
+    Span("connect", start + timings.name_lookup,
+         timings.connect - timings.name_lookup, args);
+    ready = timings.connect;
+    if (timings.tls > 0) {
+      Span("tls", start + timings.connect, timings.tls - timings.connect,
+           args);
+      ready = timings.tls;
+    }
+  }
+  int64_t first_byte = timings.first_byte > 0 ? timings.first_byte
+                                              : timings.total;
+  Span("request", start + ready, first_byte - ready, args);
+  Span("response", start + first_byte, timings.total - first_byte, args);
+}
+
+void Tracer::WriteLoop() {
+  std::string writing;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    condition_.wait_for(lock, kFlushInterval, [this] {
+      return stopping_ || pending_.size() >= kFlushBytes;
+    });
+    writing.swap(pending_);
+    bool stopping = stopping_;
+    lock.unlock();
+    // Flushed each time, so a trace survives the process dying.
+    file_.write(writing.data(), static_cast<std::streamsize>(writing.size()));
+    file_.flush();
+    writing.clear();
+    if (stopping) {
+      return;
+    }
+    lock.lock();
+  }
+}
+
+}  // namespace all_paystack_payments
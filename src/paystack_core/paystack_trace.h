@@ -0,0 +1,94 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_TRACE_H_
+#define PAYSTACK_CORE_PAYSTACK_TRACE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "paystack_transport.h"
+
+namespace all_paystack_payments {
+
+// What a span belongs to, shown as its arguments in the trace viewer.
+struct TraceArgs {
+  // The payment reference, if known. Empty otherwise.
+  std::string reference;
+  // The method call, for spans of the dispatcher. nullptr otherwise.
+  const char* method = nullptr;
+};
+
+// Writes spans of the plugin's work to a file in the Chrome trace event
+// format, which chrome://tracing and ui.perfetto.dev open:
+//
+//   tracer.Start("/tmp/checkout.json", &error);
+//   int64_t start = Tracer::Now();
+//   ...
+//   tracer.Span("parse", start, Tracer::Now() - start, {reference});
+//   tracer.Stop();
+//
+// Span formats the event on the calling thread and appends it to a buffer
+// that a background thread writes out, so recording never waits for the
+// disk. The file is a JSON array of complete ("X") events, one per line;
+// viewers also open it if the process dies before Stop closes the array.
+//
+// Span may be called from any thread, and does nothing unless tracing.
+// Start and Stop must be called from one thread.
+class Tracer {
+ public:
+  Tracer();
+  // Stops tracing.
+  ~Tracer();
+
+  // Disallow copy and assign.
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+
+  // Microseconds on the monotonic clock spans are timed with.
+  static int64_t Now();
+
+  // Starts writing spans to |path|, replacing it, after stopping any trace
+  // in progress. Returns false, with |error| set, if it cannot be created.
+  bool Start(const std::string& path, std::string* error);
+
+  // Writes out the spans recorded so far and closes the file. Does nothing
+  // if not tracing.
+  void Stop();
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  // Records a span of |duration| microseconds that began at |start|, as
+  // returned by Now.
+  void Span(const char* name, int64_t start, int64_t duration,
+            const TraceArgs& args);
+
+  // Records the phases of the exchange that ended with |response| at |end|:
+  // dns, connect and tls if it opened a connection, then request (until the
+  // first byte of the response) and response. Nothing if the transport did
+  // not time it.
+  void Transfer(const HttpResponse& response, int64_t end,
+                const TraceArgs& args);
+
+ private:
+  void WriteLoop();
+
+  std::atomic<bool> enabled_{false};
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  // Formatted events waiting for the writer, separated by ",\n".
+  std::string pending_;
+  bool first_event_ = true;
+  bool stopping_ = false;
+
+  // Only used by the writer thread while it runs.
+  std::ofstream file_;
+  std::thread writer_;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_TRACE_H_
@@ -0,0 +1,111 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_TRANSPORT_H_
+#define PAYSTACK_CORE_PAYSTACK_TRANSPORT_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace all_paystack_payments {
+
+enum class HttpMethod { kGet, kPost };
+
+// A request to the Paystack API.
+struct HttpRequest {
+  HttpMethod method = HttpMethod::kGet;
+  std::string url;
+  // Sent as the bearer token.
+  std::string public_key;
+  // JSON body of a POST request.
+  std::string body;
+  // Opens a new connection rather than reusing or multiplexing over one,
+  // so that the request cannot queue behind a stuck one.
+  bool fresh_connection = false;
+  // Limits on connecting and on the whole exchange, in milliseconds; 0 for
+  // none. An exchange that runs out of either fails like any other
+  // transport failure.
+  int64_t connect_timeout_ms = 0;
+  int64_t timeout_ms = 0;
+};
+
+// When an exchange reached each of its phases, in microseconds from its
+// start. 0 if the transport does not measure them, or for phases the
+// exchange skipped, such as name lookup on a reused connection.
+struct HttpTimings {
+  int64_t name_lookup = 0;
+  int64_t connect = 0;
+  // TLS handshake completed.
+  int64_t tls = 0;
+  int64_t first_byte = 0;
+  int64_t total = 0;
+};
+
+// What a response's headers said about the client's rate limit, in seconds.
+// -1 for headers the response did not have.
+struct RateLimitHeaders {
+  // Retry-After, usually on a 429.
+  int64_t retry_after = -1;
+  // X-RateLimit-Remaining: requests left in the current window.
+  int64_t remaining = -1;
+  // X-RateLimit-Reset: time until the window resets.
+  int64_t reset = -1;
+};
+
+// Outcome of a single HTTP exchange.
+struct HttpResponse {
+  // Empty if the exchange completed, whatever the HTTP status. Otherwise
+  // why it failed, as reported by the transport.
+  std::string error;
+  long status_code = 0;
+  // The response body, unless it was streamed to a BodySink.
+  std::string body;
+  // Major version of the protocol the exchange used, 1 or 2; 0 if unknown.
+  int http_version = 0;
+  // Connections the exchange had to open; 0 when it reused one.
+  long connections_opened = 0;
+  HttpTimings timings;
+  // Filled by transports with read_rate_limit_header.
+  RateLimitHeaders rate_limit;
+
+  bool ok() const { return error.empty(); }
+};
+
+using HttpCallback = std::function<void(HttpResponse& response)>;
+
+// Receives the response body as it arrives, instead of HttpResponse::body.
+// Returning false aborts the exchange.
+using BodySink = std::function<bool(const char* data, size_t size)>;
+
+// Identifies a request in flight, to cancel it. 0 for none.
+using RequestId = uint64_t;
+
+// Run once a delay has elapsed, or with |cancelled| set if the transport is
+// destroyed first.
+using DelayedTask = std::function<void(bool cancelled)>;
+
+// Carries requests to the Paystack API for PaystackClient. Each platform
+// provides one over its HTTP stack; tests and benchmarks provide fakes.
+class Transport {
+ public:
+  virtual ~Transport() = default;
+
+  // Starts |request|. If |sink| is set, the response body is streamed to it
+  // rather than collected in HttpResponse::body. |callback| is invoked
+  // exactly once, possibly before Send returns, on the thread the transport
+  // runs its callbacks on. Returns the request's id while it is in flight,
+  // or 0 if it completed before Send returned.
+  virtual RequestId Send(HttpRequest request, HttpCallback callback,
+                         BodySink sink) = 0;
+
+  // Aborts request |id| if it is still in flight, invoking its callback
+  // with an error before returning.
+  virtual void Cancel(RequestId id) = 0;
+
+  // Runs |task| on the same thread as Send's callbacks once |delay_ms|
+  // milliseconds have passed. A transport that completes requests inside
+  // Send, and has no timers, runs |task| cancelled at once instead.
+  virtual void RunAfter(int64_t delay_ms, DelayedTask task) = 0;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_TRANSPORT_H_
@@ -0,0 +1,88 @@
+#include "paystack_verify_cache.h"
+
+#include <iterator>
+
+namespace all_paystack_payments {
+
+constexpr size_t VerifyCache::kDefaultCapacity;
+constexpr VerifyCache::Clock::duration VerifyCache::kDefaultPendingTtl;
+
+VerifyCache::VerifyCache(size_t capacity, Clock::duration pending_ttl)
+    : capacity_(capacity > 0 ? capacity : 1), pending_ttl_(pending_ttl) {}
+
+bool VerifyCache::Get(const std::string& reference, VerifyResult* result,
+                      Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(reference);
+  if (it == index_.end()) {
+    misses_++;
+    return false;
+  }
+  if (now >= it->second->expires_at) {
+    EraseLocked(it->second);
+    misses_++;
+    return false;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  *result = it->second->result;
+  hits_++;
+  return true;
+}
+
+void VerifyCache::Put(const std::string& reference, const VerifyResult& result,
+                      Clock::time_point now) {
+  if (!result.ok()) {
+    return;
+  }
+  Clock::time_point expires_at =
+      IsTerminal(result.status) ? Clock::time_point::max() : now + pending_ttl_;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(reference);
+  if (it != index_.end()) {
+    it->second->result = result;
+    it->second->expires_at = expires_at;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+  if (entries_.size() >= capacity_) {
+    EraseLocked(std::prev(entries_.end()));
+  }
+  entries_.push_front(Entry{reference, result, expires_at});
+  index_.emplace(reference, entries_.begin());
+}
+
+void VerifyCache::Invalidate(const std::string& reference) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(reference);
+  if (it != index_.end()) {
+    EraseLocked(it->second);
+  }
+}
+
+void VerifyCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  index_.clear();
+  entries_.clear();
+}
+
+VerifyCache::Stats VerifyCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.size = entries_.size();
+  return stats;
+}
+
+bool VerifyCache::IsTerminal(const std::string& status) {
+  // Not abandoned: the customer may still pay.
+  return status == "success" || status == "failed" || status == "reversed";
+}
+
+void VerifyCache::EraseLocked(EntryList::iterator entry) {
+  index_.erase(entry->reference);
+  entries_.erase(entry);
+}
+
+}  // namespace all_paystack_payments
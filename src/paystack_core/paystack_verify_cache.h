@@ -0,0 +1,89 @@
+#ifndef PAYSTACK_CORE_PAYSTACK_VERIFY_CACHE_H_
+#define PAYSTACK_CORE_PAYSTACK_VERIFY_CACHE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "paystack_response_parser.h"
+
+namespace all_paystack_payments {
+
+// Bounded LRU cache of verification results, keyed by reference.
+//
+// Transactions in a terminal state (success, failed, reversed) no longer
+// change, so they are kept until evicted. Other results expire
+// after a short TTL so that a pending transaction is checked again soon.
+// Only successful verifications are cached.
+//
+// Thread safe.
+class VerifyCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t size = 0;
+  };
+
+  static constexpr size_t kDefaultCapacity = 512;
+  static constexpr Clock::duration kDefaultPendingTtl = std::chrono::seconds(5);
+
+  explicit VerifyCache(size_t capacity = kDefaultCapacity,
+                       Clock::duration pending_ttl = kDefaultPendingTtl);
+
+  // Disallow copy and assign.
+  VerifyCache(const VerifyCache&) = delete;
+  VerifyCache& operator=(const VerifyCache&) = delete;
+
+  // Copies the cached result for |reference| into |result| and returns true,
+  // or returns false if there is none or it has expired.
+  bool Get(const std::string& reference, VerifyResult* result,
+           Clock::time_point now = Clock::now());
+
+  // Caches |result| for |reference|, evicting the least recently used entry
+  // when full. Failed verifications are ignored.
+  void Put(const std::string& reference, const VerifyResult& result,
+           Clock::time_point now = Clock::now());
+
+  // Drops the result for |reference|, if any.
+  void Invalidate(const std::string& reference);
+
+  // Drops every result.
+  void Clear();
+
+  Stats stats() const;
+
+  // Whether a transaction with |status| can no longer change.
+  static bool IsTerminal(const std::string& status);
+
+ private:
+  struct Entry {
+    std::string reference;
+    VerifyResult result;
+    // Clock::time_point::max() for terminal results.
+    Clock::time_point expires_at;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  void EraseLocked(EntryList::iterator entry);
+
+  const size_t capacity_;
+  const Clock::duration pending_ttl_;
+
+  mutable std::mutex mutex_;
+  // Most recently used first.
+  EntryList entries_;
+  std::unordered_map<std::string, EntryList::iterator> index_;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // PAYSTACK_CORE_PAYSTACK_VERIFY_CACHE_H_
@@ -0,0 +1,1297 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "paystack_callback_request.h"
+#include "paystack_client.h"
+#include "paystack_json_writer.h"
+#include "paystack_method_registry.h"
+#include "paystack_metrics.h"
+#include "paystack_payment_poller.h"
+#include "paystack_rate_limiter.h"
+#include "paystack_request_body.h"
+#include "paystack_response_parser.h"
+#include "paystack_retry.h"
+#include "paystack_single_flight.h"
+#include "paystack_trace.h"
+#include "paystack_transport.h"
+#include "paystack_verify_cache.h"
+
+// Tests of the platform-neutral core. They need no Flutter engine; see
+// ../CMakeLists.txt for how to build and run them.
+
+namespace all_paystack_payments {
+namespace test {
+
+namespace {
+
+// Holds requests and timers until the test answers or fires them.
+class FakeTransport : public Transport {
+ public:
+  struct Exchange {
+    RequestId id;
+    HttpRequest request;
+    HttpCallback callback;
+    BodySink sink;
+  };
+
+  struct Timer {
+    int64_t delay_ms;
+    DelayedTask task;
+  };
+
+  RequestId Send(HttpRequest request, HttpCallback callback,
+                 BodySink sink) override {
+    pending.push_back({++last_id, std::move(request), std::move(callback),
+                       std::move(sink)});
+    return last_id;
+  }
+
+  void Cancel(RequestId id) override {
+    for (size_t i = 0; i < pending.size(); i++) {
+      if (pending[i].id == id) {
+        cancelled.push_back(id);
+        Fail(i, "Callback aborted");
+        return;
+      }
+    }
+  }
+
+  void RunAfter(int64_t delay_ms, DelayedTask task) override {
+    timers.push_back({delay_ms, std::move(task)});
+  }
+
+  // Answers the |index|th pending request with |body|, streamed to its sink
+  // in two pieces.
+  void Respond(size_t index, const std::string& body,
+               long status_code = 200) {
+    Exchange exchange = std::move(pending[index]);
+    pending.erase(pending.begin() + index);
+    HttpResponse response;
+    response.status_code = status_code;
+    response.timings = timings;
+    response.connections_opened = connections_opened;
+    response.rate_limit = rate_limit;
+    size_t half = body.size() / 2;
+    if (exchange.sink(body.data(), half)) {
+      exchange.sink(body.data() + half, body.size() - half);
+    }
+    exchange.callback(response);
+  }
+
+  // Fails the |index|th pending request as the transport would.
+  void Fail(size_t index, const std::string& error) {
+    Exchange exchange = std::move(pending[index]);
+    pending.erase(pending.begin() + index);
+    HttpResponse response;
+    response.error = error;
+    exchange.callback(response);
+  }
+
+  // Fires the oldest pending timer.
+  void Fire(bool cancelled = false) {
+    Timer timer = std::move(timers.front());
+    timers.erase(timers.begin());
+    timer.task(cancelled);
+  }
+
+  std::vector<Exchange> pending;
+  std::vector<Timer> timers;
+  RequestId last_id = 0;
+  std::vector<RequestId> cancelled;
+  // Reported by every response.
+  HttpTimings timings;
+  long connections_opened = 0;
+  RateLimitHeaders rate_limit;
+};
+
+std::string VerifyBody(const std::string& reference,
+                       const std::string& status = "success") {
+  return R"({"status":true,"message":"Verification successful","data":{)"
+         R"("reference":")" + reference + R"(","status":")" + status +
+         R"(",)"
+         R"("amount":50000,"currency":"NGN","channel":"card"}})";
+}
+
+ApiConfig TestApi() {
+  ApiConfig api;
+  api.public_key = "pk_test";
+  return api;
+}
+
+RetryPolicy NoRetries() {
+  RetryPolicy policy;
+  policy.max_attempts = 1;
+  return policy;
+}
+
+CheckoutRequest TestCheckout() {
+  CheckoutRequest request;
+  request.amount = 50000;
+  request.email = "a@b.co";
+  request.currency = "NGN";
+  return request;
+}
+
+}  // namespace
+
+TEST(JsonWriter, AppendsNumbersAndStrings) {
+  std::string json;
+  json_append_int(&json, std::numeric_limits<int64_t>::min());
+  json.push_back(',');
+  EXPECT_TRUE(json_append_double(&json, 0.1));
+  json.push_back(',');
+  EXPECT_TRUE(json_append_double(&json, 2));
+  json.push_back(',');
+  EXPECT_TRUE(json_append_double(&json, 1e300));
+  json.push_back(',');
+  const char text[] = "a\"\\\x01";
+  json_append_string(&json, text, strlen(text));
+  EXPECT_EQ(json, R"(-9223372036854775808,0.1,2.0,1e+300,"a\"\\\u0001")");
+
+  EXPECT_FALSE(json_append_double(&json, std::nan("")));
+  EXPECT_FALSE(
+      json_append_double(&json, std::numeric_limits<double>::infinity()));
+}
+
+TEST(MethodTable, FindsEveryMethod) {
+  static constexpr ArgSpec kArgs[] = {{"reference", ArgType::kString, true}};
+  static constexpr MethodSpec<int> kMethods[] = {
+      {"initialize", kNoArgs, false, 0},
+      {"initializePayment", arg_list(kArgs), true, 1},
+      {"verifyPayment", arg_list(kArgs), true, 2},
+      {"verifyPayments", kNoArgs, true, 3},
+      {"getPlatformVersion", kNoArgs, false, 4},
+  };
+  static constexpr MethodTable<5> kTable(kMethods);
+  static_assert(kTable.ok(), "No perfect hash for the test methods");
+
+  for (size_t i = 0; i < 5; i++) {
+    EXPECT_EQ(kTable.Find(kMethods[i].name), i) << kMethods[i].name;
+  }
+  for (const char* unknown : {"", "verify", "verifyPaymentsX", "initializ"}) {
+    EXPECT_EQ(kTable.Find(unknown), kTable.kNotFound) << unknown;
+  }
+  EXPECT_STREQ(arg_type_description(ArgType::kStringList), "a list of strings");
+}
+
+TEST(LatencyHistogram, ReportsPercentiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.Summarize().p99, 0);
+  for (int64_t micros = 1; micros <= 10000; micros++) {
+    histogram.Record(micros);
+  }
+  LatencySummary summary = histogram.Summarize();
+  EXPECT_EQ(summary.count, 10000u);
+  EXPECT_EQ(summary.max, 10000);
+  // Within the histogram's 1/32 resolution, and never below the value.
+  EXPECT_GE(summary.p50, 5000);
+  EXPECT_LE(summary.p50, 5000 + 5000 / 32);
+  EXPECT_GE(summary.p99, 9900);
+  EXPECT_LE(summary.p99, 9900 + 9900 / 32);
+  EXPECT_EQ(summary.p999, 10000);
+  EXPECT_EQ(histogram.ValueAtPercentile(0), 1);
+
+  histogram.Record(-5);
+  histogram.Record(int64_t{1} << 40);
+  EXPECT_EQ(histogram.ValueAtPercentile(0), 0);
+  EXPECT_EQ(histogram.Summarize().max, LatencyHistogram::kMaxValue);
+}
+
+TEST(VerifyResponseParser, ParsesChunkedBody) {
+  const std::string body =
+      R"({"status":true,"message":"Verification successful","data":{)"
+      R"("id":4099260516,"log":{"time_spent":9,"history":[{"type":"action",)"
+      R"("message":"Attempted to pay with card","time":7}]},)"
+      R"("reference":"ref_\u00e9","status":"abandoned","amount":20000,)"
+      R"("authorization":{"reference":"not_this_one","amount":1},)"
+      R"("currency":"GHS","gateway_response":"The transaction was not completed"}})";
+  // Bodies arrive in arbitrary pieces; split this one everywhere.
+  for (size_t chunk = 1; chunk <= body.size(); chunk++) {
+    VerifyResponseParser parser;
+    for (size_t offset = 0; offset < body.size(); offset += chunk) {
+      ASSERT_TRUE(parser.Feed(body.data() + offset,
+                              std::min(chunk, body.size() - offset)));
+    }
+    VerifyResult result = parser.Finish(HttpResponse());
+    ASSERT_TRUE(result.ok()) << result.error_code;
+    EXPECT_EQ(result.reference, "ref_\xc3\xa9");
+    EXPECT_EQ(result.status, "abandoned");
+    EXPECT_EQ(result.amount, 20000);
+    EXPECT_EQ(result.currency, "GHS");
+    EXPECT_EQ(result.gateway_response, "The transaction was not completed");
+  }
+}
+
+TEST(VerifyResponseParser, RejectsInvalidBodies) {
+  const char* bodies[] = {
+      R"({"status":true,"data":{"reference":"ref_123"}})",
+      R"({"status":"true","data":{}})",
+      R"({"status":false})",
+      R"({"status":true,"data":{"reference":"ref_123",)",
+      R"(<html>Bad gateway</html>)",
+  };
+  for (const char* body : bodies) {
+    VerifyResponseParser parser;
+    parser.Feed(body, strlen(body));
+    EXPECT_EQ(parser.Finish(HttpResponse()).error_code, "PARSE_ERROR") << body;
+  }
+}
+
+TEST(CheckoutResponseParser, ParsesBody) {
+  const std::string body =
+      R"({"status":true,"message":"Authorization URL created","data":{)"
+      R"("authorization_url":"https://checkout.paystack.com/0peioxfhpn",)"
+      R"("access_code":"0peioxfhpn","reference":"7PVGX8MEk85tgeEpVDtD"}})";
+  CheckoutResponseParser parser;
+  ASSERT_TRUE(parser.Feed(body.data(), body.size()));
+  CheckoutResult result = parser.Finish(HttpResponse());
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(result.authorization_url,
+            "https://checkout.paystack.com/0peioxfhpn");
+  EXPECT_EQ(result.reference, "7PVGX8MEk85tgeEpVDtD");
+}
+
+TEST(InitializeBody, WritesMembersInKeyOrder) {
+  CheckoutRequest minimal;
+  minimal.amount = -1;
+  minimal.email = "a@b.co";
+  minimal.currency = "NGN";
+  EXPECT_EQ(build_initialize_body(minimal),
+            R"({"amount":-1,"currency":"NGN","email":"a@b.co"})");
+
+  // The same bytes nlohmann::json dumps for these members.
+  CheckoutRequest full;
+  full.amount = 250000;
+  full.email = "q\"uote\\back\x1f\n\xc3\xa9\xe2\x82\xac@b.co";
+  full.currency = "GHS";
+  full.has_reference = true;
+  full.reference = "ref\t1";
+  full.has_callback_url = true;
+  full.callback_url = "https://example.com/cb?a=1&b=</script>";
+  full.has_metadata = true;
+  full.metadata_json = R"({"cart":[{"id":1,"name":"Tea"}],"note":"x"})";
+  EXPECT_EQ(build_initialize_body(full),
+            R"({"amount":250000,"callback_url":"https://example.com/cb?a=1&b=</script>",)"
+            R"("currency":"GHS","email":"q\"uote\\back\u001f\n)"
+            "\xc3\xa9\xe2\x82\xac"
+            R"(@b.co","metadata":{"cart":[{"id":1,"name":"Tea"}],"note":"x"},)"
+            R"("reference":"ref\t1"})");
+}
+
+TEST(VerifyCache, KeepsTerminalResults) {
+  VerifyCache cache;
+  VerifyCache::Clock::time_point now = VerifyCache::Clock::now();
+  VerifyResult result;
+  result.reference = "ref_done";
+  result.status = "success";
+  cache.Put("ref_done", result, now);
+
+  VerifyResult cached;
+  EXPECT_TRUE(cache.Get("ref_done", &cached, now + std::chrono::hours(24)));
+  EXPECT_EQ(cached.status, "success");
+  EXPECT_FALSE(cache.Get("ref_other", &cached, now));
+
+  VerifyCache::Stats stats = cache.stats();
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.size, 1u);
+}
+
+TEST(VerifyCache, ExpiresPendingResults) {
+  VerifyCache cache(8, std::chrono::seconds(5));
+  VerifyCache::Clock::time_point now = VerifyCache::Clock::now();
+  VerifyResult result;
+  result.status = "ongoing";
+  cache.Put("ref_pending", result, now);
+  // The customer may still pay an abandoned transaction.
+  result.status = "abandoned";
+  cache.Put("ref_abandoned", result, now);
+
+  VerifyResult cached;
+  EXPECT_TRUE(cache.Get("ref_pending", &cached, now + std::chrono::seconds(4)));
+  EXPECT_TRUE(
+      cache.Get("ref_abandoned", &cached, now + std::chrono::seconds(4)));
+  EXPECT_FALSE(
+      cache.Get("ref_pending", &cached, now + std::chrono::seconds(5)));
+  EXPECT_FALSE(
+      cache.Get("ref_abandoned", &cached, now + std::chrono::seconds(5)));
+  EXPECT_EQ(cache.stats().size, 0u);
+}
+
+TEST(VerifyCache, EvictsLeastRecentlyUsed) {
+  VerifyCache cache(2);
+  VerifyResult result;
+  result.status = "failed";
+  cache.Put("ref_a", result);
+  cache.Put("ref_b", result);
+  VerifyResult cached;
+  ASSERT_TRUE(cache.Get("ref_a", &cached));
+  cache.Put("ref_c", result);
+
+  EXPECT_TRUE(cache.Get("ref_a", &cached));
+  EXPECT_FALSE(cache.Get("ref_b", &cached));
+  EXPECT_TRUE(cache.Get("ref_c", &cached));
+}
+
+TEST(VerifyCache, IgnoresErrorsAndInvalidates) {
+  VerifyCache cache;
+  VerifyResult error;
+  error.error_code = "HTTP_ERROR";
+  cache.Put("ref_error", error);
+  EXPECT_EQ(cache.stats().size, 0u);
+
+  VerifyResult result;
+  result.status = "abandoned";
+  cache.Put("ref_a", result);
+  cache.Put("ref_b", result);
+  cache.Invalidate("ref_a");
+  VerifyResult cached;
+  EXPECT_FALSE(cache.Get("ref_a", &cached));
+  EXPECT_TRUE(cache.Get("ref_b", &cached));
+  cache.Clear();
+  EXPECT_EQ(cache.stats().size, 0u);
+}
+
+TEST(CallbackRequest, ReadsTheReference) {
+  std::string reference;
+  auto read = [&reference](const std::string& request) {
+    reference.clear();
+    return read_callback_reference(request.data(), request.size(),
+                                   "/paystack/callback", &reference);
+  };
+  EXPECT_TRUE(read("GET /paystack/callback?trxref=T1&reference=T2 HTTP/1.1"
+                   "\r\nHost: 127.0.0.1\r\n\r\n"));
+  EXPECT_EQ(reference, "T2");
+  EXPECT_TRUE(read("GET /paystack/callback?trxref=a%2Fb+c HTTP/1.1\r\n"));
+  EXPECT_EQ(reference, "a/b c");
+
+  EXPECT_FALSE(read("POST /paystack/callback?reference=T1 HTTP/1.1\r\n"));
+  EXPECT_FALSE(read("GET /paystack/callbacks?reference=T1 HTTP/1.1\r\n"));
+  EXPECT_FALSE(read("GET /paystack/callback HTTP/1.1\r\n"));
+  EXPECT_FALSE(read("GET /paystack/callback?reference= HTTP/1.1\r\n"));
+  EXPECT_FALSE(read("GET /paystack/callback?reference=%2 HTTP/1.1\r\n"));
+  EXPECT_FALSE(read("GET /favicon.ico HTTP/1.1\r\n"));
+}
+
+TEST(CallbackRequest, ReadsTheReferenceOfALoopbackUrl) {
+  std::string reference;
+  EXPECT_TRUE(read_callback_url(
+      "http://127.0.0.1:40123/paystack/callback?trxref=T1&reference=T1#done",
+      "/paystack/callback", &reference));
+  EXPECT_EQ(reference, "T1");
+
+  EXPECT_FALSE(read_callback_url("http://127.0.0.1/paystack/callback?trxref=T1",
+                                 "/paystack/callback", &reference));
+  EXPECT_FALSE(read_callback_url(
+      "https://example.com:8443/paystack/callback?trxref=T1",
+      "/paystack/callback", &reference));
+  EXPECT_FALSE(read_callback_url("http://127.0.0.1:40123/paystack/callback",
+                                 "/paystack/callback", &reference));
+}
+
+TEST(SingleFlight, CoalescesConcurrentRequests) {
+  SingleFlight<int> in_flight;
+  std::vector<int> results;
+  auto collect = [&results](const int& result) { results.push_back(result); };
+
+  EXPECT_TRUE(in_flight.Join("ref_a", collect));
+  EXPECT_FALSE(in_flight.Join("ref_a", collect));
+  EXPECT_TRUE(in_flight.Join("ref_b", collect));
+  EXPECT_EQ(in_flight.size(), 2u);
+
+  in_flight.Complete("ref_a", 1);
+  EXPECT_EQ(results, std::vector<int>({1, 1}));
+  EXPECT_EQ(in_flight.size(), 1u);
+
+  // Once completed, the next request for the key starts a new one.
+  EXPECT_TRUE(in_flight.Join("ref_a", collect));
+}
+
+TEST(PaystackClient, NormalizesBaseUrls) {
+  std::string url = "http://127.0.0.1:8089/";
+  EXPECT_TRUE(normalize_base_url(&url));
+  EXPECT_EQ(url, "http://127.0.0.1:8089");
+  url = "https://api.paystack.co";
+  EXPECT_TRUE(normalize_base_url(&url));
+  EXPECT_EQ(url, "https://api.paystack.co");
+
+  for (std::string invalid : {"", "api.paystack.co", "ftp://host", "https://"}) {
+    EXPECT_FALSE(normalize_base_url(&invalid)) << invalid;
+  }
+}
+
+TEST(PaystackClient, InitializesTransactions) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  CheckoutRequest request;
+  request.amount = 50000;
+  request.email = "a@b.co";
+  request.currency = "NGN";
+  CheckoutResult result;
+  client.InitializeTransaction(request, TestApi(),
+                               [&result](const CheckoutResult& checkout) {
+                                 result = checkout;
+                               });
+
+  ASSERT_EQ(transport.pending.size(), 1u);
+  const HttpRequest& sent = transport.pending[0].request;
+  EXPECT_EQ(sent.method, HttpMethod::kPost);
+  EXPECT_EQ(sent.url, "https://api.paystack.co/transaction/initialize");
+  EXPECT_EQ(sent.public_key, "pk_test");
+  EXPECT_EQ(sent.body, build_initialize_body(request));
+
+  transport.Respond(
+      0, R"({"status":true,"message":"ok","data":{)"
+         R"("authorization_url":"https://checkout.paystack.com/x",)"
+         R"("reference":"ref_1"}})");
+  ASSERT_TRUE(result.ok()) << result.error_code;
+  EXPECT_EQ(result.authorization_url, "https://checkout.paystack.com/x");
+  EXPECT_EQ(result.reference, "ref_1");
+}
+
+TEST(PaystackClient, CoalescesAndCachesVerifications) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  std::vector<VerifyResult> results;
+  auto collect = [&results](const VerifyResult& result) {
+    results.push_back(result);
+  };
+  ApiConfig api = TestApi();
+  api.base_url = "http://127.0.0.1:8089";
+  client.VerifyTransaction("ref_1", api, collect);
+  client.VerifyTransaction("ref_1", api, collect);
+
+  ASSERT_EQ(transport.pending.size(), 1u);
+  EXPECT_EQ(transport.pending[0].request.method, HttpMethod::kGet);
+  EXPECT_EQ(transport.pending[0].request.url,
+            "http://127.0.0.1:8089/transaction/verify/ref_1");
+  transport.Respond(0, VerifyBody("ref_1"));
+
+  ASSERT_EQ(results.size(), 2u);
+  EXPECT_EQ(results[0].status, "success");
+  EXPECT_EQ(results[1].reference, "ref_1");
+  VerifyResult cached;
+  EXPECT_TRUE(client.verify_cache().Get("ref_1", &cached));
+  EXPECT_EQ(cached.channel, "card");
+}
+
+TEST(PaystackClient, ReportsTransportFailures) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  VerifyResult result;
+  client.VerifyTransaction("ref_1", TestApi(),
+                           [&result](const VerifyResult& verify_result) {
+                             result = verify_result;
+                           });
+  // Retried twice, each after a jittered backoff, before it fails.
+  for (int attempt = 0; attempt < 3; attempt++) {
+    ASSERT_EQ(transport.pending.size(), 1u);
+    transport.Fail(0, "Couldn't connect to server");
+    if (attempt < 2) {
+      EXPECT_TRUE(result.error_code.empty());
+      ASSERT_EQ(transport.timers.size(), 1u);
+      EXPECT_GE(transport.timers[0].delay_ms, 100);
+      EXPECT_LE(transport.timers[0].delay_ms, 2000);
+      transport.Fire();
+    }
+  }
+  EXPECT_TRUE(transport.timers.empty());
+  EXPECT_EQ(result.error_code, "HTTP_ERROR");
+  EXPECT_EQ(client.verify_cache().stats().size, 0u);
+  EndpointMetrics& verify = client.metrics().endpoint(Endpoint::kVerify);
+  EXPECT_EQ(verify.requests, 3u);
+  EXPECT_EQ(verify.retries, 2u);
+}
+
+TEST(PaystackClient, RetriesOnlySafeCallsAndServerErrors) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  int completed = 0;
+  auto count = [&completed](const CheckoutResult&) { completed++; };
+
+  // Paystack generates the reference, so a second attempt could start a
+  // second transaction.
+  client.InitializeTransaction(TestCheckout(), TestApi(), count);
+  transport.Respond(0, R"({"status":false,"message":"Unavailable"})", 503);
+  EXPECT_EQ(completed, 1);
+  EXPECT_TRUE(transport.timers.empty());
+
+  CheckoutRequest with_reference = TestCheckout();
+  with_reference.has_reference = true;
+  with_reference.reference = "ref_1";
+  client.InitializeTransaction(with_reference, TestApi(), count);
+  transport.Respond(0, R"({"status":false,"message":"Unavailable"})", 503);
+  ASSERT_EQ(transport.timers.size(), 1u);
+  transport.Fire();
+  ASSERT_EQ(transport.pending.size(), 1u);
+  EXPECT_EQ(transport.pending[0].request.body,
+            build_initialize_body(with_reference));
+  // Client errors are final.
+  transport.Respond(0, R"({"status":false,"message":"Duplicate"})", 400);
+  EXPECT_EQ(completed, 2);
+  EXPECT_TRUE(transport.timers.empty());
+  EXPECT_EQ(client.metrics().endpoint(Endpoint::kInitialize).retries, 1u);
+}
+
+TEST(PaystackClient, SpendsTheRetryBudget) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  RetryPolicy policy;
+  policy.budget_ratio = 0.5;
+  policy.budget_reserve = 2;
+  client.set_retry_policy(policy);
+  VerifyResult result;
+  auto keep = [&result](const VerifyResult& verified) { result = verified; };
+
+  client.VerifyTransaction("ref_1", TestApi(), keep);
+  transport.Fail(0, "Couldn't connect to server");
+  transport.Fire();
+  transport.Fail(0, "Couldn't connect to server");
+  transport.Fire();
+  transport.Fail(0, "Couldn't connect to server");
+  EXPECT_EQ(result.error_code, "HTTP_ERROR");
+  EndpointMetrics& verify = client.metrics().endpoint(Endpoint::kVerify);
+  EXPECT_EQ(verify.retries, 2u);
+  EXPECT_EQ(verify.throttled_retries, 0u);
+
+  // The reserve is spent, and the next call only deposits half a retry.
+  client.VerifyTransaction("ref_2", TestApi(), keep);
+  transport.Fail(0, "Couldn't connect to server");
+  EXPECT_TRUE(transport.timers.empty());
+  EXPECT_EQ(verify.throttled_retries, 1u);
+}
+
+TEST(PaystackClient, CancelledRetriesReportTheLastFailure) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  VerifyResult result;
+  client.VerifyTransaction(
+      "ref_1", TestApi(),
+      [&result](const VerifyResult& verified) { result = verified; });
+  transport.Respond(0, "<html>Bad gateway</html>", 502);
+  transport.Fire(true);
+  EXPECT_TRUE(transport.pending.empty());
+  EXPECT_EQ(result.error_code, "PARSE_ERROR");
+}
+
+TEST(RetryPolicy, JittersDelaysWithinBounds) {
+  RetryPolicy policy;
+  std::minstd_rand random(7);
+  int64_t previous = 0;
+  for (int i = 0; i < 100; i++) {
+    int64_t delay = decorrelated_jitter(policy, previous, &random);
+    EXPECT_GE(delay, policy.base_delay_ms);
+    EXPECT_LE(delay, std::min(policy.max_delay_ms,
+                              std::max(previous, policy.base_delay_ms) * 3));
+    previous = delay;
+  }
+}
+
+TEST(CircuitBreaker, OpensAndProbes) {
+  CircuitBreakerPolicy policy;
+  policy.failure_threshold = 2;
+  policy.open_duration = std::chrono::seconds(5);
+  CircuitBreaker breaker(policy);
+  CircuitBreaker::Clock::time_point now = CircuitBreaker::Clock::now();
+
+  ASSERT_TRUE(breaker.Allow(now));
+  breaker.OnFailure(now);
+  ASSERT_TRUE(breaker.Allow(now));
+  breaker.OnSuccess();
+  ASSERT_TRUE(breaker.Allow(now));
+  breaker.OnFailure(now);
+  ASSERT_TRUE(breaker.Allow(now));
+  breaker.OnFailure(now);
+  EXPECT_EQ(breaker.state(), CircuitBreaker::State::kOpen);
+  EXPECT_FALSE(breaker.Allow(now + std::chrono::seconds(4)));
+
+  // One probe at a time once the open period is over; a failed probe
+  // reopens the circuit.
+  now += std::chrono::seconds(5);
+  EXPECT_TRUE(breaker.Allow(now));
+  EXPECT_EQ(breaker.state(), CircuitBreaker::State::kHalfOpen);
+  EXPECT_FALSE(breaker.Allow(now));
+  breaker.OnFailure(now);
+  EXPECT_EQ(breaker.state(), CircuitBreaker::State::kOpen);
+  EXPECT_FALSE(breaker.Allow(now + std::chrono::seconds(1)));
+
+  now += std::chrono::seconds(5);
+  EXPECT_TRUE(breaker.Allow(now));
+  // A cancelled probe frees its slot.
+  breaker.OnCancelled();
+  EXPECT_TRUE(breaker.Allow(now));
+  breaker.OnSuccess();
+  EXPECT_EQ(breaker.state(), CircuitBreaker::State::kClosed);
+  EXPECT_TRUE(breaker.Allow(now));
+  EXPECT_EQ(breaker.rejected(), 3u);
+}
+
+TEST(ConcurrencyLimiter, IncreasesAdditivelyAndDecreasesMultiplicatively) {
+  ConcurrencyLimitPolicy policy;
+  policy.initial_limit = 2;
+  policy.min_limit = 1;
+  policy.backoff_ratio = 0.5;
+  ConcurrencyLimiter limiter(policy);
+  EXPECT_TRUE(limiter.TryAcquire());
+  EXPECT_TRUE(limiter.TryAcquire());
+  EXPECT_FALSE(limiter.TryAcquire());
+  // 2 + 1/2 + 1/2.5 is still below 3.
+  limiter.Release(false);
+  limiter.Release(false);
+  EXPECT_EQ(limiter.limit(), 2);
+  EXPECT_TRUE(limiter.TryAcquire());
+  limiter.Release(false);
+  EXPECT_EQ(limiter.limit(), 3);
+  EXPECT_TRUE(limiter.TryAcquire());
+  limiter.Release(true);
+  EXPECT_EQ(limiter.limit(), 1);
+  EXPECT_TRUE(limiter.TryAcquire());
+  limiter.Release(true);
+  EXPECT_EQ(limiter.limit(), 1);
+  EXPECT_EQ(limiter.in_flight(), 0);
+}
+
+TEST(PaystackClient, FailsFastWhileTheCircuitIsOpen) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  client.set_retry_policy(NoRetries());
+  CircuitBreakerPolicy policy;
+  policy.failure_threshold = 2;
+  client.set_circuit_breaker_policy(policy);
+  VerifyResult result;
+  auto keep = [&result](const VerifyResult& verified) { result = verified; };
+
+  client.VerifyTransaction("ref_1", TestApi(), keep);
+  transport.Respond(0, R"({"status":false,"message":"Unavailable"})", 503);
+  // Client errors do not count against the endpoint.
+  client.VerifyTransaction("ref_2", TestApi(), keep);
+  transport.Respond(0, R"({"status":false,"message":"Not found"})", 404);
+  client.VerifyTransaction("ref_3", TestApi(), keep);
+  transport.Fail(0, "Couldn't connect to server");
+  client.VerifyTransaction("ref_4", TestApi(), keep);
+  transport.Fail(0, "Couldn't connect to server");
+  EXPECT_EQ(client.circuit_breaker(Endpoint::kVerify).state(),
+            CircuitBreaker::State::kOpen);
+
+  client.VerifyTransaction("ref_5", TestApi(), keep);
+  EXPECT_TRUE(transport.pending.empty());
+  EXPECT_EQ(result.error_code, kCircuitOpenError);
+  // Each endpoint has its own circuit.
+  client.InitializeTransaction(TestCheckout(), TestApi(),
+                               [](const CheckoutResult&) {});
+  EXPECT_EQ(transport.pending.size(), 1u);
+}
+
+TEST(PaystackClient, QueuesBeyondTheConcurrencyLimit) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  client.set_retry_policy(NoRetries());
+  ConcurrencyLimitPolicy policy;
+  policy.initial_limit = 2;
+  policy.backoff_ratio = 0.5;
+  client.set_concurrency_limit_policy(policy);
+  std::vector<std::string> verified;
+  auto keep = [&verified](const VerifyResult& result) {
+    verified.push_back(result.reference);
+  };
+
+  for (int i = 0; i < 4; i++) {
+    client.VerifyTransaction("ref_" + std::to_string(i), TestApi(), keep);
+  }
+  ASSERT_EQ(transport.pending.size(), 2u);
+  EXPECT_EQ(client.queued(), 2u);
+  EXPECT_EQ(client.concurrency_limiter().in_flight(), 2);
+
+  // A request that fails with a server error halves the limit, so the queue
+  // waits for the other one.
+  transport.Respond(0, R"({"status":false,"message":"Unavailable"})", 503);
+  EXPECT_EQ(client.concurrency_limiter().limit(), 1);
+  EXPECT_EQ(transport.pending.size(), 1u);
+  // A success raises it back to 2, and the queue starts in order.
+  transport.Respond(0, VerifyBody("ref_1"));
+  EXPECT_EQ(client.concurrency_limiter().limit(), 2);
+  ASSERT_EQ(transport.pending.size(), 2u);
+  EXPECT_EQ(client.queued(), 0u);
+  EXPECT_EQ(transport.pending[0].request.url,
+            std::string(kDefaultBaseUrl) + "/transaction/verify/ref_2");
+  transport.Respond(0, VerifyBody("ref_2"));
+  transport.Respond(0, VerifyBody("ref_3"));
+  EXPECT_EQ(verified,
+            (std::vector<std::string>{"", "ref_1", "ref_2", "ref_3"}));
+}
+
+TEST(TokenBucket, RefillsAtItsRateUpToItsBurst) {
+  TokenBucket bucket(2, 3);
+  TokenBucket::Clock::time_point now = TokenBucket::Clock::now();
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(bucket.TryTake(now));
+  }
+  EXPECT_FALSE(bucket.TryTake(now));
+  EXPECT_EQ(bucket.TimeUntilAvailable(now), std::chrono::milliseconds(500));
+  now += std::chrono::milliseconds(500);
+  EXPECT_TRUE(bucket.TryTake(now));
+  EXPECT_FALSE(bucket.TryTake(now));
+  // A long quiet period refills no more than the burst.
+  now += std::chrono::seconds(10);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(bucket.TryTake(now));
+  }
+  EXPECT_FALSE(bucket.TryTake(now));
+
+  // Without a rate, only pauses hold requests back.
+  TokenBucket unlimited;
+  unlimited.PauseUntil(now + std::chrono::seconds(2));
+  EXPECT_FALSE(unlimited.TryTake(now));
+  EXPECT_EQ(unlimited.TimeUntilAvailable(now), std::chrono::seconds(2));
+  EXPECT_TRUE(unlimited.TryTake(now + std::chrono::seconds(2)));
+  EXPECT_TRUE(unlimited.TryTake(now + std::chrono::seconds(2)));
+}
+
+TEST(RateLimitHeaders, AreReadFromHeaderLines) {
+  RateLimitHeaders headers;
+  for (const char* line :
+       {"HTTP/1.1 429 Too Many Requests\r\n", "retry-after: 3\r\n",
+        "X-RateLimit-Remaining: 0\r\n", "X-RateLimit-Reset:  12 \r\n",
+        "X-RateLimit-Limit: 100\r\n", "\r\n"}) {
+    read_rate_limit_header(line, strlen(line), &headers);
+  }
+  EXPECT_EQ(headers.retry_after, 3);
+  EXPECT_EQ(headers.remaining, 0);
+  EXPECT_EQ(headers.reset, 12);
+
+  // Dates and other values that are not a number of seconds are ignored.
+  RateLimitHeaders dated;
+  const char* date = "Retry-After: Wed, 21 Oct 2026 07:28:00 GMT\r\n";
+  read_rate_limit_header(date, strlen(date), &dated);
+  EXPECT_EQ(dated.retry_after, -1);
+}
+
+RateLimitPolicy TestRateLimitPolicy() {
+  RateLimitPolicy policy;
+  policy.requests_per_second = 1;
+  policy.burst = 2;
+  return policy;
+}
+
+TEST(PaystackClient, QueuesBeyondTheRateLimit) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  client.set_rate_limit_policy(TestRateLimitPolicy());
+  for (int i = 0; i < 3; i++) {
+    client.VerifyTransaction("ref_" + std::to_string(i), TestApi(),
+                             [](const VerifyResult&) {});
+  }
+  EXPECT_EQ(transport.pending.size(), 2u);
+  EXPECT_EQ(client.rate_limited(Endpoint::kVerify), 1u);
+  ASSERT_EQ(transport.timers.size(), 1u);
+  EXPECT_GT(transport.timers[0].delay_ms, 0);
+  EXPECT_LE(transport.timers[0].delay_ms, 1000);
+  // Each endpoint has its own bucket.
+  client.InitializeTransaction(TestCheckout(), TestApi(),
+                               [](const CheckoutResult&) {});
+  EXPECT_EQ(transport.pending.size(), 3u);
+
+  // Waiting calls give up once the transport goes away.
+  VerifyResult result;
+  client.VerifyTransaction("ref_3", TestApi(),
+                           [&result](const VerifyResult& verified) {
+                             result = verified;
+                           });
+  EXPECT_EQ(client.rate_limited(Endpoint::kVerify), 2u);
+  transport.Fire(true);
+  EXPECT_EQ(client.rate_limited(Endpoint::kVerify), 0u);
+  EXPECT_EQ(result.error_code, kRateLimitedError);
+}
+
+TEST(PaystackClient, SendsAgainAfterA429) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  // Even without retries, and for checkouts that are not safe to repeat:
+  // Paystack did not act on the request.
+  client.set_retry_policy(NoRetries());
+  RateLimitPolicy policy;
+  policy.default_retry_after = std::chrono::milliseconds(5);
+  client.set_rate_limit_policy(policy);
+  CheckoutResult result;
+  client.InitializeTransaction(TestCheckout(), TestApi(),
+                               [&result](const CheckoutResult& checkout) {
+                                 result = checkout;
+                               });
+  ASSERT_EQ(transport.pending.size(), 1u);
+  const HttpRequest first = transport.pending[0].request;
+  EXPECT_FALSE(first.body.empty());
+  transport.Respond(0, R"({"status":false,"message":"Slow down"})", 429);
+  EXPECT_TRUE(transport.pending.empty());
+  ASSERT_EQ(transport.timers.size(), 1u);
+  EXPECT_LE(transport.timers[0].delay_ms, 5);
+  EXPECT_EQ(client.metrics()
+                .endpoint(Endpoint::kInitialize)
+                .rate_limited.load(std::memory_order_relaxed),
+            1u);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  transport.Fire();
+  ASSERT_EQ(transport.pending.size(), 1u);
+  // The same request goes out again.
+  const HttpRequest& resent = transport.pending[0].request;
+  EXPECT_EQ(resent.url, "https://api.paystack.co/transaction/initialize");
+  EXPECT_EQ(resent.public_key, first.public_key);
+  EXPECT_EQ(resent.body, first.body);
+  transport.Respond(
+      0, R"({"status":true,"message":"ok","data":{)"
+         R"("authorization_url":"https://checkout.paystack.com/x",)"
+         R"("reference":"ref_1"}})");
+  EXPECT_TRUE(result.ok()) << result.error_code;
+}
+
+TEST(PaystackClient, FailsThrottledCallsAtOnceWithoutAWait) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  // As the Windows plugin configures it, having no timers.
+  client.set_retry_policy(NoRetries());
+  RateLimitPolicy policy;
+  policy.max_wait = std::chrono::milliseconds(0);
+  client.set_rate_limit_policy(policy);
+  VerifyResult result;
+  client.VerifyTransaction("ref_1", TestApi(),
+                           [&result](const VerifyResult& verified) {
+                             result = verified;
+                           });
+  transport.Respond(0, R"({"status":false,"message":"Slow down"})", 429);
+  EXPECT_EQ(result.error_code, kRateLimitedError);
+  EXPECT_TRUE(transport.pending.empty());
+  EXPECT_TRUE(transport.timers.empty());
+}
+
+TEST(PaystackClient, FailsCallsThatWaitTooLongForTheRateLimit) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  RateLimitPolicy policy;
+  policy.max_wait = std::chrono::milliseconds(50);
+  client.set_rate_limit_policy(policy);
+  // Paystack says no request is left until its window resets in a minute.
+  transport.rate_limit.remaining = 0;
+  transport.rate_limit.reset = 60;
+  client.VerifyTransaction("ref_1", TestApi(), [](const VerifyResult&) {});
+  transport.Respond(0, VerifyBody("ref_1"));
+
+  VerifyResult result;
+  client.VerifyTransaction("ref_2", TestApi(),
+                           [&result](const VerifyResult& verified) {
+                             result = verified;
+                           });
+  EXPECT_TRUE(transport.pending.empty());
+  ASSERT_EQ(transport.timers.size(), 1u);
+  EXPECT_LE(transport.timers[0].delay_ms, 50);
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  transport.Fire();
+  EXPECT_TRUE(transport.pending.empty());
+  EXPECT_EQ(result.error_code, kRateLimitedError);
+  EXPECT_EQ(client.rate_limit_expired(Endpoint::kVerify), 1u);
+}
+
+TEST(PaystackClient, CancelsCallsInFlight) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  int answers = 0;
+  VerifyResult result;
+  auto keep = [&answers, &result](const VerifyResult& verified) {
+    answers++;
+    result = verified;
+  };
+  client.VerifyTransaction("ref_1", TestApi(), keep);
+  ASSERT_EQ(transport.pending.size(), 1u);
+  EXPECT_EQ(transport.pending[0].request.connect_timeout_ms, 10000);
+  EXPECT_EQ(transport.pending[0].request.timeout_ms, 30000);
+  EXPECT_EQ(client.pending_calls(), 1u);
+
+  EXPECT_TRUE(client.Cancel("ref_1"));
+  EXPECT_EQ(transport.cancelled, std::vector<RequestId>{1});
+  EXPECT_TRUE(transport.pending.empty());
+  EXPECT_EQ(answers, 1);
+  EXPECT_EQ(result.error_code, kCancelledError);
+  EXPECT_EQ(client.pending_calls(), 0u);
+  EXPECT_EQ(client.concurrency_limiter().in_flight(), 0);
+  EXPECT_FALSE(client.Cancel("ref_1"));
+  EXPECT_FALSE(client.Cancel(""));
+}
+
+TEST(PaystackClient, CancelsQueuedCallsAndRetries) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  ConcurrencyLimitPolicy policy;
+  policy.initial_limit = 1;
+  client.set_concurrency_limit_policy(policy);
+  std::vector<std::string> answers;
+  auto keep = [&answers](const VerifyResult& result) {
+    answers.push_back(result.reference + ":" + result.error_code);
+  };
+  client.VerifyTransaction("ref_1", TestApi(), keep);
+  client.VerifyTransaction("ref_2", TestApi(), keep);
+  ASSERT_EQ(client.queued(), 1u);
+
+  // The queued request never starts.
+  EXPECT_TRUE(client.Cancel("ref_2"));
+  EXPECT_EQ(answers, std::vector<std::string>{":CANCELLED"});
+  // Nor does the retry of a failed one.
+  transport.Fail(0, "Couldn't connect to server");
+  ASSERT_EQ(transport.timers.size(), 1u);
+  EXPECT_TRUE(transport.pending.empty());
+  EXPECT_TRUE(client.Cancel("ref_1"));
+  transport.Fire();
+  EXPECT_TRUE(transport.pending.empty());
+  EXPECT_EQ(answers, (std::vector<std::string>{":CANCELLED", ":CANCELLED"}));
+  EXPECT_EQ(client.pending_calls(), 0u);
+}
+
+// Times |count| verifications at |total_micros| each.
+void WarmUpVerifications(FakeTransport* transport, PaystackClient* client,
+                         int count, int64_t total_micros) {
+  transport->timings.total = total_micros;
+  for (int i = 0; i < count; i++) {
+    std::string reference = "ref_warm_" + std::to_string(i);
+    client->VerifyTransaction(reference, TestApi(), [](const VerifyResult&) {});
+    EXPECT_TRUE(transport->timers.empty());
+    transport->Respond(0, VerifyBody(reference));
+  }
+}
+
+HedgePolicy TestHedgePolicy() {
+  HedgePolicy policy;
+  policy.percentile = 90;
+  policy.min_samples = 3;
+  return policy;
+}
+
+TEST(PaystackClient, HedgesSlowVerifications) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  client.set_hedge_policy(TestHedgePolicy());
+  // Not hedged until there are enough latencies to go by.
+  WarmUpVerifications(&transport, &client, 3, 50000);
+
+  VerifyResult result;
+  client.VerifyTransaction(
+      "ref_1", TestApi(),
+      [&result](const VerifyResult& verified) { result = verified; });
+  ASSERT_EQ(transport.timers.size(), 1u);
+  EXPECT_GE(transport.timers[0].delay_ms, 50);
+  EXPECT_LT(transport.timers[0].delay_ms, 100);
+  transport.Fire();
+  ASSERT_EQ(transport.pending.size(), 2u);
+  EXPECT_FALSE(transport.pending[0].request.fresh_connection);
+  EXPECT_TRUE(transport.pending[1].request.fresh_connection);
+  EXPECT_EQ(transport.pending[1].request.url, transport.pending[0].request.url);
+
+  // The hedge answers first, and the original request is cancelled.
+  RequestId original = transport.pending[0].id;
+  transport.Respond(1, VerifyBody("ref_1"));
+  EXPECT_EQ(result.reference, "ref_1");
+  EXPECT_TRUE(result.error_code.empty());
+  EXPECT_TRUE(transport.pending.empty());
+  EXPECT_EQ(transport.cancelled, std::vector<RequestId>{original});
+  EndpointMetrics& verify = client.metrics().endpoint(Endpoint::kVerify);
+  EXPECT_EQ(verify.hedges, 1u);
+  EXPECT_EQ(verify.hedges_won, 1u);
+  EXPECT_EQ(verify.requests, 4u);
+}
+
+TEST(PaystackClient, CapsHedges) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  HedgePolicy policy = TestHedgePolicy();
+  policy.budget_ratio = 0;
+  policy.budget_reserve = 1;
+  client.set_hedge_policy(policy);
+  WarmUpVerifications(&transport, &client, 3, 50000);
+  int completed = 0;
+  auto count = [&completed](const VerifyResult&) { completed++; };
+
+  // Answered in time.
+  client.VerifyTransaction("ref_1", TestApi(), count);
+  transport.Respond(0, VerifyBody("ref_1"));
+  transport.Fire();
+  EXPECT_TRUE(transport.pending.empty());
+
+  // A transient failure of either exchange leaves the call to the other.
+  client.VerifyTransaction("ref_2", TestApi(), count);
+  transport.Fire();
+  ASSERT_EQ(transport.pending.size(), 2u);
+  transport.Fail(1, "Couldn't connect to server");
+  EXPECT_EQ(completed, 1);
+  transport.Respond(0, VerifyBody("ref_2"));
+  EXPECT_EQ(completed, 2);
+  EXPECT_TRUE(transport.timers.empty());
+
+  // The budget allows one hedge.
+  client.VerifyTransaction("ref_3", TestApi(), count);
+  transport.Fire();
+  EXPECT_EQ(transport.pending.size(), 1u);
+  transport.Respond(0, VerifyBody("ref_3"));
+  EXPECT_EQ(completed, 3);
+  EndpointMetrics& verify = client.metrics().endpoint(Endpoint::kVerify);
+  EXPECT_EQ(verify.hedges, 1u);
+  EXPECT_EQ(verify.hedges_won, 0u);
+  EXPECT_EQ(verify.retries, 0u);
+}
+
+TEST(PaystackClient, RecordsMetrics) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  client.set_retry_policy(NoRetries());
+  client.VerifyTransaction("ref_1", TestApi(), [](const VerifyResult&) {});
+  transport.timings = {2000, 5000, 30000, 80000, 90000};
+  transport.connections_opened = 1;
+  transport.Respond(0, VerifyBody("ref_1"));
+  client.VerifyTransaction("ref_2", TestApi(), [](const VerifyResult&) {});
+  transport.timings = {0, 0, 0, 40000, 41000};
+  transport.connections_opened = 0;
+  transport.Respond(0, R"({"status":false,"message":"Not found"})");
+  client.VerifyTransaction("ref_3", TestApi(), [](const VerifyResult&) {});
+  transport.Fail(0, "Couldn't connect to server");
+
+  EndpointMetrics& verify = client.metrics().endpoint(Endpoint::kVerify);
+  EXPECT_EQ(verify.requests, 3u);
+  EXPECT_EQ(verify.errors[0], 1u);  // HTTP_ERROR
+  EXPECT_EQ(verify.errors[1], 1u);  // API_ERROR
+  EXPECT_EQ(verify.errors[2], 0u);  // PARSE_ERROR
+  // Only the first exchange opened a connection.
+  EXPECT_EQ(verify.phase(Phase::kDns).Summarize().count, 1u);
+  EXPECT_EQ(verify.phase(Phase::kTls).Summarize().max, 30000);
+  LatencySummary total = verify.phase(Phase::kTotal).Summarize();
+  EXPECT_EQ(total.count, 2u);
+  EXPECT_EQ(total.max, 90000);
+  EXPECT_EQ(verify.phase(Phase::kParse).Summarize().count, 3u);
+  EXPECT_EQ(client.metrics().endpoint(Endpoint::kInitialize).requests, 0u);
+}
+
+TEST(PaystackClient, VerifiesBatchesThatCompleteSynchronously) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  client.set_retry_policy(NoRetries());
+  RateLimitPolicy policy;
+  policy.max_wait = std::chrono::milliseconds(0);
+  client.set_rate_limit_policy(policy);
+  // Every later verification is throttled inside VerifyTransaction.
+  transport.rate_limit.remaining = 0;
+  transport.rate_limit.reset = 60;
+  client.VerifyTransaction("ref_x", TestApi(), [](const VerifyResult&) {});
+  transport.Respond(0, VerifyBody("ref_x"));
+
+  std::vector<std::string> references;
+  for (int i = 0; i < 100000; i++) {
+    references.push_back("ref_" + std::to_string(i));
+  }
+  std::vector<VerifyResult> results;
+  client.VerifyTransactions(
+      references, 4, TestApi(),
+      [&results](const std::vector<VerifyResult>& batch_results) {
+        results = batch_results;
+      });
+  ASSERT_EQ(results.size(), references.size());
+  EXPECT_EQ(results.back().error_code, kRateLimitedError);
+  EXPECT_TRUE(transport.pending.empty());
+}
+
+TEST(PaystackClient, VerifiesBatchesInOrder) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  client.set_retry_policy(NoRetries());
+  std::vector<VerifyResult> results;
+  bool done = false;
+  client.VerifyTransactions(
+      {"ref_0", "ref_1", "ref_2", "ref_3"}, 2, TestApi(),
+      [&](const std::vector<VerifyResult>& batch_results) {
+        results = batch_results;
+        done = true;
+      });
+
+  // No more than |max_concurrency| requests at a time, answered in any order.
+  ASSERT_EQ(transport.pending.size(), 2u);
+  transport.Respond(1, VerifyBody("ref_1"));
+  ASSERT_EQ(transport.pending.size(), 2u);
+  transport.Fail(0, "Timeout was reached");
+  transport.Respond(1, VerifyBody("ref_3"));
+  ASSERT_EQ(transport.pending.size(), 1u);
+  EXPECT_FALSE(done);
+  transport.Respond(0, VerifyBody("ref_2"));
+
+  ASSERT_TRUE(done);
+  ASSERT_EQ(results.size(), 4u);
+  EXPECT_EQ(results[0].error_code, "HTTP_ERROR");
+  EXPECT_EQ(results[1].reference, "ref_1");
+  EXPECT_EQ(results[2].reference, "ref_2");
+  EXPECT_EQ(results[3].reference, "ref_3");
+}
+
+TEST(PaymentPoller, BacksOffAndReportsChanges) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  client.set_retry_policy(NoRetries());
+  std::vector<PaymentStatusUpdate> updates;
+  PaymentPoller poller(&client, &transport,
+                       [&updates](const PaymentStatusUpdate& update) {
+                         updates.push_back(update);
+                       });
+  PollPolicy policy;
+  policy.initial_interval_ms = 1000;
+  policy.max_interval_ms = 2000;
+  policy.backoff = 1.5;
+  poller.Watch("ref_1", TestApi(), policy);
+  ASSERT_EQ(transport.timers.size(), 1u);
+  EXPECT_EQ(transport.timers[0].delay_ms, 0);
+  transport.Fire();
+  ASSERT_EQ(transport.pending.size(), 1u);
+  transport.Respond(0, VerifyBody("ref_1", "abandoned"));
+  ASSERT_EQ(updates.size(), 1u);
+  EXPECT_EQ(updates[0].reference, "ref_1");
+  EXPECT_EQ(updates[0].status, "abandoned");
+  EXPECT_FALSE(updates[0].final);
+
+  // An unchanged status and a failed verification are not reported, and
+  // each delay is longer than the last, up to the maximum.
+  ASSERT_EQ(transport.timers.size(), 1u);
+  EXPECT_NEAR(transport.timers[0].delay_ms, 1000, 10);
+  transport.Fire();
+  transport.Respond(0, VerifyBody("ref_1", "abandoned"));
+  ASSERT_EQ(transport.timers.size(), 1u);
+  EXPECT_NEAR(transport.timers[0].delay_ms, 1500, 10);
+  transport.Fire();
+  transport.Fail(0, "Timeout was reached");
+  ASSERT_EQ(transport.timers.size(), 1u);
+  EXPECT_NEAR(transport.timers[0].delay_ms, 2000, 10);
+  EXPECT_EQ(updates.size(), 1u);
+
+  transport.Fire();
+  transport.Respond(0, VerifyBody("ref_1"));
+  ASSERT_EQ(updates.size(), 2u);
+  EXPECT_EQ(updates[1].status, "success");
+  EXPECT_TRUE(updates[1].final);
+  EXPECT_FALSE(updates[1].timed_out);
+  EXPECT_EQ(poller.watched(), 0u);
+  EXPECT_TRUE(transport.timers.empty());
+}
+
+TEST(PaymentPoller, SharesOneTimerAndStopsOnUnwatch) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  std::vector<PaymentStatusUpdate> updates;
+  PaymentPoller poller(&client, &transport,
+                       [&updates](const PaymentStatusUpdate& update) {
+                         updates.push_back(update);
+                       });
+  poller.Watch("ref_1", TestApi());
+  poller.Watch("ref_2", TestApi());
+  EXPECT_EQ(poller.watched(), 2u);
+  ASSERT_EQ(transport.timers.size(), 1u);
+  transport.Fire();
+  ASSERT_EQ(transport.pending.size(), 2u);
+
+  // The result of an unwatched reference is dropped.
+  EXPECT_TRUE(poller.Unwatch("ref_2"));
+  EXPECT_FALSE(poller.Unwatch("ref_2"));
+  transport.Respond(1, VerifyBody("ref_2", "ongoing"));
+  transport.Respond(0, VerifyBody("ref_1", "ongoing"));
+  ASSERT_EQ(updates.size(), 1u);
+  EXPECT_EQ(updates[0].reference, "ref_1");
+  ASSERT_EQ(transport.timers.size(), 1u);
+
+  EXPECT_TRUE(poller.Unwatch("ref_1"));
+  transport.Fire();
+  EXPECT_TRUE(transport.pending.empty());
+  EXPECT_TRUE(transport.timers.empty());
+  EXPECT_EQ(updates.size(), 1u);
+}
+
+TEST(PaymentPoller, StopsAtTheDeadlineOrACachedFinalStatus) {
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  std::vector<PaymentStatusUpdate> updates;
+  PaymentPoller poller(&client, &transport,
+                       [&updates](const PaymentStatusUpdate& update) {
+                         updates.push_back(update);
+                       });
+  PollPolicy policy;
+  policy.timeout_ms = 0;
+  poller.Watch("ref_1", TestApi(), policy);
+  transport.Fire();
+  transport.Respond(0, VerifyBody("ref_1", "abandoned"));
+  ASSERT_EQ(updates.size(), 1u);
+  EXPECT_EQ(updates[0].status, "abandoned");
+  EXPECT_TRUE(updates[0].final);
+  EXPECT_TRUE(updates[0].timed_out);
+
+  client.VerifyTransaction("ref_2", TestApi(), [](const VerifyResult&) {});
+  transport.Respond(0, VerifyBody("ref_2"));
+  poller.Watch("ref_2", TestApi());
+  transport.Fire();
+  EXPECT_TRUE(transport.pending.empty());
+  ASSERT_EQ(updates.size(), 2u);
+  EXPECT_EQ(updates[1].status, "success");
+  EXPECT_TRUE(updates[1].final);
+  EXPECT_EQ(poller.watched(), 0u);
+  EXPECT_TRUE(transport.timers.empty());
+}
+
+TEST(Tracer, TracesExchanges) {
+  std::string path = testing::TempDir() + "paystack_trace_test.json";
+  Tracer tracer;
+  std::string error;
+  ASSERT_TRUE(tracer.Start(path, &error)) << error;
+  FakeTransport transport;
+  PaystackClient client(&transport);
+  client.set_tracer(&tracer);
+  client.VerifyTransaction("ref_1", TestApi(), [](const VerifyResult&) {});
+  transport.timings = {2000, 5000, 30000, 80000, 90000};
+  transport.connections_opened = 1;
+  transport.Respond(0, VerifyBody("ref_1"));
+  TraceArgs args;
+  args.method = "verifyTransaction";
+  tracer.Span("dispatch", Tracer::Now(), 12, args);
+  tracer.Stop();
+  // Nothing is recorded once stopped.
+  tracer.Span("dispatch", Tracer::Now(), 12, args);
+
+  std::ifstream file(path);
+  std::string trace((std::istreambuf_iterator<char>(file)),
+                    std::istreambuf_iterator<char>());
+  EXPECT_EQ(trace.compare(0, 2, "[\n"), 0);
+  EXPECT_EQ(trace.compare(trace.size() - 3, 3, "\n]\n"), 0);
+  for (const char* name : {"dns", "connect", "tls", "request", "response",
+                           "parse", "dispatch"}) {
+    EXPECT_NE(trace.find(std::string(R"({"name":")") + name + "\""),
+              std::string::npos)
+        << name;
+  }
+  EXPECT_NE(trace.find(R"("name":"tls","cat":"paystack","ph":"X",)"),
+            std::string::npos);
+  EXPECT_NE(trace.find(R"("args":{"reference":"ref_1"}})"), std::string::npos);
+  EXPECT_NE(trace.find(R"("args":{"method":"verifyTransaction"}})"),
+            std::string::npos);
+  auto count = [&trace](const char* name) {
+    size_t spans = 0;
+    for (size_t at = trace.find(name); at != std::string::npos;
+         at = trace.find(name, at + 1)) {
+      spans++;
+    }
+    return spans;
+  };
+  // One for each of the two pieces of the body, and one for Finish.
+  EXPECT_EQ(count(R"("name":"parse")"), 3u);
+  EXPECT_EQ(count(R"("name":"dispatch")"), 1u);
+  std::remove(path.c_str());
+}
+
+}  // namespace test
+}  // namespace all_paystack_payments
@@ -0,0 +1,367 @@
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "paystack_client.h"
+#include "paystack_mock_server.h"
+#include "paystack_rate_limiter.h"
+#include "paystack_transport.h"
+
+namespace all_paystack_payments {
+namespace test {
+
+namespace {
+
+// Sends |request| to the server on |port| and returns everything it writes
+// back before closing the connection. Empty if it closed it unanswered.
+std::string Exchange(int port, const std::string& request) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  timeval timeout = {5, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+  std::string response;
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) ==
+          0 &&
+      send(fd, request.data(), request.size(), 0) ==
+          static_cast<ssize_t>(request.size())) {
+    char buffer[4096];
+    ssize_t received;
+    while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+      response.append(buffer, static_cast<size_t>(received));
+    }
+  }
+  close(fd);
+  return response;
+}
+
+// Blocking transport over Exchange, one connection per request.
+class SocketTransport : public Transport {
+ public:
+  explicit SocketTransport(int port) : port_(port) {}
+
+  RequestId Send(HttpRequest request, HttpCallback callback,
+                 BodySink sink) override {
+    sent.push_back(request);
+    size_t path_start = request.url.find('/', strlen("http://"));
+    std::string raw =
+        std::string(request.method == HttpMethod::kPost ? "POST " : "GET ") +
+        request.url.substr(path_start) +
+        " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n"
+        "Authorization: Bearer " +
+        request.public_key + "\r\nContent-Length: " +
+        std::to_string(request.body.size()) + "\r\n\r\n" + request.body;
+    std::string reply = Exchange(port_, raw);
+    HttpResponse response;
+    size_t header_end = reply.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+      response.error = "Empty reply from server";
+    } else {
+      response.status_code = strtol(reply.c_str() + strlen("HTTP/1.1 "),
+                                     nullptr, 10);
+      for (size_t line = 0; line < header_end;) {
+        size_t line_end = reply.find("\r\n", line);
+        read_rate_limit_header(reply.data() + line, line_end - line,
+                               &response.rate_limit);
+        line = line_end + 2;
+      }
+      std::string body = reply.substr(header_end + 4);
+      if (sink) {
+        sink(body.data(), body.size());
+      } else {
+        response.body = body;
+      }
+    }
+    callback(response);
+    return 0;
+  }
+
+  void Cancel(RequestId) override {}
+
+  void RunAfter(int64_t delay_ms, DelayedTask task) override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    task(false);
+  }
+
+  std::vector<HttpRequest> sent;
+
+ private:
+  int port_;
+};
+
+// Answers every request with a fixed response.
+class FixedTransport : public Transport {
+ public:
+  RequestId Send(HttpRequest request, HttpCallback callback,
+                 BodySink) override {
+    sent.push_back(request);
+    HttpResponse response;
+    response.status_code = 200;
+    response.body = R"({"status":true,"message":"Verification successful",)"
+                    R"("data":{"reference":"ref_live","status":"abandoned",)"
+                    R"("amount":1000,"currency":"GHS"}})";
+    callback(response);
+    return 0;
+  }
+
+  void Cancel(RequestId) override {}
+
+  void RunAfter(int64_t delay_ms, DelayedTask task) override {
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    task(false);
+  }
+
+  std::vector<HttpRequest> sent;
+};
+
+std::string MakeTempDir() {
+  char path[] = "/tmp/paystack_mock_server_testXXXXXX";
+  return mkdtemp(path);
+}
+
+ApiConfig MockApi(const MockServer& server) {
+  ApiConfig api;
+  api.base_url = server.base_url();
+  api.public_key = "pk_test";
+  return api;
+}
+
+}  // namespace
+
+TEST(MockServer, ParsesLatencyDistributions) {
+  LatencyDistribution latency;
+  ASSERT_TRUE(parse_latency_distribution("lognormal:80,0.6", &latency));
+  EXPECT_EQ(latency.kind, LatencyDistribution::Kind::kLogNormal);
+  EXPECT_EQ(latency.first, 80);
+  EXPECT_EQ(latency.second, 0.6);
+  ASSERT_TRUE(parse_latency_distribution("uniform:5,20", &latency));
+  EXPECT_EQ(latency.kind, LatencyDistribution::Kind::kUniform);
+  ASSERT_TRUE(parse_latency_distribution("none", &latency));
+  EXPECT_EQ(latency.kind, LatencyDistribution::Kind::kNone);
+
+  for (const char* invalid : {"", "fixed", "fixed:-1", "uniform:20,5",
+                              "exponential:x", "lognormal:0,1", "normal:5"}) {
+    EXPECT_FALSE(parse_latency_distribution(invalid, &latency)) << invalid;
+  }
+}
+
+TEST(MockServer, ServesTheClient) {
+  MockServer server{MockServerOptions()};
+  std::string error;
+  ASSERT_TRUE(server.Start(&error)) << error;
+  SocketTransport transport(server.port());
+  PaystackClient client(&transport);
+
+  CheckoutRequest request;
+  request.amount = 50000;
+  request.email = "a@b.co";
+  request.currency = "NGN";
+  request.has_reference = true;
+  request.reference = "ref_load_1";
+  CheckoutResult checkout;
+  client.InitializeTransaction(
+      request, MockApi(server),
+      [&checkout](const CheckoutResult& result) { checkout = result; });
+  ASSERT_TRUE(checkout.ok()) << checkout.error_message;
+  EXPECT_EQ(checkout.reference, "ref_load_1");
+  EXPECT_EQ(checkout.authorization_url,
+            "https://checkout.paystack.com/ref_load_1");
+
+  VerifyResult verified;
+  client.VerifyTransaction(
+      "ref_load_1", MockApi(server),
+      [&verified](const VerifyResult& result) { verified = result; });
+  ASSERT_TRUE(verified.ok()) << verified.error_message;
+  EXPECT_EQ(verified.reference, "ref_load_1");
+  EXPECT_EQ(verified.status, "success");
+  EXPECT_EQ(server.stats().requests, 2u);
+}
+
+TEST(MockServer, HoldsTheClientBackAfterA429) {
+  MockServerOptions options;
+  options.rate_limit_rate = 1;
+  options.retry_after_seconds = 1;
+  MockServer server(options);
+  std::string error;
+  ASSERT_TRUE(server.Start(&error)) << error;
+  SocketTransport transport(server.port());
+  PaystackClient client(&transport);
+  // Retry-After outlasts the wait the client allows, so it gives up instead
+  // of sending the request again.
+  RateLimitPolicy policy;
+  policy.max_wait = std::chrono::milliseconds(50);
+  client.set_rate_limit_policy(policy);
+
+  VerifyResult verified;
+  client.VerifyTransaction(
+      "ref_load_1", MockApi(server),
+      [&verified](const VerifyResult& result) { verified = result; });
+  EXPECT_EQ(verified.error_code, kRateLimitedError);
+  EXPECT_EQ(transport.sent.size(), 1u);
+  EXPECT_EQ(server.stats().rate_limited, 1u);
+}
+
+TEST(MockServer, KeepsConnectionsAlive) {
+  MockServer server{MockServerOptions()};
+  std::string error;
+  ASSERT_TRUE(server.Start(&error)) << error;
+
+  std::string get = "GET /transaction/verify/ref_1 HTTP/1.1\r\n"
+                    "Authorization: Bearer pk_test\r\n\r\n";
+  std::string last = "GET /transaction/verify/ref_2 HTTP/1.1\r\n"
+                     "Authorization: Bearer pk_test\r\n"
+                     "Connection: close\r\n\r\n";
+  std::string reply = Exchange(server.port(), get + last);
+  EXPECT_NE(reply.find(R"("reference":"ref_1")"), std::string::npos);
+  EXPECT_NE(reply.find(R"("reference":"ref_2")"), std::string::npos);
+
+  reply = Exchange(server.port(),
+                   "GET /transaction/verify/ref_1 HTTP/1.1\r\n"
+                   "Connection: close\r\n\r\n");
+  EXPECT_EQ(reply.compare(0, 12, "HTTP/1.1 401"), 0) << reply;
+}
+
+TEST(MockServer, InjectsFaults) {
+  const std::string get = "GET /transaction/verify/ref_1 HTTP/1.1\r\n"
+                          "Authorization: Bearer pk_test\r\n"
+                          "Connection: close\r\n\r\n";
+  {
+    MockServerOptions options;
+    options.rate_limit_rate = 1;
+    options.retry_after_seconds = 3;
+    MockServer server(options);
+    std::string error;
+    ASSERT_TRUE(server.Start(&error)) << error;
+    std::string reply = Exchange(server.port(), get);
+    EXPECT_EQ(reply.compare(0, 12, "HTTP/1.1 429"), 0) << reply;
+    EXPECT_NE(reply.find("Retry-After: 3\r\n"), std::string::npos);
+    EXPECT_EQ(server.stats().rate_limited, 1u);
+  }
+  {
+    MockServerOptions options;
+    options.error_rate = 1;
+    MockServer server(options);
+    std::string error;
+    ASSERT_TRUE(server.Start(&error)) << error;
+    SocketTransport transport(server.port());
+    PaystackClient client(&transport);
+    RetryPolicy policy;
+    policy.base_delay_ms = 1;
+    policy.max_delay_ms = 5;
+    client.set_retry_policy(policy);
+    VerifyResult verified;
+    client.VerifyTransaction(
+        "ref_1", MockApi(server),
+        [&verified](const VerifyResult& result) { verified = result; });
+    // The 500 of the last attempt.
+    EXPECT_EQ(verified.error_code, "API_ERROR");
+    EXPECT_EQ(verified.error_message, "Internal server error");
+    EXPECT_EQ(transport.sent.size(), 3u);
+    EXPECT_EQ(client.metrics().endpoint(Endpoint::kVerify).retries, 2u);
+  }
+  {
+    MockServerOptions options;
+    options.drop_rate = 1;
+    MockServer server(options);
+    std::string error;
+    ASSERT_TRUE(server.Start(&error)) << error;
+    EXPECT_EQ(Exchange(server.port(), get), "");
+    EXPECT_EQ(server.stats().dropped, 1u);
+  }
+}
+
+TEST(MockServer, DelaysAndDribblesResponses) {
+  MockServerOptions options;
+  options.latency.kind = LatencyDistribution::Kind::kFixed;
+  options.latency.first = 30;
+  options.slow_body_rate = 1;
+  options.slow_body_chunk_bytes = 256;
+  options.slow_body_interval_ms = 10;
+  MockServer server(options);
+  std::string error;
+  ASSERT_TRUE(server.Start(&error)) << error;
+  SocketTransport transport(server.port());
+  PaystackClient client(&transport);
+
+  auto start = std::chrono::steady_clock::now();
+  VerifyResult verified;
+  client.VerifyTransaction(
+      "ref_1", MockApi(server),
+      [&verified](const VerifyResult& result) { verified = result; });
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  // The built-in verification body takes a few chunks.
+  EXPECT_TRUE(verified.ok()) << verified.error_message;
+  EXPECT_GE(elapsed, std::chrono::milliseconds(40));
+  EXPECT_EQ(server.stats().slow_bodies, 1u);
+}
+
+TEST(MockServer, RecordsAndReplaysFixtures) {
+  std::string fixtures = MakeTempDir();
+  FixedTransport upstream;
+  {
+    MockServerOptions options;
+    options.fixtures_dir = fixtures;
+    options.upstream = &upstream;
+    options.upstream_base_url = "https://api.example.test";
+    MockServer server(options);
+    std::string error;
+    ASSERT_TRUE(server.Start(&error)) << error;
+    SocketTransport transport(server.port());
+    PaystackClient client(&transport);
+    VerifyResult verified;
+    client.VerifyTransaction(
+        "ref/live", MockApi(server),
+        [&verified](const VerifyResult& result) { verified = result; });
+    EXPECT_EQ(verified.status, "abandoned");
+    ASSERT_EQ(upstream.sent.size(), 1u);
+    EXPECT_EQ(upstream.sent[0].url,
+              "https://api.example.test/transaction/verify/ref/live");
+    EXPECT_EQ(upstream.sent[0].public_key, "pk_test");
+    EXPECT_EQ(server.stats().recorded, 1u);
+  }
+
+  // Replayed without the upstream, by name and as the fallback.
+  std::ofstream(fixtures + "/verify.json") << "404\n"
+                                           << R"({"status":false,)"
+                                           << R"("message":"Not found"})";
+  MockServerOptions options;
+  options.fixtures_dir = fixtures;
+  MockServer server(options);
+  std::string error;
+  ASSERT_TRUE(server.Start(&error)) << error;
+  SocketTransport transport(server.port());
+  PaystackClient client(&transport);
+  VerifyResult replayed;
+  client.VerifyTransaction(
+      "ref/live", MockApi(server),
+      [&replayed](const VerifyResult& result) { replayed = result; });
+  EXPECT_EQ(replayed.status, "abandoned");
+  EXPECT_EQ(replayed.currency, "GHS");
+  VerifyResult missing;
+  client.VerifyTransaction(
+      "ref_other", MockApi(server),
+      [&missing](const VerifyResult& result) { missing = result; });
+  EXPECT_EQ(missing.error_message, "Not found");
+  EXPECT_EQ(server.stats().replayed, 2u);
+
+  std::remove((fixtures + "/verify_ref_live.json").c_str());
+  std::remove((fixtures + "/verify.json").c_str());
+  rmdir(fixtures.c_str());
+}
+
+}  // namespace test
+}  // namespace all_paystack_payments
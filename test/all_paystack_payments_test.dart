@@ -11,7 +11,13 @@ class MockAllPaystackPaymentsPlatform
   Future<String?> getPlatformVersion() => Future.value('42');
 
   @override
-  Future<void> initialize(String publicKey) => Future.value();
+  Future<void> initialize(
+    String publicKey, {
+    String? baseUrl,
+    int? hedgeVerifyPercentile,
+    int? rateLimitPerSecond,
+    bool? embeddedCheckout,
+  }) => Future.value();
 
   @override
   Future<PaymentResponse> initializePayment(PaymentRequest request) {
@@ -27,7 +33,10 @@ class MockAllPaystackPaymentsPlatform
   }
 
   @override
-  Future<PaymentResponse> verifyPayment(String reference) {
+  Future<PaymentResponse> verifyPayment(
+    String reference, {
+    List<String>? fields,
+  }) {
     return Future.value(
       PaymentResponse(
         reference: reference,
@@ -39,6 +48,56 @@ class MockAllPaystackPaymentsPlatform
     );
   }
 
+  @override
+  Future<List<VerificationResult>> verifyPayments(
+    List<String> references, {
+    int maxConcurrency = 16,
+  }) {
+    return Future.value([
+      for (final reference in references)
+        VerificationResult.success(
+          reference,
+          PaymentResponse(
+            reference: reference,
+            status: PaymentStatus.success,
+            amount: 1000,
+            currency: Currency.ngn,
+            paymentMethod: PaymentMethod.card,
+          ),
+        ),
+    ]);
+  }
+
+  @override
+  Future<void> invalidateVerificationCache({String? reference}) =>
+      Future.value();
+
+  @override
+  Future<Map<String, int>> getVerificationCacheStats() =>
+      Future.value({'hits': 3, 'misses': 1, 'size': 1});
+
+  @override
+  Future<Map<String, dynamic>> getMetrics() => Future.value({
+    'verify': {
+      'requests': 2,
+      'errors': {'HTTP_ERROR': 0, 'API_ERROR': 1, 'PARSE_ERROR': 0},
+    },
+  });
+
+  @override
+  Future<Map<String, dynamic>> getTransportStats() => Future.value({
+    'circuits': {
+      'verify': {'state': 'open', 'consecutiveFailures': 5, 'rejected': 2},
+    },
+    'limiter': {'limit': 20, 'inFlight': 0, 'queued': 0},
+  });
+
+  @override
+  Future<bool> startTracing(String path) => Future.value(true);
+
+  @override
+  Future<void> stopTracing() => Future.value();
+
   @override
   Future<PaymentResponse> getPaymentStatus(String reference) {
     return Future.value(
@@ -56,7 +115,26 @@ class MockAllPaystackPaymentsPlatform
   Future<bool> cancelPayment(String reference) => Future.value(true);
 
   @override
-  Future<String> getCheckoutUrl(PaymentRequest request) {
+  Future<bool> watchPayment(String reference, {Duration? timeout}) =>
+      Future.value(true);
+
+  @override
+  Future<bool> unwatchPayment(String reference) => Future.value(true);
+
+  @override
+  Stream<PaymentStatusUpdate> get paymentStatusUpdates => Stream.value(
+    const PaymentStatusUpdate(
+      reference: 'test_ref',
+      status: 'success',
+      isFinal: true,
+    ),
+  );
+
+  @override
+  Future<String> getCheckoutUrl(
+    PaymentRequest request, {
+    bool returnToApp = false,
+  }) {
     return Future.value('https://checkout.paystack.com/test_checkout_url');
   }
 }
@@ -134,6 +212,16 @@ void main() {
 
       expect(result, true);
     });
+
+    test('watchPayment reports updates from platform', () async {
+      expect(await AllPaystackPayments.watchPayment('test_ref'), true);
+      final update = await AllPaystackPayments.paymentStatusUpdates.first;
+
+      expect(update.reference, 'test_ref');
+      expect(update.isSuccessful, true);
+      expect(update.isFinal, true);
+      expect(await AllPaystackPayments.unwatchPayment('test_ref'), true);
+    });
   });
 
   group('Payment Flow Integration Tests', () {
@@ -28,7 +28,10 @@ void main() {
   group('Error Scenarios - Card Payments', () {
     setUp(() {
       when(
-        mockPlatform.getCheckoutUrl(any),
+        mockPlatform.getCheckoutUrl(
+          any,
+          returnToApp: anyNamed('returnToApp'),
+        ),
       ).thenAnswer((_) async => 'https://checkout.paystack.com/test');
     });
 
@@ -153,7 +156,10 @@ void main() {
   group('Error Scenarios - Bank Transfer', () {
     setUp(() {
       when(
-        mockPlatform.getCheckoutUrl(any),
+        mockPlatform.getCheckoutUrl(
+          any,
+          returnToApp: anyNamed('returnToApp'),
+        ),
       ).thenAnswer((_) async => 'https://checkout.paystack.com/bank');
     });
 
@@ -178,7 +184,10 @@ void main() {
   group('Error Scenarios - Mobile Money', () {
     setUp(() {
       when(
-        mockPlatform.getCheckoutUrl(any),
+        mockPlatform.getCheckoutUrl(
+          any,
+          returnToApp: anyNamed('returnToApp'),
+        ),
       ).thenAnswer((_) async => 'https://checkout.paystack.com/mobile');
     });
 
@@ -303,7 +312,10 @@ void main() {
   group('Error Scenarios - Network and Timeout', () {
     setUp(() {
       when(
-        mockPlatform.getCheckoutUrl(any),
+        mockPlatform.getCheckoutUrl(
+          any,
+          returnToApp: anyNamed('returnToApp'),
+        ),
       ).thenAnswer((_) async => 'https://checkout.paystack.com/test');
     });
 
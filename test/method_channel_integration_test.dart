@@ -9,13 +9,26 @@ void main() {
   MethodChannelAllPaystackPayments platform =
       MethodChannelAllPaystackPayments();
   const MethodChannel channel = MethodChannel('all_paystack_payments');
+  Object? initializeArguments;
+  Object? watchArguments;
+  Object? checkoutArguments;
 
   setUp(() {
     TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
         .setMockMethodCallHandler(channel, (MethodCall methodCall) async {
           switch (methodCall.method) {
             case 'initialize':
+              initializeArguments = methodCall.arguments;
               return {'status': 'success'};
+            case 'getCheckoutUrl':
+              checkoutArguments = methodCall.arguments;
+              return {
+                'status': 'success',
+                'data': {
+                  'authorization_url': 'https://checkout.paystack.com/abc',
+                  'reference': 'test_ref_123',
+                },
+              };
             case 'initializePayment':
               return {
                 'reference': 'test_ref_123',
@@ -31,7 +44,31 @@ void main() {
                 'amount': 1000,
                 'currency': 'NGN',
                 'payment_method': 'card',
+                if (methodCall.arguments['fields'] != null)
+                  'fields': methodCall.arguments['fields'],
               };
+            case 'verifyPayments':
+              return [
+                for (final reference in methodCall.arguments['references'])
+                  reference == 'missing_ref'
+                      ? {
+                          'reference': reference,
+                          'success': false,
+                          'code': 'API_ERROR',
+                          'message': 'Transaction reference not found',
+                        }
+                      : {
+                          'reference': reference,
+                          'success': true,
+                          'data': {
+                            'reference': reference,
+                            'status': 'success',
+                            'amount': 1000,
+                            'currency': 'NGN',
+                            'payment_method': 'card',
+                          },
+                        },
+              ];
             case 'getPaymentStatus':
               return {
                 'reference': methodCall.arguments['reference'],
@@ -40,8 +77,50 @@ void main() {
                 'currency': 'NGN',
                 'payment_method': 'card',
               };
+            case 'invalidateVerificationCache':
+              return null;
+            case 'getVerificationCacheStats':
+              return {'hits': 3, 'misses': 1, 'size': 1};
+            case 'getMetrics':
+              return {
+                'verify': {
+                  'requests': 4,
+                  'phases': {
+                    'total': {'count': 4, 'p50': 80000, 'p99': 210000},
+                  },
+                },
+                'methods': {
+                  'verifyPayment': {'calls': 4, 'invalidArguments': 0},
+                },
+              };
+            case 'getTransportStats':
+              return {
+                'circuits': {
+                  'verify': {
+                    'state': 'halfOpen',
+                    'consecutiveFailures': 5,
+                    'rejected': 12,
+                  },
+                },
+                'limiter': {'limit': 7, 'inFlight': 7, 'queued': 3},
+              };
+            case 'startTracing':
+              if (methodCall.arguments['path'] == '/nonexistent/trace.json') {
+                throw PlatformException(
+                  code: 'TRACE_ERROR',
+                  message: 'Failed to open /nonexistent/trace.json',
+                );
+              }
+              return null;
+            case 'stopTracing':
+              return null;
             case 'cancelPayment':
               return true;
+            case 'watchPayment':
+              watchArguments = methodCall.arguments;
+              return true;
+            case 'unwatchPayment':
+              return false;
             case 'getPlatformVersion':
               return '42';
             default:
@@ -58,7 +137,60 @@ void main() {
   group('MethodChannelAllPaystackPayments', () {
     test('initialize calls platform correctly', () async {
       await platform.initialize('test_key');
-      // Test passes if no exception is thrown
+      expect(initializeArguments, {'publicKey': 'test_key'});
+    });
+
+    test('initialize sends the base URL when given', () async {
+      await platform.initialize(
+        'test_key',
+        baseUrl: 'http://127.0.0.1:8089',
+      );
+      expect(initializeArguments, {
+        'publicKey': 'test_key',
+        'baseUrl': 'http://127.0.0.1:8089',
+      });
+    });
+
+    test('initialize sends the hedge percentile when given', () async {
+      await platform.initialize('test_key', hedgeVerifyPercentile: 95);
+      expect(initializeArguments, {
+        'publicKey': 'test_key',
+        'hedgeVerifyPercentile': 95,
+      });
+    });
+
+    test('initialize sends the rate limit when given', () async {
+      await platform.initialize('test_key', rateLimitPerSecond: 25);
+      expect(initializeArguments, {
+        'publicKey': 'test_key',
+        'rateLimitPerSecond': 25,
+      });
+    });
+
+    test('initialize asks for the embedded checkout when given', () async {
+      await platform.initialize('test_key', embeddedCheckout: true);
+      expect(initializeArguments, {
+        'publicKey': 'test_key',
+        'embeddedCheckout': true,
+      });
+    });
+
+    test('getCheckoutUrl asks to return to the app only when told', () async {
+      final request = BankTransferRequest(
+        amount: 1000,
+        currency: Currency.ngn,
+        email: 'test@example.com',
+      );
+      expect(
+        await platform.getCheckoutUrl(request),
+        'https://checkout.paystack.com/abc',
+      );
+      expect(
+        (checkoutArguments as Map).containsKey('returnToApp'),
+        isFalse,
+      );
+      await platform.getCheckoutUrl(request, returnToApp: true);
+      expect((checkoutArguments as Map)['returnToApp'], isTrue);
     });
 
     test('initializePayment calls platform and returns response', () async {
@@ -89,6 +221,34 @@ void main() {
       expect(response.status, PaymentStatus.success);
     });
 
+    test('verifyPayment sends the field projection', () async {
+      final response = await platform.verifyPayment(
+        'test_ref',
+        fields: ['customer'],
+      );
+
+      expect(response.rawResponse!['fields'], ['customer']);
+    });
+
+    test('verifyPayments returns one result per reference in order', () async {
+      final results = await platform.verifyPayments([
+        'ref_1',
+        'missing_ref',
+        'ref_2',
+      ]);
+
+      expect(results.map((result) => result.reference), [
+        'ref_1',
+        'missing_ref',
+        'ref_2',
+      ]);
+      expect(results[0].isSuccessful, true);
+      expect(results[0].response!.status, PaymentStatus.success);
+      expect(results[1].isSuccessful, false);
+      expect(results[1].error!.code, 'API_ERROR');
+      expect(results[2].isSuccessful, true);
+    });
+
     test('getPaymentStatus calls platform and returns response', () async {
       final response = await platform.getPaymentStatus('test_ref');
 
@@ -96,12 +256,90 @@ void main() {
       expect(response.status, PaymentStatus.pending);
     });
 
+    test('getVerificationCacheStats returns counters', () async {
+      await platform.invalidateVerificationCache(reference: 'test_ref');
+      final stats = await platform.getVerificationCacheStats();
+
+      expect(stats, {'hits': 3, 'misses': 1, 'size': 1});
+    });
+
+    test('getMetrics returns the native metrics', () async {
+      final metrics = await platform.getMetrics();
+
+      expect(metrics['verify']['requests'], 4);
+      expect(metrics['verify']['phases']['total']['p99'], 210000);
+      expect(metrics['methods']['verifyPayment']['calls'], 4);
+    });
+
+    test('getTransportStats returns the native load control state', () async {
+      final stats = await platform.getTransportStats();
+
+      expect(stats['circuits']['verify']['state'], 'halfOpen');
+      expect(stats['limiter']['queued'], 3);
+    });
+
+    test('startTracing and stopTracing call the platform', () async {
+      expect(await platform.startTracing('/tmp/trace.json'), true);
+      await platform.stopTracing();
+    });
+
+    test('startTracing reports files it cannot create', () async {
+      expect(
+        () => platform.startTracing('/nonexistent/trace.json'),
+        throwsA(
+          isA<PaystackError>().having((e) => e.code, 'code', 'TRACE_ERROR'),
+        ),
+      );
+    });
+
     test('cancelPayment calls platform and returns result', () async {
       final result = await platform.cancelPayment('test_ref');
 
       expect(result, true);
     });
 
+    test('watchPayment sends the timeout in milliseconds', () async {
+      expect(
+        await platform.watchPayment(
+          'test_ref',
+          timeout: const Duration(minutes: 2),
+        ),
+        true,
+      );
+      expect(watchArguments, {'reference': 'test_ref', 'timeoutMs': 120000});
+      expect(await platform.unwatchPayment('test_ref'), false);
+    });
+
+    test('paymentStatusUpdates decodes native events', () async {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+          .setMockStreamHandler(
+            platform.eventChannel,
+            MockStreamHandler.inline(
+              onListen: (arguments, events) {
+                events.success({
+                  'reference': 'test_ref',
+                  'status': 'abandoned',
+                  'final': true,
+                  'timedOut': true,
+                });
+              },
+            ),
+          );
+      addTearDown(
+        () => TestDefaultBinaryMessengerBinding
+            .instance
+            .defaultBinaryMessenger
+            .setMockStreamHandler(platform.eventChannel, null),
+      );
+
+      final update = await platform.paymentStatusUpdates.first;
+      expect(update.reference, 'test_ref');
+      expect(update.status, 'abandoned');
+      expect(update.isFinal, true);
+      expect(update.timedOut, true);
+      expect(update.isSuccessful, false);
+    });
+
     test('getPlatformVersion calls platform and returns version', () async {
       final version = await platform.getPlatformVersion();
 
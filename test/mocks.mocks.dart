@@ -9,6 +9,8 @@ import 'package:all_paystack_payments/all_paystack_payments_platform_interface.d
     as _i3;
 import 'package:all_paystack_payments/payment_request.dart' as _i5;
 import 'package:all_paystack_payments/payment_response.dart' as _i2;
+import 'package:all_paystack_payments/payment_status_update.dart' as _i9;
+import 'package:all_paystack_payments/verification_result.dart' as _i8;
 import 'package:all_paystack_payments/webview_payment_handler.dart' as _i7;
 import 'package:mockito/mockito.dart' as _i1;
 import 'package:mockito/src/dummies.dart' as _i6;
@@ -44,9 +46,24 @@ class MockAllPaystackPaymentsPlatform extends _i1.Mock
   }
 
   @override
-  _i4.Future<void> initialize(String? publicKey) =>
+  _i4.Future<void> initialize(
+    String? publicKey, {
+    String? baseUrl,
+    int? hedgeVerifyPercentile,
+    int? rateLimitPerSecond,
+    bool? embeddedCheckout,
+  }) =>
       (super.noSuchMethod(
-            Invocation.method(#initialize, [publicKey]),
+            Invocation.method(
+              #initialize,
+              [publicKey],
+              {
+                #baseUrl: baseUrl,
+                #hedgeVerifyPercentile: hedgeVerifyPercentile,
+                #rateLimitPerSecond: rateLimitPerSecond,
+                #embeddedCheckout: embeddedCheckout,
+              },
+            ),
             returnValue: _i4.Future<void>.value(),
             returnValueForMissingStub: _i4.Future<void>.value(),
           )
@@ -68,31 +85,62 @@ class MockAllPaystackPaymentsPlatform extends _i1.Mock
           as _i4.Future<_i2.PaymentResponse>);
 
   @override
-  _i4.Future<String> getCheckoutUrl(_i5.PaymentRequest? request) =>
+  _i4.Future<String> getCheckoutUrl(
+    _i5.PaymentRequest? request, {
+    bool? returnToApp = false,
+  }) =>
       (super.noSuchMethod(
-            Invocation.method(#getCheckoutUrl, [request]),
+            Invocation.method(
+              #getCheckoutUrl,
+              [request],
+              {#returnToApp: returnToApp},
+            ),
             returnValue: _i4.Future<String>.value(
               _i6.dummyValue<String>(
                 this,
-                Invocation.method(#getCheckoutUrl, [request]),
+                Invocation.method(
+                  #getCheckoutUrl,
+                  [request],
+                  {#returnToApp: returnToApp},
+                ),
               ),
             ),
           )
           as _i4.Future<String>);
 
   @override
-  _i4.Future<_i2.PaymentResponse> verifyPayment(String? reference) =>
+  _i4.Future<_i2.PaymentResponse> verifyPayment(
+    String? reference, {
+    List<String>? fields,
+  }) =>
       (super.noSuchMethod(
-            Invocation.method(#verifyPayment, [reference]),
+            Invocation.method(#verifyPayment, [reference], {#fields: fields}),
             returnValue: _i4.Future<_i2.PaymentResponse>.value(
               _FakePaymentResponse_0(
                 this,
-                Invocation.method(#verifyPayment, [reference]),
+                Invocation.method(#verifyPayment, [reference], {#fields: fields}),
               ),
             ),
           )
           as _i4.Future<_i2.PaymentResponse>);
 
+  @override
+  _i4.Future<List<_i8.VerificationResult>> verifyPayments(
+    List<String>? references, {
+    int? maxConcurrency = 16,
+  }) =>
+      (super.noSuchMethod(
+            Invocation.method(
+              #verifyPayments,
+              [references],
+              {#maxConcurrency: maxConcurrency},
+            ),
+            returnValue: _i4.Future<List<_i8.VerificationResult>>.value(
+              <_i8.VerificationResult>[],
+            ),
+          )
+          as _i4.Future<List<_i8.VerificationResult>>);
+
   @override
   _i4.Future<_i2.PaymentResponse> getPaymentStatus(String? reference) =>
       (super.noSuchMethod(
@@ -106,6 +154,62 @@ class MockAllPaystackPaymentsPlatform extends _i1.Mock
           )
           as _i4.Future<_i2.PaymentResponse>);
 
+  @override
+  _i4.Future<void> invalidateVerificationCache({String? reference}) =>
+      (super.noSuchMethod(
+            Invocation.method(#invalidateVerificationCache, [], {
+              #reference: reference,
+            }),
+            returnValue: _i4.Future<void>.value(),
+            returnValueForMissingStub: _i4.Future<void>.value(),
+          )
+          as _i4.Future<void>);
+
+  @override
+  _i4.Future<Map<String, int>> getVerificationCacheStats() =>
+      (super.noSuchMethod(
+            Invocation.method(#getVerificationCacheStats, []),
+            returnValue: _i4.Future<Map<String, int>>.value(<String, int>{}),
+          )
+          as _i4.Future<Map<String, int>>);
+
+  @override
+  _i4.Future<Map<String, dynamic>> getMetrics() =>
+      (super.noSuchMethod(
+            Invocation.method(#getMetrics, []),
+            returnValue: _i4.Future<Map<String, dynamic>>.value(
+              <String, dynamic>{},
+            ),
+          )
+          as _i4.Future<Map<String, dynamic>>);
+
+  @override
+  _i4.Future<Map<String, dynamic>> getTransportStats() =>
+      (super.noSuchMethod(
+            Invocation.method(#getTransportStats, []),
+            returnValue: _i4.Future<Map<String, dynamic>>.value(
+              <String, dynamic>{},
+            ),
+          )
+          as _i4.Future<Map<String, dynamic>>);
+
+  @override
+  _i4.Future<bool> startTracing(String? path) =>
+      (super.noSuchMethod(
+            Invocation.method(#startTracing, [path]),
+            returnValue: _i4.Future<bool>.value(false),
+          )
+          as _i4.Future<bool>);
+
+  @override
+  _i4.Future<void> stopTracing() =>
+      (super.noSuchMethod(
+            Invocation.method(#stopTracing, []),
+            returnValue: _i4.Future<void>.value(),
+            returnValueForMissingStub: _i4.Future<void>.value(),
+          )
+          as _i4.Future<void>);
+
   @override
   _i4.Future<bool> cancelPayment(String? reference) =>
       (super.noSuchMethod(
@@ -114,6 +218,30 @@ class MockAllPaystackPaymentsPlatform extends _i1.Mock
           )
           as _i4.Future<bool>);
 
+  @override
+  _i4.Future<bool> watchPayment(String? reference, {Duration? timeout}) =>
+      (super.noSuchMethod(
+            Invocation.method(#watchPayment, [reference], {#timeout: timeout}),
+            returnValue: _i4.Future<bool>.value(false),
+          )
+          as _i4.Future<bool>);
+
+  @override
+  _i4.Future<bool> unwatchPayment(String? reference) =>
+      (super.noSuchMethod(
+            Invocation.method(#unwatchPayment, [reference]),
+            returnValue: _i4.Future<bool>.value(false),
+          )
+          as _i4.Future<bool>);
+
+  @override
+  _i4.Stream<_i9.PaymentStatusUpdate> get paymentStatusUpdates =>
+      (super.noSuchMethod(
+            Invocation.getter(#paymentStatusUpdates),
+            returnValue: _i4.Stream<_i9.PaymentStatusUpdate>.empty(),
+          )
+          as _i4.Stream<_i9.PaymentStatusUpdate>);
+
   @override
   _i4.Future<String?> getPlatformVersion() =>
       (super.noSuchMethod(
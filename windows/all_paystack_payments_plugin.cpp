@@ -10,15 +10,186 @@
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
 
-#include <curl/curl.h>
-#include <nlohmann/json.hpp>
-
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iterator>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include "paystack_encodable_value.h"
 
 namespace all_paystack_payments {
 
+namespace {
+
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+// Whether |value| is an argument of |type|. The standard codec sends integers
+// that do not fit in 32 bits as int64.
+bool HasArgType(const EncodableValue& value, ArgType type) {
+  switch (type) {
+    case ArgType::kString:
+      return std::holds_alternative<std::string>(value);
+    case ArgType::kInt:
+      return std::holds_alternative<int32_t>(value) || std::holds_alternative<int64_t>(value);
+    case ArgType::kBool:
+      return std::holds_alternative<bool>(value);
+    case ArgType::kMap:
+      return std::holds_alternative<EncodableMap>(value);
+    case ArgType::kStringList: {
+      const auto* list = std::get_if<flutter::EncodableList>(&value);
+      return list && std::all_of(list->begin(), list->end(), [](const EncodableValue& item) { return std::holds_alternative<std::string>(item); });
+    }
+  }
+  return false;
+}
+
+// Bounds of initialize's hedgeVerifyPercentile.
+constexpr int64_t kMinHedgePercentile = 50;
+constexpr int64_t kMaxHedgePercentile = 99;
+
+// Upper bound of initialize's rateLimitPerSecond.
+constexpr int64_t kMaxRateLimitPerSecond = 1000;
+
+// Members of a verified transaction that PaymentResponse reads, returned
+// whatever field projection the caller asked for.
+const char* const kVerifyCoreFields[] = {
+    "reference", "status", "amount", "currency", "gateway_response", "created_at",
+};
+
+// Reads the optional "fields" projection of a verify call, which the
+// registry has checked is a list of strings.
+std::vector<std::string> ReadVerifyFields(const EncodableMap& arguments) {
+  std::vector<std::string> fields;
+  auto fields_it = arguments.find(EncodableValue("fields"));
+  if (fields_it != arguments.end() && !fields_it->second.IsNull()) {
+    for (const EncodableValue& field : std::get<flutter::EncodableList>(fields_it->second)) {
+      fields.push_back(std::get<std::string>(field));
+    }
+  }
+  return fields;
+}
+
+// Answers a verify call with the transaction's data object, or only |fields|
+// of it (plus the members PaymentResponse needs) if the list is not empty.
+void RespondWithVerifyResult(const VerifyResult& verify_result, const std::vector<std::string>& fields, flutter::MethodResult<EncodableValue>* result) {
+  if (!verify_result.ok()) {
+    result->Error(verify_result.error_code, verify_result.error_message);
+    return;
+  }
+  std::vector<std::string> projection;
+  if (!fields.empty()) {
+    projection = fields;
+    projection.insert(projection.end(), std::begin(kVerifyCoreFields), std::end(kVerifyCoreFields));
+  }
+  EncodableValue data;
+  if (!json_to_encodable_value(verify_result.data_json.data(), verify_result.data_json.size(), projection, &data) ||
+      !std::holds_alternative<EncodableMap>(data)) {
+    result->Error("PARSE_ERROR", "Failed to parse API response");
+    return;
+  }
+  // Paystack's channel names match the payment methods the Dart side knows.
+  std::get<EncodableMap>(data)[EncodableValue("payment_method")] =
+      EncodableValue(verify_result.channel.empty() ? std::string("card") : verify_result.channel);
+  result->Success(data);
+}
+
+// Microseconds since |start|, for the metrics' kBuild phase.
+int64_t MicrosSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// What the spans of |method_call| are traced with: its method and the
+// reference it is about, if any.
+TraceArgs TraceArgsOf(const flutter::MethodCall<EncodableValue> &method_call) {
+  TraceArgs args;
+  args.method = method_call.method_name().c_str();
+  const auto *arguments = method_call.arguments() ? std::get_if<EncodableMap>(method_call.arguments()) : nullptr;
+  if (arguments) {
+    auto it = arguments->find(EncodableValue("reference"));
+    if (it != arguments->end() && std::holds_alternative<std::string>(it->second)) {
+      args.reference = std::get<std::string>(it->second);
+    }
+  }
+  return args;
+}
+
+// Summarizes |metrics| for getMetrics: for each endpoint, the number of
+// requests, errors by code, retries and the percentiles of each phase in
+// microseconds.
+EncodableMap MetricsToEncodableMap(ClientMetrics& metrics) {
+  EncodableMap result;
+  for (size_t i = 0; i < kEndpointCount; i++) {
+    auto endpoint = static_cast<Endpoint>(i);
+    EndpointMetrics& endpoint_metrics = metrics.endpoint(endpoint);
+    EncodableMap endpoint_map;
+    endpoint_map[EncodableValue("requests")] = EncodableValue(static_cast<int64_t>(endpoint_metrics.requests.load(std::memory_order_relaxed)));
+    EncodableMap errors;
+    for (size_t code = 0; code < kMetricErrorCodeCount; code++) {
+      errors[EncodableValue(kMetricErrorCodes[code])] = EncodableValue(static_cast<int64_t>(endpoint_metrics.errors[code].load(std::memory_order_relaxed)));
+    }
+    endpoint_map[EncodableValue("errors")] = EncodableValue(errors);
+    endpoint_map[EncodableValue("retries")] = EncodableValue(static_cast<int64_t>(endpoint_metrics.retries.load(std::memory_order_relaxed)));
+    endpoint_map[EncodableValue("throttledRetries")] = EncodableValue(static_cast<int64_t>(endpoint_metrics.throttled_retries.load(std::memory_order_relaxed)));
+    endpoint_map[EncodableValue("hedges")] = EncodableValue(static_cast<int64_t>(endpoint_metrics.hedges.load(std::memory_order_relaxed)));
+    endpoint_map[EncodableValue("hedgesWon")] = EncodableValue(static_cast<int64_t>(endpoint_metrics.hedges_won.load(std::memory_order_relaxed)));
+    endpoint_map[EncodableValue("rateLimited")] = EncodableValue(static_cast<int64_t>(endpoint_metrics.rate_limited.load(std::memory_order_relaxed)));
+    EncodableMap phases;
+    for (size_t phase = 0; phase < kPhaseCount; phase++) {
+      LatencySummary summary = endpoint_metrics.phases[phase].Summarize();
+      EncodableMap summary_map;
+      summary_map[EncodableValue("count")] = EncodableValue(static_cast<int64_t>(summary.count));
+      summary_map[EncodableValue("p50")] = EncodableValue(summary.p50);
+      summary_map[EncodableValue("p90")] = EncodableValue(summary.p90);
+      summary_map[EncodableValue("p99")] = EncodableValue(summary.p99);
+      summary_map[EncodableValue("p999")] = EncodableValue(summary.p999);
+      summary_map[EncodableValue("max")] = EncodableValue(summary.max);
+      phases[EncodableValue(phase_name(static_cast<Phase>(phase)))] = EncodableValue(summary_map);
+    }
+    endpoint_map[EncodableValue("phases")] = EncodableValue(phases);
+    result[EncodableValue(endpoint_name(endpoint))] = EncodableValue(endpoint_map);
+  }
+  return result;
+}
+
+// Summarizes the state of |client|'s load control for getTransportStats: the
+// circuit of each endpoint, and the concurrency limit with the requests in
+// flight and queued.
+EncodableMap TransportStatsToEncodableMap(const PaystackClient& client) {
+  EncodableMap circuits;
+  EncodableMap rate_limits;
+  for (size_t i = 0; i < kEndpointCount; i++) {
+    auto endpoint = static_cast<Endpoint>(i);
+    const CircuitBreaker& breaker = client.circuit_breaker(endpoint);
+    EncodableMap circuit;
+    circuit[EncodableValue("state")] = EncodableValue(circuit_state_name(breaker.state()));
+    circuit[EncodableValue("consecutiveFailures")] = EncodableValue(breaker.consecutive_failures());
+    circuit[EncodableValue("rejected")] = EncodableValue(static_cast<int64_t>(breaker.rejected()));
+    circuits[EncodableValue(endpoint_name(endpoint))] = EncodableValue(circuit);
+    EncodableMap rate_limit;
+    rate_limit[EncodableValue("waiting")] = EncodableValue(static_cast<int64_t>(client.rate_limited(endpoint)));
+    rate_limit[EncodableValue("expired")] = EncodableValue(static_cast<int64_t>(client.rate_limit_expired(endpoint)));
+    rate_limits[EncodableValue(endpoint_name(endpoint))] = EncodableValue(rate_limit);
+  }
+  const ConcurrencyLimiter& limiter = client.concurrency_limiter();
+  EncodableMap limiter_map;
+  limiter_map[EncodableValue("limit")] = EncodableValue(limiter.limit());
+  limiter_map[EncodableValue("inFlight")] = EncodableValue(limiter.in_flight());
+  limiter_map[EncodableValue("queued")] = EncodableValue(static_cast<int64_t>(client.queued()));
+  EncodableMap result;
+  result[EncodableValue("circuits")] = EncodableValue(circuits);
+  result[EncodableValue("limiter")] = EncodableValue(limiter_map);
+  result[EncodableValue("rateLimits")] = EncodableValue(rate_limits);
+  return result;
+}
+
+}  // namespace
+
 // static
 void AllPaystackPaymentsPlugin::RegisterWithRegistrar(
     flutter::PluginRegistrarWindows *registrar) {
@@ -37,57 +208,183 @@ void AllPaystackPaymentsPlugin::RegisterWithRegistrar(
   registrar->AddPlugin(std::move(plugin));
 }
 
-AllPaystackPaymentsPlugin::AllPaystackPaymentsPlugin() {}
+// Every method call the plugin handles. A new method only needs an entry
+// here and its handler. Requests block until they complete, so no method is
+// async on Windows.
+struct AllPaystackPaymentsPlugin::Methods {
+  static constexpr ArgSpec kInitializeArgs[] = {
+      {"publicKey", ArgType::kString, true},
+      {"baseUrl", ArgType::kString, false},
+      {"hedgeVerifyPercentile", ArgType::kInt, false},
+      {"rateLimitPerSecond", ArgType::kInt, false},
+      // Accepted for parity with Linux; checkouts open in the browser.
+      {"embeddedCheckout", ArgType::kBool, false},
+  };
+  static constexpr ArgSpec kCheckoutArgs[] = {
+      {"amount", ArgType::kInt, true},
+      {"email", ArgType::kString, true},
+      {"currency", ArgType::kString, false},
+      {"reference", ArgType::kString, false},
+      {"callbackUrl", ArgType::kString, false},
+      // Accepted for parity with Linux; checkouts return to the integration's
+      // callback URL.
+      {"returnToApp", ArgType::kBool, false},
+      {"metadata", ArgType::kMap, false},
+  };
+  static constexpr ArgSpec kVerifyArgs[] = {
+      {"reference", ArgType::kString, true},
+      {"fields", ArgType::kStringList, false},
+  };
+  static constexpr ArgSpec kCancelArgs[] = {
+      {"reference", ArgType::kString, true},
+  };
+  static constexpr ArgSpec kWatchArgs[] = {
+      {"reference", ArgType::kString, true},
+      {"timeoutMs", ArgType::kInt, false},
+  };
+  static constexpr ArgSpec kShowWebViewArgs[] = {
+      {"checkoutUrl", ArgType::kString, true},
+  };
+  static constexpr ArgSpec kStartTracingArgs[] = {
+      {"path", ArgType::kString, true},
+  };
+
+  static constexpr MethodSpec<Handler> kAll[] = {
+      {"initialize", arg_list(kInitializeArgs), false, &AllPaystackPaymentsPlugin::HandleInitialize},
+      {"initializePayment", arg_list(kCheckoutArgs), false, &AllPaystackPaymentsPlugin::HandleInitializePayment},
+      {"getCheckoutUrl", arg_list(kCheckoutArgs), false, &AllPaystackPaymentsPlugin::HandleGetCheckoutUrl},
+      {"verifyPayment", arg_list(kVerifyArgs), false, &AllPaystackPaymentsPlugin::HandleVerifyPayment},
+      {"getPaymentStatus", arg_list(kVerifyArgs), false, &AllPaystackPaymentsPlugin::HandleGetPaymentStatus},
+      {"cancelPayment", arg_list(kCancelArgs), false, &AllPaystackPaymentsPlugin::HandleCancelPayment},
+      {"watchPayment", arg_list(kWatchArgs), false, &AllPaystackPaymentsPlugin::HandleWatchPayment},
+      {"unwatchPayment", arg_list(kCancelArgs), false, &AllPaystackPaymentsPlugin::HandleWatchPayment},
+      {"showWebView", arg_list(kShowWebViewArgs), false, &AllPaystackPaymentsPlugin::HandleShowWebView},
+      {"getMetrics", kNoArgs, false, &AllPaystackPaymentsPlugin::HandleGetMetrics},
+      {"getTransportStats", kNoArgs, false, &AllPaystackPaymentsPlugin::HandleGetTransportStats},
+      {"startTracing", arg_list(kStartTracingArgs), false, &AllPaystackPaymentsPlugin::HandleStartTracing},
+      {"stopTracing", kNoArgs, false, &AllPaystackPaymentsPlugin::HandleStopTracing},
+      {"getPlatformVersion", kNoArgs, false, &AllPaystackPaymentsPlugin::HandleGetPlatformVersion},
+  };
+  static constexpr size_t kCount = sizeof(kAll) / sizeof(kAll[0]);
+
+  static constexpr MethodTable<kCount> kTable{kAll};
+  static_assert(kTable.ok(), "No perfect hash for the method names; raise MethodTable's seed limit");
+};
+
+AllPaystackPaymentsPlugin::AllPaystackPaymentsPlugin()
+    : method_stats_(new MethodStats[Methods::kCount]) {
+  client_.set_tracer(&tracer_);
+  // Backing off would block the platform thread (see CurlTransport).
+  RetryPolicy retry_policy;
+  retry_policy.max_attempts = 1;
+  client_.set_retry_policy(retry_policy);
+}
 
 AllPaystackPaymentsPlugin::~AllPaystackPaymentsPlugin() {}
 
+// static
+bool AllPaystackPaymentsPlugin::CheckMethodArgs(
+    const MethodSpec<Handler> &method, const EncodableValue *arguments,
+    flutter::MethodResult<EncodableValue> *result) {
+  const ArgList &specs = method.args;
+  if (specs.size == 0) {
+    return true;
+  }
+  const auto *map = arguments ? std::get_if<EncodableMap>(arguments) : nullptr;
+  if (!map) {
+    bool has_required = std::any_of(specs.data, specs.data + specs.size, [](const ArgSpec &spec) { return spec.required; });
+    if (!has_required && (!arguments || arguments->IsNull())) {
+      return true;
+    }
+    result->Error("INVALID_ARGUMENTS", "Arguments must be a map");
+    return false;
+  }
+  for (size_t i = 0; i < specs.size; i++) {
+    const ArgSpec &spec = specs.data[i];
+    auto it = map->find(EncodableValue(spec.name));
+    if (it == map->end() || it->second.IsNull()) {
+      if (!spec.required) {
+        continue;
+      }
+    } else if (HasArgType(it->second, spec.type)) {
+      continue;
+    }
+    result->Error("INVALID_ARGUMENTS", std::string(spec.name) + " must be " + arg_type_description(spec.type));
+    return false;
+  }
+  return true;
+}
+
 void AllPaystackPaymentsPlugin::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue> &method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
-  if (method_call.method_name().compare("initialize") == 0) {
-    HandleInitialize(method_call, std::move(result));
-  } else if (method_call.method_name().compare("initializePayment") == 0) {
-    HandleInitializePayment(method_call, std::move(result));
-  } else if (method_call.method_name().compare("getCheckoutUrl") == 0) {
-    HandleGetCheckoutUrl(method_call, std::move(result));
-  } else if (method_call.method_name().compare("verifyPayment") == 0) {
-    HandleVerifyPayment(method_call, std::move(result));
-  } else if (method_call.method_name().compare("getPaymentStatus") == 0) {
-    HandleGetPaymentStatus(method_call, std::move(result));
-  } else if (method_call.method_name().compare("cancelPayment") == 0) {
-    HandleCancelPayment(std::move(result));
-  } else if (method_call.method_name().compare("showWebView") == 0) {
-    HandleShowWebView(method_call, std::move(result));
-  } else if (method_call.method_name().compare("getPlatformVersion") == 0) {
-    std::ostringstream version_stream;
-    version_stream << "Windows ";
-    if (IsWindows10OrGreater()) {
-      version_stream << "10+";
-    } else if (IsWindows8OrGreater()) {
-      version_stream << "8";
-    } else if (IsWindows7OrGreater()) {
-      version_stream << "7";
-    }
-    result->Success(flutter::EncodableValue(version_stream.str()));
-  } else {
+  int64_t start = Tracer::Now();
+  size_t index = Methods::kTable.Find(method_call.method_name().c_str());
+  if (index == Methods::kTable.kNotFound) {
     result->NotImplemented();
+  } else {
+    const MethodSpec<Handler> &method = Methods::kAll[index];
+    MethodStats &stats = method_stats_[index];
+    stats.calls.fetch_add(1, std::memory_order_relaxed);
+    if (CheckMethodArgs(method, method_call.arguments(), result.get())) {
+      (this->*method.handler)(method_call, std::move(result));
+    } else {
+      stats.invalid_arguments.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  // Requests complete within the handler, so the dispatch span covers the
+  // whole call.
+  if (tracer_.enabled()) {
+    tracer_.Span("dispatch", start, Tracer::Now() - start, TraceArgsOf(method_call));
   }
 }
 
 void AllPaystackPaymentsPlugin::HandleInitialize(
     const flutter::MethodCall<flutter::EncodableValue> &method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
-  const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
-  if (!arguments) {
-    result->Error("INVALID_ARGUMENTS", "Arguments must be a map");
-    return;
+  const auto& arguments = std::get<flutter::EncodableMap>(*method_call.arguments());
+  ApiConfig api;
+  api.public_key = std::get<std::string>(arguments.at(flutter::EncodableValue("publicKey")));
+  auto base_url_it = arguments.find(flutter::EncodableValue("baseUrl"));
+  if (base_url_it != arguments.end() && !base_url_it->second.IsNull()) {
+    api.base_url = std::get<std::string>(base_url_it->second);
+    if (!normalize_base_url(&api.base_url)) {
+      result->Error("INVALID_ARGUMENTS", "baseUrl must be an http or https URL");
+      return;
+    }
   }
-  auto public_key_it = arguments->find(flutter::EncodableValue("publicKey"));
-  if (public_key_it == arguments->end() || !std::holds_alternative<std::string>(public_key_it->second)) {
-    result->Error("INVALID_ARGUMENTS", "publicKey must be a string");
-    return;
+  // Checked for parity with Linux, but never applied: a hedge could only be
+  // sent after CurlTransport's Send has already returned.
+  auto hedge_it = arguments.find(EncodableValue("hedgeVerifyPercentile"));
+  if (hedge_it != arguments.end() && !hedge_it->second.IsNull()) {
+    int64_t percentile = hedge_it->second.LongValue();
+    if (percentile < kMinHedgePercentile || percentile > kMaxHedgePercentile) {
+      result->Error("INVALID_ARGUMENTS", "hedgeVerifyPercentile must be between 50 and 99");
+      return;
+    }
+  }
+  // Each endpoint gets a bucket of its own, a second's worth deep. Waiting
+  // for it, or after a 429, would block the platform thread, so calls it
+  // holds back fail at once with RATE_LIMITED.
+  RateLimitPolicy rate_limit_policy;
+  rate_limit_policy.max_wait = std::chrono::milliseconds(0);
+  auto rate_it = arguments.find(EncodableValue("rateLimitPerSecond"));
+  if (rate_it != arguments.end() && !rate_it->second.IsNull()) {
+    int64_t rate = rate_it->second.LongValue();
+    if (rate < 1 || rate > kMaxRateLimitPerSecond) {
+      result->Error("INVALID_ARGUMENTS", "rateLimitPerSecond must be between 1 and 1000");
+      return;
+    }
+    rate_limit_policy.requests_per_second = static_cast<double>(rate);
+    rate_limit_policy.burst = static_cast<double>(rate);
   }
-  public_key_ = std::get<std::string>(public_key_it->second);
+  // Cached results belong to the integration the previous key and API
+  // identified.
+  if (api_.public_key != api.public_key || api_.base_url != api.base_url) {
+    client_.verify_cache().Clear();
+  }
+  api_ = std::move(api);
+  client_.set_rate_limit_policy(rate_limit_policy);
   result->Success();
 }
 
@@ -102,154 +399,110 @@ void AllPaystackPaymentsPlugin::HandleInitializePayment(
 void AllPaystackPaymentsPlugin::HandleGetCheckoutUrl(
     const flutter::MethodCall<flutter::EncodableValue> &method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
-  const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
-  if (!arguments) {
-    result->Error("INVALID_ARGUMENTS", "Arguments must be a map");
-    return;
+  const auto& arguments = std::get<EncodableMap>(*method_call.arguments());
+  auto currency_it = arguments.find(EncodableValue("currency"));
+  auto reference_it = arguments.find(EncodableValue("reference"));
+  auto metadata_it = arguments.find(EncodableValue("metadata"));
+  auto callback_url_it = arguments.find(EncodableValue("callbackUrl"));
+
+  CheckoutRequest request;
+  request.amount = arguments.at(EncodableValue("amount")).LongValue();
+  request.email = std::get<std::string>(arguments.at(EncodableValue("email")));
+  request.currency = (currency_it != arguments.end() && std::holds_alternative<std::string>(currency_it->second)) ?
+                     std::get<std::string>(currency_it->second) : "NGN";
+  if (reference_it != arguments.end() && std::holds_alternative<std::string>(reference_it->second)) {
+    request.has_reference = true;
+    request.reference = std::get<std::string>(reference_it->second);
   }
-
-  // Extract common fields
-  auto amount_it = arguments->find(flutter::EncodableValue("amount"));
-  auto email_it = arguments->find(flutter::EncodableValue("email"));
-  auto currency_it = arguments->find(flutter::EncodableValue("currency"));
-  auto reference_it = arguments->find(flutter::EncodableValue("reference"));
-  auto metadata_it = arguments->find(flutter::EncodableValue("metadata"));
-  auto callback_url_it = arguments->find(flutter::EncodableValue("callbackUrl"));
-
-  if (amount_it == arguments->end() || !std::holds_alternative<int>(amount_it->second) ||
-      email_it == arguments->end() || !std::holds_alternative<std::string>(email_it->second)) {
-    result->Error("INVALID_ARGUMENTS", "Missing required arguments: amount, email");
-    return;
-  }
-
-  int amount = std::get<int>(amount_it->second);
-  std::string email = std::get<std::string>(email_it->second);
-  std::string currency = (currency_it != arguments->end() && std::holds_alternative<std::string>(currency_it->second)) ?
-                         std::get<std::string>(currency_it->second) : "NGN";
-  std::string reference = (reference_it != arguments->end() && std::holds_alternative<std::string>(reference_it->second)) ?
-                          std::get<std::string>(reference_it->second) : "";
-  std::string callback_url = (callback_url_it != arguments->end() && std::holds_alternative<std::string>(callback_url_it->second)) ?
-                             std::get<std::string>(callback_url_it->second) : "";
-
-  // Build JSON body
-  nlohmann::json json_body;
-  json_body["amount"] = amount;
-  json_body["email"] = email;
-  if (!currency.empty()) json_body["currency"] = currency;
-  if (!reference.empty()) json_body["reference"] = reference;
-  if (!callback_url.empty()) json_body["callback_url"] = callback_url;
-
-  // Add metadata if present
-  if (metadata_it != arguments->end() && std::holds_alternative<flutter::EncodableMap>(metadata_it->second)) {
-    // For simplicity, we'll skip metadata for now as it requires recursive parsing
+  if (callback_url_it != arguments.end() && std::holds_alternative<std::string>(callback_url_it->second)) {
+    request.has_callback_url = true;
+    request.callback_url = std::get<std::string>(callback_url_it->second);
   }
-
-  std::string json_str = json_body.dump();
-  std::string response = MakeHttpPostRequest("https://api.paystack.co/transaction/initialize", json_str, public_key_);
-
-  if (response.empty()) {
-    result->Error("HTTP_ERROR", "Failed to make HTTP request");
-    return;
+  if (metadata_it != arguments.end() && !metadata_it->second.IsNull()) {
+    if (!encodable_value_to_json(metadata_it->second, &request.metadata_json)) {
+      result->Error("INVALID_ARGUMENTS", "metadata must be a map of JSON values");
+      return;
+    }
+    request.has_metadata = true;
   }
 
-  try {
-    nlohmann::json json_response = nlohmann::json::parse(response);
-    if (json_response["status"].get<bool>()) {
-      nlohmann::json data = json_response["data"];
-      std::string checkout_url = data["authorization_url"].get<std::string>();
-      std::string ref = data["reference"].get<std::string>();
-
-      flutter::EncodableMap result_map;
-      result_map[flutter::EncodableValue("status")] = flutter::EncodableValue("success");
-
-      flutter::EncodableMap data_map;
-      data_map[flutter::EncodableValue("authorization_url")] = flutter::EncodableValue(checkout_url);
-      data_map[flutter::EncodableValue("reference")] = flutter::EncodableValue(ref);
-      result_map[flutter::EncodableValue("data")] = flutter::EncodableValue(data_map);
-
-      result->Success(flutter::EncodableValue(result_map));
-    } else {
-      result->Error("API_ERROR", json_response["message"].get<std::string>());
+  // The transport is blocking, so the callback runs before this returns.
+  client_.InitializeTransaction(request, api_, [this, &result](const CheckoutResult& checkout_result) {
+    auto start = std::chrono::steady_clock::now();
+    if (!checkout_result.ok()) {
+      result->Error(checkout_result.error_code, checkout_result.error_message);
+      return;
     }
-  } catch (const std::exception& e) {
-    result->Error("PARSE_ERROR", "Failed to parse API response");
-  }
+    EncodableMap result_map;
+    result_map[EncodableValue("status")] = EncodableValue("success");
+
+    EncodableMap data_map;
+    data_map[EncodableValue("authorization_url")] = EncodableValue(checkout_result.authorization_url);
+    data_map[EncodableValue("reference")] = EncodableValue(checkout_result.reference);
+    result_map[EncodableValue("data")] = EncodableValue(data_map);
+    EncodableValue response(result_map);
+    client_.metrics().Record(Endpoint::kInitialize, Phase::kBuild, MicrosSince(start));
+
+    result->Success(response);
+  });
 }
 
 void AllPaystackPaymentsPlugin::HandleVerifyPayment(
     const flutter::MethodCall<flutter::EncodableValue> &method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
-  const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
-  if (!arguments) {
-    result->Error("INVALID_ARGUMENTS", "Arguments must be a map");
-    return;
-  }
-  auto reference_it = arguments->find(flutter::EncodableValue("reference"));
-  if (reference_it == arguments->end() || !std::holds_alternative<std::string>(reference_it->second)) {
-    result->Error("INVALID_ARGUMENTS", "reference must be a string");
-    return;
-  }
-  std::string reference = std::get<std::string>(reference_it->second);
-  std::string url = "https://api.paystack.co/transaction/verify/" + reference;
-  std::string response = MakeHttpRequest(url, public_key_);
-  if (response.empty()) {
-    result->Error("HTTP_ERROR", "Failed to make HTTP request");
-    return;
-  }
-  try {
-    nlohmann::json json_response = nlohmann::json::parse(response);
-    if (json_response["status"].get<bool>()) {
-      nlohmann::json data = json_response["data"];
-      flutter::EncodableMap result_map;
-      result_map[flutter::EncodableValue("reference")] = flutter::EncodableValue(data["reference"].get<std::string>());
-      result_map[flutter::EncodableValue("status")] = flutter::EncodableValue(data["status"].get<std::string>());
-      result_map[flutter::EncodableValue("amount")] = flutter::EncodableValue(data["amount"].get<int>());
-      result_map[flutter::EncodableValue("currency")] = flutter::EncodableValue(data["currency"].get<std::string>());
-      result_map[flutter::EncodableValue("payment_method")] = flutter::EncodableValue("card");
-      if (data.contains("gateway_response")) {
-        result_map[flutter::EncodableValue("gateway_response")] = flutter::EncodableValue(data["gateway_response"].get<std::string>());
-      }
-      result->Success(flutter::EncodableValue(result_map));
-    } else {
-      result->Error("API_ERROR", json_response["message"].get<std::string>());
-    }
-  } catch (const std::exception& e) {
-    result->Error("PARSE_ERROR", "Failed to parse API response");
-  }
+  const auto& arguments = std::get<flutter::EncodableMap>(*method_call.arguments());
+  const auto& reference = std::get<std::string>(arguments.at(flutter::EncodableValue("reference")));
+  std::vector<std::string> fields = ReadVerifyFields(arguments);
+  client_.VerifyTransaction(reference, api_, [this, &result, &fields](const VerifyResult& verify_result) {
+    auto start = std::chrono::steady_clock::now();
+    RespondWithVerifyResult(verify_result, fields, result.get());
+    client_.metrics().Record(Endpoint::kVerify, Phase::kBuild, MicrosSince(start));
+  });
 }
 
 void AllPaystackPaymentsPlugin::HandleGetPaymentStatus(
     const flutter::MethodCall<flutter::EncodableValue> &method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  // Answer from the cache when possible; otherwise this is a verify, which
+  // refreshes the cache.
+  const auto& arguments = std::get<flutter::EncodableMap>(*method_call.arguments());
+  VerifyResult cached;
+  if (client_.verify_cache().Get(std::get<std::string>(arguments.at(flutter::EncodableValue("reference"))), &cached)) {
+    RespondWithVerifyResult(cached, ReadVerifyFields(arguments), result.get());
+    return;
+  }
   HandleVerifyPayment(method_call, std::move(result));
 }
 
 void AllPaystackPaymentsPlugin::HandleCancelPayment(
+    const flutter::MethodCall<flutter::EncodableValue> &method_call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  const auto& arguments = std::get<flutter::EncodableMap>(*method_call.arguments());
+  const auto& reference = std::get<std::string>(arguments.at(flutter::EncodableValue("reference")));
+  // Requests complete inside CurlTransport's Send, on this thread, so there
+  // is never one left to abort; kept for parity with Linux.
+  result->Success(flutter::EncodableValue(client_.Cancel(reference)));
+}
+
+void AllPaystackPaymentsPlugin::HandleWatchPayment(
+    const flutter::MethodCall<flutter::EncodableValue> &method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  // PaymentPoller runs on transport timers, which CurlTransport does not
+  // have, so nothing is watched here; callers fall back to
+  // verifyPayment. Answers unwatchPayment too.
   result->Success(flutter::EncodableValue(false));
 }
 
 void AllPaystackPaymentsPlugin::HandleShowWebView(
     const flutter::MethodCall<flutter::EncodableValue> &method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
-  const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
-  if (!arguments) {
-    result->Error("INVALID_ARGUMENTS", "Arguments must be a map");
-    return;
-  }
-
-  auto checkout_url_it = arguments->find(flutter::EncodableValue("checkoutUrl"));
-  if (checkout_url_it == arguments->end() || !std::holds_alternative<std::string>(checkout_url_it->second)) {
-    result->Error("INVALID_ARGUMENTS", "checkoutUrl must be a string");
-    return;
-  }
-
-  std::string checkout_url = std::get<std::string>(checkout_url_it->second);
+  const auto& arguments = std::get<flutter::EncodableMap>(*method_call.arguments());
+  const auto& checkout_url = std::get<std::string>(arguments.at(flutter::EncodableValue("checkoutUrl")));
 
   // For Windows, open the URL in the default browser
   // In a full implementation, this could show a webview window
   HINSTANCE result_browser = ShellExecuteA(nullptr, "open", checkout_url.c_str(), nullptr, nullptr, SW_SHOWNORMAL);
-  if ((int)result_browser <= 32) {
+  if (reinterpret_cast<INT_PTR>(result_browser) <= 32) {
     result->Error("BROWSER_ERROR", "Failed to open browser");
     return;
   }
@@ -268,49 +521,59 @@ void AllPaystackPaymentsPlugin::HandleShowWebView(
   result->Success(flutter::EncodableValue(response_map));
 }
 
-std::string AllPaystackPaymentsPlugin::MakeHttpPostRequest(const std::string& url, const std::string& json_body, const std::string& public_key) {
-  CURL* curl = curl_easy_init();
-  if (!curl) return "";
-  std::string response;
-  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(curl, CURLOPT_POST, 1L);
-  curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_body.c_str());
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-  struct curl_slist* headers = nullptr;
-  std::string auth_header = "Authorization: Bearer " + public_key;
-  headers = curl_slist_append(headers, "Content-Type: application/json");
-  headers = curl_slist_append(headers, auth_header.c_str());
-  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-  CURLcode res = curl_easy_perform(curl);
-  curl_slist_free_all(headers);
-  curl_easy_cleanup(curl);
-  if (res != CURLE_OK) return "";
-  return response;
+void AllPaystackPaymentsPlugin::HandleGetMetrics(
+    const flutter::MethodCall<flutter::EncodableValue> &method_call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  EncodableMap metrics = MetricsToEncodableMap(client_.metrics());
+  EncodableMap methods;
+  for (size_t i = 0; i < Methods::kCount; i++) {
+    EncodableMap method;
+    method[EncodableValue("calls")] = EncodableValue(static_cast<int64_t>(method_stats_[i].calls.load(std::memory_order_relaxed)));
+    method[EncodableValue("invalidArguments")] = EncodableValue(static_cast<int64_t>(method_stats_[i].invalid_arguments.load(std::memory_order_relaxed)));
+    methods[EncodableValue(Methods::kAll[i].name)] = EncodableValue(method);
+  }
+  metrics[EncodableValue("methods")] = EncodableValue(methods);
+  result->Success(EncodableValue(metrics));
+}
+
+void AllPaystackPaymentsPlugin::HandleGetTransportStats(
+    const flutter::MethodCall<flutter::EncodableValue> &method_call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  result->Success(EncodableValue(TransportStatsToEncodableMap(client_)));
 }
 
-static std::string MakeHttpRequest(const std::string& url, const std::string& public_key) {
-  CURL* curl = curl_easy_init();
-  if (!curl) return "";
-  std::string response;
-  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-  struct curl_slist* headers = nullptr;
-  std::string auth_header = "Authorization: Bearer " + public_key;
-  headers = curl_slist_append(headers, auth_header.c_str());
-  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-  CURLcode res = curl_easy_perform(curl);
-  curl_slist_free_all(headers);
-  curl_easy_cleanup(curl);
-  if (res != CURLE_OK) return "";
-  return response;
+void AllPaystackPaymentsPlugin::HandleStartTracing(
+    const flutter::MethodCall<flutter::EncodableValue> &method_call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  const auto& arguments = std::get<flutter::EncodableMap>(*method_call.arguments());
+  std::string error;
+  if (!tracer_.Start(std::get<std::string>(arguments.at(flutter::EncodableValue("path"))), &error)) {
+    result->Error("TRACE_ERROR", error);
+    return;
+  }
+  result->Success();
 }
 
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* response) {
-  size_t total_size = size * nmemb;
-  response->append((char*)contents, total_size);
-  return total_size;
+void AllPaystackPaymentsPlugin::HandleStopTracing(
+    const flutter::MethodCall<flutter::EncodableValue> &method_call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  tracer_.Stop();
+  result->Success();
+}
+
+void AllPaystackPaymentsPlugin::HandleGetPlatformVersion(
+    const flutter::MethodCall<flutter::EncodableValue> &method_call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  std::ostringstream version_stream;
+  version_stream << "Windows ";
+  if (IsWindows10OrGreater()) {
+    version_stream << "10+";
+  } else if (IsWindows8OrGreater()) {
+    version_stream << "8";
+  } else if (IsWindows7OrGreater()) {
+    version_stream << "7";
+  }
+  result->Success(flutter::EncodableValue(version_stream.str()));
 }
 
 }  // namespace all_paystack_payments
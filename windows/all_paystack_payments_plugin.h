@@ -7,6 +7,11 @@
 #include <memory>
 #include <string>
 
+#include "paystack_client.h"
+#include "paystack_curl_transport.h"
+#include "paystack_method_registry.h"
+#include "paystack_trace.h"
+
 namespace all_paystack_payments {
 
 class AllPaystackPaymentsPlugin : public flutter::Plugin {
@@ -27,8 +32,42 @@ class AllPaystackPaymentsPlugin : public flutter::Plugin {
       std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
 
  private:
-  std::string public_key_;
-  std::string MakeHttpPostRequest(const std::string& url, const std::string& json_body, const std::string& public_key);
+  using Result = std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>;
+  using Handler = void (AllPaystackPaymentsPlugin::*)(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+
+  // The method registry, defined with the handlers it names.
+  struct Methods;
+
+  // Answers INVALID_ARGUMENTS and returns false if |arguments| do not match
+  // the schema |method| declares.
+  static bool CheckMethodArgs(const MethodSpec<Handler> &method, const flutter::EncodableValue *arguments, flutter::MethodResult<flutter::EncodableValue> *result);
+
+  // Method call handlers. HandleMethodCall has checked their arguments
+  // against the method's schema.
+  void HandleInitialize(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+  void HandleInitializePayment(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+  void HandleGetCheckoutUrl(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+  void HandleVerifyPayment(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+  void HandleGetPaymentStatus(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+  void HandleCancelPayment(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+  void HandleWatchPayment(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+  void HandleShowWebView(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+  void HandleGetMetrics(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+  void HandleGetTransportStats(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+  void HandleStartTracing(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+  void HandleStopTracing(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+  void HandleGetPlatformVersion(const flutter::MethodCall<flutter::EncodableValue> &method_call, Result result);
+
+  // Indexed like the registry.
+  std::unique_ptr<MethodStats[]> method_stats_;
+
+  ApiConfig api_;
+  // Traces the dispatcher and the client, which it outlives.
+  Tracer tracer_;
+  // Requests block the platform thread until they complete, as they always
+  // have on Windows.
+  CurlTransport transport_;
+  PaystackClient client_{&transport_};
 };
 
 }  // namespace all_paystack_payments
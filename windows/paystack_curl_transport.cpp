@@ -0,0 +1,132 @@
+#include "paystack_curl_transport.h"
+
+#include <string>
+#include <utility>
+
+#include "paystack_rate_limiter.h"
+
+namespace all_paystack_payments {
+
+namespace {
+
+// Reads when the finished transfer on |handle| reached each phase.
+void ReadTimings(CURL* handle, HttpTimings* timings) {
+  const struct {
+    CURLINFO info;
+    int64_t* micros;
+  } phases[] = {
+      {CURLINFO_NAMELOOKUP_TIME_T, &timings->name_lookup},
+      {CURLINFO_CONNECT_TIME_T, &timings->connect},
+      {CURLINFO_APPCONNECT_TIME_T, &timings->tls},
+      {CURLINFO_STARTTRANSFER_TIME_T, &timings->first_byte},
+      {CURLINFO_TOTAL_TIME_T, &timings->total},
+  };
+  for (const auto& phase : phases) {
+    curl_off_t micros = 0;
+    if (curl_easy_getinfo(handle, phase.info, &micros) == CURLE_OK) {
+      *phase.micros = micros;
+    }
+  }
+}
+
+}  // namespace
+
+struct CurlTransport::Exchange {
+  HttpResponse response;
+  BodySink sink;
+};
+
+CurlTransport::CurlTransport() : handle_(curl_easy_init()) {}
+
+CurlTransport::~CurlTransport() {
+  if (handle_) curl_easy_cleanup(handle_);
+}
+
+RequestId CurlTransport::Send(HttpRequest request, HttpCallback callback,
+                              BodySink sink) {
+  Exchange exchange;
+  exchange.sink = std::move(sink);
+  if (!handle_) {
+    exchange.response.error = curl_easy_strerror(CURLE_FAILED_INIT);
+    callback(exchange.response);
+    return 0;
+  }
+  // Clears the previous request's options but keeps the open connection.
+  curl_easy_reset(handle_);
+  curl_easy_setopt(handle_, CURLOPT_URL, request.url.c_str());
+  curl_easy_setopt(handle_, CURLOPT_WRITEFUNCTION, WriteCallback);
+  curl_easy_setopt(handle_, CURLOPT_WRITEDATA, &exchange);
+  curl_easy_setopt(handle_, CURLOPT_HEADERFUNCTION, HeaderCallback);
+  curl_easy_setopt(handle_, CURLOPT_HEADERDATA, &exchange);
+  curl_slist* headers = nullptr;
+  std::string auth_header = "Authorization: Bearer " + request.public_key;
+  headers = curl_slist_append(headers, auth_header.c_str());
+  if (request.method == HttpMethod::kPost) {
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+    curl_easy_setopt(handle_, CURLOPT_POST, 1L);
+    curl_easy_setopt(handle_, CURLOPT_POSTFIELDS, request.body.c_str());
+    curl_easy_setopt(handle_, CURLOPT_POSTFIELDSIZE,
+                     static_cast<long>(request.body.size()));
+  } else {
+    curl_easy_setopt(handle_, CURLOPT_HTTPGET, 1L);
+  }
+  if (request.fresh_connection) {
+    curl_easy_setopt(handle_, CURLOPT_FRESH_CONNECT, 1L);
+  }
+  curl_easy_setopt(handle_, CURLOPT_CONNECTTIMEOUT_MS,
+                   static_cast<long>(request.connect_timeout_ms));
+  curl_easy_setopt(handle_, CURLOPT_TIMEOUT_MS,
+                   static_cast<long>(request.timeout_ms));
+  curl_easy_setopt(handle_, CURLOPT_HTTPHEADER, headers);
+
+  CURLcode result = curl_easy_perform(handle_);
+  curl_slist_free_all(headers);
+  if (result != CURLE_OK) {
+    exchange.response.error = curl_easy_strerror(result);
+  }
+  curl_easy_getinfo(handle_, CURLINFO_RESPONSE_CODE,
+                    &exchange.response.status_code);
+  curl_easy_getinfo(handle_, CURLINFO_NUM_CONNECTS,
+                    &exchange.response.connections_opened);
+  ReadTimings(handle_, &exchange.response.timings);
+  long http_version = 0;
+  curl_easy_getinfo(handle_, CURLINFO_HTTP_VERSION, &http_version);
+  if (http_version == CURL_HTTP_VERSION_2_0) {
+    exchange.response.http_version = 2;
+  } else if (http_version != 0) {
+    exchange.response.http_version = 1;
+  }
+  callback(exchange.response);
+  return 0;
+}
+
+void CurlTransport::Cancel(RequestId id) {}
+
+void CurlTransport::RunAfter(int64_t delay_ms, DelayedTask task) {
+  // Waiting here would block the platform thread.
+  task(true);
+}
+
+// static
+size_t CurlTransport::WriteCallback(char* data, size_t size, size_t nmemb,
+                                    void* user_data) {
+  Exchange* exchange = static_cast<Exchange*>(user_data);
+  size_t total_size = size * nmemb;
+  if (exchange->sink) {
+    // A short count makes curl abort the transfer with CURLE_WRITE_ERROR.
+    return exchange->sink(data, total_size) ? total_size : 0;
+  }
+  exchange->response.body.append(data, total_size);
+  return total_size;
+}
+
+// static
+size_t CurlTransport::HeaderCallback(char* data, size_t size, size_t nmemb,
+                                     void* user_data) {
+  Exchange* exchange = static_cast<Exchange*>(user_data);
+  size_t total_size = size * nmemb;
+  read_rate_limit_header(data, total_size, &exchange->response.rate_limit);
+  return total_size;
+}
+
+}  // namespace all_paystack_payments
@@ -0,0 +1,48 @@
+#ifndef FLUTTER_PLUGIN_PAYSTACK_CURL_TRANSPORT_H_
+#define FLUTTER_PLUGIN_PAYSTACK_CURL_TRANSPORT_H_
+
+#include <curl/curl.h>
+
+#include "paystack_transport.h"
+
+namespace all_paystack_payments {
+
+// Transport over a blocking libcurl easy handle. Send performs the whole
+// exchange and invokes its callback before returning. It runs on the
+// platform thread, so there are no timers: RunAfter runs its task cancelled
+// at once, and the plugin configures PaystackClient not to retry, hedge or
+// wait for the rate limiter.
+//
+// The handle is kept between requests, so back to back calls to the API
+// reuse its connection.
+class CurlTransport : public Transport {
+ public:
+  CurlTransport();
+  ~CurlTransport() override;
+
+  // Disallow copy and assign.
+  CurlTransport(const CurlTransport&) = delete;
+  CurlTransport& operator=(const CurlTransport&) = delete;
+
+  RequestId Send(HttpRequest request, HttpCallback callback,
+                 BodySink sink) override;
+
+  // Requests complete inside Send, so there is never one to cancel.
+  void Cancel(RequestId id) override;
+
+  void RunAfter(int64_t delay_ms, DelayedTask task) override;
+
+ private:
+  struct Exchange;
+
+  static size_t WriteCallback(char* data, size_t size, size_t nmemb,
+                              void* user_data);
+  static size_t HeaderCallback(char* data, size_t size, size_t nmemb,
+                               void* user_data);
+
+  CURL* handle_;
+};
+
+}  // namespace all_paystack_payments
+
+#endif  // FLUTTER_PLUGIN_PAYSTACK_CURL_TRANSPORT_H_
@@ -0,0 +1,202 @@
+#include "paystack_encodable_value.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "paystack_json_stream.h"
+#include "paystack_json_writer.h"
+
+namespace all_paystack_payments {
+
+namespace {
+
+using flutter::EncodableList;
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+// Far deeper than any metadata, and shallow enough for the stack.
+constexpr int kMaxDepth = 64;
+
+// Builds an EncodableValue tree from JsonStreamParser events, skipping the
+// top-level members outside the field projection.
+class EncodableValueBuilder : public JsonHandler {
+ public:
+  EncodableValueBuilder(const std::vector<std::string>& fields,
+                        EncodableValue* root)
+      : fields_(fields), root_(root) {}
+
+  bool Null() override { return Add(EncodableValue()); }
+  bool Bool(bool value) override { return Add(EncodableValue(value)); }
+  bool Int(int64_t value) override { return Add(EncodableValue(value)); }
+  bool Double(double value) override { return Add(EncodableValue(value)); }
+  bool String(const char* data, size_t length) override {
+    return Add(EncodableValue(std::string(data, length)));
+  }
+  bool StartObject() override { return Open(EncodableValue(EncodableMap())); }
+  bool Key(const char* data, size_t length) override {
+    if (skip_depth_ > 0) return true;
+    if (!fields_.empty() && containers_.size() == 1 &&
+        !IsProjected(data, length)) {
+      skipping_ = true;
+      return true;
+    }
+    key_.assign(data, length);
+    return true;
+  }
+  bool EndObject() override { return Close(); }
+  bool StartArray() override { return Open(EncodableValue(EncodableList())); }
+  bool EndArray() override { return Close(); }
+
+ private:
+  // Adds |value| to the open container, or makes it the root, and returns
+  // where it was stored.
+  EncodableValue* Store(EncodableValue value) {
+    if (containers_.empty()) {
+      *root_ = std::move(value);
+      return root_;
+    }
+    EncodableValue* container = containers_.back();
+    if (auto* map = std::get_if<EncodableMap>(container)) {
+      EncodableValue& slot = (*map)[EncodableValue(key_)];
+      slot = std::move(value);
+      return &slot;
+    }
+    EncodableList& list = std::get<EncodableList>(*container);
+    list.push_back(std::move(value));
+    return &list.back();
+  }
+
+  bool Add(EncodableValue value) {
+    if (skip_depth_ > 0) return true;
+    if (skipping_) {
+      skipping_ = false;
+      return true;
+    }
+    Store(std::move(value));
+    return true;
+  }
+
+  // Open containers are only reached through their parents, which are not
+  // modified while a child is open, so the pointers stay valid.
+  bool Open(EncodableValue container) {
+    if (skip_depth_ > 0 || skipping_) {
+      skipping_ = false;
+      skip_depth_++;
+      return true;
+    }
+    containers_.push_back(Store(std::move(container)));
+    return true;
+  }
+
+  bool Close() {
+    if (skip_depth_ > 0) {
+      skip_depth_--;
+      return true;
+    }
+    containers_.pop_back();
+    return true;
+  }
+
+  bool IsProjected(const char* key, size_t length) const {
+    for (const std::string& field : fields_) {
+      if (field.size() == length && memcmp(field.data(), key, length) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const std::vector<std::string>& fields_;
+  EncodableValue* root_;
+  std::vector<EncodableValue*> containers_;
+  std::string key_;
+  // The next value belongs to a member outside the projection.
+  bool skipping_ = false;
+  // Depth inside a skipped container.
+  int skip_depth_ = 0;
+};
+
+template <typename T, typename Append>
+void AppendArray(std::string* out, const std::vector<T>& values,
+                 Append append) {
+  out->push_back('[');
+  for (size_t i = 0; i < values.size(); i++) {
+    if (i > 0) out->push_back(',');
+    append(out, values[i]);
+  }
+  out->push_back(']');
+}
+
+bool AppendValue(const EncodableValue& value, int depth, std::string* out) {
+  if (std::holds_alternative<std::monostate>(value)) {
+    out->append("null");
+  } else if (const auto* b = std::get_if<bool>(&value)) {
+    out->append(*b ? "true" : "false");
+  } else if (const auto* i32 = std::get_if<int32_t>(&value)) {
+    json_append_int(out, *i32);
+  } else if (const auto* i64 = std::get_if<int64_t>(&value)) {
+    json_append_int(out, *i64);
+  } else if (const auto* d = std::get_if<double>(&value)) {
+    return json_append_double(out, *d);
+  } else if (const auto* s = std::get_if<std::string>(&value)) {
+    json_append_string(out, s->data(), s->size());
+  } else if (const auto* u8s = std::get_if<std::vector<uint8_t>>(&value)) {
+    AppendArray(out, *u8s,
+                [](std::string* o, uint8_t v) { json_append_int(o, v); });
+  } else if (const auto* i32s = std::get_if<std::vector<int32_t>>(&value)) {
+    AppendArray(out, *i32s,
+                [](std::string* o, int32_t v) { json_append_int(o, v); });
+  } else if (const auto* i64s = std::get_if<std::vector<int64_t>>(&value)) {
+    AppendArray(out, *i64s,
+                [](std::string* o, int64_t v) { json_append_int(o, v); });
+  } else if (const auto* ds = std::get_if<std::vector<double>>(&value)) {
+    for (double v : *ds) {
+      if (!std::isfinite(v)) return false;
+    }
+    AppendArray(out, *ds,
+                [](std::string* o, double v) { json_append_double(o, v); });
+  } else if (const auto* list = std::get_if<EncodableList>(&value)) {
+    if (depth == kMaxDepth) return false;
+    out->push_back('[');
+    for (size_t i = 0; i < list->size(); i++) {
+      if (i > 0) out->push_back(',');
+      if (!AppendValue((*list)[i], depth + 1, out)) return false;
+    }
+    out->push_back(']');
+  } else if (const auto* map = std::get_if<EncodableMap>(&value)) {
+    if (depth == kMaxDepth) return false;
+    out->push_back('{');
+    bool first = true;
+    for (const auto& entry : *map) {
+      const auto* key = std::get_if<std::string>(&entry.first);
+      if (key == nullptr) return false;
+      if (!first) out->push_back(',');
+      first = false;
+      json_append_string(out, key->data(), key->size());
+      out->push_back(':');
+      if (!AppendValue(entry.second, depth + 1, out)) return false;
+    }
+    out->push_back('}');
+  } else {
+    // Float32 lists and custom values.
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool json_to_encodable_value(const char* json, size_t length,
+                             const std::vector<std::string>& fields,
+                             EncodableValue* value) {
+  EncodableValueBuilder builder(fields, value);
+  JsonStreamParser parser(&builder);
+  return parser.Feed(json, length) && parser.Finish();
+}
+
+bool encodable_value_to_json(const EncodableValue& value, std::string* out) {
+  return AppendValue(value, 0, out);
+}
+
+}  // namespace all_paystack_payments
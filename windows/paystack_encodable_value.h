@@ -0,0 +1,32 @@
+#ifndef FLUTTER_PLUGIN_PAYSTACK_ENCODABLE_VALUE_H_
+#define FLUTTER_PLUGIN_PAYSTACK_ENCODABLE_VALUE_H_
+
+#include <flutter/encodable_value.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace all_paystack_payments {
+
+// Converts the JSON document |json| to an EncodableValue, keeping only
+// |fields| of its top-level object if the list is not empty. Returns false if
+// |json| is not valid JSON.
+//
+// Integers become int64_t and other numbers double, as the standard codec
+// decodes them on the Dart side.
+bool json_to_encodable_value(const char* json, size_t length,
+                             const std::vector<std::string>& fields,
+                             flutter::EncodableValue* value);
+
+// Appends |value| to |out| as JSON. Maps must have string keys and floats
+// must be finite.
+//
+// Returns false, leaving |out| partly written, if |value| holds anything
+// that has no JSON form or is nested too deeply.
+bool encodable_value_to_json(const flutter::EncodableValue& value,
+                             std::string* out);
+
+}  // namespace all_paystack_payments
+
+#endif  // FLUTTER_PLUGIN_PAYSTACK_ENCODABLE_VALUE_H_
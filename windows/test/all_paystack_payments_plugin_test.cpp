@@ -9,12 +9,14 @@
 #include <variant>
 
 #include "all_paystack_payments_plugin.h"
+#include "paystack_encodable_value.h"
 
 namespace all_paystack_payments {
 namespace test {
 
 namespace {
 
+using flutter::EncodableList;
 using flutter::EncodableMap;
 using flutter::EncodableValue;
 using flutter::MethodCall;
@@ -39,5 +41,44 @@ TEST(AllPaystackPaymentsPlugin, GetPlatformVersion) {
   EXPECT_TRUE(result_string.rfind("Windows ", 0) == 0);
 }
 
+TEST(EncodableValueJson, WritesMetadata) {
+  EncodableMap item;
+  item[EncodableValue("id")] = EncodableValue(int64_t{1});
+  item[EncodableValue("name")] = EncodableValue("T\"ea");
+  EncodableMap metadata;
+  metadata[EncodableValue("cart")] = EncodableValue(EncodableList{EncodableValue(item)});
+  metadata[EncodableValue("gift")] = EncodableValue(false);
+  metadata[EncodableValue("weight")] = EncodableValue(2.5);
+  std::string json;
+  ASSERT_TRUE(encodable_value_to_json(EncodableValue(metadata), &json));
+  EXPECT_EQ(json, R"({"cart":[{"id":1,"name":"T\"ea"}],"gift":false,"weight":2.5})");
+
+  EncodableMap bad_key;
+  bad_key[EncodableValue(1)] = EncodableValue("x");
+  json.clear();
+  EXPECT_FALSE(encodable_value_to_json(EncodableValue(bad_key), &json));
+}
+
+TEST(EncodableValueJson, ReadsProjectedFields) {
+  const std::string json =
+      R"({"reference":"r","amount":50000,"log":{"history":[1,2]},)"
+      R"("fees":1.5,"customer":{"email":"a@b.co"}})";
+  EncodableValue value;
+  ASSERT_TRUE(json_to_encodable_value(json.data(), json.size(), {"reference", "customer"}, &value));
+  const auto& map = std::get<EncodableMap>(value);
+  EXPECT_EQ(map.size(), 2u);
+  EXPECT_EQ(std::get<std::string>(map.at(EncodableValue("reference"))), "r");
+  const auto& customer = std::get<EncodableMap>(map.at(EncodableValue("customer")));
+  EXPECT_EQ(std::get<std::string>(customer.at(EncodableValue("email"))), "a@b.co");
+
+  ASSERT_TRUE(json_to_encodable_value(json.data(), json.size(), {}, &value));
+  const auto& full = std::get<EncodableMap>(value);
+  EXPECT_EQ(full.size(), 5u);
+  EXPECT_EQ(std::get<int64_t>(full.at(EncodableValue("amount"))), 50000);
+  EXPECT_EQ(std::get<double>(full.at(EncodableValue("fees"))), 1.5);
+
+  EXPECT_FALSE(json_to_encodable_value("{\"a\":", 5, {}, &value));
+}
+
 }  // namespace test
 }  // namespace all_paystack_payments